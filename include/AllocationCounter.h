@@ -0,0 +1,49 @@
+/*
+ * AllocationCounter.h - counts memory-allocations while rendering
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _ALLOCATION_COUNTER_H
+#define _ALLOCATION_COUNTER_H
+
+
+// Counts calls of operator new (in any thread, including plugins) while
+// enabled. It's meant for benchmarking renderings without GUI where
+// practically only audio-threads are running - allocations there are
+// potential sources of xruns. Allocations by C-libraries (malloc()) are not
+// counted. Replacing operator new affects the whole program, so it's only
+// done if LMMS has been configured with WANT_ALLOCATION_COUNTER - otherwise
+// nothing is counted at all.
+class AllocationCounter
+{
+public:
+	static bool isAvailable();
+
+	static void setEnabled( bool _enabled );
+
+	static int count();
+	static void reset();
+
+} ;
+
+
+#endif
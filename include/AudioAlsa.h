@@ -77,10 +77,40 @@ private:
 	virtual void applyQualitySettings();
 	virtual void run();
 
+	enum SampleFormats
+	{
+		Float32,
+		S32,
+		S24,
+		S16
+	} ;
+
+	int openDevice();
 	int setHWParams( const ch_cnt_t _channels, snd_pcm_access_t _access );
 	int setSWParams();
 	int handleError( int _err );
 
+	// main-loops for mmap- and read/write-access
+	void runMmap();
+	void runReadWrite();
+
+	// convert _frames frames of mixer-output into _dst in negotiated
+	// format, fetching new buffers from mixer as needed - returns false
+	// (and fills rest of _dst with silence) if there're no more buffers
+	bool fillBuffer( char * _dst, snd_pcm_uframes_t _frames );
+	void convert( const surroundSampleFrame * _src, const fpp_t _frames,
+								char * _dst );
+	template<typename T>
+	void convertToInt( const surroundSampleFrame * _src,
+					const fpp_t _frames, const float _gain,
+					const float _max, const int _shift,
+								T * _dst );
+
+	inline int bytesPerFrame() const
+	{
+		return channels() * ( m_format == S16 ? 2 : 4 );
+	}
+
 
 	snd_pcm_t * m_handle;
 
@@ -90,7 +120,16 @@ private:
 	snd_pcm_hw_params_t * m_hwParams;
 	snd_pcm_sw_params_t * m_swParams;
 
+	SampleFormats m_format;
 	bool m_convertEndian;
+	bool m_mmap;
+	bool m_dither;
+	unsigned int m_ditherState;
+
+	// mixer-output not yet written to device
+	surroundSampleFrame * m_mixBuffer;
+	fpp_t m_mixFrames;
+	fpp_t m_mixPos;
 
 } ;
 
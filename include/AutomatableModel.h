@@ -235,6 +235,8 @@ public slots:
 protected:
 	virtual void redoStep( JournalEntry& je );
 	virtual void undoStep( JournalEntry& je );
+	virtual bool mergeJournalEntries( JournalEntry& last,
+						const JournalEntry& je );
 
 	float fittedValue( float value ) const;
 
@@ -57,6 +57,23 @@ public:
 	virtual bool processAudioBuffer( sampleFrame * _buf,
 						const fpp_t _frames ) = 0;
 
+	// effects able to work on deinterleaved audio return true here - an
+	// EffectChain then deinterleaves only once for each sequence of such
+	// effects and calls processPlanarAudioBuffer() instead of
+	// processAudioBuffer()
+	virtual bool supportsPlanarProcessing() const
+	{
+		return false;
+	}
+
+	// _channels[c] points to _frames samples of channel c which have to
+	// be processed in place
+	virtual bool processPlanarAudioBuffer( sample_t * const * _channels,
+							const fpp_t _frames )
+	{
+		return false;
+	}
+
 	inline ch_cnt_t processorCount() const
 	{
 		return m_processors;
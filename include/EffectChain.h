@@ -71,6 +71,9 @@ private:
 
 	BoolModel m_enabledModel;
 
+	// shared by consecutive effects supporting planar processing
+	sample_t m_planarBuffer[DEFAULT_CHANNELS][DEFAULT_BUFFER_SIZE];
+
 
 	friend class EffectRackView;
 
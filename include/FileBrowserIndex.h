@@ -0,0 +1,142 @@
+/*
+ * FileBrowserIndex.h - scans directories for file-browsers in background
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _FILE_BROWSER_INDEX_H
+#define _FILE_BROWSER_INDEX_H
+
+#include <QtCore/QDateTime>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+
+class QFileSystemWatcher;
+
+
+// Keeps listings of directories shown in file-browsers. Directories are read
+// by a low-priority thread and each result is announced through
+// directoryScanned() as soon as it is available, so the GUI never waits for
+// (possibly network-mounted) file-systems. Listings are saved in the working
+// directory and only re-read if a directory was modified, which makes
+// browsing large libraries instant after the first scan.
+class FileBrowserIndex : public QThread
+{
+	Q_OBJECT
+public:
+	struct Listing
+	{
+		QStringList dirs;
+		QStringList lockedDirs;		// sub-set of unreadable dirs
+		QStringList files;
+		QDateTime modified;
+	} ;
+
+	static FileBrowserIndex * inst();
+
+	// fills _listing with known contents of directory _path and returns
+	// true if there's any - directory is re-read in background in any
+	// case and directoryScanned() is emitted if contents changed
+	bool listing( const QString & _path, Listing & _listing );
+
+	// re-read directory _path (even if it seems to be unchanged if _force
+	// is set) - urgent requests are handled before everything else
+	void requestScan( const QString & _path, const bool _urgent,
+						const bool _force = false );
+
+	// index everything below _path while being idle
+	void crawl( const QString & _path );
+
+	// emit directoryScanned() whenever directory _path is changed - calls
+	// are counted per path, so every watch() has to be balanced by an
+	// unwatch() (GUI-thread only)
+	void watch( const QString & _path );
+	void unwatch( const QString & _path );
+
+	// returns whether any file or directory name below _path (according
+	// to the index) contains _filter and whether file matches one of
+	// _patterns (as passed to QDir::match())
+	bool containsMatch( const QString & _path, const QString & _filter,
+						const QString & _patterns );
+
+
+signals:
+	// contents of directory _path (in canonical form as returned by
+	// QDir::cleanPath()) are known or have changed
+	void directoryScanned( const QString & _path );
+
+
+private slots:
+	void directoryChanged( const QString & _path );
+	// lets thread finish pending work and saves index - called when
+	// application quits
+	void stop();
+
+
+private:
+	struct Request
+	{
+		QString path;
+		bool force;	// re-read even if unmodified
+		bool notify;	// emit directoryScanned() in any case
+		bool crawl;	// request sub-directories afterwards
+	} ;
+
+	FileBrowserIndex();
+	virtual ~FileBrowserIndex();
+
+	virtual void run();
+
+	void addRequest( QList<Request> & _queue, const Request & _request );
+	void scan( const Request & _request );
+	// requires m_mutex to be locked
+	bool containsMatchLocked( const QString & _path,
+						const QString & _filter,
+						const QString & _patterns );
+
+	void readIndex();
+	void writeIndex();
+
+
+	QMutex m_mutex;
+	QWaitCondition m_requestAvailable;
+
+	QHash<QString, Listing> m_listings;
+	bool m_dirty;
+
+	QList<Request> m_urgentRequests;
+	QList<Request> m_requests;
+	bool m_quit;
+	// canonical paths of crawled directories - avoids loops due to links
+	QSet<QString> m_crawled;
+
+	QFileSystemWatcher * m_watcher;
+	QHash<QString, int> m_watchCount;
+
+} ;
+
+
+#endif
@@ -97,6 +97,14 @@ public:
 		return false;
 	}
 
+	// return true if notes can be rendered by an OfflineRenderContext,
+	// i.e. the instrument renders each note within playNote() and doesn't
+	// mix its output via an InstrumentPlayHandle
+	inline virtual bool supportsOfflineRendering() const
+	{
+		return !isMidiBased();
+	}
+
 	// sub-classes can re-implement this for receiving all incoming
 	// MIDI-events
 	inline virtual bool handleMidiEvent( const midiEvent &, const midiTime & )
@@ -26,7 +26,11 @@
 #ifndef _INSTRUMENT_TRACK_H
 #define _INSTRUMENT_TRACK_H
 
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+
 #include "AudioPort.h"
+#include "ComboBoxModel.h"
 #include "InstrumentFunctions.h"
 #include "InstrumentSoundShaping.h"
 #include "MidiEventProcessor.h"
@@ -47,11 +51,13 @@ class fadeButton;
 class Instrument;
 class InstrumentTrackWindow;
 class InstrumentMidiIOView;
+class comboBox;
 class knob;
 class lcdSpinBox;
 class midiPortMenu;
 class multimediaProject;
 class notePlayHandle;
+class OfflineRenderContext;
 class PluginView;
 class tabWidget;
 class trackLabelButton;
@@ -62,6 +68,15 @@ class EXPORT InstrumentTrack : public track, public MidiEventProcessor
 	Q_OBJECT
 	mapPropertyFromModel(int,getVolume,setVolume,m_volumeModel);
 public:
+	// which voice to stop if the track plays more notes than allowed
+	enum VoiceStealingPolicies
+	{
+		StealOldest,
+		StealQuietest,
+		StealSameKey,
+		NumVoiceStealingPolicies
+	} ;
+
 	InstrumentTrack( TrackContainer* tc );
 	virtual ~InstrumentTrack();
 
@@ -195,6 +210,16 @@ public:
 		return &m_effectChannelModel;
 	}
 
+	IntModel * maxVoicesModel()
+	{
+		return &m_maxVoicesModel;
+	}
+
+	ComboBoxModel * voiceStealingModel()
+	{
+		return &m_voiceStealingModel;
+	}
+
 
 signals:
 	void instrumentChanged();
@@ -218,6 +243,28 @@ protected slots:
 
 
 private:
+	// registration of OfflineRenderContexts rendering notes of this
+	// track - returns false if rendering is disabled at the moment
+	bool addOfflineRenderContext( OfflineRenderContext * _context );
+	void removeOfflineRenderContext( OfflineRenderContext * _context );
+
+	// abort all running OfflineRenderContexts, wait for them to finish
+	// and refuse new ones until enableOfflineRendering() is called -
+	// needed before touching the instrument
+	void disableOfflineRendering();
+	void enableOfflineRendering();
+
+	// voice-management, called by notePlayHandle - adding a voice steals
+	// voices of this track if either the limit of the track or the global
+	// one of the mixer is exceeded
+	void addVoice( notePlayHandle * _n );
+	void removeVoice( notePlayHandle * _n );
+	void stealVoice( notePlayHandle * _n );
+
+	// following methods require m_voicesMutex to be locked
+	notePlayHandle * voiceToSteal( const notePlayHandle * _n );
+	void markVoiceStolen( notePlayHandle * _n );
+
 	AudioPort m_audioPort;
 	MidiPort m_midiPort;
 
@@ -234,7 +281,12 @@ private:
 	FloatModel m_pitchModel;
 	IntModel m_pitchRangeModel;
 	IntModel m_effectChannelModel;
+	IntModel m_maxVoicesModel;
+	ComboBoxModel m_voiceStealingModel;
 
+	QMutex m_voicesMutex;
+	NotePlayHandleList m_voices;
+	int m_activeVoices;				// voices not stolen yet
 
 	Instrument * m_instrument;
 	InstrumentSoundShaping m_soundShaping;
@@ -243,10 +295,16 @@ private:
 
 	Piano m_piano;
 
+	QMutex m_offlineRenderMutex;
+	QWaitCondition m_offlineRenderDone;
+	QList<OfflineRenderContext *> m_offlineRenderContexts;
+	int m_offlineRenderDisabled;
+
 
 	friend class InstrumentTrackView;
 	friend class InstrumentTrackWindow;
 	friend class notePlayHandle;
+	friend class OfflineRenderContext;
 	friend class FlpImport;
 
 } ;
@@ -396,6 +454,8 @@ private:
 	knob * m_pitchKnob;
 	lcdSpinBox* m_pitchRangeSpinBox;
 	lcdSpinBox * m_effectChannelNumber;
+	lcdSpinBox * m_maxVoicesSpinBox;
+	comboBox * m_voiceStealingComboBox;
 
 
 	// tab-widget with all children
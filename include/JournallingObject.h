@@ -149,6 +149,9 @@ public:
 		return oldJournalling;
 	}
 
+	// called by ProjectJournal when dropping oldest undo-step
+	void forgetOldestJournalEntry();
+
 
 protected:
 	void changeID( jo_id_t _id );
@@ -163,6 +166,15 @@ protected:
 	{
 	}
 
+	// sub-objects can merge _je into _last (the latest entry) so that
+	// continuous changes end up in one undo-step - return false if not
+	// possible
+	virtual bool mergeJournalEntries( JournalEntry &,
+						const JournalEntry & )
+	{
+		return false;
+	}
+
 
 private:
 	void saveJournal( QDomDocument & _doc, QDomElement & _parent );
@@ -0,0 +1,122 @@
+/*
+ * LocklessRingBuffer.h - single-producer/single-consumer FIFO which doesn't
+ *                        need any locks
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _LOCKLESS_RING_BUFFER_H
+#define _LOCKLESS_RING_BUFFER_H
+
+#include "atomic_int.h"
+
+
+// Passes elements from exactly one writing thread to exactly one reading
+// thread without locking and without allocating memory, therefore it can be
+// used from and to realtime-threads (e.g. the mixer). _size has to be a power
+// of 2, one element is always kept free for distinguishing a full from an
+// empty buffer.
+template<typename T, int _size>
+class LocklessRingBuffer
+{
+public:
+	LocklessRingBuffer() :
+		m_readIndex( 0 ),
+		m_writeIndex( 0 )
+	{
+	}
+
+	// returns false if buffer is full - to be called by writer only
+	bool write( const T & _element )
+	{
+		const int w = m_writeIndex;
+		const int next = ( w + 1 ) & ( _size - 1 );
+		if( next == m_readIndex.fetchAndAddOrdered( 0 ) )
+		{
+			return false;
+		}
+		m_buffer[w] = _element;
+		m_writeIndex.fetchAndStoreOrdered( next );
+		return true;
+	}
+
+	// returns false if buffer is empty - to be called by reader only
+	bool read( T & _element )
+	{
+		const int r = m_readIndex;
+		if( r == m_writeIndex.fetchAndAddOrdered( 0 ) )
+		{
+			return false;
+		}
+		_element = m_buffer[r];
+		m_readIndex.fetchAndStoreOrdered( ( r + 1 ) & ( _size - 1 ) );
+		return true;
+	}
+
+	// writes as many of given elements as there's space for and returns
+	// their number - to be called by writer only
+	int write( const T * _elements, const int _count )
+	{
+		int w = m_writeIndex;
+		const int r = m_readIndex.fetchAndAddOrdered( 0 );
+		const int space = ( r - w - 1 ) & ( _size - 1 );
+		const int n = qMin( _count, space );
+		for( int i = 0; i < n; ++i )
+		{
+			m_buffer[w] = _elements[i];
+			w = ( w + 1 ) & ( _size - 1 );
+		}
+		m_writeIndex.fetchAndStoreOrdered( w );
+		return n;
+	}
+
+	// reads up to _count elements and returns their number - to be called
+	// by reader only
+	int read( T * _elements, const int _count )
+	{
+		int r = m_readIndex;
+		const int w = m_writeIndex.fetchAndAddOrdered( 0 );
+		const int n = qMin( _count, ( w - r ) & ( _size - 1 ) );
+		for( int i = 0; i < n; ++i )
+		{
+			_elements[i] = m_buffer[r];
+			r = ( r + 1 ) & ( _size - 1 );
+		}
+		m_readIndex.fetchAndStoreOrdered( r );
+		return n;
+	}
+
+	bool isEmpty()
+	{
+		return m_readIndex.fetchAndAddOrdered( 0 ) ==
+					m_writeIndex.fetchAndAddOrdered( 0 );
+	}
+
+
+private:
+	T m_buffer[_size];
+	AtomicInt m_readIndex;
+	AtomicInt m_writeIndex;
+
+} ;
+
+
+#endif
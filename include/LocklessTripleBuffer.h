@@ -0,0 +1,90 @@
+/*
+ * LocklessTripleBuffer.h - passes latest version of some data from one thread
+ *                          to another without locking
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _LOCKLESS_TRIPLE_BUFFER_H
+#define _LOCKLESS_TRIPLE_BUFFER_H
+
+#include "atomic_int.h"
+
+
+// Unlike LocklessRingBuffer this doesn't queue anything - the writer always
+// fills a private back-buffer and publishes it as a whole, the reader always
+// gets the latest published one. Neither side ever waits for the other one,
+// which makes it suitable for handing data from the mixer to the GUI.
+template<typename T>
+class LocklessTripleBuffer
+{
+public:
+	LocklessTripleBuffer() :
+		m_front( 0 ),
+		m_back( 2 ),
+		m_middle( 1 )
+	{
+	}
+
+	// buffer the writer can fill - to be called by writer only
+	T & back()
+	{
+		return m_buffers[m_back];
+	}
+
+	// make back-buffer available to reader - to be called by writer only
+	void publish()
+	{
+		m_back = m_middle.fetchAndStoreOrdered( m_back | NewDataFlag ) &
+								IndexMask;
+	}
+
+	// returns latest published data - the reference stays valid until
+	// next call - to be called by reader only
+	const T & front()
+	{
+		if( m_middle.fetchAndAddOrdered( 0 ) & NewDataFlag )
+		{
+			m_front = m_middle.fetchAndStoreOrdered( m_front ) &
+								IndexMask;
+		}
+		return m_buffers[m_front];
+	}
+
+
+private:
+	enum
+	{
+		IndexMask = 3,
+		NewDataFlag = 4
+	} ;
+
+	T m_buffers[3];
+	int m_front;
+	int m_back;
+	// index of middle buffer and flag whether it was published since
+	// reader took it the last time
+	AtomicInt m_middle;
+
+} ;
+
+
+#endif
@@ -31,6 +31,10 @@
 #include <sys/time.h>
 #endif
 
+#ifdef LMMS_BUILD_LINUX
+#include <time.h>
+#endif
+
 #include <cstdlib>
 #include "lmms_basics.h"
 
@@ -60,6 +64,22 @@ public:
 					( now.tv_usec - begin.tv_usec );
 	}
 
+	// returns current time in microseconds - on Linux the clock is
+	// monotonic, i.e. not affected by changes of system-time, therefore
+	// it's suitable for timestamping events
+	static inline int64_t now()
+	{
+#ifdef LMMS_BUILD_LINUX
+		struct timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		return (int64_t) ts.tv_sec * 1000 * 1000 + ts.tv_nsec / 1000;
+#else
+		struct timeval tv;
+		gettimeofday( &tv, NULL );
+		return (int64_t) tv.tv_sec * 1000 * 1000 + tv.tv_usec;
+#endif
+	}
+
 
 private:
 	struct timeval begin;
@@ -34,6 +34,7 @@
 #include <QtCore/QMutex>
 #include <QtCore/QThread>
 #include <QtCore/QTimer>
+#include <QtCore/QVector>
 
 
 #include "MidiClient.h"
@@ -140,6 +141,18 @@ private:
 		private: int p[2];
 	} ;
 	QMap<MidiPort *, Ports> m_portIDs;
+
+	// flat table indexed by ALSA-port-ID for routing incoming events
+	// without searching m_portIDs - rebuilt whenever m_portIDs changes
+	struct PortRoute
+	{
+		MidiPort * dest;	// port receiving events sent to this ID
+		bool ours;		// ID belongs to one of our ports
+	} ;
+	QVector<PortRoute> m_portRoutes;
+
+	// m_seqMutex has to be locked by caller
+	void updatePortRoutes();
 #endif
 
 	int m_queueID;
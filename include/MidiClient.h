@@ -59,6 +59,10 @@ public:
 	// re-implemented methods HAVE to call removePort() of base-class!!
 	virtual void removePort( MidiPort * _port );
 
+	// called by mixer at the beginning of each period for delivering
+	// input-events queued by all ports
+	void processQueuedInEvents( const int64_t _period_start );
+
 
 	// returns whether client works with raw-MIDI, only needs to be
 	// re-implemented by MidiClientRaw for returning true
@@ -31,13 +31,14 @@
 #include <QtCore/QPair>
 
 #include "midi.h"
+#include "midi_time.h"
 #include "AutomatableModel.h"
+#include "LocklessRingBuffer.h"
 
 
 class MidiClient;
 class MidiEventProcessor;
 class MidiPortMenu;
-class midiTime;
 
 
 // class for abstraction of MIDI-port
@@ -104,9 +105,18 @@ public:
 		return outputChannel() - 1;
 	}
 
+	// called by MIDI-client (usually from its own thread) - the event is
+	// timestamped and queued until the mixer delivers it
 	void processInEvent( const midiEvent & _me, const midiTime & _time );
 	void processOutEvent( const midiEvent & _me, const midiTime & _time );
 
+	// called by mixer at the beginning of each period - delivers all
+	// events queued since _period_start (time in microseconds, see
+	// MicroTimer::now()) with according offset within the period
+	// controller-changes and pitch-bends which are superseded by later
+	// ones of the same period are dropped
+	void processQueuedInEvents( const int64_t _period_start );
+
 
 	virtual void saveSettings( QDomDocument & _doc, QDomElement & _parent );
 	virtual void loadSettings( const QDomElement & _this );
@@ -146,11 +156,22 @@ private slots:
 
 
 private:
+	struct QueuedInEvent
+	{
+		midiEvent event;
+		midiTime time;
+		int64_t timestamp;
+	} ;
+
 	MidiClient * m_midiClient;
 	MidiEventProcessor * m_midiEventProcessor;
 
 	Modes m_mode;
 
+	// written by thread of MIDI-client, read by mixer
+	static const int InEventQueueSize = 1024;
+	LocklessRingBuffer<QueuedInEvent, InEventQueueSize> m_inEvents;
+
 	IntModel m_inputChannelModel;
 	IntModel m_outputChannelModel;
 	IntModel m_inputControllerModel;
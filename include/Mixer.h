@@ -47,6 +47,7 @@
 #include "lmms_basics.h"
 #include "note.h"
 #include "fifo_buffer.h"
+#include "LocklessTripleBuffer.h"
 
 
 class AudioDevice;
@@ -63,6 +64,15 @@ const int BYTES_PER_SURROUND_FRAME = sizeof( surroundSampleFrame );
 
 const float OUTPUT_SAMPLE_MULTIPLIER = 32767.0f;
 
+// global voice-limit if not configured otherwise
+const int DefaultMaxVoices = 256;
+// CPU-load (percent) above which voice-limits are scaled down
+const int VoiceBudgetLoad = 70;
+// released notes are stopped once their output stayed below this level
+// (dBFS) for the given number of periods, if not configured otherwise
+const float DefaultSilenceThreshold = -96.0f;
+const int DefaultSilentPeriods = 8;
+
 
 const float BaseFreq = 440.0f;
 const Keys BaseKey = Key_A;
@@ -260,6 +270,80 @@ public:
 		return m_cpuLoad;
 	}
 
+	// stages of renderNextBuffer() whose durations are accumulated for
+	// profiling
+	enum ProfileStages
+	{
+		StagePrepare,		// removing handles, song, MIDI
+		StagePlayHandles,
+		StageAudioPortEffects,
+		StageFxChannels,
+		StageMasterMix,
+		NumProfileStages
+	} ;
+
+	// total time spent in given stage in microseconds since last call of
+	// resetProfile()
+	inline int64_t stageTime( ProfileStages _stage ) const
+	{
+		return m_stageTimes[_stage];
+	}
+
+	inline int profiledPeriods() const
+	{
+		return m_profiledPeriods;
+	}
+
+	void resetProfile();
+
+	// voice-budget - limits of voices are scaled by voiceBudgetScale()
+	// which drops below 1 if we're running out of CPU in realtime mode
+	inline float voiceBudgetScale() const
+	{
+		return m_voiceBudgetScale;
+	}
+
+	// maximum number of voices of all instrument-tracks together
+	inline int maxVoices() const
+	{
+		return qMax( 1, (int)( m_maxVoices * m_voiceBudgetScale ) );
+	}
+
+	// same as configured by user, i.e. without applying voice-budget
+	inline int configuredMaxVoices() const
+	{
+		return m_maxVoices;
+	}
+
+	// number of voices currently playing (stolen ones not included) -
+	// addVoice() and removeVoice() return the new number
+	inline int addVoice()
+	{
+		return m_voiceCount.fetchAndAddOrdered( 1 ) + 1;
+	}
+
+	inline int removeVoice()
+	{
+		return m_voiceCount.fetchAndAddOrdered( -1 ) - 1;
+	}
+
+	inline int voiceCount()
+	{
+		return m_voiceCount.fetchAndAddOrdered( 0 );
+	}
+
+	// released notes whose output stays below silenceThreshold() (as
+	// amplitude) for silentPeriods() periods are stopped
+	inline float silenceThreshold() const
+	{
+		return m_silenceThreshold;
+	}
+
+	inline int silentPeriods() const
+	{
+		return m_silentPeriods;
+	}
+
 	const qualitySettings & currentQualitySettings() const
 	{
 		return m_qualitySettings;
@@ -338,6 +422,42 @@ public:
 	static float peakValueRight( sampleFrame * _ab, const f_cnt_t _frames );
 
 
+	// decimated master-output of one period for oscilloscope-like
+	// displays - each column holds minimum and maximum of the frames it
+	// covers
+	struct ScopeColumn
+	{
+		sample_t min[DEFAULT_CHANNELS];
+		sample_t max[DEFAULT_CHANNELS];
+	} ;
+
+	struct ScopeData
+	{
+		enum { MaxColumns = 256 };
+
+		ScopeData() :
+			numColumns( 0 ),
+			peak( 0.0f )
+		{
+		}
+
+		ScopeColumn columns[MaxColumns];
+		int numColumns;
+		sample_t peak;		// absolute peak of all channels
+	} ;
+
+	// scope-data is only computed while at least one user is registered
+	void addScopeUser();
+	void removeScopeUser();
+
+	// latest scope-data - must only be called from one thread (usually
+	// the GUI-thread) and reference is valid until next call
+	inline const ScopeData & scopeData()
+	{
+		return m_scopeData.front();
+	}
+
+
 	bool criticalXRuns() const;
 
 	inline bool hasFifoWriter() const
@@ -405,6 +525,8 @@ private:
 
 	const surroundSampleFrame * renderNextBuffer();
 
+	void updateScopeData( const surroundSampleFrame * _buf );
+
 
 
 	QVector<AudioPort *> m_audioPorts;
@@ -434,6 +556,17 @@ private:
 	bool m_newBuffer[SURROUND_CHANNELS];
 	
 	int m_cpuLoad;
+	int64_t m_stageTimes[NumProfileStages];
+	int m_profiledPeriods;
+	float m_voiceBudgetScale;
+	int m_maxVoices;
+	AtomicInt m_voiceCount;
+	float m_silenceThreshold;
+	int m_silentPeriods;
+
+	LocklessTripleBuffer<ScopeData> m_scopeData;
+	AtomicInt m_scopeUsers;
+
 	QVector<MixerWorkerThread *> m_workers;
 	int m_numWorkers;
 	QWaitCondition m_queueReadyWaitCond;
@@ -453,6 +586,9 @@ private:
 
 	MidiClient * m_midiClient;
 	QString m_midiClientName;
+	// time at which rendering of last period started, used for placing
+	// MIDI-input-events within the period
+	int64_t m_periodStartTime;
 
 
 	QMutex m_globalMutex;
@@ -0,0 +1,90 @@
+/*
+ * ObjectPool.h - recycles plain-data objects of fixed size
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _OBJECT_POOL_H
+#define _OBJECT_POOL_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
+
+// Hands out objects of type T from contiguous blocks of _block_size objects
+// and keeps released ones for re-use, so e.g. starting notes doesn't hit the
+// general-purpose allocator in most cases. T has to be plain data as neither
+// constructors nor destructors are called for recycled objects. Objects must
+// not be used after the pool has been destroyed.
+template<typename T, int _block_size = 64>
+class ObjectPool
+{
+public:
+	ObjectPool() :
+		m_mutex(),
+		m_blocks(),
+		m_free()
+	{
+	}
+
+	~ObjectPool()
+	{
+		for( int i = 0; i < m_blocks.size(); ++i )
+		{
+			delete[] m_blocks[i];
+		}
+	}
+
+	T * allocate()
+	{
+		QMutexLocker ml( &m_mutex );
+		if( m_free.isEmpty() )
+		{
+			T * block = new T[_block_size];
+			m_blocks.push_back( block );
+			// release() never has to grow free-list afterwards
+			m_free.reserve( m_blocks.size() * _block_size );
+			for( int i = _block_size - 1; i >= 0; --i )
+			{
+				m_free.push_back( block + i );
+			}
+		}
+		T * t = m_free.last();
+		m_free.pop_back();
+		return t;
+	}
+
+	void release( T * _t )
+	{
+		QMutexLocker ml( &m_mutex );
+		m_free.push_back( _t );
+	}
+
+
+private:
+	QMutex m_mutex;
+	QVector<T *> m_blocks;
+	QVector<T *> m_free;
+
+} ;
+
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * OfflineRenderContext.h - renders notes of an instrument-track into a
+ *                          sample-buffer without involving the mixer
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _OFFLINE_RENDER_CONTEXT_H
+#define _OFFLINE_RENDER_CONTEXT_H
+
+#include <QtCore/QList>
+#include <QtCore/QVector>
+
+#include "Mixer.h"
+#include "midi_time.h"
+
+
+class InstrumentTrack;
+class note;
+class pattern;
+class SampleBuffer;
+
+
+// An OfflineRenderContext plays notes of an instrument-track on its own,
+// i.e. it creates the note-play-handles itself and collects their output
+// instead of sending it to the track's audio-port. Therefore it can run in
+// any thread while the mixer keeps on playing. The output contains
+// envelopes, volume and panning of the track but neither the effects of the
+// track nor the FX mixer - these are applied when the rendered sample is
+// played back through the track (like it's done for frozen patterns).
+class EXPORT OfflineRenderContext
+{
+public:
+	OfflineRenderContext( InstrumentTrack * _track );
+	~OfflineRenderContext();
+
+	// returns whether instrument of given track can be rendered that way,
+	// see Instrument::supportsOfflineRendering()
+	static bool isSupported( const InstrumentTrack * _track );
+
+	// take a copy of all notes of given pattern - has to be called
+	// from the thread owning the pattern (usually GUI-thread)
+	void addPattern( const pattern * _pattern,
+					const midiTime & _start = midiTime( 0 ) );
+
+	// length of all added patterns
+	const midiTime & length() const
+	{
+		return m_length;
+	}
+
+	// render all added notes including their release - returns NULL if
+	// rendering was aborted or the track went away, otherwise a new
+	// sample-buffer; _progress is updated (0-100) while rendering
+	SampleBuffer * render( volatile int * _progress = NULL );
+
+	// abort a running render() - can be called from any thread
+	void abort()
+	{
+		m_aborted = true;
+	}
+
+	bool isAborted() const
+	{
+		return m_aborted;
+	}
+
+	// note-play-handles currently played by this context (used instead of
+	// mixer's play-handles e.g. by arpeggio)
+	const PlayHandleList & playHandles() const
+	{
+		return m_playHandles;
+	}
+
+	// called by InstrumentTrack::processAudioBuffer() for notes played by
+	// this context - counterpart of Mixer::bufferToPort()
+	void bufferToContext( const sampleFrame * _buf, const fpp_t _frames,
+				const f_cnt_t _offset, stereoVolumeVector _vv );
+
+
+private:
+	struct NoteEntry
+	{
+		note * n;
+		midiTime start;		// position of pattern
+	} ;
+	typedef QVector<NoteEntry> NoteEntryVector;
+
+	void startNotes( const midiTime & _from, const midiTime & _to,
+						const f_cnt_t _offset );
+	void clearPlayHandles();
+
+	InstrumentTrack * m_track;
+	NoteEntryVector m_notes;
+	midiTime m_length;
+
+	PlayHandleList m_playHandles;
+
+	// like AudioPort, output of a note might exceed the current period
+	sampleFrame * m_firstBuffer;
+	sampleFrame * m_secondBuffer;
+
+	volatile bool m_aborted;
+
+} ;
+
+
+#endif
@@ -68,9 +68,17 @@ public:
 	} ;
 
 
+	// per-voice state of one oscillator - an array of these (one for each
+	// oscillator of a chain, head first) is all a voice has to keep, while
+	// oscillators themselves are shared by all voices of an instrument
+	struct State
+	{
+		float phaseOffset;
+		float phase;
+	} ;
+
 	Oscillator( const IntModel * _wave_shape_model,
 			const IntModel * _mod_algo_model,
-			const float & _freq,
 			const float & _detuning,
 			const float & _phase_offset,
 			const float & _volume,
@@ -81,13 +89,26 @@ public:
 	}
 
 
+	// number of oscillators in chain, i.e. of states a voice needs
+	int chainLength() const
+	{
+		return m_subOsc != NULL ? m_subOsc->chainLength() + 1 : 1;
+	}
+
+	// sets up states of a new voice
+	void initState( State * _state ) const;
+
 	inline void setUserWave( const SampleBuffer * _wave )
 	{
 		m_userWave = _wave;
 	}
 
+	// renders next _frames of voice with given frequency and states -
+	// doesn't modify the oscillator, so it can be called for several
+	// voices simultaneously
 	void update( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 
 	// now follow the wave-shape-routines...
 
@@ -158,56 +179,67 @@ public:
 private:
 	const IntModel * m_waveShapeModel;
 	const IntModel * m_modulationAlgoModel;
-	const float & m_freq;
 	const float & m_detuning;
 	const float & m_volume;
 	const float & m_ext_phaseOffset;
 	Oscillator * m_subOsc;
-	float m_phaseOffset;
-	float m_phase;
 	const SampleBuffer * m_userWave;
 
 
 	void updateNoSub( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	void updatePM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	void updateAM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	void updateMix( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	void updateSync( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	void updateFM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 
 	float syncInit( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
-	inline bool syncOk( float _osc_coeff );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
+	static inline bool syncOk( float _osc_coeff, State * _state );
 
 	template<WaveShapes W>
 	void updateNoSub( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	template<WaveShapes W>
 	void updatePM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	template<WaveShapes W>
 	void updateAM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	template<WaveShapes W>
 	void updateMix( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	template<WaveShapes W>
 	void updateSync( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 	template<WaveShapes W>
 	void updateFM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const;
 
 	template<WaveShapes W>
-	inline sample_t getSample( const float _sample );
+	inline sample_t getSample( const float _sample ) const;
+
+	inline void recalcPhase( State * _state ) const;
 
-	inline void recalcPhase();
 
 } ;
 
@@ -26,9 +26,13 @@
 #define _PROJECT_JOURNAL_H
 
 #include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QTime>
 #include <QtCore/QVariant>
 #include <QtCore/QVector>
 
+#include <list>
+
 #include "lmms_basics.h"
 
 class JournallingObject;
@@ -37,14 +41,33 @@ class JournallingObject;
 class ProjectJournal
 {
 public:
+	enum
+	{
+		// entries of the same object following each other within
+		// this period (in ms) are merged into one undo-step
+		CoalesceInterval = 500,
+		// default upper limit of memory used for history in MB
+		DefaultMaxJournalSize = 16
+	} ;
+
 	ProjectJournal();
 	virtual ~ProjectJournal();
 
 	void undo();
 	void redo();
 
-	// tell history that a new journal entry was added to object with ID _id
-	void journalEntryAdded( const jo_id_t _id );
+	// tell history that a new journal entry of approximately _size bytes
+	// was added to object with ID _id
+	void journalEntryAdded( const jo_id_t _id, const int _size );
+
+	// returns whether object with ID _id may merge a new journal entry
+	// into its latest one instead of adding a new entry, i.e. whether
+	// latest undo-step belongs to this object and is recent enough
+	bool canCoalesce( const jo_id_t _id ) const;
+
+	// tell history that object with ID _id merged a new journal entry
+	// into its latest one
+	void journalEntryCoalesced( const jo_id_t _id );
 
 	bool isJournalling() const
 	{
@@ -89,13 +112,43 @@ public:
 
 
 private:
+	struct Entry
+	{
+		jo_id_t id;
+		int size;
+	} ;
+
 	typedef QHash<jo_id_t, JournallingObject *> JoIdMap;
-	typedef QVector<jo_id_t> JournalEntryVector;
+	// iterators of std::list stay valid when removing other elements
+	typedef std::list<Entry> JournalEntryList;
+	typedef QList<JournalEntryList::iterator> EntryPositions;
+
+	// remove entry which has to be the oldest or the newest one of its ID
+	void removeEntry( JournalEntryList::iterator _it );
+	// remove all steps which can be redone
+	void removeRedoEntries();
+
+	// drop oldest undo-steps until history fits into m_maxJournalSize
+	void trimJournal();
+
 
 	JoIdMap m_joIDs;
 
-	JournalEntryVector m_journalEntries;
-	JournalEntryVector::Iterator m_currentJournalEntry;
+	JournalEntryList m_journalEntries;
+	// next step to redo, end() if there's nothing to redo
+	JournalEntryList::iterator m_currentJournalEntry;
+
+	// positions of entries in m_journalEntries per ID (oldest first), so
+	// that all entries of an object are removed without searching for them
+	QHash<jo_id_t, EntryPositions> m_entryPositions;
+
+	int m_journalSize;
+	int m_maxJournalSize;
+	QTime m_lastEntryTime;
+
+	// IDs which can be handed out again
+	QVector<jo_id_t> m_freeIDs;
+	jo_id_t m_nextID;
 
 	bool m_journalling;
 
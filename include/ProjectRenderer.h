@@ -76,6 +76,13 @@ public:
 		return m_fileDev != NULL;
 	}
 
+	// print realtime-factor, timings of mixer-stages, allocations and
+	// memory-usage to stdout when done
+	void setProfiling( bool _on )
+	{
+		m_profiling = _on;
+	}
+
 	static ExportFileFormats getFileFormatFromExtension(
 							const QString & _ext );
 
@@ -100,6 +107,9 @@ private:
 
 	volatile int m_progress;
 	volatile bool m_abort;
+	bool m_profiling;
+
+	void printProfile( int _periods, int64_t _wall_time );
 
 } ;
 
@@ -0,0 +1,122 @@
+/*
+ * RenderServer.h - renders projects on request of local clients
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _RENDER_SERVER_H
+#define _RENDER_SERVER_H
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QStringList>
+#include <QtNetwork/QLocalSocket>
+
+#include "ProjectRenderer.h"
+
+
+class QLocalServer;
+
+
+// Keeps engine, plugins and sample-cache alive between renderings and accepts
+// jobs through a local socket (a UNIX domain socket on POSIX systems), so
+// render-farms don't pay for starting up LMMS once per project. The protocol
+// is line-based, fields are separated by tabs:
+//
+//   render <project> <output> [<option>=<value> ...]
+//	-> queued <id>
+//	-> progress <id> <percent>	(repeatedly)
+//	-> done <id> <output> | failed <id> <reason>
+//   cancel <id>		-> cancelled <id> | error <reason>
+//   status			-> job <id> <state> <project> (for each job), end
+//   quit			-> bye (server exits after current job)
+//
+// Options are format (wav, ogg), samplerate, bitrate, depth (16, 32), vbr
+// (0, 1), interpolation (linear, sincfastest, sincmedium, sincbest) and
+// oversampling (1, 2, 4, 8). Jobs are processed one after another as there's
+// only one engine per process.
+class RenderServer : public QObject
+{
+	Q_OBJECT
+public:
+	RenderServer( const QString & _socket_name );
+	virtual ~RenderServer();
+
+	bool isListening() const;
+
+	// seed RNG with given value before each job (--seed)
+	void setSeed( unsigned int _seed );
+
+
+private slots:
+	void acceptConnection();
+	void readCommands();
+	void updateProgress( int _progress );
+	void jobFinished();
+
+
+private:
+	struct Job
+	{
+		Job() :
+			id( 0 ),
+			qs( Mixer::qualitySettings::Mode_HighQuality ),
+			os( 44100, false, 160, ProjectRenderer::Depth_16Bit ),
+			format( ProjectRenderer::WaveFile ),
+			client(),
+			cancelled( false )
+		{
+		}
+
+		int id;
+		QString project;
+		QString output;
+		Mixer::qualitySettings qs;
+		ProjectRenderer::OutputSettings os;
+		ProjectRenderer::ExportFileFormats format;
+		// may become NULL if client disconnects meanwhile
+		QPointer<QLocalSocket> client;
+		bool cancelled;
+	} ;
+
+	void handleCommand( QLocalSocket * _client,
+						const QStringList & _fields );
+	// returns empty string on success, reason otherwise
+	QString parseOption( Job & _job, const QString & _option );
+	void startNextJob();
+
+	static void reply( QLocalSocket * _client, const QStringList & _fields );
+
+	QLocalServer * m_server;
+
+	QList<Job> m_jobs;	// first one is being processed if m_renderer
+	ProjectRenderer * m_renderer;
+	int m_lastProgress;
+	int m_nextId;
+	bool m_quit;
+	bool m_fixedSeed;
+	unsigned int m_seed;
+
+} ;
+
+
+#endif
@@ -39,7 +39,11 @@
 #include "shared_object.h"
 
 
+class QFile;
 class QPainter;
+class SamplePeaks;
+class SamplePeaksBuilder;
+class SharedSampleData;
 
 
 class EXPORT SampleBuffer : public QObject, public sharedObject
@@ -172,6 +176,13 @@ public:
 		return m_data;
 	}
 
+	// returns whether sample-data is streamed from a memory-mapped
+	// cache-file rather than held in memory
+	inline bool isStreamed() const
+	{
+		return m_streamFile != NULL;
+	}
+
     QString openAudioFile() const;
     QString openAndSetAudioFile();
 
@@ -215,6 +226,12 @@ public:
 		return m_data[f1][0];
 	}
 
+	// decodes given file at base sample-rate without amplification and
+	// reversing (used by SampleCache) - files which would be streamed
+	// are not decoded
+	static bool decodeFile( const QString & _file, sampleFrame * & _data,
+							f_cnt_t & _frames );
+
 	static QString tryToMakeRelative( const QString & _file );
 	static QString tryToMakeAbsolute( const QString & _file );
 
@@ -230,6 +247,11 @@ public slots:
 
 private:
 	void update( bool _keep_settings = false );
+	void freeData();
+
+	bool loadFromCache( const QString & _file, bool _keep_settings );
+	bool decodeAudioFile( const QString & _file, bool _keep_settings,
+					bool _allow_streaming = true );
 
     void convertIntToFloat ( int_sample_t * & _ibuf, f_cnt_t _frames, int _channels);
     void directFloatWrite ( sample_t * & _fbuf, f_cnt_t _frames, int _channels);
@@ -245,6 +267,9 @@ private:
 	f_cnt_t decodeSampleDS( const char * _f, int_sample_t * & _buf,
 						ch_cnt_t & _channels,
 						sample_rate_t & _sample_rate );
+	// decodes big files into a memory-mapped cache-file, returns false
+	// if file is too small for streaming or cannot be decoded that way
+	bool decodeSampleStreamed( const char * _f, bool _keep_settings );
 
 	QString m_audioFile;
 	sampleFrame * m_origData;
@@ -261,6 +286,19 @@ private:
 	float m_frequency;
 	sample_rate_t m_sampleRate;
 
+	// cache-file m_data is mapped from when streaming
+	QFile * m_streamFile;
+	// last playback position, used for read-ahead
+	volatile f_cnt_t m_streamPosition;
+
+	// cache-entry m_data belongs to if it's shared with other buffers
+	SharedSampleData * m_sharedData;
+
+	// min/max-pyramid of m_data for visualize() - taken from cache-entry
+	// or built in background on first use
+	SamplePeaks * m_peaks;
+	SamplePeaksBuilder * m_peaksBuilder;
+
 	sampleFrame * getSampleFragment( f_cnt_t _start, f_cnt_t _frames,
 						bool _looped,
 						sampleFrame * * _tmp ) const;
@@ -270,6 +308,9 @@ private:
 signals:
 	void sampleUpdated();
 
+
+	friend class SampleStreamer;
+
 } ;
 
 
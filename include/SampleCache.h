@@ -0,0 +1,148 @@
+/*
+ * SampleCache.h - shared, prefetched and persistently cached sample-data
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _SAMPLE_CACHE_H
+#define _SAMPLE_CACHE_H
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
+
+#include "export.h"
+#include "lmms_basics.h"
+
+
+class QDomElement;
+class SamplePeaks;
+
+
+// decoded sample-data of one file at base sample-rate, shared by all
+// SampleBuffers using this file without amplification and reversing
+class SharedSampleData
+{
+public:
+	const sampleFrame * data() const
+	{
+		return m_data;
+	}
+
+	f_cnt_t frames() const
+	{
+		return m_frames;
+	}
+
+
+private:
+	SharedSampleData( const QString & _file, const QString & _key );
+	~SharedSampleData();
+
+	QString m_file;
+	QString m_key;
+	sampleFrame * m_data;
+	f_cnt_t m_frames;
+	SamplePeaks * m_peaks;	// built in background, NULL until then
+	int m_refs;
+	bool m_pinned;		// prefetched but not yet used
+	bool m_ready;		// decoding has finished
+
+	friend class SampleCache;
+	friend class SampleDecoderJob;
+
+} ;
+
+
+
+
+// keeps decoded sample-data of all files currently used so identical files
+// are decoded only once, decodes files of a project in parallel while it is
+// being loaded and stores decoded data in the working-directory so that it
+// doesn't have to be decoded again next time
+class EXPORT SampleCache
+{
+public:
+	static SampleCache * inst();
+
+	// start decoding all sample-files referenced in given project in
+	// background
+	void prefetchProject( const QDomElement & _content );
+	void prefetch( const QStringList & _files );
+
+	// drop prefetched data nobody asked for - to be called after
+	// project has been loaded
+	void finishPrefetch();
+
+	// returns a new reference to decoded data of given (absolute) file
+	// or NULL if file is neither prefetched nor in disk-cache - waits
+	// for prefetching of this file to finish
+	SharedSampleData * acquire( const QString & _file );
+
+	// hands over data decoded by caller - returns a reference to the
+	// entry for given file which might contain other data if someone
+	// else was faster in which case _data is deleted
+	SharedSampleData * adopt( const QString & _file, sampleFrame * _data,
+						const f_cnt_t _frames );
+
+	void release( SharedSampleData * _shared );
+
+	// returns a new reference to peaks of given data or NULL if they
+	// aren't available (yet)
+	SamplePeaks * peaks( SharedSampleData * _shared );
+
+
+private:
+	SampleCache();
+	~SampleCache();
+
+	// file, modification-time and target sample-rate - empty if file
+	// doesn't exist
+	static QString cacheKey( const QString & _file );
+	static QString diskCacheFile( const QString & _key,
+					const char * _suffix = ".smp" );
+
+	// also loads peaks if they're in disk-cache
+	static bool loadFromDisk( SharedSampleData * _shared );
+	// peaks are always saved, data only if _with_data is set
+	static void saveToDisk( const SharedSampleData * _shared,
+							bool _with_data );
+	// removes least recently used files if disk-cache has grown too big
+	static void pruneDisk();
+
+	// called by decoder-job when finished - if _keep_ref is set, a
+	// reference is added which the job releases later on
+	void finishDecoding( SharedSampleData * _shared, bool _keep_ref );
+	void removeIfUnused( SharedSampleData * _shared );
+
+	QMutex m_mutex;
+	QWaitCondition m_decodingFinished;
+	QHash<QString, SharedSampleData *> m_entries;
+	QThreadPool m_pool;
+
+	friend class SampleDecoderJob;
+
+} ;
+
+
+#endif
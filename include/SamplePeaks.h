@@ -0,0 +1,94 @@
+/*
+ * SamplePeaks.h - min/max-pyramid of sample-data for fast waveform-drawing
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _SAMPLE_PEAKS_H
+#define _SAMPLE_PEAKS_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "export.h"
+#include "lmms_basics.h"
+#include "shared_object.h"
+
+
+// Minimum and maximum of blocks of 64, 512 and 4096 frames of some
+// sample-data. Values are the sums of both channels as drawn by
+// SampleBuffer::visualize(), so drawing a waveform costs O(pixels) at any
+// zoom-level instead of walking through all frames.
+class EXPORT SamplePeaks : public sharedObject
+{
+public:
+	enum
+	{
+		NumLevels = 3,
+		// ranges smaller than this are read from sample-data directly
+		MinBlockSize = 64
+	} ;
+
+	// walks through given data once - stops early (leaving the peaks
+	// incomplete) as soon as *_abort becomes true
+	SamplePeaks( const sampleFrame * _data, const f_cnt_t _frames,
+				const volatile bool * _abort = NULL );
+
+	// returns NULL if file doesn't exist or doesn't contain peaks of
+	// _frames frames
+	static SamplePeaks * load( const QString & _file,
+						const f_cnt_t _frames );
+	bool save( const QString & _file ) const;
+
+	inline f_cnt_t frames() const
+	{
+		return m_frames;
+	}
+
+	// determine minimum and maximum within frames [_from, _to) - the
+	// range is extended to the block-boundaries of the level used, _data
+	// has to be the data the peaks were built from
+	void getPeak( const sampleFrame * _data, f_cnt_t _from, f_cnt_t _to,
+					float & _min, float & _max ) const;
+
+
+private:
+	struct Peak
+	{
+		float min;
+		float max;
+	} ;
+	typedef QVector<Peak> PeakVector;
+
+	SamplePeaks( const f_cnt_t _frames );
+
+	static f_cnt_t blockSize( const int _level )
+	{
+		return MinBlockSize << ( 3 * _level );
+	}
+
+	f_cnt_t m_frames;
+	PeakVector m_levels[NumLevels];
+
+} ;
+
+
+#endif
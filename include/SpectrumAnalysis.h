@@ -0,0 +1,105 @@
+/*
+ * SpectrumAnalysis.h - computes spectra of audio-data in background
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _SPECTRUM_ANALYSIS_H
+#define _SPECTRUM_ANALYSIS_H
+
+#include <QtCore/QVector>
+
+#include <fftw3.h>
+
+#include "export.h"
+#include "lmms_basics.h"
+#include "LocklessRingBuffer.h"
+#include "LocklessTripleBuffer.h"
+
+
+// Samples pushed by one thread (usually an effect in the mixer) are analyzed
+// by a shared low-priority thread which performs Hann-windowed FFTs with 50%
+// overlap. The latest magnitude-spectrum can be read by another thread
+// (usually the GUI), so the pushing thread only pays for copying samples.
+class EXPORT SpectrumAnalysis
+{
+public:
+	enum
+	{
+		MaxFftSize = 8192
+	} ;
+
+	struct Result
+	{
+		Result() :
+			bins( 0 ),
+			peak( 0.0f ),
+			power( 0.0f )
+		{
+		}
+
+		float spectrum[MaxFftSize / 2 + 1];	// magnitudes of bins
+		int bins;		// 0 until first window was analyzed
+		float peak;		// maximum absolute value in window
+		float power;		// signal power of window
+	} ;
+
+	// _fft_size has to be a power of 2 not bigger than MaxFftSize
+	SpectrumAnalysis( const int _fft_size );
+	~SpectrumAnalysis();
+
+	inline int fftSize() const
+	{
+		return m_fftSize;
+	}
+
+	// never blocks - samples are dropped if the analysis-thread can't
+	// keep up
+	void pushSamples( const sample_t * _samples, const int _count );
+
+	// latest result, reference is valid until next call
+	inline const Result & result()
+	{
+		return m_results.front();
+	}
+
+
+private:
+	// called by analysis-thread with a (cached) plan for m_fftSize and
+	// its input-/output-buffers
+	void analyze( fftwf_plan _plan, float * _in, fftwf_complex * _out );
+
+	const int m_fftSize;
+	LocklessRingBuffer<sample_t, MaxFftSize * 4> m_input;
+
+	// only used by analysis-thread
+	QVector<float> m_window;
+	QVector<float> m_history;
+	int m_historyFrames;
+
+	LocklessTripleBuffer<Result> m_results;
+
+	friend class SpectrumAnalysisThread;
+
+} ;
+
+
+#endif
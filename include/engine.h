@@ -70,6 +70,12 @@ public:
 		return !s_hasGUI || s_suppressMessages;
 	}
 
+	// print time needed by each step of init() to stdout
+	static void setReportStartupTiming( bool _on )
+	{
+		s_reportStartupTiming = _on;
+	}
+
 	// core
 	static Mixer *mixer()
 	{
@@ -174,6 +180,7 @@ private:
 
 	static bool s_hasGUI;
 	static bool s_suppressMessages;
+	static bool s_reportStartupTiming;
 	static float s_framesPerTick;
 
 	// core
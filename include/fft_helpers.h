@@ -82,4 +82,11 @@ int EXPORT calc13octaveband31( float * _absspec_buffer, float * _subbands,
  */
 float EXPORT signalpower(float *timesignal, int num_values);
 
+/* serialize creation and destruction of FFTW plans - FFTW's planner isn't
+ * thread-safe, so everything in this process (including plugins) has to
+ * hold this lock around fftwf_plan_*() and fftwf_destroy_plan()
+ */
+void EXPORT fftwPlannerLock();
+void EXPORT fftwPlannerUnlock();
+
 #endif
@@ -50,7 +50,8 @@ class fileBrowser : public SideBarWidget
 public:
 	fileBrowser( const QString & _directories, const QString & _filter,
 			const QString & _title, const QPixmap & _pm,
-			QWidget * _parent, bool _dirs_as_items = false );
+			QWidget * _parent, bool _dirs_as_items = false,
+						bool _index_all = false );
 	virtual ~fileBrowser();
 
 
@@ -59,11 +60,18 @@ public slots:
 	void reloadTree( void );
 
 
+private slots:
+	void directoryScanned( const QString & _path );
+
+
 private:
 	bool filterItems( QTreeWidgetItem * _item, const QString & _filter );
+	bool directoryContainsMatch( QTreeWidgetItem * _item,
+						const QString & _filter );
 	virtual void keyPressEvent( QKeyEvent * _ke );
 
 	void addItems( const QString & _path );
+	void rebuildTopLevelItems( void );
 
 	fileBrowserTreeWidget * m_l;
 
@@ -71,6 +79,8 @@ private:
 
 	QString m_directories;
 	QString m_filter;
+	// top-level paths registered at FileBrowserIndex
+	QStringList m_watched;
 
 	bool m_dirsAsItems;
 
@@ -124,10 +134,14 @@ class directory : public QTreeWidgetItem
 {
 public:
 	directory( const QString & _filename, const QString & _path,
-						const QString & _filter );
+				const QString & _filter, bool _locked = false );
+	virtual ~directory();
 
 	void update( void );
 
+	// re-read contents from FileBrowserIndex after they changed
+	void refresh( void );
+
 	inline QString fullName( QString _path = QString::null )
 	{
 		if( _path == QString::null )
@@ -147,9 +161,15 @@ public:
 		m_directories.push_back( _dir );
 	}
 
+	inline const QStringList & directories( void ) const
+	{
+		return( m_directories );
+	}
+
 
 private:
 	void initPixmaps( void );
+	void populate( void );
 
 	bool addItems( const QString & _path );
 
@@ -160,6 +180,8 @@ private:
 
 	QStringList m_directories;
 	QString m_filter;
+	// paths registered at FileBrowserIndex while being expanded
+	QStringList m_watched;
 
 } ;
 
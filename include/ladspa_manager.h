@@ -31,9 +31,11 @@
 #include <ladspa.h>
 
 #include <QtCore/QMap>
+#include <QtCore/QMutex>
 #include <QtCore/QPair>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QVector>
 
 
 #include "export.h"
@@ -48,10 +50,15 @@ typedef QList<sortable_plugin_t> l_sortable_plugin_t;
 typedef QList<ladspa_key_t> l_ladspa_key_t;
 
 /* ladspaManager provides a database of LADSPA plug-ins.  Upon instantiation,
-it loads all of the plug-ins found in the LADSPA_PATH environmental variable
-and stores their access descriptors according in a dictionary keyed on
+it looks for all of the plug-ins found in the LADSPA_PATH environmental
+variable and stores their descriptions in a dictionary keyed on
 the filename the plug-in was loaded from and the label of the plug-in.
 
+Descriptions including port-information are kept in an on-disk cache keyed
+on path, size and modification time of each library, so libraries are only
+loaded if they changed since last start or if a plug-in is actually used
+(i.e. getDescriptor(), instantiate() etc. are called).
+
 The can be retrieved by using ladspa_key_t.  For example, to get the 
 "Phase Modulated Voice" plug-in from the cmt library, you would perform the
 calls using:
@@ -70,13 +77,30 @@ enum ladspaPluginType
 	OTHER
 };
 
+typedef struct ladspaPortStorage
+{
+	LADSPA_PortDescriptor descriptor;
+	LADSPA_PortRangeHintDescriptor hints;
+	float lowerBound;
+	float upperBound;
+	QString name;
+} ladspaPortDescription;
+
 typedef struct ladspaManagerStorage
 {
+	// NULL until library has been loaded
 	LADSPA_Descriptor_Function descriptorFunction;
+	QString file;
 	uint32_t index;
 	ladspaPluginType type;
 	uint16_t inputChannels;
 	uint16_t outputChannels;
+	QString label;
+	QString name;
+	QString maker;
+	QString copyright;
+	LADSPA_Properties properties;
+	QVector<ladspaPortDescription> ports;
 } ladspaManagerDescription;
 
 
@@ -87,6 +111,18 @@ public:
 	ladspaManager();
 	virtual ~ladspaManager();
 
+	/* Number of libraries which had to be loaded for reading their
+	descriptions and number of ones taken from cache at startup. */
+	inline int librariesScanned() const
+	{
+		return m_librariesScanned;
+	}
+
+	inline int librariesCached() const
+	{
+		return m_librariesCached;
+	}
+
 	l_sortable_plugin_t getSortedPlugins();
 	ladspaManagerDescription * getDescription( const ladspa_key_t & 
 								_plugin );
@@ -323,16 +359,47 @@ public:
 						LADSPA_Handle _instance );
 
 private:
-	void  addPlugins( LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file );
-	uint16_t  getPluginInputs( const LADSPA_Descriptor * _descriptor );
-	uint16_t  getPluginOutputs( const LADSPA_Descriptor * _descriptor );
-	
+	typedef QList<ladspaManagerDescription> ladspaManagerDescriptionList;
+
+	struct cachedLibrary
+	{
+		qint64 size;
+		uint modified;
+		ladspaManagerDescriptionList plugins;
+	} ;
+	typedef QMap<QString, cachedLibrary> ladspaCacheMapType;
+
+	/* Loads given library and appends descriptions of all of its
+	plug-ins to _plugins. */
+	void  scanLibrary( const QString & _file,
+				ladspaManagerDescriptionList & _plugins );
+	void  addPlugins( const ladspaManagerDescriptionList & _plugins,
+						const QString & _file_name );
+	uint16_t  getPluginInputs( const ladspaManagerDescription * _desc );
+	uint16_t  getPluginOutputs( const ladspaManagerDescription * _desc );
+
+	/* Returns the port-description or NULL if plug-in or port don't
+	exist. */
+	const ladspaPortDescription *  getPort( const ladspa_key_t & _plugin,
+							uint32_t _port );
+
+	/* Returns the descriptor and loads the plug-in's library if that
+	didn't happen yet. */
+	const LADSPA_Descriptor *  loadDescriptor(
+					const ladspa_key_t & _plugin );
+
+	ladspaCacheMapType readCache();
+	void  writeCache( const ladspaCacheMapType & _cache );
+
 	typedef QMap<ladspa_key_t, ladspaManagerDescription *>
 						ladspaManagerMapType;
 	ladspaManagerMapType m_ladspaManagerMap;
 	l_sortable_plugin_t m_sortedPlugins;
 
+	QMutex m_loadMutex;
+	int m_librariesScanned;
+	int m_librariesCached;
+
 } ;
 
 #endif
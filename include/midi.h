@@ -88,6 +88,7 @@ enum MidiStandardControllers
 	MidiControllerBreathController = 2,
 	MidiControllerFootController = 4,
 	MidiControllerPortamentoTime = 5,
+	MidiControllerDataEntry = 6,
 	MidiControllerMainVolume = 7,
 	MidiControllerBalance = 8,
 	MidiControllerPan = 10,
@@ -133,7 +134,8 @@ struct midiEvent
 		m_channel( _channel ),
 		m_sysExData( NULL ),
 		m_sourcePort( _sourcePort ),
-		m_fromMidiPort( false )
+		m_fromMidiPort( false ),
+		m_offset( 0 )
 	{
 		m_data.m_param[0] = _param1;
 		m_data.m_param[1] = _param2;
@@ -146,7 +148,8 @@ struct midiEvent
 		m_channel( 0 ),
 		m_sysExData( _sysex_data ),
 		m_sourcePort( NULL ),
-		m_fromMidiPort( false )
+		m_fromMidiPort( false ),
+		m_offset( 0 )
 	{
 		m_data.m_sysExDataLen = _data_len;
 	}
@@ -158,7 +161,8 @@ struct midiEvent
 		m_data( _copy.m_data ),
 		m_sysExData( _copy.m_sysExData ),
 		m_sourcePort( _copy.m_sourcePort ),
-		m_fromMidiPort( _copy.m_fromMidiPort )
+		m_fromMidiPort( _copy.m_fromMidiPort ),
+		m_offset( _copy.m_offset )
 	{
 	}
 
@@ -235,6 +239,18 @@ struct midiEvent
 		return m_fromMidiPort;
 	}
 
+	// position of event within current period in frames - set for events
+	// received from MIDI-ports when they are delivered by the mixer
+	inline f_cnt_t offset() const
+	{
+		return m_offset;
+	}
+
+	void setOffset( const f_cnt_t _offset )
+	{
+		m_offset = _offset;
+	}
+
 	MidiEventTypes m_type;		// MIDI event type
 	MidiMetaEvents m_metaEvent;	// Meta event (mostly unused)
 	int8_t m_channel;		// MIDI channel
@@ -251,6 +267,7 @@ struct midiEvent
 
 private:
 	bool m_fromMidiPort;
+	f_cnt_t m_offset;
 
 } ;
 
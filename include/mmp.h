@@ -30,6 +30,9 @@
 #include <QtXml/QDomDocument>
 #include <QTextStream>
 
+class QIODevice;
+class QXmlStreamReader;
+
 #include "export.h"
 #include "lmms_basics.h"
 
@@ -88,6 +91,12 @@ private:
 	void upgrade();
 
 	void loadData( const QByteArray & _data, const QString & _sourceFile );
+	// parses XML (optionally compressed) from given device piece by piece
+	// instead of reading and uncompressing everything at once
+	bool loadStream( QIODevice & _dev, QString & _errorMsg,
+						int & _line, int & _col );
+	void buildDocument( QXmlStreamReader & _reader );
+	void finishLoading();
 
 
 	struct EXPORT typeDescStruct
@@ -36,6 +36,7 @@
 
 class InstrumentTrack;
 class notePlayHandle;
+class OfflineRenderContext;
 
 template<ch_cnt_t=DEFAULT_CHANNELS> class basicFilters;
 typedef QList<notePlayHandle *> NotePlayHandleList;
@@ -52,7 +53,8 @@ public:
 					const f_cnt_t _offset,
 					const f_cnt_t _frames, const note & _n,
 					notePlayHandle * _parent = NULL,
-					const bool _part_of_arp = false );
+					const bool _part_of_arp = false,
+					OfflineRenderContext * _render_context = NULL );
 	virtual ~notePlayHandle();
 
 	virtual void setVolume( const volume_t _volume = DefaultVolume );
@@ -77,7 +79,8 @@ public:
 
 	virtual inline bool done() const
 	{
-		return m_released && framesLeft() <= 0;
+		return ( m_released && framesLeft() <= 0 ) || m_fadedOut ||
+					( m_silent && m_subNotes.isEmpty() );
 	}
 
 	f_cnt_t framesLeft() const;
@@ -141,6 +144,13 @@ public:
 		return m_instrumentTrack;
 	}
 
+	// returns the context rendering this note or NULL if note is played
+	// by the mixer
+	inline OfflineRenderContext * renderContext() const
+	{
+		return m_renderContext;
+	}
+
 	// returns whether note is a top note, e.g. is not part of an arpeggio
 	// or a chord
 	inline bool isTopNote() const
@@ -168,6 +178,31 @@ public:
 
 	void mute();
 
+	// stop note (and its sub-notes) within next period by fading it out -
+	// used for voice-stealing, can be called from any thread
+	void steal();
+
+	inline bool isStolen() const
+	{
+		return m_stolen;
+	}
+
+	// returns whether note is faded out in current period
+	inline bool isFadingOut() const
+	{
+		return m_fadingOut;
+	}
+
+	// called by InstrumentTrack with peak-level of the output of current
+	// period - a released note which stays silent for some periods isn't
+	// rendered anymore and is done as soon as its sub-notes are
+	void reportOutputLevel( const float _peak );
+
+	inline bool isSilent() const
+	{
+		return m_silent;
+	}
+
 	// returns index of note-play-handle in vector of note-play-handles 
 	// belonging to this instrument-track - used by arpeggiator
 	int index() const;
@@ -177,6 +212,16 @@ public:
 	static ConstNotePlayHandleList nphsOfInstrumentTrack(
 			const InstrumentTrack * _ct, bool _all_ph = false );
 
+	// same as above but searches given list of play-handles
+	static ConstNotePlayHandleList nphsOfInstrumentTrack(
+			const InstrumentTrack * _ct,
+			const PlayHandleList & _play_handles,
+			bool _all_ph = false );
+
+	// list of play-handles this note is played with, i.e. the ones of
+	// mixer or the ones of the render-context
+	const PlayHandleList & siblingPlayHandles() const;
+
 	// return whether given note-play-handle is equal to *this
 	bool operator==( const notePlayHandle & _nph ) const;
 
@@ -237,6 +282,9 @@ private:
 
 	} ;
 
+	// sustain pedal has no effect on offline rendered notes
+	bool isSustained() const;
+
 	InstrumentTrack * m_instrumentTrack;	// needed for calling
 											// InstrumentTrack::playNote
 	f_cnt_t m_frames;						// total frames to play
@@ -257,6 +305,15 @@ private:
 											// an arpeggio (either base-note or
 											// sub-note)
 	bool m_muted;							// indicates whether note is muted
+	notePlayHandle * m_parent;				// note this one is sub-note of
+	bool m_isVoice;							// indicates whether note is counted
+											// by voice-limits of track
+	volatile bool m_stolen;					// set by voice-stealing
+	bool m_fadingOut;						// stolen note plays last period
+	bool m_fadedOut;						// stolen note is done
+	int m_silentPeriods;					// number of periods output of
+											// released note was inaudible
+	bool m_silent;							// note isn't rendered anymore
 	track * m_bbTrack;						// related BB track
 #ifdef LMMS_SINGERBOT_SUPPORT
 	int m_patternIndex;						// position among relevant notes
@@ -274,6 +331,11 @@ private:
 	BaseDetuning * m_baseDetuning;
 	midiTime m_songGlobalParentOffset;
 
+	OfflineRenderContext * m_renderContext;
+
+
+	friend class InstrumentTrack;
+
 } ;
 
 #endif
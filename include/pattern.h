@@ -42,6 +42,7 @@ class QProgressBar;
 class QPushButton;
 
 class InstrumentTrack;
+class OfflineRenderContext;
 class patternFreezeThread;
 class SampleBuffer;
 
@@ -159,6 +160,7 @@ private:
 	SampleBuffer* m_frozenPattern;
 	bool m_freezing;
 	volatile bool m_freezeAborted;
+	patternFreezeThread * m_freezeThread;
 
 
 	friend class patternView;
@@ -225,11 +227,16 @@ class patternFreezeStatusDialog : public QDialog
 {
 	Q_OBJECT
 public:
-	patternFreezeStatusDialog( QThread * _thread );
+	patternFreezeStatusDialog( QThread * _thread, bool _modal = true );
 	virtual ~patternFreezeStatusDialog();
 
 	void setProgress( int _p );
 
+	volatile int * progress()
+	{
+		return &m_progress;
+	}
+
 
 protected:
 	void closeEvent( QCloseEvent * _ce );
@@ -246,7 +253,7 @@ private:
 
 	QThread * m_freezeThread;
 
-	int m_progress;
+	volatile int m_progress;
 
 
 signals:
@@ -258,21 +265,34 @@ signals:
 
 
 
+// Freezes a pattern either in background using an OfflineRenderContext (if
+// the instrument supports it) or by taking over the mixer (legacy way which
+// blocks the user-interface)
 class patternFreezeThread : public QThread
 {
 public:
 	patternFreezeThread( pattern * _pattern );
 	virtual ~patternFreezeThread();
 
+	void abort();
+
+	// called by pattern when it's being destroyed
+	void detachPattern();
+
 
 protected:
 	virtual void run();
 
 
 private:
+	void renderLegacy();
+
 	pattern * m_pattern;
 	patternFreezeStatusDialog * m_statusDlg;
 
+	OfflineRenderContext * m_renderContext;
+	SampleBuffer * m_result;
+
 } ;
 
 
@@ -28,6 +28,7 @@
 #ifndef _PIANO_ROLL_H
 #define _PIANO_ROLL_H
 
+#include <QtGui/QPixmap>
 #include <QtGui/QWidget>
 
 #include "ComboBoxModel.h"
@@ -38,7 +39,6 @@
 
 
 class QPainter;
-class QPixmap;
 class QScrollBar;
 class QString;
 class QMenu;
@@ -146,6 +146,9 @@ protected slots:
 	void changeNoteEditMode( int i );
 	void markSemiTone( int i );
 
+	// notes were changed somewhere else - redraw note-layer
+	void notesChanged();
+
 
 signals:
 	void semiToneMarkerMenuScaleSetEnabled(bool);
@@ -331,9 +334,30 @@ private:
 	timeLine * m_timeLine;
 	bool m_scrollBack;
 
+	// keyboard/grid and notes are only redrawn if their state changed
+	QPixmap m_backgroundCache;
+	QPixmap m_notesCache;
+	uint m_backgroundState;
+	uint m_notesViewState;
+	// set by everything changing notes or their selection (pattern's
+	// dataChanged(), mouse-/key-events, edit-actions) so that notes don't
+	// have to be compared on every repaint
+	bool m_notesDirty;
+	// updated by updateCullingInfo() - notes can only be culled by binary
+	// search if they're sorted (which isn't the case while dragging)
+	bool m_notesSorted;
+	int m_maxNoteLength;
+
 	void copy_to_clipboard( const NoteVector & _notes ) const;
 
 	void drawDetuningInfo( QPainter & _p, note * _n, int _x, int _y );
+	void drawBackground( QPainter & _p );
+	void drawNotes( QPainter & _p );
+	// fingerprints of everything the cached layers depend on (except for
+	// the notes themselves, see m_notesDirty)
+	uint backgroundState() const;
+	uint notesViewState() const;
+	void updateCullingInfo();
 	bool mouseOverNote();
 	note * noteUnderMouse();
 
@@ -211,7 +211,9 @@ public:
 	// file management
 	void createNewProject();
 	void createNewProjectFromTemplate( const QString & _template );
-	void loadProject( const QString & _filename );
+	// returns false if _filename couldn't be read - an empty project has
+	// been created then
+	bool loadProject( const QString & _filename );
 	bool guiSaveProject();
 	bool guiSaveProjectAs( const QString & _filename );
     bool saveProjectFile( const QString & _filename );
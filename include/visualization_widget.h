@@ -28,6 +28,8 @@
 
 #include <QtGui/QWidget>
 #include <QtGui/QPixmap>
+#include <QtCore/QLine>
+#include <QtCore/QVector>
 
 #include "Mixer.h"
 
@@ -53,15 +55,11 @@ protected:
 	virtual void mousePressEvent( QMouseEvent * _me );
 
 
-protected slots:
-	void updateAudioBuffer();
-
-
 private:
 	QPixmap s_background;
-	QPointF * m_points;
+	QPixmap m_inactiveBackground;
+	QVector<QLine> m_lines;
 
-	sampleFrame * m_buffer;
 	bool m_active;
 
 } ;
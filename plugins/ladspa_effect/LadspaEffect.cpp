@@ -67,6 +67,7 @@ LadspaEffect::LadspaEffect( Model * _parent,
 	Effect( &ladspaeffect_plugin_descriptor, _parent, _key ),
 	m_controls( NULL ),
 	m_maxSampleRate( 0 ),
+	m_inplaceBroken( false ),
 	m_key( LadspaSubPluginFeatures::subPluginKeyToLadspaKey( _key ) )
 {
 	ladspa2LMMS * manager = engine::getLADSPAManager();
@@ -153,39 +154,127 @@ bool LadspaEffect::processAudioBuffer( sampleFrame * _buf,
 				engine::mixer()->processingSampleRate();
 	}
 
-	// Copy the LMMS audio buffer to the LADSPA input buffer and initialize
-	// the control ports.  Need to change this to handle non-in-place-broken
-	// plugins--would speed things up to use the same buffer for both
-	// LMMS and LADSPA.
-	ch_cnt_t channel = 0;
+	sample_t * channels[DEFAULT_CHANNELS];
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		channels[ch] = m_planarBuffer[ch];
+		for( fpp_t frame = 0; frame < frames; ++frame )
+		{
+			channels[ch][frame] = _buf[frame][ch];
+		}
+	}
+
+	runPlugins( channels, frames );
+
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		for( fpp_t frame = 0; frame < frames; ++frame )
+		{
+			_buf[frame][ch] = channels[ch][frame];
+		}
+	}
+
+	if( o_buf != NULL )
+	{
+		sampleBack( _buf, o_buf, m_maxSampleRate );
+		delete[] _buf;
+	}
+
+	bool is_running = isRunning();
+	m_pluginMutex.unlock();
+	return( is_running );
+}
+
+
+
+
+bool LadspaEffect::supportsPlanarProcessing() const
+{
+	return m_maxSampleRate >= engine::mixer()->processingSampleRate();
+}
+
+
+
+
+bool LadspaEffect::processPlanarAudioBuffer( sample_t * const * _channels,
+							const fpp_t _frames )
+{
+	m_pluginMutex.lock();
+	if( !isOkay() || dontRun() || !isRunning() || !isEnabled() )
+	{
+		m_pluginMutex.unlock();
+		return( FALSE );
+	}
+
+	if( m_maxSampleRate < engine::mixer()->processingSampleRate() )
+	{
+		// sample-rate was changed meanwhile, so we have to resample
+		m_pluginMutex.unlock();
+		sampleFrame buf[DEFAULT_BUFFER_SIZE];
+		for( fpp_t frame = 0; frame < _frames; ++frame )
+		{
+			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			{
+				buf[frame][ch] = _channels[ch][frame];
+			}
+		}
+		const bool is_running = processAudioBuffer( buf, _frames );
+		for( fpp_t frame = 0; frame < _frames; ++frame )
+		{
+			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			{
+				_channels[ch][frame] = buf[frame][ch];
+			}
+		}
+		return( is_running );
+	}
+
+	runPlugins( _channels, _frames );
+
+	bool is_running = isRunning();
+	m_pluginMutex.unlock();
+	return( is_running );
+}
+
+
+
+
+void LadspaEffect::runPlugins( sample_t * const * _channels, const int _frames )
+{
+	const float d = dryLevel();
+	const float w = wetLevel();
+	// plugins read their input directly from the channel-buffers and, if
+	// the dry signal isn't needed for mixing, write their output there
+	// as well
+	const bool in_place = d == 0.0f && !m_inplaceBroken;
+
+	ch_cnt_t in_channel = 0;
+	ch_cnt_t out_channel = 0;
 	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
 	{
 		for( int port = 0; port < m_portCount; ++port )
 		{
 			port_desc_t * pp = m_ports.at( proc ).at( port );
+			LADSPA_Data * buffer = pp->buffer;
 			switch( pp->rate )
 			{
 				case CHANNEL_IN:
-					for( fpp_t frame = 0; 
-						frame < frames; ++frame )
+					if( in_channel < DEFAULT_CHANNELS )
 					{
-						pp->buffer[frame] = 
-							_buf[frame][channel];
+						buffer = _channels[in_channel];
 					}
-					++channel;
+					++in_channel;
 					break;
-				case AUDIO_RATE_INPUT:
-					pp->value = static_cast<LADSPA_Data>( 
-										pp->control->value() / pp->scale );
-					// This only supports control rate ports, so the audio rates are
-					// treated as though they were control rate by setting the
-					// port buffer to all the same value.
-					for( fpp_t frame = 0; 
-						frame < frames; ++frame )
+				case CHANNEL_OUT:
+					if( in_place &&
+						out_channel < DEFAULT_CHANNELS )
 					{
-						pp->buffer[frame] = 
-							pp->value;
+						buffer = _channels[out_channel];
 					}
+					++out_channel;
+					break;
+				case AUDIO_RATE_INPUT:
+					updateAudioRateInput( pp, _frames );
 					break;
 				case CONTROL_RATE_INPUT:
 					if( pp->control == NULL )
@@ -197,74 +286,103 @@ bool LadspaEffect::processAudioBuffer( sampleFrame * _buf,
 					pp->buffer[0] = 
 						pp->value;
 					break;
-				case CHANNEL_OUT:
 				case AUDIO_RATE_OUTPUT:
 				case CONTROL_RATE_OUTPUT:
-					break;
 				default:
 					break;
 			}
+			connectPort( proc, port, buffer );
 		}
 	}
 
 	// Process the buffers.
 	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
 	{
-		(m_descriptor->run)( m_handles[proc], frames );
+		(m_descriptor->run)( m_handles[proc], _frames );
 	}
 
-	// Copy the LADSPA output buffers to the LMMS buffer.
-	double out_sum = 0.0;
-	channel = 0;
-	const float d = dryLevel();
-	const float w = wetLevel();
+	// Mix the LADSPA output buffers into the channel-buffers if not done
+	// in place already.
+	float out_sum = 0.0f;
+	out_channel = 0;
 	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
 	{
 		for( int port = 0; port < m_portCount; ++port )
 		{
 			port_desc_t * pp = m_ports.at( proc ).at( port );
-			switch( pp->rate )
+			if( pp->rate != CHANNEL_OUT )
 			{
-				case CHANNEL_IN:
-				case AUDIO_RATE_INPUT:
-				case CONTROL_RATE_INPUT:
-					break;
-				case CHANNEL_OUT:
-					for( fpp_t frame = 0; 
-						frame < frames; ++frame )
+				continue;
+			}
+			if( out_channel < DEFAULT_CHANNELS )
+			{
+				sample_t * ch = _channels[out_channel];
+				float sum = 0.0f;
+				for( int frame = 0; frame < _frames; ++frame )
+				{
+					if( !in_place )
 					{
-						_buf[frame][channel] = 
-							d * 
-							_buf[frame][channel] +
-							w *
-							pp->buffer[frame];
-						out_sum += 
-							_buf[frame][channel] *
-							_buf[frame][channel];
+						ch[frame] = d * ch[frame] +
+							w * pp->buffer[frame];
 					}
-					++channel;
-					break;
-				case AUDIO_RATE_OUTPUT:
-				case CONTROL_RATE_OUTPUT:
-					break;
-				default:
-					break;
+					sum += ch[frame] * ch[frame];
+				}
+				out_sum += sum;
 			}
+			++out_channel;
 		}
 	}
 
-	if( o_buf != NULL )
+	checkGate( out_sum / _frames );
+}
+
+
+
+
+void LadspaEffect::updateAudioRateInput( port_desc_t * _pp, const int _frames )
+{
+	if( _pp->control == NULL )
 	{
-		sampleBack( _buf, o_buf, m_maxSampleRate );
-		delete[] _buf;
+		return;
 	}
 
-	checkGate( out_sum / frames );
+	// ramp linearly from value of previous period to the current one, so
+	// automated audio-rate ports don't get a step once per period
+	const LADSPA_Data prev = _pp->value;
+	_pp->value = static_cast<LADSPA_Data>(
+				_pp->control->value() / _pp->scale );
+	if( _pp->value != prev )
+	{
+		const LADSPA_Data step = ( _pp->value - prev ) / _frames;
+		for( int frame = 0; frame < _frames; ++frame )
+		{
+			_pp->buffer[frame] = prev + step * ( frame + 1 );
+		}
+	}
+	// buffer still contains a ramp?
+	else if( _pp->buffer[0] != _pp->value ||
+				_pp->buffer[_frames - 1] != _pp->value )
+	{
+		for( int frame = 0; frame < _frames; ++frame )
+		{
+			_pp->buffer[frame] = _pp->value;
+		}
+	}
+}
 
 
-	bool is_running = isRunning();
-	m_pluginMutex.unlock();
-	return( is_running );
+
+
+void LadspaEffect::connectPort( const ch_cnt_t _proc, const int _port,
+							LADSPA_Data * _buffer )
+{
+	LADSPA_Data * & connection = m_connections[_proc * m_portCount + _port];
+	if( connection != _buffer )
+	{
+		( m_descriptor->connect_port )( m_handles[_proc], _port,
+								_buffer );
+		connection = _buffer;
+	}
 }
 
 
@@ -429,7 +547,16 @@ void LadspaEffect::pluginInstantiation()
 			p->min *= p->scale;
 			p->def *= p->scale;
 
-			p->value = p->def;
+			p->value = p->def / p->scale;
+			if( p->rate == AUDIO_RATE_INPUT )
+			{
+				for( fpp_t frame = 0; frame <
+					engine::mixer()->framesPerPeriod();
+								++frame )
+				{
+					p->buffer[frame] = p->value;
+				}
+			}
 
 
 			ports.append( p );
@@ -478,6 +605,8 @@ void LadspaEffect::pluginInstantiation()
 		m_handles.append( effect );
 	}
 
+	m_inplaceBroken = manager->isInplaceBroken( m_key );
+
 	// Connect the ports.
 	for( ch_cnt_t proc = 0; proc < processorCount(); proc++ )
 	{
@@ -495,6 +624,7 @@ void LadspaEffect::pluginInstantiation()
 				setDontRun( TRUE );
 				return;
 			}
+			m_connections.append( pp->buffer );
 		}
 	}
 
@@ -534,6 +664,7 @@ void LadspaEffect::pluginDestruction()
 	m_ports.clear();
 	m_handles.clear();
 	m_portControls.clear();
+	m_connections.clear();
 }
 
 
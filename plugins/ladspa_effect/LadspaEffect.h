@@ -45,6 +45,10 @@ public:
 
 	virtual bool processAudioBuffer( sampleFrame * _buf,
 							const fpp_t _frames );
+
+	virtual bool supportsPlanarProcessing() const;
+	virtual bool processPlanarAudioBuffer( sample_t * const * _channels,
+							const fpp_t _frames );
 	
 	void setControl( int _control, LADSPA_Data _data );
 
@@ -69,11 +73,18 @@ private:
 
 	static sample_rate_t maxSamplerate( const QString & _name );
 
+	// following methods require m_pluginMutex to be locked
+	void runPlugins( sample_t * const * _channels, const int _frames );
+	void updateAudioRateInput( port_desc_t * _pp, const int _frames );
+	void connectPort( const ch_cnt_t _proc, const int _port,
+						LADSPA_Data * _buffer );
+
 
 	QMutex m_pluginMutex;
 	LadspaControls * m_controls;
 
 	sample_rate_t m_maxSampleRate;
+	bool m_inplaceBroken;
 	ladspa_key_t m_key;
 	int m_portCount;
 
@@ -83,6 +94,13 @@ private:
 	QVector<multi_proc_t> m_ports;
 	multi_proc_t m_portControls;
 
+	// buffers the ports are connected to at the moment, indexed by
+	// processor * m_portCount + port
+	QVector<LADSPA_Data *> m_connections;
+
+	// channel-buffers for processAudioBuffer()
+	sample_t m_planarBuffer[DEFAULT_CHANNELS][DEFAULT_BUFFER_SIZE];
+
 } ;
 
 #endif
@@ -154,6 +154,12 @@ public:
 		return 0; //4048;
 	}
 
+	// monophonic synth rendering through an InstrumentPlayHandle
+	virtual bool supportsOfflineRendering() const
+	{
+		return false;
+	}
+
 	virtual PluginView * instantiateView( QWidget * _parent );
 
 private:
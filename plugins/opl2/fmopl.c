@@ -214,22 +214,26 @@ static INT32 RATE_0[16]=
 /* lock level of common table */
 static int num_lock = 0;
 
+/* LMMS: the work state below is per thread so that different chips can be
+   updated in parallel */
+#define OPL_THREAD_LOCAL __thread
+
 /* work table */
-static void *cur_chip = NULL;	/* current chip point */
+static OPL_THREAD_LOCAL void *cur_chip = NULL;	/* current chip point */
 /* currenct chip state */
 /* static OPLSAMPLE  *bufL,*bufR; */
-static OPL_CH *S_CH;
-static OPL_CH *E_CH;
-OPL_SLOT *SLOT7_1,*SLOT7_2,*SLOT8_1,*SLOT8_2;
-
-static INT32 outd[1];
-static INT32 ams;
-static INT32 vib;
-INT32  *ams_table;
-INT32  *vib_table;
-static INT32 amsIncr;
-static INT32 vibIncr;
-static INT32 feedback2;		/* connect for SLOT 2 */
+static OPL_THREAD_LOCAL OPL_CH *S_CH;
+static OPL_THREAD_LOCAL OPL_CH *E_CH;
+OPL_THREAD_LOCAL OPL_SLOT *SLOT7_1,*SLOT7_2,*SLOT8_1,*SLOT8_2;
+
+static OPL_THREAD_LOCAL INT32 outd[1];
+static OPL_THREAD_LOCAL INT32 ams;
+static OPL_THREAD_LOCAL INT32 vib;
+OPL_THREAD_LOCAL INT32  *ams_table;
+OPL_THREAD_LOCAL INT32  *vib_table;
+static OPL_THREAD_LOCAL INT32 amsIncr;
+static OPL_THREAD_LOCAL INT32 vibIncr;
+static OPL_THREAD_LOCAL INT32 feedback2;		/* connect for SLOT 2 */
 
 /* log output level */
 #define LOG_ERR  3      /* ERROR       */
@@ -452,7 +456,7 @@ INLINE void set_sl_rr(FM_OPL *OPL,int slot,int v)
 /* operator output calcrator */
 #define OP_OUT(slot,env,con)   slot->wavetable[((slot->Cnt+con)/(0x1000000/SIN_ENT))&(SIN_ENT-1)][env]
 /* ---------- calcrate one of channel ---------- */
-INLINE void OPL_CALC_CH( OPL_CH *CH )
+static INLINE void OPL_CALC_CH( OPL_CH *CH )
 {
 	UINT32 env_out;
 	OPL_SLOT *SLOT;
@@ -471,11 +475,16 @@ INLINE void OPL_CALC_CH( OPL_CH *CH )
 		{
 			int feedback1 = (CH->op1_out[0]+CH->op1_out[1])>>CH->FB;
 			CH->op1_out[1] = CH->op1_out[0];
-			*CH->connect1 += CH->op1_out[0] = OP_OUT(SLOT,env_out,feedback1);
+			CH->op1_out[0] = OP_OUT(SLOT,env_out,feedback1);
+			/* LMMS: don't use connect1 which points to the work
+			   state of the thread which wrote the register */
+			if(CH->CON) outd[0] += CH->op1_out[0];
+			else        feedback2 += CH->op1_out[0];
 		}
 		else
 		{
-			*CH->connect1 += OP_OUT(SLOT,env_out,0);
+			if(CH->CON) outd[0] += OP_OUT(SLOT,env_out,0);
+			else        feedback2 += OP_OUT(SLOT,env_out,0);
 		}
 	}else
 	{
@@ -1049,7 +1058,9 @@ void YM3812UpdateOne(FM_OPL *OPL, INT16 *buffer, int length)
 	UINT8 rythm = OPL->rythm&0x20;
 	OPL_CH *CH,*R_CH;
 
-	if( (void *)OPL != cur_chip ){
+	/* LMMS: always set up work state - a chip with same address as the
+	   cached one might have been created by another thread meanwhile */
+	{
 		cur_chip = (void *)OPL;
 		/* channel pointers */
 		S_CH = OPL->P_CH;
@@ -1114,7 +1125,9 @@ void Y8950UpdateOne(FM_OPL *OPL, INT16 *buffer, int length)
 	/* setup DELTA-T unit */
 	YM_DELTAT_DECODE_PRESET(DELTAT);
 
-	if( (void *)OPL != cur_chip ){
+	/* LMMS: always set up work state - a chip with same address as the
+	   cached one might have been created by another thread meanwhile */
+	{
 		cur_chip = (void *)OPL;
 		/* channel pointers */
 		S_CH = OPL->P_CH;
@@ -51,6 +51,8 @@
 
 #include <QtXml/QDomDocument>
 
+#include <cstring>
+
 #include "opl.h"
 #include "temuopl.h"
 #include "kemuopl.h"
@@ -88,10 +90,6 @@ Plugin * PLUGIN_EXPORT lmms_plugin_main( Model *, void * _data )
 
 }
 
-// I'd much rather do without a mutex, but it looks like
-// the emulator code isn't really ready for threads
-QMutex opl2instrument::emulatorMutex;
-
 opl2instrument::opl2instrument( InstrumentTrack * _instrument_track ) :
 	Instrument( _instrument_track, &OPL2_plugin_descriptor ),
 	m_patchModel( 0, 0, 127, this, tr( "Patch" ) ),
@@ -135,19 +133,13 @@ opl2instrument::opl2instrument( InstrumentTrack * _instrument_track ) :
 	vib_depth_mdl(false, this, tr( "Vibrato Depth" )   ),
 	trem_depth_mdl(false, this, tr( "Tremolo Depth" )   )
 {
-	// Connect the plugin to the mixer...
-	InstrumentPlayHandle * iph = new InstrumentPlayHandle( this );
-	engine::mixer()->addPlayHandle( iph );
-
 	// Create an emulator - samplerate, 16 bit, mono
 	// CTemuopl is the better one, CKemuopl kinda sucks (some sounds silent, pitch goes flat after a while)
-	emulatorMutex.lock();
 	// theEmulator = new CKemuopl(engine::mixer()->processingSampleRate(), true, false);
 	theEmulator = new CTemuopl(engine::mixer()->processingSampleRate(), true, false);
 	theEmulator->init();
 	// Enable waveform selection
 	theEmulator->write(0x01,0x20);
-	emulatorMutex.unlock();
 
 	updatePatch();
 
@@ -158,9 +150,17 @@ opl2instrument::opl2instrument( InstrumentTrack * _instrument_track ) :
 	// Some kind of sane default
 	tuneEqual(69, 440);
 
-	for(int i=1; i<9; ++i) {
+	for(int i=0; i<9; ++i) {
 		voiceNote[i] = OPL2_VOICE_FREE;
 	}
+	lastVoice = 0;
+
+	m_overflow.reserve( 256 );
+
+	// Connect the plugin to the mixer...
+	InstrumentPlayHandle * iph = new InstrumentPlayHandle( this );
+	engine::mixer()->addPlayHandle( iph );
+
 	connect( engine::mixer(), SIGNAL( sampleRateChanged() ),
 		 this, SLOT( reloadEmulator() ) );
 	// Connect knobs
@@ -207,23 +207,49 @@ opl2instrument::opl2instrument( InstrumentTrack * _instrument_track ) :
 	MOD_CON( trem_depth_mdl );
 }
 
+opl2instrument::~opl2instrument()
+{
+	engine::mixer()->removePlayHandles( instrumentTrack() );
+	delete theEmulator;
+	delete[] renderbuffer;
+}
+
 // Samplerate changes when choosing oversampling, so this is more or less mandatory
 void opl2instrument::reloadEmulator() {
-	emulatorMutex.lock();
-	theEmulator = new CTemuopl(engine::mixer()->processingSampleRate(), true, false);
-	theEmulator->init();
-	theEmulator->write(0x01,0x20);
-	emulatorMutex.unlock();
-	for(int i=1; i<9; ++i) {
+	Copl * emulator = new CTemuopl(engine::mixer()->processingSampleRate(), true, false);
+	emulator->init();
+	emulator->write(0x01,0x20);
+
+	engine::mixer()->lock();
+	delete theEmulator;
+	theEmulator = emulator;
+	engine::mixer()->unlock();
+
+	m_writeMutex.lock();
+	for(int i=0; i<9; ++i) {
 		voiceNote[i] = OPL2_VOICE_FREE;
 	}
+	m_writeMutex.unlock();
 	updatePatch();
 }
 
+void opl2instrument::queueWrite( int reg, int value )
+{
+	RegisterWrite w;
+	w.reg = reg;
+	w.value = value;
+	// once something overflowed, everything has to go to overflow-list
+	// until play() has applied it, as order of writes matters
+	if( !m_overflow.isEmpty() || !m_writes.write( w ) )
+	{
+		m_overflow.push_back( w );
+		m_overflowPending.fetchAndStoreOrdered( 1 );
+	}
+}
+
 bool opl2instrument::handleMidiEvent( const midiEvent & _me,
 				      const midiTime & _time )
 {
-	emulatorMutex.lock();
 	// Real dummy version... Should at least add: 
 	// - smarter voice allocation:
 	//   - reuse same note, now we have round robin-ish
@@ -231,18 +257,18 @@ bool opl2instrument::handleMidiEvent( const midiEvent & _me,
 	// - mono mode 
 	// 
 	int key;
-	static int lastvoice=0;
+	QMutexLocker ml( &m_writeMutex );
 	if( _me.m_type == MidiNoteOn ) {
 		// to get us in line with MIDI
 		key = _me.key() +12;
-		for(int i=lastvoice+1; i!=lastvoice; ++i,i%=9) {
+		for(int i=(lastVoice+1)%9; i!=lastVoice; ++i,i%=9) {
 			if( voiceNote[i] == OPL2_VOICE_FREE ) {
-				theEmulator->write(0xA0+i, fnums[key] & 0xff);
-				theEmulator->write(0xB0+i, 32 + ((fnums[key] & 0x1f00) >> 8) );
+				queueWrite(0xA0+i, fnums[key] & 0xff);
+				queueWrite(0xB0+i, 32 + ((fnums[key] & 0x1f00) >> 8) );
 				// printf("%d: %d %d\n", key, (fnums[key] & 0x1c00) >> 10, fnums[key] & 0x3ff);
 				voiceNote[i] = key;
 				// printf("Voice %d on\n",i);
-				lastvoice=i;
+				lastVoice=i;
 				break;
 			}
 		}
@@ -250,8 +276,8 @@ bool opl2instrument::handleMidiEvent( const midiEvent & _me,
 		key = _me.key() +12;
 		for(int i=0; i<9; ++i) {
 			if( voiceNote[i] == key ) {
-				theEmulator->write(0xA0+i, fnums[key] & 0xff);
-				theEmulator->write(0xB0+i, (fnums[key] & 0x1f00) >> 8 );
+				queueWrite(0xA0+i, fnums[key] & 0xff);
+				queueWrite(0xB0+i, (fnums[key] & 0x1f00) >> 8 );
 				voiceNote[i] = OPL2_VOICE_FREE;
 			}
 		}
@@ -260,7 +286,6 @@ bool opl2instrument::handleMidiEvent( const midiEvent & _me,
 		// 224 - pitch wheel
 		// 160 - aftertouch?
 	}
-	emulatorMutex.unlock();
 	return true;
 }
 
@@ -277,7 +302,35 @@ PluginView * opl2instrument::instantiateView( QWidget * _parent )
 
 void opl2instrument::play( sampleFrame * _working_buffer ) 	
 {
-	emulatorMutex.lock();
+	// flag is cleared before reading the patch, so a patch changed
+	// meanwhile is applied again next period
+	if( m_patchChanged.fetchAndStoreOrdered( 0 ) && !applyPatch() )
+	{
+		// patch is being changed right now - try again next period
+		m_patchChanged.fetchAndStoreOrdered( 1 );
+	}
+
+	RegisterWrite w;
+	while( m_writes.read( w ) )
+	{
+		theEmulator->write( w.reg, w.value );
+	}
+	// queued after everything in m_writes - if we don't get the lock
+	// right now, they're applied next period
+	if( m_overflowPending.fetchAndAddOrdered( 0 ) &&
+						m_writeMutex.tryLock() )
+	{
+		for( int i = 0; i < m_overflow.size(); ++i )
+		{
+			theEmulator->write( m_overflow[i].reg,
+						m_overflow[i].value );
+		}
+		// keeps reserved memory, unlike clear()
+		m_overflow.resize( 0 );
+		m_overflowPending.fetchAndStoreOrdered( 0 );
+		m_writeMutex.unlock();
+	}
+
 	theEmulator->update(renderbuffer, frameCount);
 
 	for( fpp_t frame = 0; frame < frameCount; ++frame )
@@ -288,7 +341,6 @@ void opl2instrument::play( sampleFrame * _working_buffer )
                         _working_buffer[frame][ch] = s;
                 }
 	}
-	emulatorMutex.unlock();
 
 	// Throw the data to the track...
 	instrumentTrack()->processAudioBuffer( _working_buffer, frameCount, NULL );
@@ -368,12 +420,27 @@ void opl2instrument::loadSettings( const QDomElement & _this )
 
 // Load a preset in binary form
 void opl2instrument::loadPatch(unsigned char inst[14]) {
-	const unsigned int adlib_opadd[] = {0x00, 0x01, 0x02, 0x08, 0x09, 0x0A, 0x10, 0x11, 0x12};
-	// Set all voices
 	printf("%02x %02x %02x %02x %02x ",inst[0],inst[1],inst[2],inst[3],inst[4]);
 	printf("%02x %02x %02x %02x %02x %02x\n",inst[5],inst[6],inst[7],inst[8],inst[9],inst[10]);
 
-	emulatorMutex.lock();
+	m_writeMutex.lock();
+	memcpy( m_patch, inst, sizeof( m_patch ) );
+	m_writeMutex.unlock();
+	m_patchChanged.fetchAndStoreOrdered( 1 );
+}
+
+bool opl2instrument::applyPatch() {
+	const unsigned int adlib_opadd[] = {0x00, 0x01, 0x02, 0x08, 0x09, 0x0A, 0x10, 0x11, 0x12};
+	unsigned char inst[14];
+	if( !m_writeMutex.tryLock() )
+	{
+		return false;
+	}
+	memcpy( inst, m_patch, sizeof( inst ) );
+	const unsigned char rhythm_reg = m_rhythmReg;
+	m_writeMutex.unlock();
+
+	// Set all voices
 	for(int v=0; v<9; ++v) {
 		theEmulator->write(0x20+adlib_opadd[v],inst[0]); // op1 AM/VIB/EG/KSR/Multiplier
 		theEmulator->write(0x23+adlib_opadd[v],inst[1]); // op2
@@ -387,7 +454,9 @@ void opl2instrument::loadPatch(unsigned char inst[14]) {
 		theEmulator->write(0xe3+adlib_opadd[v],inst[9]); // op2
 		theEmulator->write(0xc0+v,inst[10]);             // feedback/algorithm
 	}
-	emulatorMutex.unlock();
+	// Not part of the patch per se
+	theEmulator->write(0xBD, rhythm_reg);
+	return true;
 }
 
 void opl2instrument::tuneEqual(int center, float Hz) {
@@ -424,7 +493,8 @@ void opl2instrument::loadGMPatch() {
 // Update patch from the models to the chip emulation
 void opl2instrument::updatePatch() {
 	printf("updatePatch()\n");
-	unsigned char *inst = midi_fm_instruments[0];
+	// don't modify the GM patch shared by all instances
+	unsigned char inst[14];
 	inst[0] = ( op1_trem_mdl.value() ?  128 : 0  ) +
 		( op1_vib_mdl.value() ?  64 : 0 ) +
 		( op1_perc_mdl.value() ?  0 : 32 ) + // NB. This envelope mode is "perc", not "sus"
@@ -457,8 +527,10 @@ void opl2instrument::updatePatch() {
 	inst[13] = 0;
 
 	// Not part of the patch per se
-	theEmulator->write(0xBD, (trem_depth_mdl.value() ? 128 : 0 ) +
-			   (vib_depth_mdl.value() ? 64 : 0 ));
+	m_writeMutex.lock();
+	m_rhythmReg = (trem_depth_mdl.value() ? 128 : 0 ) +
+			   (vib_depth_mdl.value() ? 64 : 0 );
+	m_writeMutex.unlock();
 
 	loadPatch(inst);
 }
@@ -25,8 +25,13 @@
 #ifndef _OPL2_H
 #define _OPL2_H
 
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
 #include "Instrument.h"
 #include "InstrumentView.h"
+#include "LocklessRingBuffer.h"
+#include "atomic_int.h"
 #include "opl.h"
 
 #include "lcd_spinbox.h"
@@ -40,6 +45,7 @@ class opl2instrument : public Instrument
 	Q_OBJECT
 public:
 	opl2instrument( InstrumentTrack * _instrument_track );
+	virtual ~opl2instrument();
 	virtual QString nodeName() const;
 	virtual PluginView * instantiateView( QWidget * _parent );
 
@@ -103,16 +109,43 @@ private slots:
 	void loadGMPatch();
 
 private:
+	struct RegisterWrite
+	{
+		unsigned char reg;
+		unsigned char value;
+	} ;
+
+	// queue a register-write for play() - m_writeMutex has to be locked
+	void queueWrite( int reg, int value );
+	// write current patch to all voices - called by play() only, returns
+	// false without blocking if patch is being changed at the moment
+	bool applyPatch();
+
+	// only accessed by play(), everything else queues writes or changes
+	// the patch, so that neither MIDI-events nor patch-changes ever block
+	// rendering and instances don't depend on each other
 	Copl *theEmulator;
 	fpp_t frameCount;
 	short *renderbuffer;
+
+	// serialises threads sending MIDI-events or changing the patch
+	QMutex m_writeMutex;
+	LocklessRingBuffer<RegisterWrite, 1024> m_writes;
+	// writes not fitting into m_writes - they must not be dropped as
+	// notes would hang otherwise
+	QVector<RegisterWrite> m_overflow;
+	AtomicInt m_overflowPending;
+	unsigned char m_patch[14];
+	unsigned char m_rhythmReg;	// 0xBD
+	AtomicInt m_patchChanged;
+
 	int voiceNote[9];
+	int lastVoice;
 	int heldNotes[128];
 	// These include both octave and Fnumber
 	int fnums[128];
 
 	int Hz2fnum(float Hz);
-	static QMutex emulatorMutex;
 };
 
 
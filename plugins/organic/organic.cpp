@@ -76,10 +76,13 @@ QPixmap * organicInstrumentView::s_artwork = NULL;
 organicInstrument::organicInstrument( InstrumentTrack * _instrument_track ) :
 	Instrument( _instrument_track, &organic_plugin_descriptor ),
 	m_modulationAlgo( Oscillator::SignalMix ),
+	m_oscLeft( NULL ),
+	m_oscRight( NULL ),
+	m_voices(),
 	m_fx1Model( 0.0f, 0.0f, 0.99f, 0.01f , this, tr( "Distortion" ) ),
 	m_volModel( 100.0f, 0.0f, 200.0f, 1.0f, this, tr( "Volume" ) )
 {
-	m_numOscillators = 8;
+	m_numOscillators = NUM_OF_OSCILLATORS;
 
 	m_osc = new OscillatorObject*[ m_numOscillators ];
 	for (int i=0; i < m_numOscillators; i++)
@@ -114,6 +117,25 @@ organicInstrument::organicInstrument( InstrumentTrack * _instrument_track ) :
 		m_osc[i]->updateVolume();
 		m_osc[i]->updateDetuning();
 	}
+
+	// build chains from last oscillator (which needs no sub-osc) to first
+	for( int i = m_numOscillators - 1; i >= 0; --i )
+	{
+		m_oscLeft = new Oscillator(
+				&m_osc[i]->m_waveShape,
+				&m_modulationAlgo,
+				m_osc[i]->m_detuningLeft,
+				m_osc[i]->m_phaseOffsetLeft,
+				m_osc[i]->m_volumeLeft,
+				m_oscLeft );
+		m_oscRight = new Oscillator(
+				&m_osc[i]->m_waveShape,
+				&m_modulationAlgo,
+				m_osc[i]->m_detuningRight,
+				m_osc[i]->m_phaseOffsetRight,
+				m_osc[i]->m_volumeRight,
+				m_oscRight );
+	}
 	
 
 	connect( engine::mixer(), SIGNAL( sampleRateChanged() ),
@@ -126,6 +148,8 @@ organicInstrument::organicInstrument( InstrumentTrack * _instrument_track ) :
 
 organicInstrument::~organicInstrument()
 {
+	delete m_oscLeft;
+	delete m_oscRight;
 	delete[] m_osc;
 }
 
@@ -187,77 +211,28 @@ void organicInstrument::playNote( notePlayHandle * _n,
 {
 	if( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
-		Oscillator * oscs_l[m_numOscillators];
-		Oscillator * oscs_r[m_numOscillators];
-
 		for( int i = m_numOscillators - 1; i >= 0; --i )
 		{
-			
 			m_osc[i]->m_phaseOffsetLeft = rand()
 							/ ( RAND_MAX + 1.0f );
 			m_osc[i]->m_phaseOffsetRight = rand()
 							/ ( RAND_MAX + 1.0f );
-			
-
-			
-			// initialise ocillators
-			
-			if( i == m_numOscillators - 1 )
-			{
-				// create left oscillator
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						m_osc[i]->m_phaseOffsetLeft,
-						m_osc[i]->m_volumeLeft );
-				// create right oscillator
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						m_osc[i]->m_phaseOffsetRight,
-						m_osc[i]->m_volumeRight );
-			}
-			else
-			{
-				// create left oscillator
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						m_osc[i]->m_phaseOffsetLeft,
-						m_osc[i]->m_volumeLeft,
-						oscs_l[i + 1] );
-				// create right oscillator
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						m_osc[i]->m_phaseOffsetRight,
-						m_osc[i]->m_volumeRight,
-						oscs_r[i + 1] );
-			}
-			
-				
 		}
 
-		_n->m_pluginData = new oscPtr;
-		static_cast<oscPtr *>( _n->m_pluginData )->oscLeft = oscs_l[0];
-		static_cast<oscPtr *>( _n->m_pluginData )->oscRight = oscs_r[0];
+		voiceState * v = m_voices.allocate();
+		m_oscLeft->initState( v->left );
+		m_oscRight->initState( v->right );
+		_n->m_pluginData = v;
 	}
 
-	Oscillator * osc_l = static_cast<oscPtr *>( _n->m_pluginData )->oscLeft;
-	Oscillator * osc_r = static_cast<oscPtr *>( _n->m_pluginData)->oscRight;
+	voiceState * v = static_cast<voiceState *>( _n->m_pluginData );
 
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
 
-	osc_l->update( _working_buffer, frames, 0 );
-	osc_r->update( _working_buffer, frames, 1 );
+	m_oscLeft->update( _working_buffer, frames, 0, _n->frequency(),
+								v->left );
+	m_oscRight->update( _working_buffer, frames, 1, _n->frequency(),
+								v->right );
 
 
 	// -- fx section --
@@ -283,11 +258,7 @@ void organicInstrument::playNote( notePlayHandle * _n,
 
 void organicInstrument::deleteNotePluginData( notePlayHandle * _n )
 {
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscLeft );
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscRight );
-	delete static_cast<oscPtr *>( _n->m_pluginData );
+	m_voices.release( static_cast<voiceState *>( _n->m_pluginData ) );
 }
 
 /*float inline organicInstrument::foldback(float in, float threshold)
@@ -29,6 +29,7 @@
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Oscillator.h"
+#include "ObjectPool.h"
 #include "AutomatableModel.h"
 
 class QPixmap;
@@ -37,6 +38,8 @@ class knob;
 class notePlayHandle;
 class pixmapButton;
 
+const int NUM_OF_OSCILLATORS = 8;
+
 
 class OscillatorObject : public Model
 {
@@ -111,14 +114,22 @@ private:
 	int m_numOscillators;
 	
 	OscillatorObject ** m_osc;
-	
-	struct oscPtr
+
+	const IntModel m_modulationAlgo;
+
+	// oscillator-chains shared by all notes - they refer to the parameters
+	// of m_osc and therefore never have to be rebuilt
+	Oscillator * m_oscLeft;
+	Oscillator * m_oscRight;
+
+	// all a note has to keep
+	struct voiceState
 	{
-		Oscillator * oscLeft;
-		Oscillator * oscRight;
+		Oscillator::State left[NUM_OF_OSCILLATORS];
+		Oscillator::State right[NUM_OF_OSCILLATORS];
 	} ;
 
-	const IntModel m_modulationAlgo;
+	ObjectPool<voiceState> m_voices;
 
 	FloatModel  m_fx1Model;
 	FloatModel  m_volModel;
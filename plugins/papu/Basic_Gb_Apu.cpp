@@ -63,11 +63,20 @@ long Basic_Gb_Apu::read_samples( sample_t* out, long count )
 	return buf.read_samples( out, count );
 }
 
+long Basic_Gb_Apu::read_samples( float* out, long count )
+{
+	return buf.read_samples( out, count );
+}
+
 //added by 589 --->
 
 void Basic_Gb_Apu::reset()
 {
+	// bring registers, oscillators and buffered output back to state
+	// of a newly constructed object so that it can be re-used
+	time = 0;
 	apu.reset();
+	buf.clear();
 }
 
 void Basic_Gb_Apu::treble_eq( const blip_eq_t& eq )
@@ -33,6 +33,8 @@ public:
 	// Read at most 'count' samples out of buffer and return number actually read
 	typedef blip_sample_t sample_t;
 	long read_samples( sample_t* out, long count );
+	// Same, but converts to floats in range -1 to 1
+	long read_samples( float* out, long count );
 
 	//added by 589 --->
 	void reset();
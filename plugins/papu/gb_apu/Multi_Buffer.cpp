@@ -116,6 +116,17 @@ void Stereo_Buffer::end_frame( blip_time_t clock_count, bool stereo )
 }
 
 long Stereo_Buffer::read_samples( blip_sample_t* out, long count )
+{
+	return read_samples_( out, count );
+}
+
+long Stereo_Buffer::read_samples( float* out, long count )
+{
+	return read_samples_( out, count );
+}
+
+template<class T>
+long Stereo_Buffer::read_samples_( T* out, long count )
 {
 	require( !(count & 1) ); // count must be even
 	count = (unsigned) count / 2;
@@ -213,3 +224,56 @@ void Stereo_Buffer::mix_mono( blip_sample_t* out, long count )
 	in.end( bufs [0] );
 }
 
+// added for LMMS --->
+static inline float sample_to_float( long s )
+{
+	if ( (BOOST::int16_t) s != s )
+		s = (BOOST::int16_t) (0x7FFF - (s >> 24));
+	return s * (1.0f / 32768.0f);
+}
+
+void Stereo_Buffer::mix_stereo( float* out, long count )
+{
+	Blip_Reader left; 
+	Blip_Reader right; 
+	Blip_Reader center;
+	
+	left.begin( bufs [1] );
+	right.begin( bufs [2] );
+	int bass = center.begin( bufs [0] );
+	
+	while ( count-- )
+	{
+		int c = center.read();
+		long l = c + left.read();
+		long r = c + right.read();
+		center.next( bass );
+		left.next( bass );
+		right.next( bass );
+		out [0] = sample_to_float( l );
+		out [1] = sample_to_float( r );
+		out += 2;
+	}
+	
+	center.end( bufs [0] );
+	right.end( bufs [2] );
+	left.end( bufs [1] );
+}
+
+void Stereo_Buffer::mix_mono( float* out, long count )
+{
+	Blip_Reader in;
+	int bass = in.begin( bufs [0] );
+	
+	while ( count-- )
+	{
+		long s = in.read();
+		in.next( bass );
+		out [0] = out [1] = sample_to_float( s );
+		out += 2;
+	}
+	
+	in.end( bufs [0] );
+}
+// <---
+
@@ -107,6 +107,9 @@ public:
 	
 	long samples_avail() const;
 	long read_samples( blip_sample_t*, long );
+	// added for LMMS: same as above but converts directly to floats in
+	// range -1.0 to 1.0 (clamped like 16-bit output)
+	long read_samples( float*, long );
 	
 private:
 	enum { buf_count = 3 };
@@ -115,8 +118,12 @@ private:
 	bool stereo_added;
 	bool was_stereo;
 	
+	template<class T>
+	long read_samples_( T*, long );
 	void mix_stereo( blip_sample_t*, long );
 	void mix_mono( blip_sample_t*, long );
+	void mix_stereo( float*, long );
+	void mix_mono( float*, long );
 };
 
 // Silent_Buffer generates no samples, useful where no sound is wanted
@@ -57,6 +57,10 @@ Plugin::Descriptor PLUGIN_EXPORT papu_plugin_descriptor =
 }
 
 
+// maximum number of idle APUs kept for re-use
+#define APUPOOLMAX 16
+
+
 papuInstrument::papuInstrument( InstrumentTrack * _instrument_track ) :
 	Instrument( _instrument_track, &papu_plugin_descriptor ),
 
@@ -108,13 +112,20 @@ papuInstrument::papuInstrument( InstrumentTrack * _instrument_track ) :
 	m_trebleModel( -20.0f, -100.0f, 200.0f, 1.0f, this, tr( "Treble" ) ),
 	m_bassModel( 461.0f, -1.0f, 600.0f, 1.0f, this, tr( "Bass" ) ),
 
-	m_graphModel( 0, 15, 32, this, false, 1 )
+	m_graphModel( 0, 15, 32, this, false, 1 ),
+	m_poolMutex(),
+	m_apuPool(),
+	m_poolSampleRate( engine::mixer()->processingSampleRate() )
 {
 }
 
 
 papuInstrument::~papuInstrument()
 {
+	foreach( Basic_Gb_Apu * apu, m_apuPool )
+	{
+		delete apu;
+	}
 }
 
 
@@ -231,11 +242,78 @@ f_cnt_t papuInstrument::desiredReleaseFrames() const
 
 
 
+Basic_Gb_Apu * papuInstrument::acquireApu()
+{
+	const sample_rate_t samplerate =
+				engine::mixer()->processingSampleRate();
+	Basic_Gb_Apu * papu = NULL;
+
+	m_poolMutex.lock();
+	if( m_poolSampleRate != samplerate )
+	{
+		// pooled APUs were set up for old sample-rate
+		foreach( Basic_Gb_Apu * apu, m_apuPool )
+		{
+			delete apu;
+		}
+		m_apuPool.clear();
+		m_poolSampleRate = samplerate;
+	}
+	if( !m_apuPool.isEmpty() )
+	{
+		papu = m_apuPool.takeLast();
+	}
+	m_poolMutex.unlock();
+
+	if( papu == NULL )
+	{
+		papu = new Basic_Gb_Apu();
+		papu->set_sample_rate( samplerate );
+	}
+	else
+	{
+		papu->reset();
+	}
+
+	return papu;
+}
+
+
+
+
+void papuInstrument::releaseApu( Basic_Gb_Apu * _apu )
+{
+	QMutexLocker ml( &m_poolMutex );
+	if( m_apuPool.size() < APUPOOLMAX )
+	{
+		m_apuPool.push_back( _apu );
+	}
+	else
+	{
+		delete _apu;
+	}
+}
+
+
+
+
+void papuInstrument::writeRegister( papuNote * _note, int _addr, int _data )
+{
+	int & reg = _note->regs[_addr - 0xff10];
+	if( reg != _data )
+	{
+		_note->apu->write_register( _addr, _data );
+		reg = _data;
+	}
+}
+
+
+
+
 void papuInstrument::playNote( notePlayHandle * _n,
 						sampleFrame * _working_buffer )
 {
 	const f_cnt_t tfp = _n->totalFramesPlayed();
-	const int samplerate = engine::mixer()->processingSampleRate();
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
 
 	int data = 0;
@@ -243,25 +321,30 @@ void papuInstrument::playNote( notePlayHandle * _n,
 
 	if ( tfp == 0 )
 	{
-		Basic_Gb_Apu *papu = new Basic_Gb_Apu();
-		papu->set_sample_rate( samplerate );
+		papuNote * note = new papuNote;
+		note->apu = acquireApu();
+		for( int i = 0; i < 0x30; ++i )
+		{
+			note->regs[i] = -1;
+		}
+		_n->m_pluginData = note;
 
 		// Master sound circuitry power control
-		papu->write_register( 0xff26, 0x80 );
+		writeRegister( note, 0xff26, 0x80 );
 
 		data = m_ch1VolumeModel.value();
 		data = data<<1;
 		data += m_ch1VolSweepDirModel.value();
 		data = data<<3;
 		data += m_ch1SweepStepLengthModel.value();
-		papu->write_register( 0xff12, data );
+		writeRegister( note, 0xff12, data );
 
 		data = m_ch2VolumeModel.value();
 		data = data<<1;
 		data += m_ch2VolSweepDirModel.value();
 		data = data<<3;
 		data += m_ch2SweepStepLengthModel.value();
-		papu->write_register( 0xff17, data );
+		writeRegister( note, 0xff17, data );
 
 		//channel 4 - noise
 		data = m_ch4VolumeModel.value();
@@ -269,54 +352,56 @@ void papuInstrument::playNote( notePlayHandle * _n,
 		data += m_ch4VolSweepDirModel.value();
 		data = data<<3;
 		data += m_ch4SweepStepLengthModel.value();
-		papu->write_register( 0xff21, data );
+		writeRegister( note, 0xff21, data );
 
 		//channel 4 init
-		papu->write_register( 0xff23, 128 );
-
-		_n->m_pluginData = papu;
+		writeRegister( note, 0xff23, 128 );
 	}
 
-	Basic_Gb_Apu *papu = static_cast<Basic_Gb_Apu *>( _n->m_pluginData );
+	papuNote * note = static_cast<papuNote *>( _n->m_pluginData );
+	Basic_Gb_Apu *papu = note->apu;
 
 	papu->treble_eq( m_trebleModel.value() );
 	papu->bass_freq( m_bassModel.value() );
 
+	// registers which didn't change since last period aren't written
+	// again
+
 	//channel 1 - square
 	data = m_ch1SweepTimeModel.value();
 	data = data<<1;
 	data += m_ch1SweepDirModel.value();
 	data = data << 3;
 	data += m_ch1SweepRtShiftModel.value();
-	papu->write_register( 0xff10, data );
+	writeRegister( note, 0xff10, data );
 
 	data = m_ch1WavePatternDutyModel.value();
 	data = data<<6;
-	papu->write_register( 0xff11, data );
+	writeRegister( note, 0xff11, data );
 
 
 	//channel 2 - square
 	data = m_ch2WavePatternDutyModel.value();
 	data = data<<6;
-	papu->write_register( 0xff16, data );
+	writeRegister( note, 0xff16, data );
 
 
 	//channel 3 - wave
 	//data = m_ch3OnModel.value()?128:0;
 	data = 128;
-	papu->write_register( 0xff1a, data );
+	writeRegister( note, 0xff1a, data );
 
 	int ch3voldata[4] = { 0, 3, 2, 1 };
 	data = ch3voldata[(int)m_ch3VolumeModel.value()];
 	data = data<<5;
-	papu->write_register( 0xff1c, data );
+	writeRegister( note, 0xff1c, data );
 
 
 	//controls
 	data = m_so1VolumeModel.value();
 	data = data<<4;
 	data += m_so2VolumeModel.value();
-	papu->write_register( 0xff24, data );
+	writeRegister( note, 0xff24, data );
 
 	data = m_ch4So2Model.value()?128:0;
 	data += m_ch3So2Model.value()?64:0;
@@ -326,7 +411,7 @@ void papuInstrument::playNote( notePlayHandle * _n,
 	data += m_ch3So1Model.value()?4:0;
 	data += m_ch2So1Model.value()?2:0;
 	data += m_ch1So1Model.value()?1:0;
-	papu->write_register( 0xff25, data );
+	writeRegister( note, 0xff25, data );
 
 	const float * wpm = m_graphModel.samples();
 
@@ -334,7 +419,7 @@ void papuInstrument::playNote( notePlayHandle * _n,
 	{
 		data = (int)floor(wpm[i*2]) << 4;
 		data += (int)floor(wpm[i*2+1]);
-		papu->write_register( 0xff30 + i, data );
+		writeRegister( note, 0xff30 + i, data );
 	}
 
 	if( ( freq >= 65 ) && ( freq <=4000 ) )
@@ -344,13 +429,13 @@ void papuInstrument::playNote( notePlayHandle * _n,
 		data = 2048 - ( ( 4194304 / freq )>>5 );
 		if( tfp==0 )
 		{
-			papu->write_register( 0xff13, data & 0xff );
-			papu->write_register( 0xff14, (data>>8) | initflag );
+			writeRegister( note, 0xff13, data & 0xff );
+			writeRegister( note, 0xff14, (data>>8) | initflag );
 		}
-		papu->write_register( 0xff18, data & 0xff );
-		papu->write_register( 0xff19, (data>>8) | initflag );
-		papu->write_register( 0xff1d, data & 0xff );
-		papu->write_register( 0xff1e, (data>>8) | initflag );
+		writeRegister( note, 0xff18, data & 0xff );
+		writeRegister( note, 0xff19, (data>>8) | initflag );
+		writeRegister( note, 0xff1d, data & 0xff );
+		writeRegister( note, 0xff1e, (data>>8) | initflag );
 	}
 
 	if( tfp == 0 )
@@ -374,13 +459,12 @@ void papuInstrument::playNote( notePlayHandle * _n,
 		data += m_ch4ShiftRegWidthModel.value();
 		data = data << 3;
 		data += ropt;
-		papu->write_register( 0xff22, data );
+		writeRegister( note, 0xff22, data );
 	}
 
-	int const buf_size = 2048;
+	// read samples as floats straight into working-buffer
 	int framesleft = frames;
 	int datalen = 0;
-	blip_sample_t buf [buf_size*2];
 	while( framesleft > 0 )
 	{
 		int avail = papu->samples_avail();
@@ -390,18 +474,9 @@ void papuInstrument::playNote( notePlayHandle * _n,
 			avail = papu->samples_avail();
 		}
 		datalen = framesleft>avail?avail:framesleft;
-		datalen = datalen>buf_size?buf_size:datalen;
-		
-		long count = papu->read_samples( buf, datalen*2)/2;
 
-		for( fpp_t frame = 0; frame < count; ++frame )
-		{
-			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
-			{
-				sample_t s = float(buf[frame*2+ch])/32768.0;
-				_working_buffer[frames-framesleft+frame][ch] = s;
-			}
-		}
+		long count = papu->read_samples(
+			_working_buffer[frames-framesleft], datalen*2 ) / 2;
 		framesleft -= count;
 	}
 	instrumentTrack()->processAudioBuffer( _working_buffer, frames, _n );
@@ -411,7 +486,12 @@ void papuInstrument::playNote( notePlayHandle * _n,
 
 void papuInstrument::deleteNotePluginData( notePlayHandle * _n )
 {
-	delete static_cast<Basic_Gb_Apu *>( _n->m_pluginData );
+	papuNote * note = static_cast<papuNote *>( _n->m_pluginData );
+	if( note != NULL )
+	{
+		releaseApu( note->apu );
+		delete note;
+	}
 }
 
 
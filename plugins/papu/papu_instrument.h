@@ -26,12 +26,15 @@
 #ifndef _PAPU_H
 #define _PAPU_H
 
+#include <QtCore/QList>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "knob.h"
 #include "graph.h"
 
+class Basic_Gb_Apu;
 class papuInstrumentView;
 class notePlayHandle;
 class pixmapButton;
@@ -64,6 +67,23 @@ public:
 	void updateKnobToolTip();*/
 
 private:
+	// per-note data
+	struct papuNote
+	{
+		Basic_Gb_Apu * apu;
+		// last values written to registers 0xff10 - 0xff3f, -1 if
+		// not written yet
+		int regs[0x30];
+	} ;
+
+	// take an APU with registers and buffers cleared out of the pool or
+	// create a new one
+	Basic_Gb_Apu * acquireApu();
+	void releaseApu( Basic_Gb_Apu * _apu );
+
+	// write register only if its value changed since last write
+	static void writeRegister( papuNote * _note, int _addr, int _data );
+
 	FloatModel m_ch1SweepTimeModel;
 	BoolModel m_ch1SweepDirModel;
 	FloatModel m_ch1SweepRtShiftModel;
@@ -102,6 +122,12 @@ private:
 
 	graphModel  m_graphModel;
 
+	// allocating the sample-buffers of an APU is expensive, so APUs are
+	// re-used across notes
+	QMutex m_poolMutex;
+	QList<Basic_Gb_Apu *> m_apuPool;
+	sample_rate_t m_poolSampleRate;
+
 	friend class papuInstrumentView;
 } ;
 
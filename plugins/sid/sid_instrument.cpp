@@ -33,8 +33,10 @@
 
 #include "sid_instrument.h"
 #include "engine.h"
+#include "InstrumentPlayHandle.h"
 #include "InstrumentTrack.h"
 #include "knob.h"
+#include "led_checkbox.h"
 #include "note_play_handle.h"
 #include "pixmap_button.h"
 #include "tooltip.h"
@@ -47,6 +49,10 @@
 #define SIDWRITEDELAY 9 // lda $xxxx,x 4 cycles, sta $d400,x 5 cycles
 #define SIDWAVEDELAY 4 // and $xxxx,x 4 cycles extra
 
+// number of chips created in advance and maximum number kept for re-use
+#define SIDPOOLINITIAL 4
+#define SIDPOOLMAX 16
+
 unsigned char sidorder[] =
   {0x15,0x16,0x18,0x17,
    0x05,0x06,0x02,0x03,0x00,0x01,0x04,
@@ -126,17 +132,43 @@ sidInstrument::sidInstrument( InstrumentTrack * _instrument_track ) :
 	// misc
 	m_voice3OffModel( false, this, tr( "Voice 3 off" ) ),
 	m_volumeModel( 15.0f, 0.0f, 15.0f, 1.0f, this, tr( "Volume" ) ),
-	m_chipModel( sidMOS8580, 0, NumChipModels-1, this, tr( "Chip model" ) )
+	m_chipModel( sidMOS8580, 0, NumChipModels-1, this, tr( "Chip model" ) ),
+	m_multiVoiceModel( false, this, tr( "Multi-voice" ) ),
+	m_poolMutex(),
+	m_sidPool(),
+	m_poolSampleRate( engine::mixer()->processingSampleRate() ),
+	m_chipsMutex(),
+	m_chips()
 {
 	for( int i = 0; i < 3; ++i )
 	{
 		m_voice[i] = new voiceObject( this, i );
 	}
+
+	for( int i = 0; i < SIDPOOLINITIAL; ++i )
+	{
+		releaseSid( acquireSid() );
+	}
+
+	// renders chips shared by notes in multi-voice mode
+	InstrumentPlayHandle * iph = new InstrumentPlayHandle( this );
+	engine::mixer()->addPlayHandle( iph );
 }
 
 
 sidInstrument::~sidInstrument()
 {
+	engine::mixer()->removePlayHandles( instrumentTrack() );
+
+	foreach( sidChip * chip, m_chips )
+	{
+		delete chip->sid;
+		delete chip;
+	}
+	foreach( cSID * sid, m_sidPool )
+	{
+		delete sid;
+	}
 }
 
 
@@ -181,6 +213,7 @@ void sidInstrument::saveSettings( QDomDocument & _doc,
 	m_voice3OffModel.saveSettings( _doc, _this, "voice3Off" );
 	m_volumeModel.saveSettings( _doc, _this, "volume" );
 	m_chipModel.saveSettings( _doc, _this, "chipModel" );
+	m_multiVoiceModel.saveSettings( _doc, _this, "multiVoice" );
 }
 
 
@@ -215,6 +248,7 @@ void sidInstrument::loadSettings( const QDomElement & _this )
 	m_voice3OffModel.loadSettings( _this, "voice3Off" );
 	m_volumeModel.loadSettings( _this, "volume" );
 	m_chipModel.loadSettings( _this, "chipModel" );
+	m_multiVoiceModel.loadSettings( _this, "multiVoice" );
 }
 
 
@@ -299,128 +333,340 @@ static int sid_fillbuffer(unsigned char* sidreg, cSID *sid, int tdelta, short *p
 
 
 
-void sidInstrument::playNote( notePlayHandle * _n,
-						sampleFrame * _working_buffer )
+cSID * sidInstrument::acquireSid()
 {
-	const f_cnt_t tfp = _n->totalFramesPlayed();
+	const sample_rate_t samplerate =
+				engine::mixer()->processingSampleRate();
+	cSID * sid = NULL;
 
-	const int clockrate = C64_PAL_CYCLES_PER_SEC;
-	const int samplerate = engine::mixer()->processingSampleRate();
+	m_poolMutex.lock();
+	if( m_poolSampleRate != samplerate )
+	{
+		// pooled chips were set up for old sample-rate
+		foreach( cSID * s, m_sidPool )
+		{
+			delete s;
+		}
+		m_sidPool.clear();
+		m_poolSampleRate = samplerate;
+	}
+	if( !m_sidPool.isEmpty() )
+	{
+		sid = m_sidPool.takeLast();
+	}
+	m_poolMutex.unlock();
 
-	if ( tfp == 0 )
+	if( sid == NULL )
 	{
-		cSID *sid = new cSID();
-		sid->set_sampling_parameters( clockrate, SAMPLE_FAST, samplerate );
+		sid = new cSID();
+		sid->set_sampling_parameters( C64_PAL_CYCLES_PER_SEC,
+						SAMPLE_FAST, samplerate );
 		sid->set_chip_model( MOS8580 );
 		sid->enable_filter( true );
-		sid->reset();
-		_n->m_pluginData = sid;
 	}
-	const fpp_t frames = _n->framesLeftForCurrentPeriod();
+	sid->reset();
 
-	cSID *sid = static_cast<cSID *>( _n->m_pluginData );
-	int delta_t = clockrate * frames / samplerate + 4;
-	short buf[frames];
-	unsigned char sidreg[NUMSIDREGS];
+	return sid;
+}
 
-	for (int c = 0; c < NUMSIDREGS; c++)
-	{
-		sidreg[c] = 0x00;
-	}
 
-	if( (ChipModel)m_chipModel.value() == sidMOS6581 )
+
+
+void sidInstrument::releaseSid( cSID * _sid )
+{
+	QMutexLocker ml( &m_poolMutex );
+	if( m_sidPool.size() < SIDPOOLMAX )
 	{
-		sid->set_chip_model( MOS6581 );
+		m_sidPool.push_back( _sid );
 	}
 	else
 	{
-		sid->set_chip_model( MOS8580 );
+		delete _sid;
 	}
+}
 
-	// voices
+
+
+
+void sidInstrument::setVoiceRegs( unsigned char * _regs, int _v, int _params,
+					float _freq, bool _gate ) const
+{
+	const voiceObject * vo = m_voice[_params];
+	const int base = _v*7;
 	reg8 data8 = 0;
 	reg8 data16 = 0;
-	reg8 base = 0;
-	float freq = 0.0;
-	float note = 0.0;
-	for( reg8 i = 0 ; i < 3 ; ++i )
-	{
-		base = i*7;
-		// freq ( Fn = Fout / Fclk * 16777216 ) + coarse detuning
-		freq = _n->frequency();
-		note = 69.0 + 12.0 * log( freq / 440.0 ) / log( 2 );
-		note += m_voice[i]->m_coarseModel.value();
-		freq = 440.0 * pow( 2.0, (note-69.0)/12.0 );
-		data16 = int( freq / float(clockrate) * 16777216.0 );
-
-		sidreg[base+0] = data16&0x00FF;
-		sidreg[base+1] = (data16>>8)&0x00FF;
-		// pw
-		data16 = (int)m_voice[i]->m_pulseWidthModel.value();
-		
-		sidreg[base+2] = data16&0x00FF;
-		sidreg[base+3] = (data16>>8)&0x000F;
-		// control: wave form, (test), ringmod, sync, gate
-		data8 = _n->released()?0:1;
-		data8 += m_voice[i]->m_syncModel.value()?2:0;
-		data8 += m_voice[i]->m_ringModModel.value()?4:0;
-		data8 += m_voice[i]->m_testModel.value()?8:0;
-		switch( m_voice[i]->m_waveFormModel.value() )
-		{	
-			default: break;
-			case voiceObject::NoiseWave:	data8 += 128; break;
-			case voiceObject::SquareWave:	data8 += 64; break;
-			case voiceObject::SawWave:		data8 += 32; break;
-			case voiceObject::TriangleWave:	data8 += 16; break;
-		}
-		sidreg[base+4] = data8&0x00FF;
-		// ad
-		data16 = (int)m_voice[i]->m_attackModel.value();
 
-		data8 = (data16&0x0F)<<4;
-		data16 = (int)m_voice[i]->m_decayModel.value();
+	// freq ( Fn = Fout / Fclk * 16777216 ) + coarse detuning
+	float note = 69.0 + 12.0 * log( _freq / 440.0 ) / log( 2 );
+	note += vo->m_coarseModel.value();
+	const float freq = 440.0 * pow( 2.0, (note-69.0)/12.0 );
+	data16 = int( freq / float(C64_PAL_CYCLES_PER_SEC) * 16777216.0 );
+
+	_regs[base+0] = data16&0x00FF;
+	_regs[base+1] = (data16>>8)&0x00FF;
+	// pw
+	data16 = (int)vo->m_pulseWidthModel.value();
+
+	_regs[base+2] = data16&0x00FF;
+	_regs[base+3] = (data16>>8)&0x000F;
+	// control: wave form, (test), ringmod, sync, gate
+	data8 = _gate?1:0;
+	data8 += vo->m_syncModel.value()?2:0;
+	data8 += vo->m_ringModModel.value()?4:0;
+	data8 += vo->m_testModel.value()?8:0;
+	switch( vo->m_waveFormModel.value() )
+	{
+		default: break;
+		case voiceObject::NoiseWave:	data8 += 128; break;
+		case voiceObject::SquareWave:	data8 += 64; break;
+		case voiceObject::SawWave:		data8 += 32; break;
+		case voiceObject::TriangleWave:	data8 += 16; break;
+	}
+	_regs[base+4] = data8&0x00FF;
+	// ad
+	data16 = (int)vo->m_attackModel.value();
+
+	data8 = (data16&0x0F)<<4;
+	data16 = (int)vo->m_decayModel.value();
 
-		data8 += (data16&0x0F);
-		sidreg[base+5] = data8&0x00FF;
-		// sr
-		data16 = (int)m_voice[i]->m_sustainModel.value();
+	data8 += (data16&0x0F);
+	_regs[base+5] = data8&0x00FF;
+	// sr
+	data16 = (int)vo->m_sustainModel.value();
 
-		data8 = (data16&0x0F)<<4;
-		data16 = (int)m_voice[i]->m_releaseModel.value();
+	data8 = (data16&0x0F)<<4;
+	data16 = (int)vo->m_releaseModel.value();
+
+	data8 += (data16&0x0F);
+	_regs[base+6] = data8&0x00FF;
+}
+
+
+
+
+void sidInstrument::setCommonRegs( unsigned char * _regs,
+						bool _multi_voice ) const
+{
+	reg8 data8 = 0;
+	reg8 data16 = 0;
 
-		data8 += (data16&0x0F);
-		sidreg[base+6] = data8&0x00FF;
-	}
 	// filtered
 
 	// FC (FilterCutoff)
 	data16 = (int)m_filterFCModel.value();
-	sidreg[21] = data16&0x0007;
-	sidreg[22] = (data16>>3)&0x00FF;
-	
+	_regs[21] = data16&0x0007;
+	_regs[22] = (data16>>3)&0x00FF;
+
 	// res, filt ex,3,2,1
 	data16 = (int)m_filterResonanceModel.value();
 	data8 = (data16&0x000F)<<4;
-	data8 += m_voice[2]->m_filteredModel.value()?4:0;
-	data8 += m_voice[1]->m_filteredModel.value()?2:0;
-	data8 += m_voice[0]->m_filteredModel.value()?1:0;
-	sidreg[23] = data8&0x00FF;
+	if( _multi_voice )
+	{
+		// every voice plays a note with settings of first voice
+		data8 += m_voice[0]->m_filteredModel.value()?7:0;
+	}
+	else
+	{
+		data8 += m_voice[2]->m_filteredModel.value()?4:0;
+		data8 += m_voice[1]->m_filteredModel.value()?2:0;
+		data8 += m_voice[0]->m_filteredModel.value()?1:0;
+	}
+	_regs[23] = data8&0x00FF;
 
 	// mode vol
 	data16 = (int)m_volumeModel.value();
 	data8 = data16&0x000F;
-	data8 += m_voice3OffModel.value()?128:0;
+	// voice 3 plays notes as well in multi-voice mode
+	data8 += ( m_voice3OffModel.value() && !_multi_voice )?128:0;
 
 	switch( m_filterModeModel.value() )
-	{	
+	{
 		default: break;
 		case LowPass:	data8 += 16; break;
 		case BandPass:	data8 += 32; break;
 		case HighPass:	data8 += 64; break;
 	}
 
-	sidreg[24] = data8&0x00FF;
-		
+	_regs[24] = data8&0x00FF;
+}
+
+
+
+
+void sidInstrument::play( sampleFrame * _working_buffer )
+{
+	const fpp_t frames = engine::mixer()->framesPerPeriod();
+	const int samplerate = engine::mixer()->processingSampleRate();
+	const int delta_t = C64_PAL_CYCLES_PER_SEC * frames / samplerate + 4;
+	short buf[frames];
+
+	QMutexLocker ml( &m_chipsMutex );
+	if( m_chips.isEmpty() )
+	{
+		return;
+	}
+
+	engine::mixer()->clearAudioBuffer( _working_buffer, frames );
+
+	for( QList<sidChip *>::Iterator it = m_chips.begin();
+							it != m_chips.end(); )
+	{
+		sidChip * chip = *it;
+		bool used = false;
+		for( int v = 0; v < 3; ++v )
+		{
+			const sidNote * n = chip->voices[v];
+			if( n != NULL )
+			{
+				// all notes are played with settings of
+				// first voice
+				setVoiceRegs( chip->regs, v, 0, n->frequency,
+								!n->released );
+				used = true;
+			}
+			else
+			{
+				// keep releasing last note of this voice
+				chip->regs[v*7+4] &= 0xFE;
+			}
+		}
+		setCommonRegs( chip->regs, true );
+		chip->sid->set_chip_model(
+			(ChipModel)m_chipModel.value() == sidMOS6581 ?
+							MOS6581 : MOS8580 );
+
+		const int num = sid_fillbuffer( chip->regs, chip->sid,
+							delta_t, buf, frames );
+		for( fpp_t frame = 0; frame < num; ++frame )
+		{
+			const sample_t s = float(buf[frame])/32768.0;
+			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			{
+				_working_buffer[frame][ch] += s;
+			}
+		}
+
+		if( used )
+		{
+			++it;
+		}
+		else
+		{
+			// all notes of chip have finished their release
+			releaseSid( chip->sid );
+			delete chip;
+			it = m_chips.erase( it );
+		}
+	}
+
+	instrumentTrack()->processAudioBuffer( _working_buffer, frames, NULL );
+}
+
+
+
+
+void sidInstrument::playMultiVoiceNote( notePlayHandle * _n,
+							sidNote * _note )
+{
+	QMutexLocker ml( &m_chipsMutex );
+
+	if( _note->chip == NULL )
+	{
+		// find a chip with a free voice or set up a new one
+		int voice = -1;
+		sidChip * chip = NULL;
+		foreach( sidChip * c, m_chips )
+		{
+			for( int v = 0; v < 3; ++v )
+			{
+				if( c->voices[v] == NULL )
+				{
+					chip = c;
+					voice = v;
+					break;
+				}
+			}
+			if( chip != NULL )
+			{
+				break;
+			}
+		}
+		if( chip == NULL )
+		{
+			chip = new sidChip;
+			chip->sid = acquireSid();
+			memset( chip->regs, 0, sizeof( chip->regs ) );
+			chip->voices[0] = chip->voices[1] =
+						chip->voices[2] = NULL;
+			m_chips.push_back( chip );
+			voice = 0;
+		}
+		chip->voices[voice] = _note;
+		_note->chip = chip;
+	}
+
+	// picked up by play()
+	_note->frequency = _n->frequency();
+	_note->released = _n->released();
+}
+
+
+
+
+void sidInstrument::playNote( notePlayHandle * _n,
+						sampleFrame * _working_buffer )
+{
+	const f_cnt_t tfp = _n->totalFramesPlayed();
+
+	const int clockrate = C64_PAL_CYCLES_PER_SEC;
+	const int samplerate = engine::mixer()->processingSampleRate();
+
+	if ( tfp == 0 )
+	{
+		sidNote * note = new sidNote;
+		note->chip = NULL;
+		note->frequency = _n->frequency();
+		note->released = false;
+		// mode of a note doesn't change while it's playing
+		note->sid = m_multiVoiceModel.value() ? NULL : acquireSid();
+		_n->m_pluginData = note;
+	}
+
+	sidNote * note = static_cast<sidNote *>( _n->m_pluginData );
+	if( note->sid == NULL )
+	{
+		playMultiVoiceNote( _n, note );
+		return;
+	}
+
+	const fpp_t frames = _n->framesLeftForCurrentPeriod();
+
+	cSID *sid = note->sid;
+	int delta_t = clockrate * frames / samplerate + 4;
+	short buf[frames];
+	unsigned char sidreg[NUMSIDREGS];
+
+	for (int c = 0; c < NUMSIDREGS; c++)
+	{
+		sidreg[c] = 0x00;
+	}
+
+	if( (ChipModel)m_chipModel.value() == sidMOS6581 )
+	{
+		sid->set_chip_model( MOS6581 );
+	}
+	else
+	{
+		sid->set_chip_model( MOS8580 );
+	}
+
+	// voices
+	for( int i = 0 ; i < 3 ; ++i )
+	{
+		setVoiceRegs( sidreg, i, i, _n->frequency(), !_n->released() );
+	}
+	setCommonRegs( sidreg, false );
+
 	int num = sid_fillbuffer(sidreg, sid,delta_t,buf, frames);
 	if(num!=frames)
 		printf("!!!Not enough samples\n");
@@ -442,7 +688,30 @@ void sidInstrument::playNote( notePlayHandle * _n,
 
 void sidInstrument::deleteNotePluginData( notePlayHandle * _n )
 {
-	delete static_cast<cSID *>( _n->m_pluginData );
+	sidNote * note = static_cast<sidNote *>( _n->m_pluginData );
+	if( note == NULL )
+	{
+		return;
+	}
+
+	if( note->sid != NULL )
+	{
+		releaseSid( note->sid );
+	}
+	else if( note->chip != NULL )
+	{
+		// free voice - chip is returned to pool by play() once it
+		// has no notes left
+		QMutexLocker ml( &m_chipsMutex );
+		for( int v = 0; v < 3; ++v )
+		{
+			if( note->chip->voices[v] == note )
+			{
+				note->chip->voices[v] = NULL;
+			}
+		}
+	}
+	delete note;
 }
 
 
@@ -543,6 +812,17 @@ sidInstrumentView::sidInstrumentView( Instrument * _instrument,
 	m_sidTypeBtnGrp->addButton( mos6581_btn );
 	m_sidTypeBtnGrp->addButton( mos8580_btn );
 
+	m_multiVoiceCheckBox = new ledCheckBox( tr( "Multi" ), this );
+	m_multiVoiceCheckBox->move( 110, 64 );
+	toolTip::add( m_multiVoiceCheckBox, tr( "Multi-voice" ) );
+	m_multiVoiceCheckBox->setWhatsThis(
+		tr( "When enabled, up to three notes share one chip, each one "
+			"playing on a single SID voice with the settings of "
+			"voice 1, just like on a real C64. Notes then start "
+			"and end at period boundaries and ignore velocity and "
+			"panning. Otherwise each note plays all three voices "
+			"on a chip of its own." ) );
+
 	for( int i = 0; i < 3; i++ ) 
 	{
 		knob *ak = new sidKnob( this );
@@ -757,6 +1037,7 @@ void sidInstrumentView::modelChanged()
 	m_passBtnGrp->setModel( &k->m_filterModeModel );
 	m_offButton->setModel(  &k->m_voice3OffModel );
 	m_sidTypeBtnGrp->setModel(  &k->m_chipModel );
+	m_multiVoiceCheckBox->setModel( &k->m_multiVoiceModel );
 
 	for( int i = 0; i < 3; ++i )
 	{
@@ -27,15 +27,19 @@
 #ifndef _SID_H
 #define _SID_H
 
+#include <QtCore/QList>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "knob.h"
 
 
+class cSID;
 class sidInstrumentView;
 class notePlayHandle;
 class automatableButtonGroup;
+class ledCheckBox;
 class pixmapButton;
 
 class voiceObject : public Model
@@ -91,10 +95,18 @@ public:
 	sidInstrument( InstrumentTrack * _instrument_track );
 	virtual ~sidInstrument();
 
+	virtual void play( sampleFrame * _working_buffer );
 	virtual void playNote( notePlayHandle * _n,
 						sampleFrame * _working_buffer );
 	virtual void deleteNotePluginData( notePlayHandle * _n );
 
+	// notes sharing chips in multi-voice mode are mixed via an
+	// InstrumentPlayHandle
+	virtual bool supportsOfflineRendering() const
+	{
+		return !m_multiVoiceModel.value();
+	}
+
 
 	virtual void saveSettings( QDomDocument & _doc, QDomElement & _parent );
 	virtual void loadSettings( const QDomElement & _this );
@@ -111,6 +123,44 @@ public:
 	void updateKnobToolTip();*/
 
 private:
+	struct sidChip;
+
+	// per-note data
+	struct sidNote
+	{
+		cSID * sid;		// own chip in normal mode
+		sidChip * chip;		// shared chip in multi-voice mode
+		float frequency;
+		bool released;
+	} ;
+
+	// chip whose three voices are shared by up to three notes in
+	// multi-voice mode - it's rendered once per period by play(), so notes
+	// start and end at period boundaries (play-handles of one period are
+	// processed in no particular order, so note-offsets within a period
+	// can't be honoured reliably) and velocity and panning of notes are
+	// ignored as all voices are mixed inside the chip
+	struct sidChip
+	{
+		cSID * sid;
+		unsigned char regs[0x19];	// NUMSIDREGS
+		sidNote * voices[3];
+	} ;
+
+	// take an initialised chip out of the pool or create a new one
+	cSID * acquireSid();
+	void releaseSid( cSID * _sid );
+
+	void playMultiVoiceNote( notePlayHandle * _n, sidNote * _note );
+
+	// registers of voice _v played with given note-frequency and gate
+	// using the parameters of voice _params
+	void setVoiceRegs( unsigned char * _regs, int _v, int _params,
+						float _freq, bool _gate ) const;
+	// filter, mode and volume registers - in multi-voice mode all voices
+	// use filter-routing of first voice and voice 3 is never turned off
+	void setCommonRegs( unsigned char * _regs, bool _multi_voice ) const;
+
 	// voices
 	voiceObject * m_voice[3];
 
@@ -125,6 +175,18 @@ private:
 
 	IntModel m_chipModel;
 
+	BoolModel m_multiVoiceModel;
+
+	// constructing and setting up a cSID is expensive, so chips are
+	// re-used across notes
+	QMutex m_poolMutex;
+	QList<cSID *> m_sidPool;
+	sample_rate_t m_poolSampleRate;
+
+	// chips shared by notes in multi-voice mode
+	QMutex m_chipsMutex;
+	QList<sidChip *> m_chips;
+
 	friend class sidInstrumentView;
 
 } ;
@@ -192,6 +254,7 @@ private:
 	knob * m_resKnob;
 	knob * m_cutKnob;
 	pixmapButton * m_offButton;
+	ledCheckBox * m_multiVoiceCheckBox;
 
 protected slots:
 	void updateKnobHint();
@@ -53,15 +53,10 @@ spectrumAnalyzer::spectrumAnalyzer( Model * _parent,
 			const Descriptor::SubPluginFeatures::Key * _key ) :
 	Effect( &spectrumanalyzer_plugin_descriptor, _parent, _key ),
 	m_saControls( this ),
-	m_framesFilledUp( 0 ),
+	m_analysis( FFT_BUFFER_SIZE*2 ),
 	m_energy( 0 )
 {
-	memset( m_buffer, 0, sizeof( m_buffer ) );
-
-	m_specBuf = (fftwf_complex *) fftwf_malloc( ( FFT_BUFFER_SIZE + 1 ) *
-						sizeof( fftwf_complex ) );
-	m_fftPlan = fftwf_plan_dft_r2c_1d( FFT_BUFFER_SIZE*2, m_buffer,
-						m_specBuf, FFTW_MEASURE );
+	memset( m_bands, 0, sizeof( m_bands ) );
 }
 
 
@@ -69,8 +64,6 @@ spectrumAnalyzer::spectrumAnalyzer( Model * _parent,
 
 spectrumAnalyzer::~spectrumAnalyzer()
 {
-	fftwf_destroy_plan( m_fftPlan );
-	fftwf_free( m_specBuf );
 }
 
 
@@ -89,78 +82,75 @@ bool spectrumAnalyzer::processAudioBuffer( sampleFrame * _buf,
 		return true;
 	}
 
-	fpp_t f = 0;
-	if( _frames > FFT_BUFFER_SIZE )
-	{
-		m_framesFilledUp = 0;
-		f = _frames - FFT_BUFFER_SIZE;
-	}
-
+	// the FFT itself is done by the analysis-thread, we just pass it
+	// the samples of the selected channel(s)
 	const int cm = m_saControls.m_channelMode.value();
+	const fpp_t CHUNK_SIZE = 256;
+	sample_t chunk[CHUNK_SIZE];
 
-	switch( cm )
+	for( fpp_t offset = 0; offset < _frames; offset += CHUNK_SIZE )
 	{
-		case MergeChannels:
-			for( ; f < _frames; ++f )
-			{
-				m_buffer[m_framesFilledUp] =
-					( _buf[f][0] + _buf[f][1] ) * 0.5;
-				++m_framesFilledUp;
-			}
-			break;
-		case LeftChannel:
-			for( ; f < _frames; ++f )
-			{
-				m_buffer[m_framesFilledUp] = _buf[f][0];
-				++m_framesFilledUp;
-			}
-			break;
-		case RightChannel:
-			for( ; f < _frames; ++f )
-			{
-				m_buffer[m_framesFilledUp] = _buf[f][1];
-				++m_framesFilledUp;
-			}
-			break;
+		const fpp_t n = qMin<fpp_t>( CHUNK_SIZE, _frames - offset );
+		const sampleFrame * buf = _buf + offset;
+		switch( cm )
+		{
+			case MergeChannels:
+				for( fpp_t f = 0; f < n; ++f )
+				{
+					chunk[f] = ( buf[f][0] + buf[f][1] ) * 0.5;
+				}
+				break;
+			case LeftChannel:
+				for( fpp_t f = 0; f < n; ++f )
+				{
+					chunk[f] = buf[f][0];
+				}
+				break;
+			case RightChannel:
+				for( fpp_t f = 0; f < n; ++f )
+				{
+					chunk[f] = buf[f][1];
+				}
+				break;
+		}
+		m_analysis.pushSamples( chunk, n );
 	}
 
-	if( m_framesFilledUp < FFT_BUFFER_SIZE )
-	{
-		return( isRunning() );
-	}
+	checkGate( 0 );
+
+	return( isRunning() );
+}
+
 
 
-//	hanming( m_buffer, FFT_BUFFER_SIZE, HAMMING );
+
+void spectrumAnalyzer::updateBands()
+{
+	const SpectrumAnalysis::Result & r = m_analysis.result();
+	if( r.bins == 0 || r.peak <= 0 )
+	{
+		m_energy = 0;
+		return;
+	}
 
 	const sample_rate_t sr = engine::mixer()->processingSampleRate();
 	const int LOWEST_FREQ = 0;
 	const int HIGHEST_FREQ = sr / 2;
 
-	fftwf_execute( m_fftPlan );
-	absspec( m_specBuf, m_absSpecBuf, FFT_BUFFER_SIZE+1 );
+	// absspec() etc. don't take const pointers
+	float * spec = const_cast<float *>( r.spectrum );
 	if( m_saControls.m_linearSpec.value() )
 	{
-		compressbands( m_absSpecBuf, m_bands, FFT_BUFFER_SIZE+1,
-			MAX_BANDS,
-			(int)(LOWEST_FREQ*(FFT_BUFFER_SIZE+1)/(float)(sr/2)),
-			(int)(HIGHEST_FREQ*(FFT_BUFFER_SIZE+1)/(float)(sr/2)));
-		m_energy = maximum( m_bands, MAX_BANDS ) /
-					maximum( m_buffer, FFT_BUFFER_SIZE );
+		compressbands( spec, m_bands, r.bins, MAX_BANDS,
+			(int)(LOWEST_FREQ*r.bins/(float)(sr/2)),
+			(int)(HIGHEST_FREQ*r.bins/(float)(sr/2)));
+		m_energy = maximum( m_bands, MAX_BANDS ) / r.peak;
 	}
 	else
 	{
-		calc13octaveband31( m_absSpecBuf, m_bands,
-						FFT_BUFFER_SIZE+1, sr/2.0 );
-		m_energy = signalpower( m_buffer, FFT_BUFFER_SIZE ) /
-					maximum( m_buffer, FFT_BUFFER_SIZE );
+		calc13octaveband31( spec, m_bands, r.bins, sr/2.0 );
+		m_energy = r.power / r.peak;
 	}
-
-
-	m_framesFilledUp = 0;
-
-	checkGate( 0 );
-
-	return( isRunning() );
 }
 
 
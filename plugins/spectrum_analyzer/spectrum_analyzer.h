@@ -28,6 +28,7 @@
 
 #include "Effect.h"
 #include "fft_helpers.h"
+#include "SpectrumAnalysis.h"
 #include "spectrumanalyzer_controls.h"
 
 
@@ -57,15 +58,15 @@ public:
 
 
 private:
-	spectrumAnalyzerControls m_saControls;
+	// compute m_bands and m_energy from latest result of m_analysis -
+	// called by spectrumView before painting
+	void updateBands();
 
-	fftwf_plan m_fftPlan;
+	spectrumAnalyzerControls m_saControls;
 
-	fftwf_complex * m_specBuf;
-	float m_absSpecBuf[FFT_BUFFER_SIZE+1];
-	float m_buffer[FFT_BUFFER_SIZE*2];
-	int m_framesFilledUp;
+	SpectrumAnalysis m_analysis;
 
+	// only used by GUI
 	float m_bands[MAX_BANDS];
 	float m_energy;
 
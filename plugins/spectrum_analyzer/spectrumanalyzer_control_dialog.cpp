@@ -71,6 +71,8 @@ public:
 
 	virtual void paintEvent( QPaintEvent * _pe )
 	{
+		m_sa->updateBands();
+
 		QPainter p( this );
 		QImage i = m_sa->m_saControls.m_linearSpec.value() ?
 					m_backgroundPlain : m_background;
@@ -210,7 +210,10 @@ void OscillatorObject::updatePhaseOffsetRight()
  
 
 TripleOscillator::TripleOscillator( InstrumentTrack * _instrument_track ) :
-	Instrument( _instrument_track, &tripleoscillator_plugin_descriptor )
+	Instrument( _instrument_track, &tripleoscillator_plugin_descriptor ),
+	m_oscLeft( NULL ),
+	m_oscRight( NULL ),
+	m_voices()
 {
 	for( int i = 0; i < NUM_OF_OSCILLATORS; ++i )
 	{
@@ -218,6 +221,27 @@ TripleOscillator::TripleOscillator( InstrumentTrack * _instrument_track ) :
 
 	}
 
+	// build chains from last oscillator (which needs no sub-osc) to first
+	for( int i = NUM_OF_OSCILLATORS - 1; i >= 0; --i )
+	{
+		m_oscLeft = new Oscillator(
+				&m_osc[i]->m_waveShapeModel,
+				&m_osc[i]->m_modulationAlgoModel,
+				m_osc[i]->m_detuningLeft,
+				m_osc[i]->m_phaseOffsetLeft,
+				m_osc[i]->m_volumeLeft,
+				m_oscLeft );
+		m_oscRight = new Oscillator(
+				&m_osc[i]->m_waveShapeModel,
+				&m_osc[i]->m_modulationAlgoModel,
+				m_osc[i]->m_detuningRight,
+				m_osc[i]->m_phaseOffsetRight,
+				m_osc[i]->m_volumeRight,
+				m_oscRight );
+		m_oscLeft->setUserWave( m_osc[i]->m_sampleBuffer );
+		m_oscRight->setUserWave( m_osc[i]->m_sampleBuffer );
+	}
+
 	connect( engine::mixer(), SIGNAL( sampleRateChanged() ),
 			this, SLOT( updateAllDetuning() ) );
 }
@@ -227,6 +251,8 @@ TripleOscillator::TripleOscillator( InstrumentTrack * _instrument_track ) :
 
 TripleOscillator::~TripleOscillator()
 {
+	delete m_oscLeft;
+	delete m_oscRight;
 }
 
 
@@ -300,68 +326,20 @@ void TripleOscillator::playNote( notePlayHandle * _n,
 {
 	if( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
-		Oscillator * oscs_l[NUM_OF_OSCILLATORS];
-		Oscillator * oscs_r[NUM_OF_OSCILLATORS];
-
-		for( int i = NUM_OF_OSCILLATORS - 1; i >= 0; --i )
-		{
-
-			// the last oscs needs no sub-oscs...
-			if( i == NUM_OF_OSCILLATORS - 1 )
-			{
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShapeModel,
-						&m_osc[i]->m_modulationAlgoModel,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						m_osc[i]->m_phaseOffsetLeft,
-						m_osc[i]->m_volumeLeft );
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShapeModel,
-						&m_osc[i]->m_modulationAlgoModel,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						m_osc[i]->m_phaseOffsetRight,
-						m_osc[i]->m_volumeRight );
-			}
-			else
-			{
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShapeModel,
-						&m_osc[i]->m_modulationAlgoModel,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						m_osc[i]->m_phaseOffsetLeft,
-						m_osc[i]->m_volumeLeft,
-						oscs_l[i + 1] );
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShapeModel,
-						&m_osc[i]->m_modulationAlgoModel,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						m_osc[i]->m_phaseOffsetRight,
-						m_osc[i]->m_volumeRight,
-						oscs_r[i + 1] );
-			}
-
-			oscs_l[i]->setUserWave( m_osc[i]->m_sampleBuffer );
-			oscs_r[i]->setUserWave( m_osc[i]->m_sampleBuffer );
-
-		}
-
-		_n->m_pluginData = new oscPtr;
-		static_cast<oscPtr *>( _n->m_pluginData )->oscLeft = oscs_l[0];
-		static_cast< oscPtr *>( _n->m_pluginData )->oscRight =
-								oscs_r[0];
+		voiceState * v = m_voices.allocate();
+		m_oscLeft->initState( v->left );
+		m_oscRight->initState( v->right );
+		_n->m_pluginData = v;
 	}
 
-	Oscillator * osc_l = static_cast<oscPtr *>( _n->m_pluginData )->oscLeft;
-	Oscillator * osc_r = static_cast<oscPtr *>( _n->m_pluginData )->oscRight;
+	voiceState * v = static_cast<voiceState *>( _n->m_pluginData );
 
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
 
-	osc_l->update( _working_buffer, frames, 0 );
-	osc_r->update( _working_buffer, frames, 1 );
+	m_oscLeft->update( _working_buffer, frames, 0, _n->frequency(),
+								v->left );
+	m_oscRight->update( _working_buffer, frames, 1, _n->frequency(),
+								v->right );
 
 	applyRelease( _working_buffer, _n );
 
@@ -373,11 +351,7 @@ void TripleOscillator::playNote( notePlayHandle * _n,
 
 void TripleOscillator::deleteNotePluginData( notePlayHandle * _n )
 {
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscLeft );
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscRight );
-	delete static_cast<oscPtr *>( _n->m_pluginData );
+	m_voices.release( static_cast<voiceState *>( _n->m_pluginData ) );
 }
 
 
@@ -29,6 +29,7 @@
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Oscillator.h"
+#include "ObjectPool.h"
 #include "AutomatableModel.h"
 
 
@@ -123,12 +124,20 @@ private:
 
 	OscillatorObject * m_osc[NUM_OF_OSCILLATORS];
 
-	struct oscPtr
+	// oscillator-chains shared by all notes - they refer to the parameters
+	// above and therefore never have to be rebuilt
+	Oscillator * m_oscLeft;
+	Oscillator * m_oscRight;
+
+	// all a note has to keep
+	struct voiceState
 	{
-		Oscillator * oscLeft;
-		Oscillator * oscRight;
+		Oscillator::State left[NUM_OF_OSCILLATORS];
+		Oscillator::State right[NUM_OF_OSCILLATORS];
 	} ;
 
+	ObjectPool<voiceState> m_voices;
+
 
 	friend class TripleOscillatorView;
 
@@ -63,9 +63,16 @@ public:
 		}
 	}
 	
-	float getStringSample( int _string )
+	// renders next _frames samples of given string into a buffer which
+	// stays valid until next call
+	const sample_t * renderString( int _string, const fpp_t _frames )
 	{
-		return m_strings[_string]->nextSample();
+		if( m_buffer.size() < _frames )
+		{
+			m_buffer.resize( _frames );
+		}
+		m_strings[_string]->render( m_buffer.data(), _frames );
+		return m_buffer.data();
 	}
 	
 private:
@@ -74,6 +81,7 @@ private:
 	const sample_rate_t m_sampleRate;
 	const int m_bufferLength;
 	QVector<bool> m_exists;
+	QVector<sample_t> m_buffer;
 } ;
 
 #endif
@@ -26,6 +26,8 @@
 #include <QtCore/QMap>
 #include <QtGui/QWhatsThis>
 
+#include <string.h>
+
 #include "vibed.h"
 #include "engine.h"
 #include "InstrumentTrack.h"
@@ -305,23 +307,30 @@ void vibed::playNote( notePlayHandle * _n, sampleFrame * _working_buffer )
 	stringContainer * ps = static_cast<stringContainer *>(
 							_n->m_pluginData );
 
-	for( fpp_t i = 0; i < frames; ++i )
+	memset( _working_buffer, 0, sizeof( sampleFrame ) * frames );
+
+	// render each string as a whole and mix it with gains read once per
+	// period
+	int s = 0;
+	for( int string = 0; string < 9; ++string )
 	{
-		_working_buffer[i][0] = 0.0f;
-		_working_buffer[i][1] = 0.0f;
-		int s = 0;
-		for( int string = 0; string < 9; ++string )
+		if( !ps->exists( string ) )
 		{
-			if( ps->exists( string ) )
-			{
-				// pan: 0 -> left, 1 -> right
-				const float pan = ( m_panKnobs[string]->value() + 1 ) / 2.0f;
-				const sample_t sample = ps->getStringSample( s ) * m_volumeKnobs[string]->value() / 100.0f;
-				_working_buffer[i][0] += ( 1.0f - pan ) * sample;
-				_working_buffer[i][1] += pan * sample;
-				s++;
-			}
+			continue;
+		}
+		// pan: 0 -> left, 1 -> right
+		const float pan = ( m_panKnobs[string]->value() + 1 ) / 2.0f;
+		const float vol = m_volumeKnobs[string]->value() / 100.0f;
+		const float left = ( 1.0f - pan ) * vol;
+		const float right = pan * vol;
+
+		const sample_t * buf = ps->renderString( s, frames );
+		for( fpp_t i = 0; i < frames; ++i )
+		{
+			_working_buffer[i][0] += left * buf[i];
+			_working_buffer[i][1] += right * buf[i];
 		}
+		++s;
 	}
 
 	instrumentTrack()->processAudioBuffer( _working_buffer, frames, _n );
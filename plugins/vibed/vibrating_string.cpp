@@ -22,6 +22,7 @@
  *
  */
 #include <math.h>
+#include <string.h>
 
 #include "vibrating_string.h"
 #include "templates.h"
@@ -47,7 +48,6 @@ vibratingString::vibratingString(	float _pitch,
 	m_stringLoss( 1.0f - _string_loss ),
 	m_state( 0.1f )
 {
-	m_outsamp = new sample_t[m_oversample];
 	int string_length;
 	
 	string_length = static_cast<int>( m_oversample * _sample_rate /
@@ -81,8 +81,10 @@ vibratingString::vibratingString(	float _pitch,
 						m_impulse, _len, 0.5f,
 						_state);
 	
-	m_choice = static_cast<int>( m_oversample * 
-				static_cast<float>( rand() ) / RAND_MAX ); 
+	// output of only one of the oversampled steps is used
+	m_choice = qMin( static_cast<int>( m_oversample *
+				static_cast<float>( rand() ) / RAND_MAX ),
+							m_oversample - 1 );
 	
 	m_pickupLoc = static_cast<int>( _pickup * string_length );
 }
@@ -90,6 +92,83 @@ vibratingString::vibratingString(	float _pitch,
 
 
 
+/*
+*  Right-going delay line (from bridge):
+*  -->---->---->---
+*  x=0
+*  (pointer)
+*  Left-going delay line (to bridge):
+*  --<----<----<---
+*  x=0
+*  (pointer)
+*
+*  Both lines have the same length. Positions are kept as indices so
+*  wrapping needs a single compare instead of looping over pointers,
+*  and the output at pickup position is only read in the oversampled
+*  step which is actually used.
+*/
+void vibratingString::render( sample_t * _buf, const fpp_t _frames )
+{
+	const int len = m_fromBridge->length;
+	if( len <= 0 )
+	{
+		memset( _buf, 0, sizeof( sample_t ) * _frames );
+		return;
+	}
+
+	sample_t * const from_bridge = m_fromBridge->data;
+	sample_t * const to_bridge = m_toBridge->data;
+	int from_pos = m_fromBridge->pointer - from_bridge;
+	int to_pos = m_toBridge->pointer - to_bridge;
+
+	// offsets relative to x = 0, reduced to [0, len)
+	const int pickup = m_pickupLoc % len;
+	const int bridge = 1 % len;
+	const int nut = ( len * 2 - 2 ) % len;
+	const float loss = m_stringLoss;
+
+	for( fpp_t frame = 0; frame < _frames; ++frame )
+	{
+		sample_t out = 0.0f;
+		for( int i = 0; i < m_oversample; ++i )
+		{
+			if( i == m_choice )
+			{
+				// output at pickup position
+				int p = from_pos + pickup;
+				int q = to_pos + pickup;
+				out = from_bridge[p < len ? p : p - len] +
+					to_bridge[q < len ? q : q - len];
+			}
+
+			// sample traveling into "bridge"
+			int p = to_pos + bridge;
+			const sample_t ym0 = to_bridge[p < len ? p : p - len];
+			// sample to "nut"
+			p = from_pos + nut;
+			const sample_t ypM = from_bridge[p < len ? p : p - len];
+
+			// string state update: the wave on the upper line
+			// travels one sample to the right and the
+			// bridge-reflected sample is placed at its new x = 0
+			from_pos = ( from_pos == 0 ? len : from_pos ) - 1;
+			from_bridge[from_pos] = -bridgeReflection( ym0 ) * loss;
+
+			// the nut-reflected sample is placed at x = 0 of the
+			// lower line, which then travels one sample to the left
+			to_bridge[to_pos] = -ypM * loss;
+			to_pos = ( to_pos == len - 1 ) ? 0 : to_pos + 1;
+		}
+		_buf[frame] = out;
+	}
+
+	m_fromBridge->pointer = from_bridge + from_pos;
+	m_toBridge->pointer = to_bridge + to_pos;
+}
+
+
+
+
 vibratingString::delayLine * vibratingString::initDelayLine( int _len,
 								int _pick )
 {
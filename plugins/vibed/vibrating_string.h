@@ -47,40 +47,13 @@ public:
 	
 	inline ~vibratingString()
 	{
-		delete[] m_outsamp;
 		delete[] m_impulse;
 		vibratingString::freeDelayLine( m_fromBridge );
 		vibratingString::freeDelayLine( m_toBridge );
 	}
 
-	inline sample_t nextSample()
-	{	
-		sample_t ym0;
-		sample_t ypM;
-		for( int i = 0; i < m_oversample; i++)
-		{
-			// Output at pickup position
-			m_outsamp[i] = fromBridgeAccess( m_fromBridge, 
-								m_pickupLoc );
-			m_outsamp[i] += toBridgeAccess( m_toBridge, 
-								m_pickupLoc );
-		
-			// Sample traveling into "bridge"
-			ym0 = toBridgeAccess( m_toBridge, 1 );
-			// Sample to "nut"
-			ypM = fromBridgeAccess( m_fromBridge,
-						m_fromBridge->length - 2 );
-
-			// String state update
-
-			// Decrement pointer and then update
-			fromBridgeUpdate( m_fromBridge, 
-						-bridgeReflection( ym0 ) );
-			// Update and then increment pointer
-			toBridgeUpdate( m_toBridge, -ypM );
-		}
-		return( m_outsamp[m_choice] );
-	}
+	// renders next _frames samples at pickup position into _buf
+	void render( sample_t * _buf, const fpp_t _frames );
 
 private:
 	struct delayLine
@@ -101,8 +74,6 @@ private:
 	float * m_impulse;
 	int m_choice;
 	float m_state;
-	
-	sample_t * m_outsamp;
 
 	delayLine * initDelayLine( int _len, int _pick );
 	static void freeDelayLine( delayLine * _dl );
@@ -174,93 +145,6 @@ private:
 		}
 	}
 
-	/* toBridgeUpdate(dl, insamp);
-	* Places "nut-reflected" sample from upper delay-line into
-	* current lower delay-line pointer position (which represents
-	* x = 0 position).  The pointer is then incremented (i.e. the
-	* wave travels one sample to the left), turning the previous
-	* position into an "effective" x = L position for the next
-	* iteration. */
-	inline void toBridgeUpdate( delayLine * _dl, sample_t _insamp )
-	{
-		register sample_t * ptr = _dl->pointer;
-		*ptr = _insamp * m_stringLoss;
-		++ptr;
-		if( ptr > _dl->end )
-		{
-			ptr = _dl->data;
-		}
-		_dl->pointer = ptr;
-	}
-
-	/* fromBridgeUpdate(dl, insamp);
-	* Decrements current upper delay-line pointer position (i.e.
-	* the wave travels one sample to the right), moving it to the
-	* "effective" x = 0 position for the next iteration.  The
-	* "bridge-reflected" sample from lower delay-line is then placed
-	* into this position. */
-	inline void fromBridgeUpdate( delayLine * _dl, 
-							sample_t _insamp )
-	{
-		register sample_t * ptr = _dl->pointer;
-		--ptr;
-		if( ptr < _dl->data )
-		{
-			ptr = _dl->end;
-		}
-		*ptr = _insamp * m_stringLoss;
-		_dl->pointer = ptr;
-	}
-
-	/* dlAccess(dl, position);
-	* Returns sample "position" samples into delay-line's past.
-	* Position "0" points to the most recently inserted sample. */
-	static inline sample_t dlAccess( delayLine * _dl, int _position )
-	{
-		sample_t * outpos = _dl->pointer + _position;
-		while( outpos < _dl->data )
-		{
-			outpos += _dl->length;
-		}
-		while( outpos > _dl->end )
-		{
-			outpos -= _dl->length;
-		}
-		return( *outpos );
-	}
-
-	/*
-	*  Right-going delay line:
-	*  -->---->---->--- 
-	*  x=0
-	*  (pointer)
-	*  Left-going delay line:
-	*  --<----<----<--- 
-	*  x=0
-	*  (pointer)
-	*/
-
-	/* fromBridgeAccess(dl, position);
-	* Returns spatial sample at position "position", where position zero
-	* is equal to the current upper delay-line pointer position (x = 0).
-	* In a right-going delay-line, position increases to the right, and
-	* delay increases to the right => left = past and right = future. */
-	static inline sample_t fromBridgeAccess( delayLine * _dl, 
-								int _position )
-	{
-		return( dlAccess( _dl, _position ) );
-	}
-
-	/* toBridgeAccess(dl, position);
-	* Returns spatial sample at position "position", where position zero
-	* is equal to the current lower delay-line pointer position (x = 0).
-	* In a left-going delay-line, position increases to the right, and
-	* delay DEcreases to the right => left = future and right = past. */
-	static inline sample_t toBridgeAccess( delayLine * _dl, int _position )
-	{
-		return( dlAccess( _dl, _position ) );
-	}
-
 	inline sample_t bridgeReflection( sample_t _insamp )
 	{
 		return( m_state = ( m_state + _insamp ) * 0.5 );
@@ -24,6 +24,7 @@
 
 #include <lmmsconfig.h>
 
+#include <stdlib.h>
 #include <unistd.h>
 
 #include "LocalZynAddSubFx.h"
@@ -31,6 +32,7 @@
 #include "src/Input/NULLMidiIn.h"
 #include "src/Misc/Master.h"
 #include "src/Misc/Dump.h"
+#include "src/DSP/FFTwrapper.h"
 
 
 int LocalZynAddSubFx::s_instanceCount = 0;
@@ -55,7 +57,10 @@ LocalZynAddSubFx::LocalZynAddSubFx()
 
 		OSCIL_SIZE = config.cfg.OscilSize;
 
-		srand( time( NULL ) );
+		// LMMS_SEED is set by "lmms --seed" for reproducible renderings
+		// (we're running in a separate process most of the time)
+		const char * seed = getenv( "LMMS_SEED" );
+		srand( seed != NULL ? atoi( seed ) : time( NULL ) );
 		denormalkillbuf = new REALTYPE[SOUND_BUFFER_SIZE];
 		for( int i = 0; i < SOUND_BUFFER_SIZE; ++i )
 		{
@@ -84,6 +89,15 @@ LocalZynAddSubFx::~LocalZynAddSubFx()
 
 
 
+void LocalZynAddSubFx::setFFTWPlannerLock( void (*_lock)(),
+							void (*_unlock)() )
+{
+	FFTwrapper::setPlanLock( _lock, _unlock );
+}
+
+
+
+
 void LocalZynAddSubFx::initConfig()
 {
 	config.init();
@@ -155,6 +169,14 @@ void LocalZynAddSubFx::loadPreset( const std::string & _filename, int _part )
 
 
 
+void LocalZynAddSubFx::waitForParameters()
+{
+	m_master->waitforparameters();
+}
+
+
+
+
 void LocalZynAddSubFx::setPresetDir( const std::string & _dir )
 {
 	m_presetsDir = _dir;
@@ -240,6 +262,22 @@ void LocalZynAddSubFx::processMidiEvent( const midiEvent & _e )
 
 
 
+void LocalZynAddSubFx::lock()
+{
+	pthread_mutex_lock( &m_master->mutex );
+}
+
+
+
+
+void LocalZynAddSubFx::unlock()
+{
+	pthread_mutex_unlock( &m_master->mutex );
+}
+
+
+
+
 void LocalZynAddSubFx::processAudio( sampleFrame * _out )
 {
 	REALTYPE outputl[SOUND_BUFFER_SIZE];
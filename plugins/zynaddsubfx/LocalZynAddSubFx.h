@@ -37,6 +37,10 @@ public:
 
 	void initConfig();
 
+	// lets the FFTW planner be shared with the host - has to be called
+	// before creating the first instance
+	static void setFFTWPlannerLock( void (*_lock)(), void (*_unlock)() );
+
 	void setSampleRate( int _sampleRate );
 	void setBufferSize( int _bufferSize );
 
@@ -45,9 +49,20 @@ public:
 
 	void loadPreset( const std::string & _filename, int _part = 0 );
 
+	// PADsynth samples are computed in background after loading - wait
+	// until they are ready
+	void waitForParameters();
+
 	void setPresetDir( const std::string & _dir );
 	void setLmmsWorkingDir( const std::string & _dir );
 
+	// PADsynth samples computed in background get swapped in while
+	// holding the master mutex, so it has to be locked around
+	// processMidiEvent() and processAudio() (RemoteZynAddSubFx holds it
+	// while processing any message)
+	void lock();
+	void unlock();
+
 	void processMidiEvent( const midiEvent & _e );
 
 	void processAudio( sampleFrame * _out );
@@ -42,6 +42,7 @@
 #include "RemoteZynAddSubFx.h"
 #include "LocalZynAddSubFx.h"
 #include "ControllerConnection.h"
+#include "fft_helpers.h"
 
 #include "embed.cpp"
 #include "moc_ZynAddSubFx.cxx"
@@ -253,6 +254,12 @@ void ZynAddSubFxInstrument::loadSettings( const QDomElement & _this )
 		else
 		{
 			m_plugin->loadXML( fn );
+			// when rendering from command line, notes must not start
+			// playing before their PADsynth samples are there
+			if( !engine::hasGUI() )
+			{
+				m_plugin->waitForParameters();
+			}
 		}
 		m_pluginMutex.unlock();
 
@@ -330,7 +337,9 @@ void ZynAddSubFxInstrument::play( sampleFrame * _buf )
 	}
 	else
 	{
+		m_plugin->lock();
 		m_plugin->processAudio( _buf );
+		m_plugin->unlock();
 	}
 	m_pluginMutex.unlock();
 	instrumentTrack()->processAudioBuffer( _buf,
@@ -359,7 +368,9 @@ bool ZynAddSubFxInstrument::handleMidiEvent( const midiEvent & _me,
 	}
 	else
 	{
+		m_plugin->lock();
 		m_plugin->processMidiEvent( _me );
+		m_plugin->unlock();
 	}
 	m_pluginMutex.unlock();
 
@@ -434,7 +445,19 @@ void ZynAddSubFxInstrument::initPlugin()
 	}
 	else
 	{
+		// PADsynth builds its samples in background threads while
+		// LMMS might create plans for spectrum-analyses
+		static bool planner_shared = false;
+		if( !planner_shared )
+		{
+			LocalZynAddSubFx::setFFTWPlannerLock( fftwPlannerLock,
+							fftwPlannerUnlock );
+			planner_shared = true;
+		}
 		m_plugin = new LocalZynAddSubFx;
+		// working directory is used for the cache of PADsynth samples
+		m_plugin->setLmmsWorkingDir(
+					QSTR_TO_STDSTR( configManager::inst()->workingDir() ) );
 		m_plugin->setSampleRate( engine::mixer()->processingSampleRate() );
 		m_plugin->setBufferSize( engine::mixer()->framesPerPeriod() );
 	}
@@ -21,13 +21,38 @@
 */
 
 #include <math.h>
+#include <pthread.h>
 #include "FFTwrapper.h"
 
+//only the execution of FFTW plans is thread safe, creating and destroying
+//them has to be serialized (PADsynth computes its samples in parallel)
+static pthread_mutex_t planmutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void lockPlanMutex()
+{
+    pthread_mutex_lock(&planmutex);
+}
+
+static void unlockPlanMutex()
+{
+    pthread_mutex_unlock(&planmutex);
+}
+
+static void (*planlock)()   = lockPlanMutex;
+static void (*planunlock)() = unlockPlanMutex;
+
+void FFTwrapper::setPlanLock(void (*lock)(), void (*unlock)())
+{
+    planlock   = lock;
+    planunlock = unlock;
+}
+
 FFTwrapper::FFTwrapper(int fftsize_)
 {
     fftsize      = fftsize_;
     tmpfftdata1  = new fftw_real[fftsize];
     tmpfftdata2  = new fftw_real[fftsize];
+    planlock();
 #ifdef FFTW_VERSION_2
     planfftw     = rfftw_create_plan(fftsize,
                                      FFTW_REAL_TO_COMPLEX,
@@ -47,10 +72,12 @@ FFTwrapper::FFTwrapper(int fftsize_)
                                     FFTW_HC2R,
                                     FFTW_ESTIMATE);
 #endif
+    planunlock();
 }
 
 FFTwrapper::~FFTwrapper()
 {
+    planlock();
 #ifdef FFTW_VERSION_2
     rfftw_destroy_plan(planfftw);
     rfftw_destroy_plan(planfftw_inv);
@@ -58,6 +85,7 @@ FFTwrapper::~FFTwrapper()
     fftwf_destroy_plan(planfftw);
     fftwf_destroy_plan(planfftw_inv);
 #endif
+    planunlock();
 
     delete [] tmpfftdata1;
     delete [] tmpfftdata2;
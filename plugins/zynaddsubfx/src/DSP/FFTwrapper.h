@@ -58,6 +58,11 @@ class FFTwrapper
          * @param freqs Structure FFTFREQS which stores the frequencies*/
         void smps2freqs(REALTYPE *smps, FFTFREQS freqs);
         void freqs2smps(FFTFREQS freqs, REALTYPE *smps);
+        /**Use the given functions instead of the internal mutex for
+         * serializing creation and destruction of plans, so the planner
+         * can be shared with the host's other FFTW users. Has to be called
+         * before the first FFTwrapper is created.*/
+        static void setPlanLock(void (*lock)(), void (*unlock)());
     private:
         int fftsize;
         fftw_real *tmpfftdata1, *tmpfftdata2;
@@ -631,6 +631,13 @@ void Master::applyparameters()
     ;
 }
 
+void Master::waitforparameters()
+{
+    for(int npart = 0; npart < NUM_MIDI_PARTS; npart++)
+        part[npart]->waitforparameters();
+    ;
+}
+
 void Master::add2XML(XMLwrapper *xml)
 {
     xml->addpar("volume", Pvolume);
@@ -60,6 +60,7 @@ class Master
          * @return 0 for ok or -1 if there is an error*/
         int loadXML(const char *filename);
         void applyparameters();
+        void waitforparameters();
 
         void getfromXML(XMLwrapper *xml);
 
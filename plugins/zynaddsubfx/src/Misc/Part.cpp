@@ -1246,7 +1246,15 @@ void Part::applyparameters()
 {
     for(int n = 0; n < NUM_KIT_ITEMS; n++)
         if((kit[n].padpars != NULL) && (kit[n].Ppadenabled != 0))
-            kit[n].padpars->applyparameters(true);
+            kit[n].padpars->applyparameters_async();
+    ;
+}
+
+void Part::waitforparameters()
+{
+    for(int n = 0; n < NUM_KIT_ITEMS; n++)
+        if(kit[n].padpars != NULL)
+            kit[n].padpars->waitforparameters();
     ;
 }
 
@@ -79,7 +79,8 @@ class Part
         void defaults();
         void defaultsinstrument();
 
-        void applyparameters();
+        void applyparameters(); //the PADsynth samples are computed in the background
+        void waitforparameters();
 
         void getfromXML(XMLwrapper *xml);
         void getfromXMLinstrument(XMLwrapper *xml);
@@ -20,7 +20,23 @@
 
 */
 #include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <utime.h>
+#include <algorithm>
+#include <vector>
+#ifdef OS_WINDOWS
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 #include "PADnoteParameters.h"
+#include "../Misc/Config.h"
 #include "../Output/WAVaudiooutput.h"
 using namespace std;
 
@@ -53,11 +69,17 @@ PADnoteParameters::PADnoteParameters(FFTwrapper *fft_,
         sample[i].smp = NULL;
     newsample.smp = NULL;
 
+    builderrunning  = false;
+    buildgeneration = 0;
+    pthread_mutex_init(&buildmutex, NULL);
+
     defaults();
 }
 
 PADnoteParameters::~PADnoteParameters()
 {
+    stopbuilder();
+    pthread_mutex_destroy(&buildmutex);
     deletesamples();
     delete (oscilgen);
     delete (resonance);
@@ -131,6 +153,9 @@ void PADnoteParameters::defaults()
     FilterEnvelope->defaults();
     FilterLfo->defaults();
 
+    //a pending background computation must neither bring back the old
+    //samples nor write into the ones being freed
+    stopbuilder();
     deletesamples();
 }
 
@@ -372,86 +397,71 @@ REALTYPE PADnoteParameters::getNhr(int n)
     return result;
 }
 
+/*
+ * Everything needed to compute the samples. It is taken from the parameters
+ * by the calling thread, so the worker threads don't touch the OscilGen or
+ * the Resonance (which are not reentrant).
+ */
+struct PADsampleSet {
+    PADnoteParameters *pars;
+    unsigned int generation;
+
+    int      mode;
+    int      samplesize;
+    int      samplemax;
+    int      samplerate;
+    int      profilesize;
+    REALTYPE bwadjust;
+    REALTYPE bandwidthcents;
+    REALTYPE bwpower;
+    REALTYPE *profile;
+
+    struct {
+        REALTYPE  basefreq;
+        int       nharmonics;
+        REALTYPE *hfreq; //the frequency of each harmonic (Hz)
+        REALTYPE *hamp; //the amplitude of each harmonic (resonance included)
+        REALTYPE *smp; //the computed sample
+    } sample[PAD_MAX_SAMPLES];
+
+    //used by the worker threads to pick the next sample
+    pthread_mutex_t lock;
+    int nextsample;
+};
+
 /*
  * Generates the long spectrum for Bandwidth mode (only amplitudes are generated; phases will be random)
  */
-void PADnoteParameters::generatespectrum_bandwidthMode(REALTYPE *spectrum,
-                                                       int size,
-                                                       REALTYPE basefreq,
-                                                       REALTYPE *profile,
-                                                       int profilesize,
-                                                       REALTYPE bwadjust)
+void PADnoteParameters::generatespectrum_bandwidthMode(PADsampleSet *set,
+                                                       int nsample,
+                                                       REALTYPE *spectrum,
+                                                       int size)
 {
     for(int i = 0; i < size; i++)
         spectrum[i] = 0.0;
 
-    REALTYPE harmonics[OSCIL_SIZE / 2];
-    for(int i = 0; i < OSCIL_SIZE / 2; i++)
-        harmonics[i] = 0.0;
-    //get the harmonic structure from the oscillator (I am using the frequency amplitudes, only)
-    oscilgen->get(harmonics, basefreq, false);
+    const REALTYPE  basefreq    = set->sample[nsample].basefreq;
+    const REALTYPE *profile     = set->profile;
+    const int       profilesize = set->profilesize;
+    const REALTYPE  samplerate  = set->samplerate;
 
-    //normalize
-    REALTYPE max = 0.0;
-    for(int i = 0; i < OSCIL_SIZE / 2; i++)
-        if(harmonics[i] > max)
-            max = harmonics[i];
-    if(max < 0.000001)
-        max = 1;
-    for(int i = 0; i < OSCIL_SIZE / 2; i++)
-        harmonics[i] /= max;
-
-    for(int nh = 1; nh < OSCIL_SIZE / 2; nh++) { //for each harmonic
-        REALTYPE realfreq = getNhr(nh) * basefreq;
-        if(realfreq > SAMPLE_RATE * 0.49999)
-            break;
-        if(realfreq < 20.0)
-            break;
-        if(harmonics[nh - 1] < 1e-4)
+    for(int nh = 1; nh < set->sample[nsample].nharmonics; nh++) { //for each harmonic
+        REALTYPE realfreq = set->sample[nsample].hfreq[nh];
+        REALTYPE amp      = set->sample[nsample].hamp[nh];
+        if(amp == 0.0)
             continue;
 
         //compute the bandwidth of each harmonic
-        REALTYPE bandwidthcents = setPbandwidth(Pbandwidth);
         REALTYPE bw    =
-            (pow(2.0, bandwidthcents / 1200.0) - 1.0) * basefreq / bwadjust;
-        REALTYPE power = 1.0;
-        switch(Pbwscale) {
-        case 0:
-            power = 1.0;
-            break;
-        case 1:
-            power = 0.0;
-            break;
-        case 2:
-            power = 0.25;
-            break;
-        case 3:
-            power = 0.5;
-            break;
-        case 4:
-            power = 0.75;
-            break;
-        case 5:
-            power = 1.5;
-            break;
-        case 6:
-            power = 2.0;
-            break;
-        case 7:
-            power = -0.5;
-            break;
-        }
-        bw = bw * pow(realfreq / basefreq, power);
-        int ibw      = (int)((bw / (SAMPLE_RATE * 0.5) * size)) + 1;
-
-        REALTYPE amp = harmonics[nh - 1];
-        if(resonance->Penabled)
-            amp *= resonance->getfreqresponse(realfreq);
+            (pow(2.0, set->bandwidthcents / 1200.0) - 1.0) * basefreq
+            / set->bwadjust;
+        bw = bw * pow(realfreq / basefreq, set->bwpower);
+        int ibw      = (int)((bw / (samplerate * 0.5) * size)) + 1;
 
         if(ibw > profilesize) { //if the bandwidth is larger than the profilesize
             REALTYPE rap   = sqrt((REALTYPE)profilesize / (REALTYPE)ibw);
             int      cfreq =
-                (int) (realfreq / (SAMPLE_RATE * 0.5) * size) - ibw / 2;
+                (int) (realfreq / (samplerate * 0.5) * size) - ibw / 2;
             for(int i = 0; i < ibw; i++) {
                 int src    = (int)(i * rap * rap);
                 int spfreq = i + cfreq;
@@ -464,7 +474,7 @@ void PADnoteParameters::generatespectrum_bandwidthMode(REALTYPE *spectrum,
         }
         else {  //if the bandwidth is smaller than the profilesize
             REALTYPE rap = sqrt((REALTYPE)ibw / (REALTYPE)profilesize);
-            REALTYPE ibasefreq = realfreq / (SAMPLE_RATE * 0.5) * size;
+            REALTYPE ibasefreq = realfreq / (samplerate * 0.5) * size;
             for(int i = 0; i < profilesize; i++) {
                 REALTYPE idfreq  = i / (REALTYPE)profilesize - 0.5;
                 idfreq *= ibw;
@@ -484,53 +494,26 @@ void PADnoteParameters::generatespectrum_bandwidthMode(REALTYPE *spectrum,
 /*
  * Generates the long spectrum for non-Bandwidth modes (only amplitudes are generated; phases will be random)
  */
-void PADnoteParameters::generatespectrum_otherModes(REALTYPE *spectrum,
-                                                    int size,
-                                                    REALTYPE basefreq,
-                                                    REALTYPE *profile,
-                                                    int profilesize,
-                                                    REALTYPE bwadjust)
+void PADnoteParameters::generatespectrum_otherModes(PADsampleSet *set,
+                                                    int nsample,
+                                                    REALTYPE *spectrum,
+                                                    int size)
 {
     for(int i = 0; i < size; i++)
         spectrum[i] = 0.0;
 
-    REALTYPE harmonics[OSCIL_SIZE / 2];
-    for(int i = 0; i < OSCIL_SIZE / 2; i++)
-        harmonics[i] = 0.0;
-    //get the harmonic structure from the oscillator (I am using the frequency amplitudes, only)
-    oscilgen->get(harmonics, basefreq, false);
-
-    //normalize
-    REALTYPE max = 0.0;
-    for(int i = 0; i < OSCIL_SIZE / 2; i++)
-        if(harmonics[i] > max)
-            max = harmonics[i];
-    if(max < 0.000001)
-        max = 1;
-    for(int i = 0; i < OSCIL_SIZE / 2; i++)
-        harmonics[i] /= max;
-
-    for(int nh = 1; nh < OSCIL_SIZE / 2; nh++) { //for each harmonic
-        REALTYPE realfreq = getNhr(nh) * basefreq;
+    for(int nh = 1; nh < set->sample[nsample].nharmonics; nh++) { //for each harmonic
+        REALTYPE realfreq = set->sample[nsample].hfreq[nh];
 
         ///sa fac aici interpolarea si sa am grija daca frecv descresc
 
-        if(realfreq > SAMPLE_RATE * 0.49999)
-            break;
-        if(realfreq < 20.0)
-            break;
-//	if (harmonics[nh-1]<1e-4) continue;
-
-
-        REALTYPE amp = harmonics[nh - 1];
-        if(resonance->Penabled)
-            amp *= resonance->getfreqresponse(realfreq);
-        int cfreq    = (int) (realfreq / (SAMPLE_RATE * 0.5) * size);
+        REALTYPE amp = set->sample[nsample].hamp[nh];
+        int cfreq    = (int) (realfreq / (set->samplerate * 0.5) * size);
 
         spectrum[cfreq] = amp + 1e-9;
     }
 
-    if(Pmode != 1) {
+    if(set->mode != 1) {
         int old = 0;
         for(int k = 1; k < size; k++) {
             if((spectrum[k] > 1e-10) || (k == (size - 1))) {
@@ -549,19 +532,369 @@ void PADnoteParameters::generatespectrum_otherModes(REALTYPE *spectrum,
 }
 
 /*
- * Applies the parameters (i.e. computes all the samples, based on parameters);
+ * Disk cache for the computed samples
+ *
+ * A sample is fully determined by its spectrum (the phases are randomized
+ * with a generator seeded from the spectrum), so the cache is addressed by a
+ * hash of the spectrum. Least recently used samples are removed once the
+ * cache grows beyond PAD_CACHE_MAXSIZE.
  */
-void PADnoteParameters::applyparameters(bool lockmutex)
+#define PAD_CACHE_MAGIC   0x53444150 //"PADS"
+#define PAD_CACHE_VERSION 1
+#define PAD_CACHE_MAXSIZE (512 * 1024 * 1024)
+
+static uint64_t padcache_hash(const REALTYPE *spectrum, int size, int samplesize)
+{
+    //64 bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char *data = (const unsigned char *)spectrum;
+    for(size_t i = 0; i < size * sizeof(REALTYPE); i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    hash ^= (uint64_t)samplesize * 31 + PAD_CACHE_VERSION;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+static bool padcache_dirname(char *dir, int dirsize)
+{
+    if(config.workingDir == NULL)
+        return false;
+
+    snprintf(dir, dirsize, "%szynaddsubfx-cache", config.workingDir);
+#ifdef OS_WINDOWS
+    mkdir(dir);
+#else
+    mkdir(dir, 0755);
+#endif
+    return true;
+}
+
+static bool padcache_filename(char *name, int namesize, uint64_t key)
+{
+    char dir[MAX_STRING_SIZE];
+    if(!padcache_dirname(dir, MAX_STRING_SIZE))
+        return false;
+
+    snprintf(name, namesize, "%s/pad-%016llx.smp", dir,
+             (unsigned long long)key);
+    return true;
+}
+
+struct padcache_entry {
+    time_t      mtime;
+    off_t       size;
+    std::string name;
+    bool operator<(const padcache_entry &other) const
+    {
+        return mtime < other.mtime;
+    }
+};
+
+/*
+ * Removes the least recently used samples (loading a sample touches it)
+ * until the cache is well below its maximum size
+ */
+static void padcache_prune()
+{
+    char dir[MAX_STRING_SIZE];
+    if(!padcache_dirname(dir, MAX_STRING_SIZE))
+        return;
+
+    DIR *d = opendir(dir);
+    if(d == NULL)
+        return;
+
+    std::vector<padcache_entry> entries;
+    uint64_t total = 0;
+    struct dirent *fn;
+    while((fn = readdir(d)) != NULL) {
+        const std::string name = fn->d_name;
+        if((name.size() < 8) || (name.compare(0, 4, "pad-") != 0)
+           || (name.compare(name.size() - 4, 4, ".smp") != 0))
+            continue;
+        padcache_entry entry;
+        entry.name = std::string(dir) + "/" + name;
+        struct stat st;
+        if(stat(entry.name.c_str(), &st) != 0)
+            continue;
+        entry.mtime = st.st_mtime;
+        entry.size  = st.st_size;
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    closedir(d);
+
+    if(total <= PAD_CACHE_MAXSIZE)
+        return;
+
+    std::sort(entries.begin(), entries.end());
+    for(size_t i = 0; i < entries.size(); i++) {
+        if(total <= PAD_CACHE_MAXSIZE / 4 * 3)
+            break;
+        if(remove(entries[i].name.c_str()) == 0)
+            total -= entries[i].size;
+    }
+}
+
+static bool padcache_load(uint64_t key, REALTYPE *smp, int samplesize)
+{
+    char name[MAX_STRING_SIZE];
+    if(!padcache_filename(name, MAX_STRING_SIZE, key))
+        return false;
+
+    FILE *f = fopen(name, "rb");
+    if(f == NULL)
+        return false;
+
+    int  header[3];
+    bool ok = (fread(header, sizeof(int), 3, f) == 3)
+              && (header[0] == PAD_CACHE_MAGIC)
+              && (header[1] == PAD_CACHE_VERSION)
+              && (header[2] == samplesize)
+              && (fread(smp, sizeof(REALTYPE), samplesize,
+                        f) == (size_t)samplesize);
+    fclose(f);
+    if(ok)
+        //mark as recently used
+        utime(name, NULL);
+    return ok;
+}
+
+static void padcache_store(uint64_t key, const REALTYPE *smp, int samplesize)
+{
+    char name[MAX_STRING_SIZE];
+    if(!padcache_filename(name, MAX_STRING_SIZE, key))
+        return;
+
+    //write to a temporary file first, so other instances never see a
+    //partially written sample
+    char tmpname[MAX_STRING_SIZE];
+    snprintf(tmpname, MAX_STRING_SIZE, "%s.%d.%p.tmp", name, (int)getpid(),
+             (const void *)smp);
+    FILE *f = fopen(tmpname, "wb");
+    if(f == NULL)
+        return;
+
+    int  header[3] = {PAD_CACHE_MAGIC, PAD_CACHE_VERSION, samplesize};
+    bool ok = (fwrite(header, sizeof(int), 3, f) == 3)
+              && (fwrite(smp, sizeof(REALTYPE), samplesize,
+                         f) == (size_t)samplesize);
+    ok = (fclose(f) == 0) && ok;
+
+    if(!ok || (rename(tmpname, name) != 0))
+        remove(tmpname);
+}
+
+static int numberofcpus()
+{
+#ifdef OS_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? n : 1;
+#endif
+}
+
+/*
+ * Computes one sample of the set (called from the worker threads)
+ */
+void PADnoteParameters::computesample(PADsampleSet *set,
+                                      int nsample,
+                                      FFTwrapper *fft,
+                                      FFTFREQS fftfreqs,
+                                      REALTYPE *spectrum)
+{
+    const int samplesize   = set->samplesize;
+    const int spectrumsize = samplesize / 2;
+
+    if(set->mode == 0)
+        generatespectrum_bandwidthMode(set, nsample, spectrum, spectrumsize);
+    else
+        generatespectrum_otherModes(set, nsample, spectrum, spectrumsize);
+
+    const int extra_samples = 5; //the last samples contains the first samples (used for linear/cubic interpolation)
+    REALTYPE *smp = new REALTYPE[samplesize + extra_samples];
+
+    const uint64_t key = padcache_hash(spectrum, spectrumsize, samplesize);
+    if(!padcache_load(key, smp, samplesize)) {
+        //xorshift64*, seeded from the spectrum; rand() is neither
+        //reentrant nor reproducible
+        uint64_t rnd = key | 1;
+        fftfreqs.c[0] = 0.0;
+        fftfreqs.s[0] = 0.0;
+        for(int i = 1; i < spectrumsize; i++) { //randomize the phases
+            rnd ^= rnd >> 12;
+            rnd ^= rnd << 25;
+            rnd ^= rnd >> 27;
+            REALTYPE phase = ((rnd * 2685821657736338717ULL) >> 40)
+                             / 16777216.0 * 6.29;
+            fftfreqs.c[i] = spectrum[i] * cos(phase);
+            fftfreqs.s[i] = spectrum[i] * sin(phase);
+        }
+        fft->freqs2smps(fftfreqs, smp); //that's all; here is the only ifft for the whole sample; no windows are used ;-)
+
+
+        //normalize(rms)
+        REALTYPE rms = 0.0;
+        for(int i = 0; i < samplesize; i++)
+            rms += smp[i] * smp[i];
+        rms  = sqrt(rms);
+        if(rms < 0.000001)
+            rms = 1.0;
+        rms *= sqrt(262144.0 / samplesize);
+        for(int i = 0; i < samplesize; i++)
+            smp[i] *= 1.0 / rms * 50.0;
+
+        padcache_store(key, smp, samplesize);
+    }
+
+    //prepare extra samples used by the linear or cubic interpolation
+    for(int i = 0; i < extra_samples; i++)
+        smp[i + samplesize] = smp[i];
+
+    set->sample[nsample].smp = smp;
+}
+
+void *PADnoteParameters::samplethread(void *arg)
+{
+    PADsampleSet *set = (PADsampleSet *)arg;
+
+    //each thread needs its own (BIG) FFT, since the buffers are part of it
+    FFTwrapper *fft = new FFTwrapper(set->samplesize);
+    FFTFREQS    fftfreqs;
+    newFFTFREQS(&fftfreqs, set->samplesize / 2);
+    REALTYPE   *spectrum = new REALTYPE[set->samplesize / 2];
+
+    while(!set->pars->obsolete(set->generation)) {
+        pthread_mutex_lock(&set->lock);
+        const int nsample = set->nextsample++;
+        pthread_mutex_unlock(&set->lock);
+        if(nsample >= set->samplemax)
+            break;
+        computesample(set, nsample, fft, fftfreqs, spectrum);
+    }
+
+    delete[] spectrum;
+    deleteFFTFREQS(&fftfreqs);
+    delete (fft);
+    return NULL;
+}
+
+/*
+ * Computes all samples of the set, in parallel
+ */
+void PADnoteParameters::computesamples(PADsampleSet *set)
+{
+    int nthreads = numberofcpus();
+    if(nthreads > set->samplemax)
+        nthreads = set->samplemax;
+
+    pthread_t threads[PAD_MAX_SAMPLES];
+    int       started = 0;
+    for(int i = 1; i < nthreads; i++) {
+        if(pthread_create(&threads[started], NULL, samplethread, set) != 0)
+            break;
+        started++;
+    }
+    samplethread(set);
+    for(int i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    padcache_prune();
+}
+
+void *PADnoteParameters::builderthread(void *arg)
 {
-    const int samplesize   = (((int) 1) << (Pquality.samplesize + 14));
-    int      spectrumsize = samplesize / 2;
-    REALTYPE spectrum[spectrumsize];
-    int      profilesize  = 512;
-    REALTYPE profile[profilesize];
+    PADsampleSet *set = (PADsampleSet *)arg;
+    computesamples(set);
+    set->pars->swapsamples(set, true);
+    set->pars->deletesampleset(set);
+    return NULL;
+}
 
+unsigned int PADnoteParameters::newgeneration()
+{
+    pthread_mutex_lock(&buildmutex);
+    const unsigned int generation = ++buildgeneration;
+    pthread_mutex_unlock(&buildmutex);
+    return generation;
+}
 
-    REALTYPE bwadjust = getprofile(profile, profilesize);
+bool PADnoteParameters::obsolete(unsigned int generation)
+{
+    pthread_mutex_lock(&buildmutex);
+    const bool result = generation != buildgeneration;
+    pthread_mutex_unlock(&buildmutex);
+    return result;
+}
+
+/*
+ * Makes a running background computation obsolete and waits for it
+ */
+void PADnoteParameters::stopbuilder()
+{
+    newgeneration();
+    waitforparameters();
+}
+
+void PADnoteParameters::waitforparameters()
+{
+    if(builderrunning) {
+        pthread_join(builder, NULL);
+        builderrunning = false;
+    }
+}
+
+/*
+ * Takes everything that is needed to compute the samples from the parameters
+ */
+PADsampleSet *PADnoteParameters::preparesamples()
+{
+    PADsampleSet *set = new PADsampleSet;
+    set->pars        = this;
+    set->generation  = newgeneration();
+    set->mode        = Pmode;
+    set->samplesize  = ((int) 1) << (Pquality.samplesize + 14);
+    set->samplerate  = SAMPLE_RATE;
+    set->profilesize = 512;
+    set->profile     = new REALTYPE[set->profilesize];
+    set->nextsample  = 0;
+    pthread_mutex_init(&set->lock, NULL);
+
+    set->bwadjust = getprofile(set->profile, set->profilesize);
 //    for (int i=0;i<profilesize;i++) profile[i]*=profile[i];
+    set->bandwidthcents = setPbandwidth(Pbandwidth);
+    switch(Pbwscale) {
+    case 1:
+        set->bwpower = 0.0;
+        break;
+    case 2:
+        set->bwpower = 0.25;
+        break;
+    case 3:
+        set->bwpower = 0.5;
+        break;
+    case 4:
+        set->bwpower = 0.75;
+        break;
+    case 5:
+        set->bwpower = 1.5;
+        break;
+    case 6:
+        set->bwpower = 2.0;
+        break;
+    case 7:
+        set->bwpower = -0.5;
+        break;
+    default:
+        set->bwpower = 1.0;
+        break;
+    }
+
     REALTYPE basefreq = 65.406 * pow(2.0, Pquality.basenote / 2);
     if(Pquality.basenote % 2 == 1)
         basefreq *= 1.5;
@@ -578,92 +911,147 @@ void PADnoteParameters::applyparameters(bool lockmutex)
         samplemax = samplemax / 2 + 1;
     if(samplemax == 0)
         samplemax = 1;
-
-    //prepare a BIG FFT stuff
-    FFTwrapper *fft = new FFTwrapper(samplesize);
-    FFTFREQS    fftfreqs;
-    newFFTFREQS(&fftfreqs, samplesize / 2);
+    if(samplemax > PAD_MAX_SAMPLES)
+        samplemax = PAD_MAX_SAMPLES;
+    set->samplemax = samplemax;
 
     REALTYPE adj[samplemax]; //this is used to compute frequency relation to the base frequency
     for(int nsample = 0; nsample < samplemax; nsample++)
         adj[nsample] = (Pquality.oct + 1.0) * (REALTYPE)nsample / samplemax;
-    for(int nsample = 0; nsample < samplemax; nsample++) {
-        REALTYPE tmp = adj[nsample] - adj[samplemax - 1] * 0.5;
-        REALTYPE basefreqadjust = pow(2.0, tmp);
-
-        if(Pmode == 0)
-            generatespectrum_bandwidthMode(spectrum,
-                                           spectrumsize,
-                                           basefreq * basefreqadjust,
-                                           profile,
-                                           profilesize,
-                                           bwadjust);
-        else
-            generatespectrum_otherModes(spectrum,
-                                        spectrumsize,
-                                        basefreq * basefreqadjust,
-                                        profile,
-                                        profilesize,
-                                        bwadjust);
 
-        const int extra_samples = 5; //the last samples contains the first samples (used for linear/cubic interpolation)
-        newsample.smp    = new REALTYPE[samplesize + extra_samples];
+    REALTYPE harmonics[OSCIL_SIZE / 2];
+    for(int nsample = 0; nsample < PAD_MAX_SAMPLES; nsample++) {
+        set->sample[nsample].basefreq   = 440.0;
+        set->sample[nsample].nharmonics = 0;
+        set->sample[nsample].hfreq      = NULL;
+        set->sample[nsample].hamp       = NULL;
+        set->sample[nsample].smp        = NULL;
+        if(nsample >= samplemax)
+            continue;
 
-        newsample.smp[0] = 0.0;
-        for(int i = 1; i < spectrumsize; i++) { //randomize the phases
-            REALTYPE phase = RND * 6.29;
-            fftfreqs.c[i] = spectrum[i] * cos(phase);
-            fftfreqs.s[i] = spectrum[i] * sin(phase);
+        REALTYPE tmp = adj[nsample] - adj[samplemax - 1] * 0.5;
+        REALTYPE smpbasefreq = basefreq * pow(2.0, tmp);
+        set->sample[nsample].basefreq = smpbasefreq;
+
+        for(int i = 0; i < OSCIL_SIZE / 2; i++)
+            harmonics[i] = 0.0;
+        //get the harmonic structure from the oscillator (I am using the frequency amplitudes, only)
+        oscilgen->get(harmonics, smpbasefreq, false);
+
+        //normalize
+        REALTYPE max = 0.0;
+        for(int i = 0; i < OSCIL_SIZE / 2; i++)
+            if(harmonics[i] > max)
+                max = harmonics[i];
+        if(max < 0.000001)
+            max = 1;
+        for(int i = 0; i < OSCIL_SIZE / 2; i++)
+            harmonics[i] /= max;
+
+        REALTYPE *hfreq = new REALTYPE[OSCIL_SIZE / 2];
+        REALTYPE *hamp  = new REALTYPE[OSCIL_SIZE / 2];
+        int nh;
+        for(nh = 1; nh < OSCIL_SIZE / 2; nh++) { //for each harmonic
+            REALTYPE realfreq = getNhr(nh) * smpbasefreq;
+            if(realfreq > SAMPLE_RATE * 0.49999)
+                break;
+            if(realfreq < 20.0)
+                break;
+            hfreq[nh] = realfreq;
+            hamp[nh]  = harmonics[nh - 1];
+            if((Pmode == 0) && (harmonics[nh - 1] < 1e-4)) {
+                hamp[nh] = 0.0;
+                continue;
+            }
+            if(resonance->Penabled)
+                hamp[nh] *= resonance->getfreqresponse(realfreq);
         }
-        fft->freqs2smps(fftfreqs, newsample.smp); //that's all; here is the only ifft for the whole sample; no windows are used ;-)
+        set->sample[nsample].nharmonics = nh;
+        set->sample[nsample].hfreq = hfreq;
+        set->sample[nsample].hamp  = hamp;
+    }
 
+    return set;
+}
 
-        //normalize(rms)
-        REALTYPE rms = 0.0;
-        for(int i = 0; i < samplesize; i++)
-            rms += newsample.smp[i] * newsample.smp[i];
-        rms  = sqrt(rms);
-        if(rms < 0.000001)
-            rms = 1.0;
-        rms *= sqrt(262144.0 / samplesize);
-        for(int i = 0; i < samplesize; i++)
-            newsample.smp[i] *= 1.0 / rms * 50.0;
-
-        //prepare extra samples used by the linear or cubic interpolation
-        for(int i = 0; i < extra_samples; i++)
-            newsample.smp[i + samplesize] = newsample.smp[i];
-
-        //replace the current sample with the new computed sample
-        if(lockmutex) {
-            pthread_mutex_lock(mutex);
-            deletesample(nsample);
-            sample[nsample].smp      = newsample.smp;
-            sample[nsample].size     = samplesize;
-            sample[nsample].basefreq = basefreq * basefreqadjust;
-            pthread_mutex_unlock(mutex);
+/*
+ * Replaces the current samples with the computed ones, unless they became
+ * obsolete in the meantime
+ */
+void PADnoteParameters::swapsamples(PADsampleSet *set, bool lockmutex)
+{
+    if(lockmutex)
+        //the mutex might be held by someone who is waiting for this
+        //computation to stop, so don't block on it
+        while(pthread_mutex_trylock(mutex) != 0) {
+            if(obsolete(set->generation))
+                return;
+#ifdef OS_WINDOWS
+            Sleep(1);
+#else
+            usleep(1000);
+#endif
         }
-        else {
-            deletesample(nsample);
-            sample[nsample].smp      = newsample.smp;
-            sample[nsample].size     = samplesize;
-            sample[nsample].basefreq = basefreq * basefreqadjust;
+
+    if(!obsolete(set->generation))
+        for(int n = 0; n < PAD_MAX_SAMPLES; n++) {
+            //the old samples are freed with the set (outside the mutex)
+            REALTYPE *old = sample[n].smp;
+            if(n < set->samplemax) {
+                sample[n].smp      = set->sample[n].smp;
+                sample[n].size     = set->samplesize;
+                sample[n].basefreq = set->sample[n].basefreq;
+            }
+            else {
+                sample[n].smp      = NULL;
+                sample[n].size     = 0;
+                sample[n].basefreq = 440.0;
+            }
+            set->sample[n].smp = old;
         }
-        newsample.smp = NULL;
-    }
-    delete (fft);
-    deleteFFTFREQS(&fftfreqs);
 
-    //delete the additional samples that might exists and are not useful
-    if(lockmutex) {
-        pthread_mutex_lock(mutex);
-        for(int i = samplemax; i < PAD_MAX_SAMPLES; i++)
-            deletesample(i);
+    if(lockmutex)
         pthread_mutex_unlock(mutex);
+}
+
+void PADnoteParameters::deletesampleset(PADsampleSet *set)
+{
+    for(int n = 0; n < PAD_MAX_SAMPLES; n++) {
+        delete[] set->sample[n].hfreq;
+        delete[] set->sample[n].hamp;
+        delete[] set->sample[n].smp;
+    }
+    delete[] set->profile;
+    pthread_mutex_destroy(&set->lock);
+    delete set;
+}
+
+/*
+ * Applies the parameters (i.e. computes all the samples, based on parameters);
+ */
+void PADnoteParameters::applyparameters(bool lockmutex)
+{
+    //a background computation would be outdated now
+    stopbuilder();
+
+    PADsampleSet *set = preparesamples();
+    computesamples(set);
+    swapsamples(set, lockmutex);
+    deletesampleset(set);
+}
+
+void PADnoteParameters::applyparameters_async()
+{
+    stopbuilder();
+
+    PADsampleSet *set = preparesamples();
+    if(pthread_create(&builder, NULL, builderthread, set) == 0)
+        builderrunning = true;
+    else {
+        computesamples(set);
+        swapsamples(set, true);
+        deletesampleset(set);
     }
-    else
-        for(int i = samplemax; i < PAD_MAX_SAMPLES; i++)
-            deletesample(i);
-    ;
 }
 
 void PADnoteParameters::export2wav(string basefilename)
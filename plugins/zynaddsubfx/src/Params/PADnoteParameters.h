@@ -37,6 +37,8 @@
 #include <string>
 #include <pthread.h>
 
+struct PADsampleSet;
+
 class PADnoteParameters:public Presets
 {
     public:
@@ -146,6 +148,13 @@ class PADnoteParameters:public Presets
         REALTYPE getNhr(int n); //gets the n-th overtone position relatively to N harmonic
 
         void applyparameters(bool lockmutex);
+        /* Like applyparameters(true), but the samples are computed on a
+           background thread; they replace the current samples all at once
+           when they are ready */
+        void applyparameters_async();
+        /* Waits until the samples started by applyparameters_async() are in
+           place (the mutex must not be locked by the caller) */
+        void waitforparameters();
         void export2wav(std::string basefilename);
 
         OscilGen  *oscilgen;
@@ -158,23 +167,41 @@ class PADnoteParameters:public Presets
         } sample[PAD_MAX_SAMPLES], newsample;
 
     private:
-        void generatespectrum_bandwidthMode(REALTYPE *spectrum,
-                                            int size,
-                                            REALTYPE basefreq,
-                                            REALTYPE *profile,
-                                            int profilesize,
-                                            REALTYPE bwadjust);
-        void generatespectrum_otherModes(REALTYPE *spectrum,
-                                         int size,
-                                         REALTYPE basefreq,
-                                         REALTYPE *profile,
-                                         int profilesize,
-                                         REALTYPE bwadjust);
+        static void generatespectrum_bandwidthMode(PADsampleSet *set,
+                                                   int nsample,
+                                                   REALTYPE *spectrum,
+                                                   int size);
+        static void generatespectrum_otherModes(PADsampleSet *set,
+                                                int nsample,
+                                                REALTYPE *spectrum,
+                                                int size);
+        static void computesample(PADsampleSet *set,
+                                  int nsample,
+                                  FFTwrapper *fft,
+                                  FFTFREQS fftfreqs,
+                                  REALTYPE *spectrum);
+        static void *samplethread(void *arg);
+        static void *builderthread(void *arg);
+        static void computesamples(PADsampleSet *set);
+
+        PADsampleSet *preparesamples();
+        void swapsamples(PADsampleSet *set, bool lockmutex);
+        void deletesampleset(PADsampleSet *set);
+        unsigned int newgeneration();
+        bool obsolete(unsigned int generation);
+        void stopbuilder();
+
         void deletesamples();
         void deletesample(int n);
 
         FFTwrapper      *fft;
         pthread_mutex_t *mutex;
+
+        //background computation of the samples
+        pthread_t       builder;
+        bool            builderrunning;
+        pthread_mutex_t buildmutex;
+        unsigned int    buildgeneration; //samples computed for an older generation are discarded
 };
 
 
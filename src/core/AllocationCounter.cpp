@@ -0,0 +1,162 @@
+/*
+ * AllocationCounter.cpp - counts memory-allocations while rendering
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <new>
+#include <stdlib.h>
+
+#include "lmmsconfig.h"
+#include "AllocationCounter.h"
+#include "atomic_int.h"
+
+
+// both are zero-initialized before any constructor runs, so operator new is
+// safe to use during static initialization
+static volatile bool s_enabled = false;
+static AtomicInt s_count;
+
+
+
+bool AllocationCounter::isAvailable()
+{
+#ifdef LMMS_COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+
+void AllocationCounter::setEnabled( bool _enabled )
+{
+	s_enabled = _enabled;
+}
+
+
+
+
+int AllocationCounter::count()
+{
+	return s_count.fetchAndAddOrdered( 0 );
+}
+
+
+
+
+void AllocationCounter::reset()
+{
+	s_count.fetchAndStoreOrdered( 0 );
+}
+
+
+
+
+#ifdef LMMS_COUNT_ALLOCATIONS
+
+static inline void * countedAlloc( size_t _size )
+{
+	if( s_enabled )
+	{
+		s_count.fetchAndAddOrdered( 1 );
+	}
+	void * p = malloc( _size > 0 ? _size : 1 );
+	if( p == NULL )
+	{
+		// we're built without exceptions, so there's no bad_alloc
+		abort();
+	}
+	return p;
+}
+
+
+
+
+void * operator new( size_t _size )
+{
+	return countedAlloc( _size );
+}
+
+
+
+
+void * operator new[]( size_t _size )
+{
+	return countedAlloc( _size );
+}
+
+
+
+
+void * operator new( size_t _size, const std::nothrow_t & )
+{
+	if( s_enabled )
+	{
+		s_count.fetchAndAddOrdered( 1 );
+	}
+	return malloc( _size > 0 ? _size : 1 );
+}
+
+
+
+
+void * operator new[]( size_t _size, const std::nothrow_t & _nt )
+{
+	return operator new( _size, _nt );
+}
+
+
+
+
+void operator delete( void * _p )
+{
+	free( _p );
+}
+
+
+
+
+void operator delete[]( void * _p )
+{
+	free( _p );
+}
+
+
+
+
+void operator delete( void * _p, const std::nothrow_t & )
+{
+	free( _p );
+}
+
+
+
+
+void operator delete[]( void * _p, const std::nothrow_t & )
+{
+	free( _p );
+}
+
+#endif
+
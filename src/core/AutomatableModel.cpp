@@ -334,6 +334,21 @@ void AutomatableModel::undoStep( JournalEntry& je )
 
 
 
+bool AutomatableModel::mergeJournalEntries( JournalEntry& last,
+						const JournalEntry& je )
+{
+	if( last.actionID() != je.actionID() )
+	{
+		return false;
+	}
+	// entries hold differences to previous value, so just sum them up
+	last.data() = last.data().toDouble() + je.data().toDouble();
+	return true;
+}
+
+
+
+
 void AutomatableModel::prepareJournalEntryFromOldVal()
 {
 	m_oldValue = value<float>();
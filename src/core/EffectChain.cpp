@@ -192,7 +192,41 @@ bool EffectChain::processAudioBuffer( sampleFrame * _buf, const fpp_t _frames )
 	for( EffectList::Iterator it = m_effects.begin(); 
 						it != m_effects.end(); ++it )
 	{
-		moreEffects |= ( *it )->processAudioBuffer( _buf, _frames );
+		if( ( *it )->supportsPlanarProcessing() )
+		{
+			sample_t * channels[DEFAULT_CHANNELS];
+			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			{
+				channels[ch] = m_planarBuffer[ch];
+				for( fpp_t f = 0; f < _frames; ++f )
+				{
+					channels[ch][f] = _buf[f][ch];
+				}
+			}
+			// pass planar buffers from one effect to the next one
+			// as long as possible
+			moreEffects |= ( *it )->processPlanarAudioBuffer(
+							channels, _frames );
+			while( it+1 != m_effects.end() &&
+				( *( it+1 ) )->supportsPlanarProcessing() )
+			{
+				++it;
+				moreEffects |= ( *it )->processPlanarAudioBuffer(
+							channels, _frames );
+			}
+			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			{
+				for( fpp_t f = 0; f < _frames; ++f )
+				{
+					_buf[f][ch] = channels[ch][f];
+				}
+			}
+		}
+		else
+		{
+			moreEffects |= ( *it )->processAudioBuffer( _buf,
+								_frames );
+		}
 #ifdef LMMS_DEBUG
 		for( int f = 0; f < _frames; ++f )
 		{
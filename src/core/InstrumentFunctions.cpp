@@ -359,7 +359,8 @@ void InstrumentFunctionArpeggio::processNote( notePlayHandle * _n )
 	const int selected_arp = m_arpModel.value();
 
 	ConstNotePlayHandleList cnphv = notePlayHandle::nphsOfInstrumentTrack(
-													_n->instrumentTrack() );
+													_n->instrumentTrack(),
+												_n->siblingPlayHandles() );
 	if( m_arpModeModel.value() != FreeMode && cnphv.size() == 0 )
 	{
 		// maybe we're playing only a preset-preview-note?
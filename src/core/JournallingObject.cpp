@@ -124,16 +124,83 @@ void JournallingObject::restoreState( const QDomElement & _this )
 
 
 
+// approximate memory used by data of a journal entry
+static int variantSize( const QVariant & _v )
+{
+	int size = 0;
+	switch( _v.type() )
+	{
+		case QVariant::String:
+			size = _v.toString().size() * sizeof( QChar );
+			break;
+		case QVariant::ByteArray:
+			size = _v.toByteArray().size();
+			break;
+		case QVariant::List:
+		{
+			const QList<QVariant> l = _v.toList();
+			for( QList<QVariant>::ConstIterator it = l.begin();
+							it != l.end(); ++it )
+			{
+				size += sizeof( QVariant ) + variantSize( *it );
+			}
+			break;
+		}
+		case QVariant::Map:
+		{
+			const QMap<QString, QVariant> m = _v.toMap();
+			for( QMap<QString, QVariant>::ConstIterator it =
+						m.begin(); it != m.end(); ++it )
+			{
+				size += sizeof( QVariant ) +
+					it.key().size() * sizeof( QChar ) +
+							variantSize( *it );
+			}
+			break;
+		}
+		default:
+			break;
+	}
+	return size;
+}
+
+
+
+
 void JournallingObject::addJournalEntry( const JournalEntry & _je )
 {
-	if( engine::projectJournal()->isJournalling() && isJournalling() )
+	ProjectJournal * pj = engine::projectJournal();
+	if( pj->isJournalling() && isJournalling() )
 	{
+		if( m_currentJournalEntry == m_journalEntries.end() &&
+			!m_journalEntries.isEmpty() &&
+			pj->canCoalesce( id() ) &&
+			mergeJournalEntries( m_journalEntries.last(), _je ) )
+		{
+			pj->journalEntryCoalesced( id() );
+			return;
+		}
 		m_journalEntries.erase( m_currentJournalEntry,
 						m_journalEntries.end() );
 		m_journalEntries.push_back( _je );
 		m_currentJournalEntry = m_journalEntries.end();
-		engine::projectJournal()->journalEntryAdded( id() );
+		pj->journalEntryAdded( id(), sizeof( JournalEntry ) +
+						variantSize( _je.data() ) );
+	}
+}
+
+
+
+
+void JournallingObject::forgetOldestJournalEntry()
+{
+	if( m_journalEntries.isEmpty() )
+	{
+		return;
 	}
+	const int cur = m_currentJournalEntry - m_journalEntries.begin();
+	m_journalEntries.erase( m_journalEntries.begin() );
+	m_currentJournalEntry = m_journalEntries.begin() + qMax( cur - 1, 0 );
 }
 
 
@@ -147,6 +214,9 @@ void JournallingObject::changeID( jo_id_t _id )
 											journallingObject( _id );
 		if( jo != NULL )
 		{
+			// e.g. when cloning a track or pasting a TCO the ID
+			// belongs to the original - never take it away from
+			// a living object, just keep our own ID
 			QString used_by = jo->nodeName();
 			if( used_by == "automatablemodel" &&
 				dynamic_cast<AutomatableModel *>( jo ) )
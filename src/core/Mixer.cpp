@@ -304,6 +304,16 @@ Mixer::Mixer() :
 	m_readBuf( NULL ),
 	m_writeBuf( NULL ),
 	m_cpuLoad( 0 ),
+	m_profiledPeriods( 0 ),
+	m_voiceBudgetScale( 1.0f ),
+	m_maxVoices( configManager::inst()->value( "mixer",
+						"maxvoices" ).toInt() ),
+	m_voiceCount( 0 ),
+	m_silenceThreshold( 0 ),
+	m_silentPeriods( configManager::inst()->value( "mixer",
+						"silentperiods" ).toInt() ),
+	m_scopeData(),
+	m_scopeUsers( 0 ),
 	m_workers(),
 	m_numWorkers( QThread::idealThreadCount()-1 ),
 	m_queueReadyWaitCond(),
@@ -311,6 +321,8 @@ Mixer::Mixer() :
 	m_masterGain( 1.0f ),
 	m_audioDev( NULL ),
 	m_oldAudioDev( NULL ),
+	m_midiClient( NULL ),
+	m_periodStartTime( MicroTimer::now() ),
 	m_globalMutex( QMutex::Recursive )
 {
 	for( int i = 0; i < 2; ++i )
@@ -321,6 +333,23 @@ Mixer::Mixer() :
 		clearAudioBuffer( m_inputBuffer[i], m_inputBufferSize[i] );
 	}
 
+	resetProfile();
+
+	if( m_maxVoices <= 0 )
+	{
+		m_maxVoices = DefaultMaxVoices;
+	}
+
+	const QString threshold = configManager::inst()->value( "mixer",
+							"silencethreshold" );
+	m_silenceThreshold = powf( 10.0f, ( threshold.isEmpty() ?
+					DefaultSilenceThreshold :
+					threshold.toFloat() ) / 20.0f );
+	if( m_silentPeriods <= 0 )
+	{
+		m_silentPeriods = DefaultSilentPeriods;
+	}
+
 	for( int i = 1; i < NumFxChannels+1; ++i )
 	{
 		__fx_channel_jobs[i-1] = (fx_ch_t) i;
@@ -556,6 +585,7 @@ void Mixer::pushInputFrames( sampleFrame * _ab, const f_cnt_t _frames )
 const surroundSampleFrame * Mixer::renderNextBuffer()
 {
 	MicroTimer timer;
+	const int64_t period_start = MicroTimer::now();
 	static song::playPos last_metro_pos = -1;
 
 	song::playPos p = engine::getSong()->getPlayPos(
@@ -613,9 +643,17 @@ const surroundSampleFrame * Mixer::renderNextBuffer()
 	// prepare master mix (clear internal buffers etc.)
 	engine::fxMixer()->prepareMasterMix();
 
+	// deliver MIDI-events received while rendering last period - they
+	// create note-play-handles with according offsets
+	m_midiClient->processQueuedInEvents( m_periodStartTime );
+	m_periodStartTime = period_start;
+
 	// create play-handles for new notes, samples etc.
 	engine::getSong()->processNextBuffer();
 
+	int64_t stage_start = MicroTimer::now();
+	m_stageTimes[StagePrepare] += stage_start - period_start;
+
 
 	// STAGE 1: run and render all play handles
 	FILL_JOB_QUEUE(PlayHandleList,m_playHandles,
@@ -646,12 +684,21 @@ const surroundSampleFrame * Mixer::renderNextBuffer()
 	}
 
 
+	int64_t now = MicroTimer::now();
+	m_stageTimes[StagePlayHandles] += now - stage_start;
+	stage_start = now;
+
+
 	// STAGE 2: process effects of all instrument- and sampletracks
 	FILL_JOB_QUEUE(QVector<AudioPort*>,m_audioPorts,
 					MixerWorkerThread::AudioPortEffects,1);
 	START_JOBS();
 	WAIT_FOR_JOBS();
 
+	now = MicroTimer::now();
+	m_stageTimes[StageAudioPortEffects] += now - stage_start;
+	stage_start = now;
+
 
 	// STAGE 3: process effects in FX mixer
 	FILL_JOB_QUEUE_PARAM(QVector<fx_ch_t>,__fx_channel_jobs,
@@ -659,12 +706,23 @@ const surroundSampleFrame * Mixer::renderNextBuffer()
 	START_JOBS();
 	WAIT_FOR_JOBS();
 
+	now = MicroTimer::now();
+	m_stageTimes[StageFxChannels] += now - stage_start;
+	stage_start = now;
+
 
 	// STAGE 4: do master mix in FX mixer
 	engine::fxMixer()->masterMix( m_writeBuf );
 
+	m_stageTimes[StageMasterMix] += MicroTimer::now() - stage_start;
+	++m_profiledPeriods;
+
 	unlock();
 
+	if( m_scopeUsers > 0 )
+	{
+		updateScopeData( m_readBuf );
+	}
 
 	emit nextAudioBuffer();
 
@@ -677,12 +735,39 @@ const surroundSampleFrame * Mixer::renderNextBuffer()
 	m_cpuLoad = tLimit( (int) ( new_cpu_load * 0.1f + m_cpuLoad * 0.9f ), 0,
 									100 );
 
+	// scale down voice-limits when running out of CPU so that new notes
+	// steal older ones instead of causing xruns - 25% of limits are left
+	// at full load
+	if( m_cpuLoad > VoiceBudgetLoad &&
+				engine::getSong()->realTimeTask() == true )
+	{
+		m_voiceBudgetScale = 1.0f - 0.75f *
+				( m_cpuLoad - VoiceBudgetLoad ) /
+						( 100.0f - VoiceBudgetLoad );
+	}
+	else
+	{
+		m_voiceBudgetScale = 1.0f;
+	}
+
 	return m_readBuf;
 }
 
 
 
 
+void Mixer::resetProfile()
+{
+	for( int i = 0; i < NumProfileStages; ++i )
+	{
+		m_stageTimes[i] = 0;
+	}
+	m_profiledPeriods = 0;
+}
+
+
+
+
 // removes all play-handles. this is necessary, when the song is stopped ->
 // all remaining notes etc. would be played until their end
 void Mixer::clear()
@@ -807,6 +892,58 @@ float Mixer::peakValueRight( sampleFrame * _ab, const f_cnt_t _frames )
 
 
 
+void Mixer::addScopeUser()
+{
+	m_scopeUsers.fetchAndAddOrdered( 1 );
+}
+
+
+
+
+void Mixer::removeScopeUser()
+{
+	m_scopeUsers.fetchAndAddOrdered( -1 );
+}
+
+
+
+
+void Mixer::updateScopeData( const surroundSampleFrame * _buf )
+{
+	ScopeData & d = m_scopeData.back();
+	d.numColumns = qMin<int>( m_framesPerPeriod, ScopeData::MaxColumns );
+	d.peak = 0.0f;
+
+	f_cnt_t frame = 0;
+	for( int col = 0; col < d.numColumns; ++col )
+	{
+		const f_cnt_t end = (f_cnt_t)( col + 1 ) * m_framesPerPeriod /
+								d.numColumns;
+		ScopeColumn & c = d.columns[col];
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			c.min[ch] = c.max[ch] = _buf[frame][ch];
+		}
+		for( ; frame < end; ++frame )
+		{
+			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			{
+				c.min[ch] = qMin( c.min[ch], _buf[frame][ch] );
+				c.max[ch] = qMax( c.max[ch], _buf[frame][ch] );
+			}
+		}
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			d.peak = qMax( d.peak, qMax( c.max[ch], -c.min[ch] ) );
+		}
+	}
+
+	m_scopeData.publish();
+}
+
+
+
+
 void Mixer::changeQuality( const struct qualitySettings & _qs )
 {
 	// don't delete the audio-device
@@ -0,0 +1,293 @@
+/*
+ * OfflineRenderContext.cpp - renders notes of an instrument-track into a
+ *                            sample-buffer without involving the mixer
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtCore/QPair>
+
+#include "OfflineRenderContext.h"
+#include "Instrument.h"
+#include "InstrumentTrack.h"
+#include "MixHelpers.h"
+#include "note_play_handle.h"
+#include "pattern.h"
+#include "SampleBuffer.h"
+#include "engine.h"
+
+
+// maximum number of periods to render after the end of the notes for
+// release-phases (same limit as pattern-freezing always had)
+const int MaxTailPeriods = 2000;
+
+
+OfflineRenderContext::OfflineRenderContext( InstrumentTrack * _track ) :
+	m_track( _track ),
+	m_notes(),
+	m_length( 0 ),
+	m_playHandles(),
+	m_firstBuffer( NULL ),
+	m_secondBuffer( NULL ),
+	m_aborted( false )
+{
+}
+
+
+
+
+OfflineRenderContext::~OfflineRenderContext()
+{
+	clearPlayHandles();
+
+	for( NoteEntryVector::Iterator it = m_notes.begin();
+						it != m_notes.end(); ++it )
+	{
+		delete it->n;
+	}
+}
+
+
+
+
+bool OfflineRenderContext::isSupported( const InstrumentTrack * _track )
+{
+	return _track->instrument() != NULL &&
+				_track->instrument()->supportsOfflineRendering();
+}
+
+
+
+
+void OfflineRenderContext::addPattern( const pattern * _pattern,
+						const midiTime & _start )
+{
+	const NoteVector & notes = _pattern->notes();
+	for( NoteVector::ConstIterator it = notes.begin();
+						it != notes.end(); ++it )
+	{
+		// notes with zero length are steps of beat-patterns which
+		// are not set
+		if( ( *it )->length() == 0 )
+		{
+			continue;
+		}
+		NoteEntry e = { new note( **it ), _start };
+
+		// keep notes sorted by their position
+		NoteEntryVector::Iterator pos = m_notes.begin();
+		while( pos != m_notes.end() &&
+				pos->start + pos->n->pos() <= _start + e.n->pos() )
+		{
+			++pos;
+		}
+		m_notes.insert( pos, e );
+	}
+
+	m_length = qMax<tick_t>( m_length, _start + _pattern->length() );
+}
+
+
+
+
+SampleBuffer * OfflineRenderContext::render( volatile int * _progress )
+{
+	if( !m_track->addOfflineRenderContext( this ) )
+	{
+		return NULL;
+	}
+
+	const fpp_t fpp = engine::mixer()->framesPerPeriod();
+	const float frames_per_tick = engine::framesPerTick();
+	const f_cnt_t total_frames = m_length.frames( frames_per_tick );
+
+	sampleFrame * working_buffer = new sampleFrame[fpp];
+	m_firstBuffer = new sampleFrame[fpp];
+	m_secondBuffer = new sampleFrame[fpp];
+	engine::mixer()->clearAudioBuffer( m_firstBuffer, fpp );
+	engine::mixer()->clearAudioBuffer( m_secondBuffer, fpp );
+
+	typedef QList<QPair<sampleFrame *, fpp_t> > BufferList;
+	BufferList buffers;
+
+	NoteEntryVector::ConstIterator next_note = m_notes.begin();
+	f_cnt_t frame = 0;
+	int tail_periods = 0;
+
+	while( !m_aborted )
+	{
+		if( frame >= total_frames )
+		{
+			// render tails until all notes are done
+			if( m_playHandles.isEmpty() ||
+					++tail_periods > MaxTailPeriods )
+			{
+				break;
+			}
+		}
+
+		// create note-play-handles for all notes starting within
+		// current period
+		while( next_note != m_notes.end() )
+		{
+			const f_cnt_t note_frame = midiTime( next_note->start +
+				next_note->n->pos() ).frames( frames_per_tick );
+			if( note_frame >= frame + fpp )
+			{
+				break;
+			}
+			notePlayHandle * nph = new notePlayHandle( m_track,
+					qMax<f_cnt_t>( 0, note_frame - frame ),
+					next_note->n->length().frames(
+							frames_per_tick ),
+					*next_note->n, NULL, false, this );
+			nph->setSongGlobalParentOffset( next_note->start );
+			m_playHandles.push_back( nph );
+			++next_note;
+		}
+
+		// handle automation: detuning
+		const midiTime cur_time = midiTime::fromFrames( frame,
+							frames_per_tick );
+		for( PlayHandleList::Iterator it = m_playHandles.begin();
+						it != m_playHandles.end(); ++it )
+		{
+			( (notePlayHandle *) *it )->processMidiTime( cur_time );
+		}
+
+		// play everything - output arrives via bufferToContext()
+		for( PlayHandleList::Iterator it = m_playHandles.begin();
+						it != m_playHandles.end(); ++it )
+		{
+			if( !( *it )->done() )
+			{
+				( *it )->play( working_buffer );
+			}
+		}
+		for( PlayHandleList::Iterator it = m_playHandles.begin();
+						it != m_playHandles.end(); )
+		{
+			if( ( *it )->done() )
+			{
+				delete *it;
+				it = m_playHandles.erase( it );
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		// collect output of this period and rotate buffers
+		buffers.push_back( qMakePair( m_firstBuffer, fpp ) );
+		m_firstBuffer = m_secondBuffer;
+		m_secondBuffer = new sampleFrame[fpp];
+		engine::mixer()->clearAudioBuffer( m_secondBuffer, fpp );
+
+		frame += fpp;
+		if( _progress != NULL && total_frames > 0 )
+		{
+			*_progress = qMin<f_cnt_t>( frame, total_frames ) * 100 /
+								total_frames;
+		}
+	}
+
+	clearPlayHandles();
+	m_track->removeOfflineRenderContext( this );
+
+	delete[] working_buffer;
+	delete[] m_firstBuffer;
+	delete[] m_secondBuffer;
+	m_firstBuffer = NULL;
+	m_secondBuffer = NULL;
+
+	SampleBuffer * result = NULL;
+	if( !m_aborted )
+	{
+		f_cnt_t frames = 0;
+		for( BufferList::ConstIterator it = buffers.begin();
+						it != buffers.end(); ++it )
+		{
+			frames += it->second;
+		}
+		sampleFrame * data = new sampleFrame[frames];
+		sampleFrame * data_ptr = data;
+		for( BufferList::ConstIterator it = buffers.begin();
+						it != buffers.end(); ++it )
+		{
+			memcpy( data_ptr, it->first,
+					it->second * sizeof( sampleFrame ) );
+			data_ptr += it->second;
+		}
+		result = new SampleBuffer( data, frames );
+		result->setSampleRate(
+				engine::mixer()->processingSampleRate() );
+		delete[] data;
+	}
+
+	for( BufferList::ConstIterator it = buffers.begin();
+						it != buffers.end(); ++it )
+	{
+		delete[] it->first;
+	}
+
+	return result;
+}
+
+
+
+
+void OfflineRenderContext::bufferToContext( const sampleFrame * _buf,
+						const fpp_t _frames,
+						const f_cnt_t _offset,
+						stereoVolumeVector _vv )
+{
+	const fpp_t fpp = engine::mixer()->framesPerPeriod();
+	const int start_frame = _offset % fpp;
+	const int end_frame = start_frame + _frames;
+	const int loop1_frame = qMin<int>( end_frame, fpp );
+
+	MixHelpers::addMultipliedStereo( m_firstBuffer + start_frame, _buf,
+						_vv.vol[0], _vv.vol[1],
+						loop1_frame - start_frame );
+	if( end_frame > fpp )
+	{
+		MixHelpers::addMultipliedStereo( m_secondBuffer,
+					_buf + ( fpp - start_frame ),
+					_vv.vol[0], _vv.vol[1],
+					qMin<int>( end_frame - fpp, fpp ) );
+	}
+}
+
+
+
+
+void OfflineRenderContext::clearPlayHandles()
+{
+	for( PlayHandleList::Iterator it = m_playHandles.begin();
+						it != m_playHandles.end(); ++it )
+	{
+		delete *it;
+	}
+	m_playHandles.clear();
+}
+
+
@@ -31,20 +31,16 @@
 
 Oscillator::Oscillator( const IntModel * _wave_shape_model,
 				const IntModel * _mod_algo_model,
-				const float & _freq,
 				const float & _detuning,
 				const float & _phase_offset,
 				const float & _volume,
 			Oscillator * _sub_osc ) :
 	m_waveShapeModel( _wave_shape_model ),
 	m_modulationAlgoModel( _mod_algo_model ),
-	m_freq( _freq ),
 	m_detuning( _detuning ),
 	m_volume( _volume ),
 	m_ext_phaseOffset( _phase_offset ),
 	m_subOsc( _sub_osc ),
-	m_phaseOffset( _phase_offset ),
-	m_phase( _phase_offset ),
 	m_userWave( NULL )
 {
 }
@@ -52,10 +48,24 @@ Oscillator::Oscillator( const IntModel * _wave_shape_model,
 
 
 
+void Oscillator::initState( State * _state ) const
+{
+	_state->phaseOffset = m_ext_phaseOffset;
+	_state->phase = m_ext_phaseOffset;
+	if( m_subOsc != NULL )
+	{
+		m_subOsc->initState( _state + 1 );
+	}
+}
+
+
+
+
 void Oscillator::update( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
-	if( m_freq >= engine::mixer()->processingSampleRate() / 2 )
+	if( _freq >= engine::mixer()->processingSampleRate() / 2 )
 	{
 		Mixer::clearAudioBuffer( _ab, _frames );
 		return;
@@ -65,24 +75,25 @@ void Oscillator::update( sampleFrame * _ab, const fpp_t _frames,
 		switch( m_modulationAlgoModel->value() )
 		{
 			case PhaseModulation:
-				updatePM( _ab, _frames, _chnl );
+				updatePM( _ab, _frames, _chnl, _freq, _state );
 				break;
 			case AmplitudeModulation:
-				updateAM( _ab, _frames, _chnl );
+				updateAM( _ab, _frames, _chnl, _freq, _state );
 				break;
 			case SignalMix:
-				updateMix( _ab, _frames, _chnl );
+				updateMix( _ab, _frames, _chnl, _freq, _state );
 				break;
 			case SynchronizedBySubOsc:
-				updateSync( _ab, _frames, _chnl );
+				updateSync( _ab, _frames, _chnl,
+							_freq, _state );
 				break;
 			case FrequencyModulation:
-				updateFM( _ab, _frames, _chnl );
+				updateFM( _ab, _frames, _chnl, _freq, _state );
 		}
 	}
 	else
 	{
-		updateNoSub( _ab, _frames, _chnl );
+		updateNoSub( _ab, _frames, _chnl, _freq, _state );
 	}
 }
 
@@ -90,34 +101,43 @@ void Oscillator::update( sampleFrame * _ab, const fpp_t _frames,
 
 
 void Oscillator::updateNoSub( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
 	switch( m_waveShapeModel->value() )
 	{
 		case SineWave:
 		default:
-			updateNoSub<SineWave>( _ab, _frames, _chnl );
+			updateNoSub<SineWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case TriangleWave:
-			updateNoSub<TriangleWave>( _ab, _frames, _chnl );
+			updateNoSub<TriangleWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SawWave:
-			updateNoSub<SawWave>( _ab, _frames, _chnl );
+			updateNoSub<SawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SquareWave:
-			updateNoSub<SquareWave>( _ab, _frames, _chnl );
+			updateNoSub<SquareWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case MoogSawWave:
-			updateNoSub<MoogSawWave>( _ab, _frames, _chnl );
+			updateNoSub<MoogSawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case ExponentialWave:
-			updateNoSub<ExponentialWave>( _ab, _frames, _chnl );
+			updateNoSub<ExponentialWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case WhiteNoise:
-			updateNoSub<WhiteNoise>( _ab, _frames, _chnl );
+			updateNoSub<WhiteNoise>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case UserDefinedWave:
-			updateNoSub<UserDefinedWave>( _ab, _frames, _chnl );
+			updateNoSub<UserDefinedWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 	}
 }
@@ -126,34 +146,42 @@ void Oscillator::updateNoSub( sampleFrame * _ab, const fpp_t _frames,
 
 
 void Oscillator::updatePM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
 	switch( m_waveShapeModel->value() )
 	{
 		case SineWave:
 		default:
-			updatePM<SineWave>( _ab, _frames, _chnl );
+			updatePM<SineWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case TriangleWave:
-			updatePM<TriangleWave>( _ab, _frames, _chnl );
+			updatePM<TriangleWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SawWave:
-			updatePM<SawWave>( _ab, _frames, _chnl );
+			updatePM<SawWave>( _ab, _frames, _chnl, _freq, _state );
 			break;
 		case SquareWave:
-			updatePM<SquareWave>( _ab, _frames, _chnl );
+			updatePM<SquareWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case MoogSawWave:
-			updatePM<MoogSawWave>( _ab, _frames, _chnl );
+			updatePM<MoogSawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case ExponentialWave:
-			updatePM<ExponentialWave>( _ab, _frames, _chnl );
+			updatePM<ExponentialWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case WhiteNoise:
-			updatePM<WhiteNoise>( _ab, _frames, _chnl );
+			updatePM<WhiteNoise>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case UserDefinedWave:
-			updatePM<UserDefinedWave>( _ab, _frames, _chnl );
+			updatePM<UserDefinedWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 	}
 }
@@ -162,34 +190,42 @@ void Oscillator::updatePM( sampleFrame * _ab, const fpp_t _frames,
 
 
 void Oscillator::updateAM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
 	switch( m_waveShapeModel->value() )
 	{
 		case SineWave:
 		default:
-			updateAM<SineWave>( _ab, _frames, _chnl );
+			updateAM<SineWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case TriangleWave:
-			updateAM<TriangleWave>( _ab, _frames, _chnl );
+			updateAM<TriangleWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SawWave:
-			updateAM<SawWave>( _ab, _frames, _chnl );
+			updateAM<SawWave>( _ab, _frames, _chnl, _freq, _state );
 			break;
 		case SquareWave:
-			updateAM<SquareWave>( _ab, _frames, _chnl );
+			updateAM<SquareWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case MoogSawWave:
-			updateAM<MoogSawWave>( _ab, _frames, _chnl );
+			updateAM<MoogSawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case ExponentialWave:
-			updateAM<ExponentialWave>( _ab, _frames, _chnl );
+			updateAM<ExponentialWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case WhiteNoise:
-			updateAM<WhiteNoise>( _ab, _frames, _chnl );
+			updateAM<WhiteNoise>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case UserDefinedWave:
-			updateAM<UserDefinedWave>( _ab, _frames, _chnl );
+			updateAM<UserDefinedWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 	}
 }
@@ -198,34 +234,43 @@ void Oscillator::updateAM( sampleFrame * _ab, const fpp_t _frames,
 
 
 void Oscillator::updateMix( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
 	switch( m_waveShapeModel->value() )
 	{
 		case SineWave:
 		default:
-			updateMix<SineWave>( _ab, _frames, _chnl );
+			updateMix<SineWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case TriangleWave:
-			updateMix<TriangleWave>( _ab, _frames, _chnl );
+			updateMix<TriangleWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SawWave:
-			updateMix<SawWave>( _ab, _frames, _chnl );
+			updateMix<SawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SquareWave:
-			updateMix<SquareWave>( _ab, _frames, _chnl );
+			updateMix<SquareWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case MoogSawWave:
-			updateMix<MoogSawWave>( _ab, _frames, _chnl );
+			updateMix<MoogSawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case ExponentialWave:
-			updateMix<ExponentialWave>( _ab, _frames, _chnl );
+			updateMix<ExponentialWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case WhiteNoise:
-			updateMix<WhiteNoise>( _ab, _frames, _chnl );
+			updateMix<WhiteNoise>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case UserDefinedWave:
-			updateMix<UserDefinedWave>( _ab, _frames, _chnl );
+			updateMix<UserDefinedWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 	}
 }
@@ -234,34 +279,43 @@ void Oscillator::updateMix( sampleFrame * _ab, const fpp_t _frames,
 
 
 void Oscillator::updateSync( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
 	switch( m_waveShapeModel->value() )
 	{
 		case SineWave:
 		default:
-			updateSync<SineWave>( _ab, _frames, _chnl );
+			updateSync<SineWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case TriangleWave:
-			updateSync<TriangleWave>( _ab, _frames, _chnl );
+			updateSync<TriangleWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SawWave:
-			updateSync<SawWave>( _ab, _frames, _chnl );
+			updateSync<SawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SquareWave:
-			updateSync<SquareWave>( _ab, _frames, _chnl );
+			updateSync<SquareWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case MoogSawWave:
-			updateSync<MoogSawWave>( _ab, _frames, _chnl );
+			updateSync<MoogSawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case ExponentialWave:
-			updateSync<ExponentialWave>( _ab, _frames, _chnl );
+			updateSync<ExponentialWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case WhiteNoise:
-			updateSync<WhiteNoise>( _ab, _frames, _chnl );
+			updateSync<WhiteNoise>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case UserDefinedWave:
-			updateSync<UserDefinedWave>( _ab, _frames, _chnl );
+			updateSync<UserDefinedWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 	}
 }
@@ -270,34 +324,42 @@ void Oscillator::updateSync( sampleFrame * _ab, const fpp_t _frames,
 
 
 void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
 	switch( m_waveShapeModel->value() )
 	{
 		case SineWave:
 		default:
-			updateFM<SineWave>( _ab, _frames, _chnl );
+			updateFM<SineWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case TriangleWave:
-			updateFM<TriangleWave>( _ab, _frames, _chnl );
+			updateFM<TriangleWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case SawWave:
-			updateFM<SawWave>( _ab, _frames, _chnl );
+			updateFM<SawWave>( _ab, _frames, _chnl, _freq, _state );
 			break;
 		case SquareWave:
-			updateFM<SquareWave>( _ab, _frames, _chnl );
+			updateFM<SquareWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case MoogSawWave:
-			updateFM<MoogSawWave>( _ab, _frames, _chnl );
+			updateFM<MoogSawWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case ExponentialWave:
-			updateFM<ExponentialWave>( _ab, _frames, _chnl );
+			updateFM<ExponentialWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case WhiteNoise:
-			updateFM<WhiteNoise>( _ab, _frames, _chnl );
+			updateFM<WhiteNoise>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 		case UserDefinedWave:
-			updateFM<UserDefinedWave>( _ab, _frames, _chnl );
+			updateFM<UserDefinedWave>( _ab, _frames, _chnl,
+						_freq, _state );
 			break;
 	}
 }
@@ -306,59 +368,68 @@ void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
 
 
 // should be called every time phase-offset is changed...
-inline void Oscillator::recalcPhase()
+inline void Oscillator::recalcPhase( State * _state ) const
 {
-	if( !typeInfo<float>::isEqual( m_phaseOffset, m_ext_phaseOffset ) )
+	if( !typeInfo<float>::isEqual( _state->phaseOffset,
+							m_ext_phaseOffset ) )
 	{
-		m_phase -= m_phaseOffset;
-		m_phaseOffset = m_ext_phaseOffset;
-		m_phase += m_phaseOffset;
+		_state->phase -= _state->phaseOffset;
+		_state->phaseOffset = m_ext_phaseOffset;
+		_state->phase += _state->phaseOffset;
 	}
-	m_phase = absFraction( m_phase )+2;	// make sure we're not running
-						// negative when doing PM
+	// make sure we're not running negative when doing PM
+	_state->phase = absFraction( _state->phase )+2;
 }
 
 
 
 
-inline bool Oscillator::syncOk( float _osc_coeff )
+inline bool Oscillator::syncOk( float _osc_coeff, State * _state )
 {
-	const float v1 = m_phase;
-	m_phase += _osc_coeff;
-	// check whether m_phase is in next period
-	return( floorf( m_phase ) > floorf( v1 ) );
+	const float v1 = _state->phase;
+	_state->phase += _osc_coeff;
+	// check whether phase is in next period
+	return( floorf( _state->phase ) > floorf( v1 ) );
 }
 
 
 
 
 float Oscillator::syncInit( sampleFrame * _ab, const fpp_t _frames,
-						const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
 	if( m_subOsc != NULL )
 	{
-		m_subOsc->update( _ab, _frames, _chnl );
+		m_subOsc->update( _ab, _frames, _chnl, _freq, _state + 1 );
 	}
-	recalcPhase();
-	return( m_freq * m_detuning );
+	recalcPhase( _state );
+	return( _freq * m_detuning );
 }
 
 
 
 
+// phase is kept in a local variable in all of the following loops as the
+// compiler can't know it's not aliased by the buffer
+
 // if we have no sub-osc, we can't do any modulation... just get our samples
 template<Oscillator::WaveShapes W>
 void Oscillator::updateNoSub( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	recalcPhase( _state );
+	const float osc_coeff = _freq * m_detuning;
+	const float volume = m_volume;
+	float phase = _state->phase;
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		_ab[frame][_chnl] = getSample<W>( phase ) * volume;
+		phase += osc_coeff;
 	}
+	_state->phase = phase;
 }
 
 
@@ -367,19 +438,23 @@ void Oscillator::updateNoSub( sampleFrame * _ab, const fpp_t _frames,
 // do pm by using sub-osc as modulator
 template<Oscillator::WaveShapes W>
 void Oscillator::updatePM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
-	m_subOsc->update( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	m_subOsc->update( _ab, _frames, _chnl, _freq, _state + 1 );
+	recalcPhase( _state );
+	const float osc_coeff = _freq * m_detuning;
+	const float volume = m_volume;
+	float phase = _state->phase;
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
-		_ab[frame][_chnl] = getSample<W>( m_phase +
+		_ab[frame][_chnl] = getSample<W>( phase +
 					_ab[frame][_chnl] )
-							* m_volume;
-		m_phase += osc_coeff;
+							* volume;
+		phase += osc_coeff;
 	}
+	_state->phase = phase;
 }
 
 
@@ -388,17 +463,21 @@ void Oscillator::updatePM( sampleFrame * _ab, const fpp_t _frames,
 // do am by using sub-osc as modulator
 template<Oscillator::WaveShapes W>
 void Oscillator::updateAM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
-	m_subOsc->update( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	m_subOsc->update( _ab, _frames, _chnl, _freq, _state + 1 );
+	recalcPhase( _state );
+	const float osc_coeff = _freq * m_detuning;
+	const float volume = m_volume;
+	float phase = _state->phase;
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
-		_ab[frame][_chnl] *= getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		_ab[frame][_chnl] *= getSample<W>( phase ) * volume;
+		phase += osc_coeff;
 	}
+	_state->phase = phase;
 }
 
 
@@ -407,17 +486,21 @@ void Oscillator::updateAM( sampleFrame * _ab, const fpp_t _frames,
 // do mix by using sub-osc as mix-sample
 template<Oscillator::WaveShapes W>
 void Oscillator::updateMix( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
-	m_subOsc->update( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	m_subOsc->update( _ab, _frames, _chnl, _freq, _state + 1 );
+	recalcPhase( _state );
+	const float osc_coeff = _freq * m_detuning;
+	const float volume = m_volume;
+	float phase = _state->phase;
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
-		_ab[frame][_chnl] += getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		_ab[frame][_chnl] += getSample<W>( phase ) * volume;
+		phase += osc_coeff;
 	}
+	_state->phase = phase;
 }
 
 
@@ -427,21 +510,26 @@ void Oscillator::updateMix( sampleFrame * _ab, const fpp_t _frames,
 // period)
 template<Oscillator::WaveShapes W>
 void Oscillator::updateSync( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
-	const float sub_osc_coeff = m_subOsc->syncInit( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	const float sub_osc_coeff = m_subOsc->syncInit( _ab, _frames, _chnl,
+							_freq, _state + 1 );
+	recalcPhase( _state );
+	const float osc_coeff = _freq * m_detuning;
+	const float volume = m_volume;
+	float phase = _state->phase;
 
 	for( fpp_t frame = 0; frame < _frames ; ++frame )
 	{
-		if( m_subOsc->syncOk( sub_osc_coeff ) )
+		if( syncOk( sub_osc_coeff, _state + 1 ) )
 		{
-			m_phase = m_phaseOffset;
+			phase = _state->phaseOffset;
 		}
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		_ab[frame][_chnl] = getSample<W>( phase ) * volume;
+		phase += osc_coeff;
 	}
+	_state->phase = phase;
 }
 
 
@@ -450,20 +538,24 @@ void Oscillator::updateSync( sampleFrame * _ab, const fpp_t _frames,
 // do fm by using sub-osc as modulator
 template<Oscillator::WaveShapes W>
 void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+				const ch_cnt_t _chnl, const float _freq,
+						State * _state ) const
 {
-	m_subOsc->update( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	m_subOsc->update( _ab, _frames, _chnl, _freq, _state + 1 );
+	recalcPhase( _state );
+	const float osc_coeff = _freq * m_detuning;
 	const float sampleRateCorrection = 44100.0f /
 				engine::mixer()->processingSampleRate();
+	const float volume = m_volume;
+	float phase = _state->phase;
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
-		m_phase += _ab[frame][_chnl] * sampleRateCorrection;
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		phase += _ab[frame][_chnl] * sampleRateCorrection;
+		_ab[frame][_chnl] = getSample<W>( phase ) * volume;
+		phase += osc_coeff;
 	}
+	_state->phase = phase;
 }
 
 
@@ -471,7 +563,7 @@ void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
 
 template<>
 inline sample_t Oscillator::getSample<Oscillator::SineWave>(
-							const float _sample )
+						const float _sample ) const
 {
 	return( sinSample( _sample ) );
 }
@@ -481,7 +573,7 @@ inline sample_t Oscillator::getSample<Oscillator::SineWave>(
 
 template<>
 inline sample_t Oscillator::getSample<Oscillator::TriangleWave>(
-							const float _sample )
+						const float _sample ) const
 {
 	return( triangleSample( _sample ) );
 }
@@ -491,7 +583,7 @@ inline sample_t Oscillator::getSample<Oscillator::TriangleWave>(
 
 template<>
 inline sample_t Oscillator::getSample<Oscillator::SawWave>(
-							const float _sample )
+						const float _sample ) const
 {
 	return( sawSample( _sample ) );
 }
@@ -501,7 +593,7 @@ inline sample_t Oscillator::getSample<Oscillator::SawWave>(
 
 template<>
 inline sample_t Oscillator::getSample<Oscillator::SquareWave>(
-							const float _sample )
+						const float _sample ) const
 {
 	return( squareSample( _sample ) );
 }
@@ -511,7 +603,7 @@ inline sample_t Oscillator::getSample<Oscillator::SquareWave>(
 
 template<>
 inline sample_t Oscillator::getSample<Oscillator::MoogSawWave>(
-							const float _sample )
+						const float _sample ) const
 {
 	return( moogSawSample( _sample ) );
 }
@@ -521,7 +613,7 @@ inline sample_t Oscillator::getSample<Oscillator::MoogSawWave>(
 
 template<>
 inline sample_t Oscillator::getSample<Oscillator::ExponentialWave>(
-							const float _sample )
+						const float _sample ) const
 {
 	return( expSample( _sample ) );
 }
@@ -531,7 +623,7 @@ inline sample_t Oscillator::getSample<Oscillator::ExponentialWave>(
 
 template<>
 inline sample_t Oscillator::getSample<Oscillator::WhiteNoise>(
-							const float _sample )
+						const float _sample ) const
 {
 	return( noiseSample( _sample ) );
 }
@@ -541,7 +633,7 @@ inline sample_t Oscillator::getSample<Oscillator::WhiteNoise>(
 
 template<>
 inline sample_t Oscillator::getSample<Oscillator::UserDefinedWave>(
-							const float _sample )
+						const float _sample ) const
 {
 	return( userWaveSample( _sample ) );
 }
@@ -26,6 +26,7 @@
 
 #include <QtCore/QDir>
 #include <QtCore/QLibrary>
+#include <QtCore/QMutex>
 #include <QtGui/QMessageBox>
 
 #include "Plugin.h"
@@ -135,6 +136,20 @@ Plugin * Plugin::instantiate( const QString & _plugin_name, Model * _parent,
 
 void Plugin::getDescriptorsOfAvailPlugins( DescriptorList & _plugin_descs )
 {
+	// descriptors are statically allocated by plugin-libraries which are
+	// never unloaded, so scanning the plugin-directory once is enough
+	static QMutex mutex;
+	static DescriptorList descriptors;
+	static bool scanned = false;
+
+	QMutexLocker ml( &mutex );
+	if( scanned )
+	{
+		_plugin_descs += descriptors;
+		return;
+	}
+	scanned = true;
+
 	QDir directory( configManager::inst()->pluginDir() );
 #ifdef LMMS_BUILD_WIN32
 	QFileInfoList list = directory.entryInfoList(
@@ -143,13 +158,24 @@ void Plugin::getDescriptorsOfAvailPlugins( DescriptorList & _plugin_descs )
 	QFileInfoList list = directory.entryInfoList(
 						QStringList( "lib*.so" ) );
 #endif
+	// libraries depending on other plugin-libraries might fail to load
+	// before their dependencies did, so retry those once in the end
+	QFileInfoList failed;
 	foreach( const QFileInfo & f, list )
+	{
+		if( !QLibrary( f.absoluteFilePath() ).load() )
+		{
+			failed.push_back( f );
+		}
+	}
+	foreach( const QFileInfo & f, failed )
 	{
 		QLibrary( f.absoluteFilePath() ).load();
 	}
 
 	foreach( const QFileInfo & f, list )
 	{
+		// already loaded, so this only looks up the handle
 		QLibrary plugin_lib( f.absoluteFilePath() );
 		if( plugin_lib.load() == false ||
 			plugin_lib.resolve( "lmms_plugin_main" ) == NULL )
@@ -173,9 +199,10 @@ void Plugin::getDescriptorsOfAvailPlugins( DescriptorList & _plugin_descs )
 					desc_name.toUtf8().constData() );
 			continue;
 		}
-		_plugin_descs.push_back( *plugin_desc );
+		descriptors.push_back( *plugin_desc );
 	}
 
+	_plugin_descs += descriptors;
 }
 
 
@@ -25,17 +25,37 @@
 #include <cstdlib>
 
 #include "ProjectJournal.h"
+#include "config_mgr.h"
 #include "engine.h"
 #include "JournallingObject.h"
 #include "song.h"
 
 
+static const jo_id_t EO_ID_MAX = (1 << 23)-1;
+
+
+
 ProjectJournal::ProjectJournal() :
 	m_joIDs(),
 	m_journalEntries(),
 	m_currentJournalEntry( m_journalEntries.end() ),
+	m_entryPositions(),
+	m_journalSize( 0 ),
+	m_maxJournalSize( DefaultMaxJournalSize * 1024 * 1024 ),
+	m_lastEntryTime(),
+	m_freeIDs(),
+	// start at random ID so that IDs saved in projects of other sessions
+	// rarely collide with the ones used in this session
+	m_nextID( static_cast<jo_id_t>( (jo_id_t)rand()*(jo_id_t)rand() %
+							EO_ID_MAX ) + 1 ),
 	m_journalling( false )
 {
+	const int max_size = configManager::inst()->value( "app",
+						"undomemory" ).toInt();
+	if( max_size > 0 )
+	{
+		m_maxJournalSize = max_size * 1024 * 1024;
+	}
 }
 
 
@@ -55,13 +75,19 @@ void ProjectJournal::undo()
 		return;
 	}
 
-	JournallingObject * jo;
+	// don't merge following changes into an undone step
+	m_lastEntryTime = QTime();
 
-	if( m_currentJournalEntry - 1 >= m_journalEntries.begin() &&
-		( jo = m_joIDs[*--m_currentJournalEntry] ) != NULL )
+	if( m_currentJournalEntry != m_journalEntries.begin() )
 	{
-		jo->undo();
-		engine::getSong()->setModified();
+		--m_currentJournalEntry;
+		JournallingObject * jo =
+				m_joIDs.value( m_currentJournalEntry->id );
+		if( jo != NULL )
+		{
+			jo->undo();
+			engine::getSong()->setModified();
+		}
 	}
 }
 
@@ -75,25 +101,59 @@ void ProjectJournal::redo()
 		return;
 	}
 
-	JournallingObject * jo;
+	m_lastEntryTime = QTime();
 
-	//printf("%d\n", m_joIDs[*(m_currentJournalEntry+1)] );
-	if( m_currentJournalEntry < m_journalEntries.end() &&
-		( jo = m_joIDs[*m_currentJournalEntry++] ) != NULL )
+	if( m_currentJournalEntry != m_journalEntries.end() )
 	{
-		jo->redo();
-		engine::getSong()->setModified();
+		JournallingObject * jo =
+				m_joIDs.value( m_currentJournalEntry->id );
+		++m_currentJournalEntry;
+		if( jo != NULL )
+		{
+			jo->redo();
+			engine::getSong()->setModified();
+		}
 	}
 }
 
 
 
 
-void ProjectJournal::journalEntryAdded( const jo_id_t _id )
+void ProjectJournal::journalEntryAdded( const jo_id_t _id, const int _size )
 {
-	m_journalEntries.erase( m_currentJournalEntry, m_journalEntries.end() );
-	m_journalEntries.push_back( _id );
-	m_currentJournalEntry = m_journalEntries.end();
+	removeRedoEntries();
+
+	Entry e;
+	e.id = _id;
+	e.size = _size + sizeof( Entry );
+	m_journalEntries.push_back( e );
+	m_entryPositions[_id].push_back( --m_journalEntries.end() );
+	m_journalSize += e.size;
+	m_lastEntryTime.start();
+
+	trimJournal();
+
+	engine::getSong()->setModified();
+}
+
+
+
+
+bool ProjectJournal::canCoalesce( const jo_id_t _id ) const
+{
+	return m_currentJournalEntry == m_journalEntries.end() &&
+		!m_journalEntries.empty() &&
+		m_journalEntries.back().id == _id &&
+		m_lastEntryTime.isValid() &&
+		m_lastEntryTime.elapsed() < CoalesceInterval;
+}
+
+
+
+
+void ProjectJournal::journalEntryCoalesced( const jo_id_t )
+{
+	m_lastEntryTime.start();
 	engine::getSong()->setModified();
 }
 
@@ -102,13 +162,21 @@ void ProjectJournal::journalEntryAdded( const jo_id_t _id )
 
 jo_id_t ProjectJournal::allocID( JournallingObject * _obj )
 {
-	const jo_id_t EO_ID_MAX = (1 << 23)-1;
+	// IDs might have been registered via reallocID() in the meantime
 	jo_id_t id;
-	while( m_joIDs.contains( id =
-			static_cast<jo_id_t>( (jo_id_t)rand()*(jo_id_t)rand() % 
-								 EO_ID_MAX ) ) )
+	do
 	{
-	}
+		if( !m_freeIDs.isEmpty() )
+		{
+			id = m_freeIDs.last();
+			m_freeIDs.pop_back();
+		}
+		else
+		{
+			id = m_nextID;
+			m_nextID = m_nextID % EO_ID_MAX + 1;
+		}
+	} while( m_joIDs.contains( id ) );
 
 	m_joIDs[id] = _obj;
 	//printf("new id: %d\n", id );
@@ -133,17 +201,27 @@ void ProjectJournal::reallocID( const jo_id_t _id, JournallingObject * _obj )
 void ProjectJournal::forgetAboutID( const jo_id_t _id )
 {
 	//printf("forget about %d\n", _id );
-	JournalEntryVector::Iterator it;
-	while( ( it = qFind( m_journalEntries.begin(), m_journalEntries.end(),
-					_id ) ) != m_journalEntries.end() )
+	QHash<jo_id_t, EntryPositions>::Iterator positions =
+						m_entryPositions.find( _id );
+	if( positions != m_entryPositions.end() )
 	{
-		if( m_currentJournalEntry >= it )
+		for( EntryPositions::ConstIterator it =
+						positions.value().begin();
+					it != positions.value().end(); ++it )
 		{
-			--m_currentJournalEntry;
+			if( *it == m_currentJournalEntry )
+			{
+				++m_currentJournalEntry;
+			}
+			m_journalSize -= ( *it )->size;
+			m_journalEntries.erase( *it );
 		}
-		m_journalEntries.erase( it );
+		m_entryPositions.erase( positions );
+	}
+	if( m_joIDs.remove( _id ) > 0 )
+	{
+		m_freeIDs.push_back( _id );
 	}
-	m_joIDs.remove( _id );
 }
 
 
@@ -153,10 +231,14 @@ void ProjectJournal::clearJournal()
 {
 	m_journalEntries.clear();
 	m_currentJournalEntry = m_journalEntries.end();
+	m_entryPositions.clear();
+	m_journalSize = 0;
+	m_lastEntryTime = QTime();
 	for( JoIdMap::Iterator it = m_joIDs.begin(); it != m_joIDs.end(); )
 	{
 		if( it.value() == NULL )
 		{
+			m_freeIDs.push_back( it.key() );
 			it = m_joIDs.erase( it );
 		}
 		else
@@ -168,3 +250,64 @@ void ProjectJournal::clearJournal()
 
 
 
+
+void ProjectJournal::removeEntry( JournalEntryList::iterator _it )
+{
+	QHash<jo_id_t, EntryPositions>::Iterator positions =
+					m_entryPositions.find( _it->id );
+	if( positions.value().first() == _it )
+	{
+		positions.value().removeFirst();
+	}
+	else
+	{
+		positions.value().removeLast();
+	}
+	if( positions.value().isEmpty() )
+	{
+		m_entryPositions.erase( positions );
+	}
+	m_journalSize -= _it->size;
+	m_journalEntries.erase( _it );
+}
+
+
+
+
+void ProjectJournal::removeRedoEntries()
+{
+	// newest first, so each one is the newest entry of its ID
+	while( m_currentJournalEntry != m_journalEntries.end() )
+	{
+		JournalEntryList::iterator last = --m_journalEntries.end();
+		if( last == m_currentJournalEntry )
+		{
+			m_currentJournalEntry = m_journalEntries.end();
+		}
+		removeEntry( last );
+	}
+}
+
+
+
+
+void ProjectJournal::trimJournal()
+{
+	// never drop steps which can be redone and keep at least one step
+	// to undo
+	while( m_journalSize > m_maxJournalSize &&
+		m_currentJournalEntry != m_journalEntries.begin() &&
+		m_currentJournalEntry != ++m_journalEntries.begin() )
+	{
+		JournallingObject * jo =
+			m_joIDs.value( m_journalEntries.front().id );
+		if( jo != NULL )
+		{
+			jo->forgetOldestJournalEntry();
+		}
+		removeEntry( m_journalEntries.begin() );
+	}
+}
+
+
+
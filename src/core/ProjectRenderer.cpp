@@ -35,8 +35,14 @@
 #ifdef LMMS_HAVE_SCHED_H
 #include <sched.h>
 #endif
+#ifndef LMMS_BUILD_WIN32
+#include <sys/resource.h>
+#endif
 #include <QMutexLocker>
 
+#include "AllocationCounter.h"
+#include "MicroTimer.h"
+
 FileEncodeDevice __fileEncodeDevices[] =
 {
 
@@ -71,7 +77,8 @@ ProjectRenderer::ProjectRenderer( const Mixer::qualitySettings & _qs,
 	m_qualitySettings( _qs ),
 	m_oldQualitySettings( engine::mixer()->currentQualitySettings() ),
 	m_progress( 0 ),
-	m_abort( false )
+	m_abort( false ),
+	m_profiling( false )
 {
 	if( __fileEncodeDevices[_file_format].m_getDevInst == NULL )
 	{
@@ -166,11 +173,21 @@ void ProjectRenderer::run()
 	m_progress = 0;
 	const int sl = ( engine::getSong()->length() + 1 ) * 192;
 
+	const int64_t start_time = MicroTimer::now();
+	int periods = 0;
+	if( m_profiling )
+	{
+		engine::mixer()->resetProfile();
+		AllocationCounter::reset();
+		AllocationCounter::setEnabled( true );
+	}
+
 	while( engine::getSong()->isExportDone() == false &&
 				engine::getSong()->isExporting() == true
 							&& !m_abort )
 	{
 		m_fileDev->processNextBuffer();
+		++periods;
 		const int nprog = pp * 100 / sl;
 		if( m_progress != nprog )
 		{
@@ -179,6 +196,12 @@ void ProjectRenderer::run()
 		}
 	}
 
+	if( m_profiling )
+	{
+		AllocationCounter::setEnabled( false );
+		printProfile( periods, MicroTimer::now() - start_time );
+	}
+
 	engine::getSong()->stopExport();
 
 	const QString f = m_fileDev->outputFile();
@@ -203,6 +226,57 @@ void ProjectRenderer::abortProcessing()
 
 
 
+// lines are prefixed with "profile:" and have a fixed format as they're
+// parsed by the benchmark-suite in tests/benchmark
+void ProjectRenderer::printProfile( int _periods, int64_t _wall_time )
+{
+	const Mixer * mixer = engine::mixer();
+	const double duration = (double) _periods *
+					mixer->framesPerPeriod() /
+					mixer->processingSampleRate();
+	const double wall_time = qMax<int64_t>( _wall_time, 1 ) / 1000000.0;
+
+	printf( "\nprofile: periods %d\n", _periods );
+	printf( "profile: duration %.3f s\n", duration );
+	printf( "profile: wall-time %.3f s\n", wall_time );
+	printf( "profile: realtime-factor %.2f\n", duration / wall_time );
+
+	static const char * stageNames[Mixer::NumProfileStages] =
+	{
+		"prepare", "play-handles", "audio-port-effects",
+		"fx-channels", "master-mix"
+	} ;
+	for( int i = 0; i < Mixer::NumProfileStages; ++i )
+	{
+		const int64_t t = mixer->stageTime( (Mixer::ProfileStages) i );
+		printf( "profile: stage %s %.1f us/period\n", stageNames[i],
+			(double) t / qMax( mixer->profiledPeriods(), 1 ) );
+	}
+
+	if( AllocationCounter::isAvailable() )
+	{
+		printf( "profile: allocations %d\n",
+						AllocationCounter::count() );
+	}
+	else
+	{
+		printf( "profile: allocations n/a\n" );
+	}
+
+#ifndef LMMS_BUILD_WIN32
+	struct rusage usage;
+	if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+	{
+		// ru_maxrss is given in kilobytes on Linux
+		printf( "profile: peak-rss %ld kB\n", usage.ru_maxrss );
+	}
+#endif
+	fflush( stdout );
+}
+
+
+
+
 void ProjectRenderer::updateConsoleProgress()
 {
 	const int cols = 50;
@@ -0,0 +1,500 @@
+/*
+ * RenderServer.cpp - renders projects on request of local clients
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <cstdlib>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFileInfo>
+#include <QtNetwork/QLocalServer>
+
+#include "RenderServer.h"
+#include "engine.h"
+#include "song.h"
+
+
+RenderServer::RenderServer( const QString & _socket_name ) :
+	QObject(),
+	m_server( new QLocalServer( this ) ),
+	m_jobs(),
+	m_renderer( NULL ),
+	m_lastProgress( -1 ),
+	m_nextId( 1 ),
+	m_quit( false ),
+	m_fixedSeed( false ),
+	m_seed( 0 )
+{
+	// remove socket of a server which didn't exit cleanly
+	QLocalServer::removeServer( _socket_name );
+	if( !m_server->listen( _socket_name ) )
+	{
+		fprintf( stderr, "Could not listen on %s: %s\n",
+				_socket_name.toUtf8().constData(),
+			m_server->errorString().toUtf8().constData() );
+		return;
+	}
+
+	connect( m_server, SIGNAL( newConnection() ),
+				this, SLOT( acceptConnection() ) );
+
+	printf( "render-server listening on %s\n",
+			m_server->fullServerName().toUtf8().constData() );
+}
+
+
+
+
+RenderServer::~RenderServer()
+{
+	if( m_renderer != NULL )
+	{
+		m_renderer->abortProcessing();
+		m_renderer->wait();
+		delete m_renderer;
+	}
+}
+
+
+
+
+bool RenderServer::isListening() const
+{
+	return m_server->isListening();
+}
+
+
+
+
+void RenderServer::setSeed( unsigned int _seed )
+{
+	m_fixedSeed = true;
+	m_seed = _seed;
+}
+
+
+
+
+void RenderServer::acceptConnection()
+{
+	while( m_server->hasPendingConnections() )
+	{
+		QLocalSocket * client = m_server->nextPendingConnection();
+		connect( client, SIGNAL( readyRead() ),
+					this, SLOT( readCommands() ) );
+		connect( client, SIGNAL( disconnected() ),
+					client, SLOT( deleteLater() ) );
+	}
+}
+
+
+
+
+void RenderServer::readCommands()
+{
+	QLocalSocket * client = qobject_cast<QLocalSocket *>( sender() );
+	if( client == NULL )
+	{
+		return;
+	}
+
+	while( client->canReadLine() )
+	{
+		const QString line = QString::fromUtf8(
+					client->readLine() ).trimmed();
+		if( !line.isEmpty() )
+		{
+			handleCommand( client, line.split( '\t' ) );
+		}
+	}
+}
+
+
+
+
+void RenderServer::updateProgress( int _progress )
+{
+	if( m_jobs.isEmpty() || _progress == m_lastProgress )
+	{
+		return;
+	}
+	m_lastProgress = _progress;
+
+	const Job & job = m_jobs.first();
+	if( job.client )
+	{
+		reply( job.client, QStringList() << "progress" <<
+					QString::number( job.id ) <<
+					QString::number( _progress ) );
+	}
+}
+
+
+
+
+void RenderServer::jobFinished()
+{
+	if( m_renderer == NULL || m_jobs.isEmpty() )
+	{
+		return;
+	}
+
+	m_renderer->deleteLater();
+	m_renderer = NULL;
+
+	const Job job = m_jobs.takeFirst();
+	if( job.client )
+	{
+		if( job.cancelled )
+		{
+			reply( job.client, QStringList() << "cancelled" <<
+						QString::number( job.id ) );
+		}
+		else if( !QFileInfo( job.output ).exists() )
+		{
+			reply( job.client, QStringList() << "failed" <<
+						QString::number( job.id ) <<
+						"no output written" );
+		}
+		else
+		{
+			reply( job.client, QStringList() << "done" <<
+						QString::number( job.id ) <<
+						job.output );
+		}
+	}
+
+	startNextJob();
+}
+
+
+
+
+void RenderServer::handleCommand( QLocalSocket * _client,
+						const QStringList & _fields )
+{
+	const QString & cmd = _fields.first();
+
+	if( cmd == "render" )
+	{
+		if( _fields.size() < 3 )
+		{
+			reply( _client, QStringList() << "error" <<
+				"usage: render <project> <output> "
+						"[<option>=<value> ...]" );
+			return;
+		}
+
+		Job job;
+		job.project = QFileInfo( _fields[1] ).absoluteFilePath();
+		job.output = QFileInfo( _fields[2] ).absoluteFilePath();
+		job.format = ProjectRenderer::getFileFormatFromExtension(
+				"." + QFileInfo( job.output ).suffix() );
+		job.client = _client;
+
+		if( !QFileInfo( job.project ).isReadable() )
+		{
+			reply( _client, QStringList() << "error" <<
+					"can't read " + job.project );
+			return;
+		}
+
+		for( int i = 3; i < _fields.size(); ++i )
+		{
+			const QString err = parseOption( job, _fields[i] );
+			if( !err.isEmpty() )
+			{
+				reply( _client, QStringList() << "error" <<
+									err );
+				return;
+			}
+		}
+
+		if( m_quit )
+		{
+			reply( _client, QStringList() << "error" <<
+						"server is shutting down" );
+			return;
+		}
+
+		job.id = m_nextId++;
+		m_jobs.push_back( job );
+		reply( _client, QStringList() << "queued" <<
+						QString::number( job.id ) );
+
+		if( m_renderer == NULL )
+		{
+			startNextJob();
+		}
+	}
+	else if( cmd == "cancel" && _fields.size() == 2 )
+	{
+		const int id = _fields[1].toInt();
+		for( int i = 0; i < m_jobs.size(); ++i )
+		{
+			if( m_jobs[i].id != id )
+			{
+				continue;
+			}
+			if( i == 0 && m_renderer != NULL )
+			{
+				// reported as soon as renderer has stopped
+				m_jobs[i].cancelled = true;
+				m_jobs[i].client = _client;
+				m_renderer->abortProcessing();
+			}
+			else
+			{
+				m_jobs.removeAt( i );
+				reply( _client, QStringList() << "cancelled" <<
+							QString::number( id ) );
+			}
+			return;
+		}
+		reply( _client, QStringList() << "error" <<
+						"no such job " + _fields[1] );
+	}
+	else if( cmd == "status" )
+	{
+		for( int i = 0; i < m_jobs.size(); ++i )
+		{
+			reply( _client, QStringList() << "job" <<
+				QString::number( m_jobs[i].id ) <<
+				( ( i == 0 && m_renderer != NULL ) ?
+						"rendering" : "queued" ) <<
+							m_jobs[i].project );
+		}
+		reply( _client, QStringList() << "end" );
+	}
+	else if( cmd == "quit" )
+	{
+		m_quit = true;
+		reply( _client, QStringList() << "bye" );
+		if( m_renderer == NULL )
+		{
+			QCoreApplication::instance()->quit();
+		}
+	}
+	else
+	{
+		reply( _client, QStringList() << "error" <<
+						"unknown command " + cmd );
+	}
+}
+
+
+
+
+QString RenderServer::parseOption( Job & _job, const QString & _option )
+{
+	const QString key = _option.section( '=', 0, 0 );
+	const QString value = _option.section( '=', 1 );
+
+	if( key == "format" )
+	{
+		if( value == "wav" )
+		{
+			_job.format = ProjectRenderer::WaveFile;
+		}
+		else if( value == "ogg" )
+		{
+			_job.format = ProjectRenderer::OggFile;
+		}
+		else
+		{
+			return "invalid format " + value;
+		}
+	}
+	else if( key == "samplerate" )
+	{
+		const sample_rate_t sr = value.toUInt();
+		if( sr < 44100 || sr > 192000 )
+		{
+			return "invalid samplerate " + value;
+		}
+		_job.os.samplerate = sr;
+	}
+	else if( key == "bitrate" )
+	{
+		const int br = value.toInt();
+		if( br < 64 || br > 384 )
+		{
+			return "invalid bitrate " + value;
+		}
+		_job.os.bitrate = br;
+	}
+	else if( key == "depth" )
+	{
+		if( value == "16" )
+		{
+			_job.os.depth = ProjectRenderer::Depth_16Bit;
+		}
+		else if( value == "32" )
+		{
+			_job.os.depth = ProjectRenderer::Depth_32Bit;
+		}
+		else
+		{
+			return "invalid depth " + value;
+		}
+	}
+	else if( key == "vbr" )
+	{
+		_job.os.vbr = value.toInt() != 0;
+	}
+	else if( key == "interpolation" )
+	{
+		if( value == "linear" )
+		{
+			_job.qs.interpolation =
+			Mixer::qualitySettings::Interpolation_Linear;
+		}
+		else if( value == "sincfastest" )
+		{
+			_job.qs.interpolation =
+			Mixer::qualitySettings::Interpolation_SincFastest;
+		}
+		else if( value == "sincmedium" )
+		{
+			_job.qs.interpolation =
+			Mixer::qualitySettings::Interpolation_SincMedium;
+		}
+		else if( value == "sincbest" )
+		{
+			_job.qs.interpolation =
+			Mixer::qualitySettings::Interpolation_SincBest;
+		}
+		else
+		{
+			return "invalid interpolation method " + value;
+		}
+	}
+	else if( key == "oversampling" )
+	{
+		switch( value.toInt() )
+		{
+			case 1:
+				_job.qs.oversampling =
+				Mixer::qualitySettings::Oversampling_None;
+				break;
+			case 2:
+				_job.qs.oversampling =
+				Mixer::qualitySettings::Oversampling_2x;
+				break;
+			case 4:
+				_job.qs.oversampling =
+				Mixer::qualitySettings::Oversampling_4x;
+				break;
+			case 8:
+				_job.qs.oversampling =
+				Mixer::qualitySettings::Oversampling_8x;
+				break;
+			default:
+				return "invalid oversampling " + value;
+		}
+	}
+	else
+	{
+		return "unknown option " + key;
+	}
+
+	return QString();
+}
+
+
+
+
+void RenderServer::startNextJob()
+{
+	while( !m_jobs.isEmpty() )
+	{
+		Job & job = m_jobs.first();
+
+		if( m_fixedSeed )
+		{
+			// every job must get the same random numbers as a
+			// single rendering with --seed would - reseed before
+			// loading as e.g. organic randomizes its settings then
+			srand( m_seed );
+		}
+
+		printf( "rendering %s\n", job.project.toUtf8().constData() );
+		if( !engine::getSong()->loadProject( job.project ) )
+		{
+			if( job.client )
+			{
+				reply( job.client, QStringList() << "failed" <<
+						QString::number( job.id ) <<
+						"can't load " + job.project );
+			}
+			m_jobs.removeFirst();
+			continue;
+		}
+
+		// the renderer truncates the output file once it's ready, so
+		// the client's file stays untouched if this job fails earlier
+		m_renderer = new ProjectRenderer( job.qs, job.os, job.format,
+								job.output );
+		if( m_renderer->isReady() )
+		{
+			connect( m_renderer, SIGNAL( progressChanged( int ) ),
+					this, SLOT( updateProgress( int ) ) );
+			connect( m_renderer, SIGNAL( finished() ),
+					this, SLOT( jobFinished() ) );
+			m_lastProgress = -1;
+			m_renderer->startProcessing();
+			return;
+		}
+
+		delete m_renderer;
+		m_renderer = NULL;
+		if( job.client )
+		{
+			reply( job.client, QStringList() << "failed" <<
+					QString::number( job.id ) <<
+					"can't open " + job.output );
+		}
+		m_jobs.removeFirst();
+	}
+
+	// free memory of last project while idle
+	engine::getSong()->createNewProject();
+
+	if( m_quit )
+	{
+		QCoreApplication::instance()->quit();
+	}
+}
+
+
+
+
+void RenderServer::reply( QLocalSocket * _client, const QStringList & _fields )
+{
+	_client->write( _fields.join( "\t" ).toUtf8() + '\n' );
+}
+
+
+
+
+#include "moc_RenderServer.cxx"
+
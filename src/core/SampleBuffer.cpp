@@ -28,8 +28,13 @@
 
 
 #include <QtCore/QBuffer>
+#include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
+#include <QtCore/QRunnable>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtGui/QMessageBox>
 #include <QtGui/QPainter>
 
@@ -55,6 +60,8 @@
 #include "config_mgr.h"
 #include "debug.h"
 #include "drumsynth.h"
+#include "SampleCache.h"
+#include "SamplePeaks.h"
 #include "endian_handling.h"
 #include "engine.h"
 #include "interpolation.h"
@@ -63,6 +70,211 @@
 #include "FileDialog.h"
 
 
+// samples whose decoded data exceeds this size are streamed from a
+// memory-mapped cache-file instead of being held in memory
+const qint64 STREAMING_THRESHOLD = 64 * 1024 * 1024;
+
+// number of frames decoded at once when streaming
+const f_cnt_t STREAMING_CHUNK_FRAMES = 16384;
+
+// how many seconds the read-ahead thread stays ahead of the playback position
+const int STREAMING_READ_AHEAD_SECONDS = 4;
+
+const int PAGE_SIZE_GUESS = 4096;
+
+
+
+// touches the pages of memory-mapped sample-data ahead of the current
+// playback position of each streamed SampleBuffer so that the mixer thread
+// doesn't have to wait for the disk - runs only as long as there are
+// streamed buffers
+class SampleStreamer : public QThread
+{
+public:
+	static void registerBuffer( SampleBuffer * _buf )
+	{
+		SampleStreamer * s = inst();
+		QMutexLocker ml( &s->m_mutex );
+		Entry e = { _buf, 0, 0 };
+		s->m_buffers.push_back( e );
+		if( !s->m_running )
+		{
+			// make sure a previous run() has returned completely
+			s->wait();
+			s->m_running = true;
+			s->start( QThread::LowPriority );
+		}
+	}
+
+	static void unregisterBuffer( SampleBuffer * _buf )
+	{
+		SampleStreamer * s = inst();
+		QMutexLocker ml( &s->m_mutex );
+		for( QList<Entry>::Iterator it = s->m_buffers.begin();
+						it != s->m_buffers.end(); ++it )
+		{
+			if( it->buffer == _buf )
+			{
+				s->m_buffers.erase( it );
+				break;
+			}
+		}
+	}
+
+
+private:
+	struct Entry
+	{
+		SampleBuffer * buffer;
+		f_cnt_t touchedFrom;
+		f_cnt_t touchedTo;
+	} ;
+
+	SampleStreamer() :
+		QThread(),
+		m_mutex(),
+		m_buffers(),
+		m_running( false )
+	{
+	}
+
+	static SampleStreamer * inst()
+	{
+		static SampleStreamer * s_inst = new SampleStreamer;
+		return s_inst;
+	}
+
+	virtual void run()
+	{
+		const f_cnt_t read_ahead = STREAMING_READ_AHEAD_SECONDS *
+					engine::mixer()->baseSampleRate();
+		const f_cnt_t frames_per_page =
+				PAGE_SIZE_GUESS / sizeof( sampleFrame );
+
+		while( true )
+		{
+			m_mutex.lock();
+			if( m_buffers.isEmpty() )
+			{
+				m_running = false;
+				m_mutex.unlock();
+				return;
+			}
+			for( QList<Entry>::Iterator it = m_buffers.begin();
+						it != m_buffers.end(); ++it )
+			{
+				const SampleBuffer * b = it->buffer;
+				const f_cnt_t pos = b->m_streamPosition;
+				if( pos < it->touchedFrom || pos > it->touchedTo )
+				{
+					// seeked, start over
+					it->touchedFrom = it->touchedTo = pos;
+				}
+				const f_cnt_t end = qMin( pos + read_ahead,
+								b->m_frames );
+				volatile float sum = 0;
+				for( f_cnt_t f = it->touchedTo; f < end;
+							f += frames_per_page )
+				{
+					sum += b->m_data[f][0];
+				}
+				it->touchedTo = qMax( it->touchedTo, end );
+			}
+			m_mutex.unlock();
+
+			msleep( 20 );
+		}
+	}
+
+	QMutex m_mutex;
+	QList<Entry> m_buffers;
+	bool m_running;
+
+} ;
+
+
+
+
+// builds peaks of data not managed by SampleCache in a thread of the global
+// pool - referenced by the buffer and by the pool while running, the buffer
+// detaches before it frees the data
+class SamplePeaksBuilder : public QRunnable, public sharedObject
+{
+public:
+	SamplePeaksBuilder( const sampleFrame * _data, const f_cnt_t _frames ) :
+		m_data( _data ),
+		m_frames( _frames ),
+		m_peaks( NULL ),
+		m_abort( false )
+	{
+		setAutoDelete( false );
+		QThreadPool::globalInstance()->start(
+						sharedObject::ref( this ) );
+	}
+
+	virtual ~SamplePeaksBuilder()
+	{
+		if( m_peaks != NULL )
+		{
+			sharedObject::unref( m_peaks );
+		}
+	}
+
+	virtual void run()
+	{
+		m_mutex.lock();
+		if( m_data != NULL )
+		{
+			SamplePeaks * peaks = new SamplePeaks( m_data,
+							m_frames, &m_abort );
+			if( m_abort )
+			{
+				sharedObject::unref( peaks );
+			}
+			else
+			{
+				m_peaks = peaks;
+			}
+		}
+		m_mutex.unlock();
+		sharedObject::unref( this );
+	}
+
+	// returns NULL while still building - never blocks
+	SamplePeaks * takePeaks()
+	{
+		if( !m_mutex.tryLock() )
+		{
+			return NULL;
+		}
+		SamplePeaks * peaks = m_peaks;
+		m_peaks = NULL;
+		m_mutex.unlock();
+		return peaks;
+	}
+
+	// data is about to be freed - returns after builder stopped accessing it
+	void detach()
+	{
+		m_abort = true;
+		m_mutex.lock();
+		m_data = NULL;
+		m_mutex.unlock();
+	}
+
+
+private:
+	QMutex m_mutex;
+	const sampleFrame * m_data;
+	f_cnt_t m_frames;
+	SamplePeaks * m_peaks;
+	volatile bool m_abort;
+
+} ;
+
+
+
+
 SampleBuffer::SampleBuffer( const QString & _audio_file,
 							bool _is_base64_data ) :
 	m_audioFile( ( _is_base64_data == true ) ? "" : _audio_file ),
@@ -77,7 +289,12 @@ SampleBuffer::SampleBuffer( const QString & _audio_file,
 	m_amplification( 1.0f ),
 	m_reversed( false ),
 	m_frequency( BaseFreq ),
-	m_sampleRate( engine::mixer()->baseSampleRate() )
+	m_sampleRate( engine::mixer()->baseSampleRate() ),
+	m_streamFile( NULL ),
+	m_streamPosition( 0 ),
+	m_sharedData( NULL ),
+	m_peaks( NULL ),
+	m_peaksBuilder( NULL )
 {
 	if( _is_base64_data == true )
 	{
@@ -102,7 +319,12 @@ SampleBuffer::SampleBuffer( const sampleFrame * _data, const f_cnt_t _frames ) :
 	m_amplification( 1.0f ),
 	m_reversed( false ),
 	m_frequency( BaseFreq ),
-	m_sampleRate( engine::mixer()->baseSampleRate() )
+	m_sampleRate( engine::mixer()->baseSampleRate() ),
+	m_streamFile( NULL ),
+	m_streamPosition( 0 ),
+	m_sharedData( NULL ),
+	m_peaks( NULL ),
+	m_peaksBuilder( NULL )
 {
 	if( _frames > 0 )
 	{
@@ -129,7 +351,12 @@ SampleBuffer::SampleBuffer( const f_cnt_t _frames ) :
 	m_amplification( 1.0f ),
 	m_reversed( false ),
 	m_frequency( BaseFreq ),
-	m_sampleRate( engine::mixer()->baseSampleRate() )
+	m_sampleRate( engine::mixer()->baseSampleRate() ),
+	m_streamFile( NULL ),
+	m_streamPosition( 0 ),
+	m_sharedData( NULL ),
+	m_peaks( NULL ),
+	m_peaksBuilder( NULL )
 {
 	if( _frames > 0 )
 	{
@@ -146,7 +373,45 @@ SampleBuffer::SampleBuffer( const f_cnt_t _frames ) :
 SampleBuffer::~SampleBuffer()
 {
 	delete[] m_origData;
-	delete[] m_data;
+	freeData();
+}
+
+
+
+
+void SampleBuffer::freeData()
+{
+	if( m_peaks != NULL )
+	{
+		sharedObject::unref( m_peaks );
+		m_peaks = NULL;
+	}
+
+	if( m_peaksBuilder != NULL )
+	{
+		m_peaksBuilder->detach();
+		sharedObject::unref( m_peaksBuilder );
+		m_peaksBuilder = NULL;
+	}
+
+	if( m_streamFile != NULL )
+	{
+		SampleStreamer::unregisterBuffer( this );
+		m_streamFile->unmap( (uchar *) m_data );
+		// removes the cache-file
+		delete m_streamFile;
+		m_streamFile = NULL;
+	}
+	else if( m_sharedData != NULL )
+	{
+		SampleCache::inst()->release( m_sharedData );
+		m_sharedData = NULL;
+	}
+	else
+	{
+		delete[] m_data;
+	}
+	m_data = NULL;
 }
 
 
@@ -160,7 +425,7 @@ void SampleBuffer::update( bool _keep_settings )
 	if( lock )
 	{
 		engine::mixer()->lock();
-		delete[] m_data;
+		freeData();
 	}
 
 	if( m_audioFile.isEmpty() && m_origData != NULL && m_origFrames > 0 )
@@ -178,33 +443,116 @@ void SampleBuffer::update( bool _keep_settings )
 	}
 	else if( !m_audioFile.isEmpty() )
 	{
-		QString file = tryToMakeAbsolute( m_audioFile );
-#ifdef LMMS_BUILD_WIN32
-		char * f = qstrdup( file.toLocal8Bit().constData() );
-#else
-		char * f = qstrdup( file.toUtf8().constData() );
-#endif
-		int_sample_t * buf = NULL;
-		ch_cnt_t channels = DEFAULT_CHANNELS;
-		sample_rate_t samplerate = engine::mixer()->baseSampleRate();
-		m_frames = 0;
-
-		const QFileInfo fileInfo( file );
-		if( fileInfo.size() > 100*1024*1024 )
+		const QString file = tryToMakeAbsolute( m_audioFile );
+		if( !loadFromCache( file, _keep_settings ) &&
+				decodeAudioFile( file, _keep_settings ) &&
+				m_streamFile == NULL &&
+				m_amplification == 1.0f && !m_reversed )
 		{
-			qWarning( "refusing to load sample files bigger "
-								"than 100 MB" );
+			// let other buffers using the same file share our data
+			m_sharedData = SampleCache::inst()->adopt( file, m_data,
+								m_frames );
+			m_data = const_cast<sampleFrame *>(
+						m_sharedData->data() );
 		}
-		else
+	}
+	else
+	{
+		// neither an audio-file nor a buffer to copy from, so create
+		// buffer containing one sample-frame
+		m_data = new sampleFrame[1];
+		memset( m_data, 0, sizeof( *m_data ) );
+		m_frames = 1;
+		m_loopStartFrame = m_startFrame = 0;
+		m_loopEndFrame = m_endFrame = 1;
+	}
+
+	if( lock )
+	{
+		engine::mixer()->unlock();
+	}
+
+	emit sampleUpdated();
+}
+
+
+bool SampleBuffer::loadFromCache( const QString & _file, bool _keep_settings )
+{
+	SharedSampleData * shared = SampleCache::inst()->acquire( _file );
+	if( shared == NULL )
+	{
+		return false;
+	}
+
+	m_frames = shared->frames();
+	if( m_amplification == 1.0f && !m_reversed )
+	{
+		m_data = const_cast<sampleFrame *>( shared->data() );
+		m_sharedData = shared;
+	}
+	else
+	{
+		// we need a private copy
+		const sampleFrame * src = shared->data();
+		m_data = new sampleFrame[m_frames];
+		for( f_cnt_t frame = 0; frame < m_frames; ++frame )
 		{
+			const f_cnt_t src_frame = m_reversed ?
+						m_frames - 1 - frame : frame;
+			m_data[frame][0] = src[src_frame][0] * m_amplification;
+			m_data[frame][1] = src[src_frame][1] * m_amplification;
+		}
+		SampleCache::inst()->release( shared );
+	}
+
+	if( _keep_settings == false )
+	{
+		m_loopStartFrame = m_startFrame = 0;
+		m_loopEndFrame = m_endFrame = m_frames;
+	}
 
+	return true;
+}
+
+
+
+
+bool SampleBuffer::decodeAudioFile( const QString & _file,
+					bool _keep_settings,
+					bool _allow_streaming )
+{
+#ifdef LMMS_BUILD_WIN32
+	char * f = qstrdup( _file.toLocal8Bit().constData() );
+#else
+	char * f = qstrdup( _file.toUtf8().constData() );
+#endif
+	int_sample_t * buf = NULL;
+	ch_cnt_t channels = DEFAULT_CHANNELS;
+	sample_rate_t samplerate = engine::mixer()->baseSampleRate();
+	m_frames = 0;
+
+	const QFileInfo fileInfo( _file );
+	if( _allow_streaming && decodeSampleStreamed( f, _keep_settings ) )
+	{
+		delete[] f;
+		return true;
+	}
+	if( fileInfo.size() > 100*1024*1024 )
+	{
+		// handled like files which can't be decoded below
+		qWarning( "refusing to load sample files bigger "
+				"than 100 MB which can't be streamed" );
+	}
+	else
+	{
 #ifdef LMMS_HAVE_OGGVORBIS
 		// workaround for a bug in libsndfile or our libsndfile decoder
-		// causing some OGG files to be distorted -> try with OGG Vorbis
-		// decoder first if filename extension matches "ogg"
+		// causing some OGG files to be distorted -> try with OGG
+		// Vorbis decoder first if filename extension matches "ogg"
 		if( m_frames == 0 && fileInfo.suffix() == "ogg" )
 		{
-			m_frames = decodeSampleOGGVorbis( f, buf, channels, samplerate );
+			m_frames = decodeSampleOGGVorbis( f, buf, channels,
+								samplerate );
 		}
 #endif
 		if( m_frames == 0 )
@@ -224,49 +572,50 @@ void SampleBuffer::update( bool _keep_settings )
 			m_frames = decodeSampleDS( f, buf, channels,
 								samplerate );
 		}
+	}
 
-		delete[] f;
-
-			if ( m_frames == 0 )  // if still no frames, bail
-			{
-				// sample couldn't be decoded, create buffer containing
-				// one sample-frame
-				m_data = new sampleFrame[1];
-				memset( m_data, 0, sizeof( *m_data ) );
-				m_frames = 1;
-				m_loopStartFrame = m_startFrame = 0;
-				m_loopEndFrame = m_endFrame = 1;
-			}
-			else // otherwise normalize sample rate
-			{
-				normalizeSampleRate( samplerate, _keep_settings );
-			}
-
-		}
-
-
+	delete[] f;
 
-	}
-	else
+	if( m_frames == 0 )  // if still no frames, bail
 	{
-		// neither an audio-file nor a buffer to copy from, so create
-		// buffer containing one sample-frame
+		// sample couldn't be decoded, create buffer containing
+		// one sample-frame
 		m_data = new sampleFrame[1];
 		memset( m_data, 0, sizeof( *m_data ) );
 		m_frames = 1;
 		m_loopStartFrame = m_startFrame = 0;
 		m_loopEndFrame = m_endFrame = 1;
+		return false;
 	}
 
-	if( lock )
+	// otherwise normalize sample rate
+	normalizeSampleRate( samplerate, _keep_settings );
+	return true;
+}
+
+
+
+
+bool SampleBuffer::decodeFile( const QString & _file, sampleFrame * & _data,
+							f_cnt_t & _frames )
+{
+	SampleBuffer sb;
+	sb.freeData();
+	// big files are streamed by each buffer on its own
+	if( !sb.decodeAudioFile( _file, false, false ) ||
+		(qint64) sb.m_frames * BYTES_PER_FRAME >= STREAMING_THRESHOLD )
 	{
-		engine::mixer()->unlock();
+		return false;
 	}
-
-	emit sampleUpdated();
+	_data = sb.m_data;
+	_frames = sb.m_frames;
+	sb.m_data = NULL;
+	return true;
 }
 
 
+
+
 void SampleBuffer::convertIntToFloat ( int_sample_t * & _ibuf, f_cnt_t _frames, int _channels)
 {
 			// following code transforms int-samples into
@@ -375,6 +724,163 @@ void SampleBuffer::normalizeSampleRate( const sample_rate_t _src_sr,
 
 
 
+bool SampleBuffer::decodeSampleStreamed( const char * _f,
+							bool _keep_settings )
+{
+	SF_INFO sf_info;
+	sf_info.format = 0;
+	SNDFILE * snd_file = sf_open( _f, SFM_READ, &sf_info );
+	if( snd_file == NULL )
+	{
+		return false;
+	}
+
+	const sample_rate_t dst_sr = engine::mixer()->baseSampleRate();
+	const double ratio = (double) dst_sr / sf_info.samplerate;
+	// leave some space for resampler rounding
+	const f_cnt_t max_frames = static_cast<f_cnt_t>(
+					sf_info.frames * ratio ) + 64;
+	const qint64 bytes = (qint64) max_frames * BYTES_PER_FRAME;
+	if( sf_info.frames <= 0 || bytes < STREAMING_THRESHOLD )
+	{
+		sf_close( snd_file );
+		return false;
+	}
+
+	QTemporaryFile * cache = new QTemporaryFile( QDir::tempPath() +
+						QDir::separator() +
+						"lmms-sample-XXXXXX" );
+	sampleFrame * data = NULL;
+	if( cache->open() && cache->resize( bytes ) )
+	{
+		data = (sampleFrame *) cache->map( 0, bytes );
+	}
+	if( data == NULL )
+	{
+		qWarning( "SampleBuffer: could not create cache-file for "
+								"streaming" );
+		delete cache;
+		sf_close( snd_file );
+		return false;
+	}
+
+	SRC_STATE * src_state = NULL;
+	if( sf_info.samplerate != (int) dst_sr )
+	{
+		int error;
+		src_state = src_new( SRC_SINC_MEDIUM_QUALITY,
+						DEFAULT_CHANNELS, &error );
+	}
+
+	// libsndfile normalizes integer formats to -1..1 when reading floats
+	const int channels = sf_info.channels;
+	const int ch = ( channels > 1 ) ? 1 : 0;
+	float * in_buf = new float[STREAMING_CHUNK_FRAMES * channels];
+	sampleFrame * stereo_buf = new sampleFrame[STREAMING_CHUNK_FRAMES];
+
+	f_cnt_t written = 0;
+	bool end_of_input = false;
+	while( !end_of_input && written < max_frames )
+	{
+		const f_cnt_t read = sf_readf_float( snd_file, in_buf,
+						STREAMING_CHUNK_FRAMES );
+		end_of_input = read < STREAMING_CHUNK_FRAMES;
+
+		for( f_cnt_t frame = 0; frame < read; ++frame )
+		{
+			stereo_buf[frame][0] = in_buf[frame*channels+0] *
+							m_amplification;
+			stereo_buf[frame][1] = in_buf[frame*channels+ch] *
+							m_amplification;
+		}
+
+		if( src_state == NULL )
+		{
+			const f_cnt_t todo = qMin( read, max_frames - written );
+			memcpy( data + written, stereo_buf,
+						todo * BYTES_PER_FRAME );
+			written += todo;
+			continue;
+		}
+
+		// feed resampler until it consumed all input (and is drained
+		// at end of input)
+		f_cnt_t used = 0;
+		while( written < max_frames )
+		{
+			SRC_DATA src_data;
+			src_data.data_in = stereo_buf[used];
+			src_data.input_frames = read - used;
+			src_data.data_out = data[written];
+			src_data.output_frames = max_frames - written;
+			src_data.src_ratio = ratio;
+			src_data.end_of_input = end_of_input ? 1 : 0;
+			const int error = src_process( src_state, &src_data );
+			if( error )
+			{
+				printf( "SampleBuffer: error while resampling: "
+						"%s\n", src_strerror( error ) );
+				break;
+			}
+			used += src_data.input_frames_used;
+			written += src_data.output_frames_gen;
+			if( src_data.input_frames_used == 0 &&
+					src_data.output_frames_gen == 0 )
+			{
+				break;
+			}
+		}
+	}
+
+	delete[] stereo_buf;
+	delete[] in_buf;
+	if( src_state != NULL )
+	{
+		src_delete( src_state );
+	}
+	sf_close( snd_file );
+
+	if( written == 0 )
+	{
+		cache->unmap( (uchar *) data );
+		delete cache;
+		return false;
+	}
+
+	if( m_reversed )
+	{
+		for( f_cnt_t f1 = 0, f2 = written - 1; f1 < f2; ++f1, --f2 )
+		{
+			const sample_t l = data[f1][0];
+			const sample_t r = data[f1][1];
+			data[f1][0] = data[f2][0];
+			data[f1][1] = data[f2][1];
+			data[f2][0] = l;
+			data[f2][1] = r;
+		}
+	}
+
+	m_data = data;
+	m_frames = written;
+	m_streamFile = cache;
+	m_streamPosition = 0;
+	// data is still in page-cache now - building peaks later on would
+	// have to read the whole file again
+	m_peaks = new SamplePeaks( m_data, m_frames );
+	if( _keep_settings == false )
+	{
+		m_loopStartFrame = m_startFrame = 0;
+		m_loopEndFrame = m_endFrame = m_frames;
+	}
+
+	SampleStreamer::registerBuffer( this );
+
+	return true;
+}
+
+
+
+
 f_cnt_t SampleBuffer::decodeSampleSF( const char * _f,
 					int_sample_t * & _buf,
 					ch_cnt_t & _channels,
@@ -719,6 +1225,10 @@ bool SampleBuffer::play( sampleFrame * _ab, handleState * _state,
 	delete[] tmp;
 
 	_state->m_frameIndex = play_frame;
+	if( m_streamFile != NULL )
+	{
+		m_streamPosition = play_frame;
+	}
 
 	return true;
 
@@ -801,6 +1311,71 @@ void SampleBuffer::visualize( QPainter & _p, const QRect & _dr,
 	const int yb = h / 2 + _dr.y();
 	const float y_space = h*0.25f;
 	const int nb_frames = focus_on_range ? _to_frame - _from_frame : m_frames;
+	const int xb = _dr.x();
+	const int first = focus_on_range ? _from_frame : 0;
+	const int last = focus_on_range ? _to_frame : m_frames;
+
+	if( w <= 0 || nb_frames <= 0 )
+	{
+		return;
+	}
+
+	if( m_peaks == NULL && nb_frames / w >= SamplePeaks::MinBlockSize )
+	{
+		if( m_sharedData != NULL )
+		{
+			// NULL if still being built in background - draw
+			// directly from data until then
+			m_peaks = SampleCache::inst()->peaks( m_sharedData );
+		}
+		else if( m_peaksBuilder == NULL )
+		{
+			// walking through a big sample takes a while, so
+			// don't stall the GUI - draw directly from data
+			// until peaks are ready
+			m_peaksBuilder = new SamplePeaksBuilder( m_data,
+								m_frames );
+		}
+		else
+		{
+			m_peaks = m_peaksBuilder->takePeaks();
+			if( m_peaks != NULL )
+			{
+				sharedObject::unref( m_peaksBuilder );
+				m_peaksBuilder = NULL;
+			}
+		}
+	}
+
+	if( m_peaks != NULL && nb_frames / w >= SamplePeaks::MinBlockSize )
+	{
+		// draw one vertical line per pixel from minimum to maximum,
+		// extended so that it touches the line of previous pixel
+		QVector<QLine> lines( w );
+		int prev_top = 0;
+		int prev_bottom = 0;
+		for( int x = 0; x < w; ++x )
+		{
+			float lo, hi;
+			m_peaks->getPeak( m_data,
+				first + (f_cnt_t)( (qint64) x * nb_frames / w ),
+				first + (f_cnt_t)( (qint64) ( x + 1 ) *
+							nb_frames / w ),
+								lo, hi );
+			int top = (int)( yb - hi * y_space );
+			int bottom = (int)( yb - lo * y_space );
+			if( x > 0 )
+			{
+				top = qMin( top, prev_bottom );
+				bottom = qMax( bottom, prev_top );
+			}
+			lines[x] = QLine( xb + x, top, xb + x, bottom );
+			prev_top = top;
+			prev_bottom = bottom;
+		}
+		_p.drawLines( lines );
+		return;
+	}
 
 	if( nb_frames < 60000 )
 	{
@@ -811,9 +1386,6 @@ void SampleBuffer::visualize( QPainter & _p, const QRect & _dr,
 	const int fpp = tLimit<int>( nb_frames / w, 1, 20 );
 	QPoint * l = new QPoint[nb_frames / fpp + 1];
 	int n = 0;
-	const int xb = _dr.x();
-	const int first = focus_on_range ? _from_frame : 0;
-	const int last = focus_on_range ? _to_frame : m_frames;
 	for( int frame = first; frame < last; frame += fpp )
 	{
 		l[n] = QPoint( xb + ( (frame - first) * double( w ) / nb_frames ),
@@ -1046,7 +1618,12 @@ SampleBuffer * SampleBuffer::resample( sampleFrame * _data,
 	{
 		printf( "Error: src_new() failed in sample_buffer.cpp!\n" );
 	}
-	dst_sb->update();
+	// no need for update() as nobody else knows dst_sb yet - it would
+	// lock the mixer which must not happen when decoding in background
+	if( dst_frames > 0 )
+	{
+		memcpy( dst_sb->m_data, dst_buf, dst_frames * BYTES_PER_FRAME );
+	}
 	return dst_sb;
 }
 
@@ -0,0 +1,556 @@
+/*
+ * SampleCache.cpp - shared, prefetched and persistently cached sample-data
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtXml/QDomElement>
+
+#include <cstring>
+#include <utime.h>
+
+#include "SampleCache.h"
+#include "SampleBuffer.h"
+#include "SamplePeaks.h"
+#include "config_mgr.h"
+#include "engine.h"
+#include "Mixer.h"
+
+
+static const char * DISK_CACHE_PATH = "samplecache/";
+static const char DISK_CACHE_MAGIC[8] = { 'L', 'M', 'M', 'S', 'S', 'M', 'P', '1' };
+
+// data bigger than this isn't written to disk-cache
+static const qint64 DISK_CACHE_MAX_SIZE = 64 * 1024 * 1024;
+// least recently used files are removed once disk-cache grows beyond this
+static const qint64 DISK_CACHE_MAX_TOTAL_SIZE = 1024 * 1024 * 1024;
+
+
+
+SharedSampleData::SharedSampleData( const QString & _file,
+							const QString & _key ) :
+	m_file( _file ),
+	m_key( _key ),
+	m_data( NULL ),
+	m_frames( 0 ),
+	m_peaks( NULL ),
+	m_refs( 0 ),
+	m_pinned( false ),
+	m_ready( false )
+{
+}
+
+
+
+
+SharedSampleData::~SharedSampleData()
+{
+	if( m_peaks != NULL )
+	{
+		sharedObject::unref( m_peaks );
+	}
+	delete[] m_data;
+}
+
+
+
+
+// decodes a prefetched file (or loads it from disk-cache) in a thread of
+// the pool, or writes data decoded somewhere else to disk-cache
+class SampleDecoderJob : public QRunnable
+{
+public:
+	SampleDecoderJob( SharedSampleData * _shared, bool _save_only ) :
+		m_shared( _shared ),
+		m_saveOnly( _save_only )
+	{
+	}
+
+	virtual void run()
+	{
+		if( m_saveOnly )
+		{
+			// data was decoded somewhere else
+			SamplePeaks * peaks = new SamplePeaks( m_shared->m_data,
+							m_shared->m_frames );
+			SampleCache::inst()->m_mutex.lock();
+			m_shared->m_peaks = peaks;
+			SampleCache::inst()->m_mutex.unlock();
+			SampleCache::saveToDisk( m_shared, true );
+			SampleCache::inst()->release( m_shared );
+			return;
+		}
+
+		const bool from_disk = SampleCache::loadFromDisk( m_shared );
+		const bool decoded = !from_disk &&
+				SampleBuffer::decodeFile( m_shared->m_file,
+							m_shared->m_data,
+							m_shared->m_frames );
+		// nobody else accesses the entry until it's ready, so peaks
+		// can be set without locking
+		const bool new_peaks = ( from_disk || decoded ) &&
+						m_shared->m_peaks == NULL;
+		if( new_peaks )
+		{
+			m_shared->m_peaks = new SamplePeaks( m_shared->m_data,
+							m_shared->m_frames );
+		}
+		// let waiting threads continue before writing to disk
+		SampleCache::inst()->finishDecoding( m_shared,
+							decoded || new_peaks );
+		if( decoded || new_peaks )
+		{
+			SampleCache::saveToDisk( m_shared, decoded );
+			SampleCache::inst()->release( m_shared );
+		}
+	}
+
+
+private:
+	SharedSampleData * m_shared;
+	bool m_saveOnly;
+
+} ;
+
+
+
+
+SampleCache * SampleCache::inst()
+{
+	static SampleCache * s_inst = new SampleCache;
+	return s_inst;
+}
+
+
+
+
+SampleCache::SampleCache() :
+	m_mutex(),
+	m_decodingFinished(),
+	m_entries(),
+	m_pool()
+{
+}
+
+
+
+
+SampleCache::~SampleCache()
+{
+	m_pool.waitForDone();
+	qDeleteAll( m_entries );
+}
+
+
+
+
+static void collectSampleFiles( const QDomElement & _elem,
+						QSet<QString> & _files )
+{
+	static QStringList suffixes = QStringList() << "wav" << "ogg" << "ds"
+				<< "flac" << "spx" << "voc" << "aif" << "aiff"
+				<< "au" << "raw";
+
+	const QDomNamedNodeMap attrs = _elem.attributes();
+	for( int i = 0; i < attrs.count(); ++i )
+	{
+		const QDomAttr a = attrs.item( i ).toAttr();
+		if( ( a.name() == "src" ||
+				a.name().startsWith( "userwavefile" ) ) &&
+			suffixes.contains(
+				QFileInfo( a.value() ).suffix().toLower() ) )
+		{
+			_files << SampleBuffer::tryToMakeAbsolute( a.value() );
+		}
+	}
+
+	for( QDomElement e = _elem.firstChildElement(); !e.isNull();
+					e = e.nextSiblingElement() )
+	{
+		collectSampleFiles( e, _files );
+	}
+}
+
+
+
+
+void SampleCache::prefetchProject( const QDomElement & _content )
+{
+	QSet<QString> files;
+	collectSampleFiles( _content, files );
+	prefetch( files.toList() );
+}
+
+
+
+
+void SampleCache::prefetch( const QStringList & _files )
+{
+	QMutexLocker ml( &m_mutex );
+	for( QStringList::ConstIterator it = _files.begin();
+						it != _files.end(); ++it )
+	{
+		const QString key = cacheKey( *it );
+		if( key.isEmpty() || m_entries.contains( key ) )
+		{
+			continue;
+		}
+		SharedSampleData * shared = new SharedSampleData( *it, key );
+		shared->m_pinned = true;
+		m_entries[key] = shared;
+		m_pool.start( new SampleDecoderJob( shared, false ) );
+	}
+}
+
+
+
+
+void SampleCache::finishPrefetch()
+{
+	QMutexLocker ml( &m_mutex );
+	foreach( SharedSampleData * shared, m_entries.values() )
+	{
+		if( shared->m_pinned )
+		{
+			shared->m_pinned = false;
+			removeIfUnused( shared );
+		}
+	}
+}
+
+
+
+
+SharedSampleData * SampleCache::acquire( const QString & _file )
+{
+	const QString key = cacheKey( _file );
+	if( key.isEmpty() )
+	{
+		return NULL;
+	}
+
+	QMutexLocker ml( &m_mutex );
+	SharedSampleData * shared = m_entries.value( key, NULL );
+	if( shared == NULL )
+	{
+		// not prefetched - maybe decoded some time before
+		ml.unlock();
+		SharedSampleData * from_disk = new SharedSampleData( _file, key );
+		if( !loadFromDisk( from_disk ) )
+		{
+			delete from_disk;
+			return NULL;
+		}
+		from_disk->m_ready = true;
+		ml.relock();
+		shared = m_entries.value( key, NULL );
+		if( shared == NULL )
+		{
+			shared = m_entries[key] = from_disk;
+		}
+		else
+		{
+			delete from_disk;
+		}
+	}
+
+	// keep entry alive while waiting
+	++shared->m_refs;
+	while( !shared->m_ready )
+	{
+		m_decodingFinished.wait( &m_mutex );
+	}
+
+	if( shared->m_data == NULL )
+	{
+		// prefetching failed, caller has to decode on its own
+		--shared->m_refs;
+		removeIfUnused( shared );
+		return NULL;
+	}
+
+	return shared;
+}
+
+
+
+
+SharedSampleData * SampleCache::adopt( const QString & _file,
+					sampleFrame * _data,
+					const f_cnt_t _frames )
+{
+	const QString key = cacheKey( _file );
+	QMutexLocker ml( &m_mutex );
+	SharedSampleData * shared = m_entries.value( key, NULL );
+	if( key.isEmpty() || ( shared != NULL &&
+			( !shared->m_ready || shared->m_data == NULL ) ) )
+	{
+		// can't share - return data as private copy
+		shared = new SharedSampleData( _file, QString() );
+		shared->m_data = _data;
+		shared->m_frames = _frames;
+		shared->m_ready = true;
+		shared->m_refs = 1;
+		return shared;
+	}
+
+	if( shared != NULL )
+	{
+		delete[] _data;
+		++shared->m_refs;
+		return shared;
+	}
+
+	shared = new SharedSampleData( _file, key );
+	shared->m_data = _data;
+	shared->m_frames = _frames;
+	shared->m_ready = true;
+	shared->m_refs = 2;	// one for caller, one for job
+	m_entries[key] = shared;
+	m_pool.start( new SampleDecoderJob( shared, true ) );
+
+	return shared;
+}
+
+
+
+
+void SampleCache::release( SharedSampleData * _shared )
+{
+	QMutexLocker ml( &m_mutex );
+	--_shared->m_refs;
+	removeIfUnused( _shared );
+}
+
+
+
+
+SamplePeaks * SampleCache::peaks( SharedSampleData * _shared )
+{
+	QMutexLocker ml( &m_mutex );
+	if( !_shared->m_ready || _shared->m_peaks == NULL )
+	{
+		return NULL;
+	}
+	return sharedObject::ref( _shared->m_peaks );
+}
+
+
+
+
+QString SampleCache::cacheKey( const QString & _file )
+{
+	const QFileInfo fi( _file );
+	if( !fi.isFile() )
+	{
+		return QString();
+	}
+	return fi.absoluteFilePath() + "|" +
+		QString::number( fi.lastModified().toTime_t() ) + "|" +
+		QString::number( engine::mixer()->baseSampleRate() );
+}
+
+
+
+
+QString SampleCache::diskCacheFile( const QString & _key,
+						const char * _suffix )
+{
+	return configManager::inst()->workingDir() + DISK_CACHE_PATH +
+		QCryptographicHash::hash( _key.toUtf8(),
+				QCryptographicHash::Md5 ).toHex() + _suffix;
+}
+
+
+
+
+bool SampleCache::loadFromDisk( SharedSampleData * _shared )
+{
+	const QString file_name = diskCacheFile( _shared->m_key );
+	QFile f( file_name );
+	if( !f.open( QFile::ReadOnly ) )
+	{
+		return false;
+	}
+
+	char magic[sizeof( DISK_CACHE_MAGIC )];
+	qint32 frames = 0;
+	if( f.read( magic, sizeof( magic ) ) != sizeof( magic ) ||
+		memcmp( magic, DISK_CACHE_MAGIC, sizeof( magic ) ) != 0 ||
+		f.read( (char *) &frames, sizeof( frames ) ) !=
+							sizeof( frames ) ||
+		frames <= 0 ||
+		f.size() != (qint64) sizeof( magic ) + sizeof( frames ) +
+					(qint64) frames * sizeof( sampleFrame ) )
+	{
+		return false;
+	}
+
+	sampleFrame * data = new sampleFrame[frames];
+	const qint64 bytes = (qint64) frames * sizeof( sampleFrame );
+	if( f.read( (char *) data, bytes ) != bytes )
+	{
+		delete[] data;
+		return false;
+	}
+
+	_shared->m_data = data;
+	_shared->m_frames = frames;
+	_shared->m_peaks = SamplePeaks::load(
+				diskCacheFile( _shared->m_key, ".pks" ), frames );
+
+	// mark as recently used for pruneDisk()
+	utime( QFile::encodeName( file_name ).constData(), NULL );
+
+	return true;
+}
+
+
+
+
+void SampleCache::saveToDisk( const SharedSampleData * _shared,
+							bool _with_data )
+{
+	QDir().mkpath( configManager::inst()->workingDir() +
+							DISK_CACHE_PATH );
+
+	// peaks are small compared to data and always worth keeping
+	if( _shared->m_peaks != NULL )
+	{
+		_shared->m_peaks->save( diskCacheFile( _shared->m_key,
+								".pks" ) );
+	}
+
+	const qint64 bytes = (qint64) _shared->m_frames * sizeof( sampleFrame );
+	if( !_with_data || bytes > DISK_CACHE_MAX_SIZE )
+	{
+		return;
+	}
+
+	// write to temporary file and rename it afterwards so that a
+	// concurrent reader never sees a partially written file
+	const QString file_name = diskCacheFile( _shared->m_key );
+	QFile f( file_name + ".tmp" );
+	if( !f.open( QFile::WriteOnly | QFile::Truncate ) )
+	{
+		return;
+	}
+	const qint32 frames = _shared->m_frames;
+	const bool ok = f.write( DISK_CACHE_MAGIC,
+				sizeof( DISK_CACHE_MAGIC ) ) ==
+					sizeof( DISK_CACHE_MAGIC ) &&
+			f.write( (const char *) &frames, sizeof( frames ) ) ==
+							sizeof( frames ) &&
+			f.write( (const char *) _shared->m_data, bytes ) ==
+									bytes;
+	f.close();
+	if( ok )
+	{
+		QFile::remove( file_name );
+		f.rename( file_name );
+		pruneDisk();
+	}
+	else
+	{
+		f.remove();
+	}
+}
+
+
+
+
+void SampleCache::pruneDisk()
+{
+	// several decoder-jobs might finish at the same time
+	static QMutex s_pruneMutex;
+	QMutexLocker ml( &s_pruneMutex );
+
+	// oldest files first
+	const QFileInfoList files = QDir( configManager::inst()->workingDir() +
+						DISK_CACHE_PATH ).entryInfoList(
+				QDir::Files, QDir::Time | QDir::Reversed );
+	qint64 total = 0;
+	for( QFileInfoList::ConstIterator it = files.begin();
+						it != files.end(); ++it )
+	{
+		total += it->size();
+	}
+	if( total <= DISK_CACHE_MAX_TOTAL_SIZE )
+	{
+		return;
+	}
+
+	// remove more than needed so we don't have to do this again soon
+	for( QFileInfoList::ConstIterator it = files.begin();
+			it != files.end() &&
+				total > DISK_CACHE_MAX_TOTAL_SIZE / 4 * 3; ++it )
+	{
+		if( QFile::remove( it->absoluteFilePath() ) )
+		{
+			total -= it->size();
+		}
+	}
+}
+
+
+
+
+void SampleCache::finishDecoding( SharedSampleData * _shared,
+							bool _keep_ref )
+{
+	QMutexLocker ml( &m_mutex );
+	_shared->m_ready = true;
+	m_decodingFinished.wakeAll();
+	if( _keep_ref )
+	{
+		++_shared->m_refs;
+	}
+	else
+	{
+		removeIfUnused( _shared );
+	}
+}
+
+
+
+
+void SampleCache::removeIfUnused( SharedSampleData * _shared )
+{
+	// m_mutex is locked by caller
+	if( _shared->m_refs > 0 || _shared->m_pinned || !_shared->m_ready )
+	{
+		return;
+	}
+	if( !_shared->m_key.isEmpty() &&
+			m_entries.value( _shared->m_key, NULL ) == _shared )
+	{
+		m_entries.remove( _shared->m_key );
+	}
+	delete _shared;
+}
+
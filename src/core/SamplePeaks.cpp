@@ -0,0 +1,231 @@
+/*
+ * SamplePeaks.cpp - min/max-pyramid of sample-data for fast waveform-drawing
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtCore/QFile>
+
+#include <cstring>
+
+#include "SamplePeaks.h"
+
+
+static const char PEAKS_FILE_MAGIC[8] = { 'L', 'M', 'M', 'S', 'P', 'K', 'S', '1' };
+
+
+
+SamplePeaks::SamplePeaks( const f_cnt_t _frames ) :
+	sharedObject(),
+	m_frames( _frames )
+{
+	for( int l = 0; l < NumLevels; ++l )
+	{
+		m_levels[l].resize( ( _frames + blockSize( l ) - 1 ) /
+							blockSize( l ) );
+	}
+}
+
+
+
+
+SamplePeaks::SamplePeaks( const sampleFrame * _data, const f_cnt_t _frames,
+					const volatile bool * _abort ) :
+	sharedObject(),
+	m_frames( _frames )
+{
+	for( int l = 0; l < NumLevels; ++l )
+	{
+		m_levels[l].resize( ( _frames + blockSize( l ) - 1 ) /
+							blockSize( l ) );
+	}
+
+	// finest level from sample-data
+	Peak * p = m_levels[0].data();
+	for( f_cnt_t frame = 0; frame < _frames; ++p )
+	{
+		if( _abort != NULL && *_abort )
+		{
+			return;
+		}
+		const f_cnt_t end = qMin<f_cnt_t>( frame + MinBlockSize,
+								_frames );
+		p->min = p->max = _data[frame][0] + _data[frame][1];
+		for( ++frame; frame < end; ++frame )
+		{
+			const float v = _data[frame][0] + _data[frame][1];
+			p->min = qMin( p->min, v );
+			p->max = qMax( p->max, v );
+		}
+	}
+
+	// each coarser level from previous one
+	for( int l = 1; l < NumLevels; ++l )
+	{
+		const PeakVector & src = m_levels[l-1];
+		const int factor = blockSize( l ) / blockSize( l-1 );
+		for( int i = 0; i < m_levels[l].size(); ++i )
+		{
+			const int end = qMin( ( i + 1 ) * factor, src.size() );
+			Peak & dst = m_levels[l][i];
+			dst = src[i * factor];
+			for( int j = i * factor + 1; j < end; ++j )
+			{
+				dst.min = qMin( dst.min, src[j].min );
+				dst.max = qMax( dst.max, src[j].max );
+			}
+		}
+	}
+}
+
+
+
+
+SamplePeaks * SamplePeaks::load( const QString & _file, const f_cnt_t _frames )
+{
+	QFile f( _file );
+	if( !f.open( QFile::ReadOnly ) )
+	{
+		return NULL;
+	}
+
+	char magic[sizeof( PEAKS_FILE_MAGIC )];
+	qint32 frames = 0;
+	if( f.read( magic, sizeof( magic ) ) != sizeof( magic ) ||
+		memcmp( magic, PEAKS_FILE_MAGIC, sizeof( magic ) ) != 0 ||
+		f.read( (char *) &frames, sizeof( frames ) ) !=
+							sizeof( frames ) ||
+		frames != _frames )
+	{
+		return NULL;
+	}
+
+	SamplePeaks * peaks = new SamplePeaks( _frames );
+	qint64 expected_size = sizeof( magic ) + sizeof( frames );
+	for( int l = 0; l < NumLevels; ++l )
+	{
+		expected_size += peaks->m_levels[l].size() * sizeof( Peak );
+	}
+	if( f.size() != expected_size )
+	{
+		delete peaks;
+		return NULL;
+	}
+
+	for( int l = 0; l < NumLevels; ++l )
+	{
+		const qint64 bytes = peaks->m_levels[l].size() * sizeof( Peak );
+		if( f.read( (char *) peaks->m_levels[l].data(), bytes ) !=
+									bytes )
+		{
+			delete peaks;
+			return NULL;
+		}
+	}
+
+	return peaks;
+}
+
+
+
+
+bool SamplePeaks::save( const QString & _file ) const
+{
+	// write to temporary file and rename it afterwards so that a
+	// concurrent reader never sees a partially written file
+	QFile f( _file + ".tmp" );
+	if( !f.open( QFile::WriteOnly | QFile::Truncate ) )
+	{
+		return false;
+	}
+
+	const qint32 frames = m_frames;
+	bool ok = f.write( PEAKS_FILE_MAGIC, sizeof( PEAKS_FILE_MAGIC ) ) ==
+						sizeof( PEAKS_FILE_MAGIC ) &&
+			f.write( (const char *) &frames, sizeof( frames ) ) ==
+							sizeof( frames );
+	for( int l = 0; ok && l < NumLevels; ++l )
+	{
+		const qint64 bytes = m_levels[l].size() * sizeof( Peak );
+		ok = f.write( (const char *) m_levels[l].constData(), bytes ) ==
+									bytes;
+	}
+	f.close();
+
+	if( ok )
+	{
+		QFile::remove( _file );
+		ok = f.rename( _file );
+	}
+	else
+	{
+		f.remove();
+	}
+	return ok;
+}
+
+
+
+
+void SamplePeaks::getPeak( const sampleFrame * _data, f_cnt_t _from,
+				f_cnt_t _to, float & _min, float & _max ) const
+{
+	if( m_frames <= 0 )
+	{
+		_min = _max = 0.0f;
+		return;
+	}
+
+	_from = qBound<f_cnt_t>( 0, _from, m_frames - 1 );
+	_to = qBound<f_cnt_t>( _from + 1, _to, m_frames );
+
+	if( _to - _from < MinBlockSize )
+	{
+		_min = _max = _data[_from][0] + _data[_from][1];
+		for( f_cnt_t frame = _from + 1; frame < _to; ++frame )
+		{
+			const float v = _data[frame][0] + _data[frame][1];
+			_min = qMin( _min, v );
+			_max = qMax( _max, v );
+		}
+		return;
+	}
+
+	// use coarsest level whose blocks still fit into the range so that
+	// only a few blocks have to be looked at
+	int l = NumLevels - 1;
+	while( blockSize( l ) > _to - _from )
+	{
+		--l;
+	}
+
+	const PeakVector & level = m_levels[l];
+	const int first = _from / blockSize( l );
+	const int last = qMin<int>( ( _to + blockSize( l ) - 1 ) /
+						blockSize( l ), level.size() );
+	_min = level[first].min;
+	_max = level[first].max;
+	for( int i = first + 1; i < last; ++i )
+	{
+		_min = qMin( _min, level[i].min );
+		_max = qMax( _max, level[i].max );
+	}
+}
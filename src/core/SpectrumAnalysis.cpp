@@ -0,0 +1,217 @@
+/*
+ * SpectrumAnalysis.cpp - computes spectra of audio-data in background
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+
+#include <cmath>
+#include <cstring>
+
+#include "SpectrumAnalysis.h"
+#include "fft_helpers.h"
+#include "lmms_constants.h"
+
+
+// runs analysis of all registered SpectrumAnalysis objects and keeps one
+// FFTW-plan per FFT-size - it's started when the first object registers and
+// stops as soon as none is left. Plans are created by the registering thread
+// while holding the process-wide FFTW planner lock (see fft_helpers.h).
+class SpectrumAnalysisThread : public QThread
+{
+public:
+	static void registerAnalysis( SpectrumAnalysis * _a )
+	{
+		SpectrumAnalysisThread * t = inst();
+		QMutexLocker ml( &t->m_mutex );
+		t->createPlan( _a->fftSize() );
+		t->m_analyses.push_back( _a );
+		if( !t->m_running )
+		{
+			// make sure a previous run() has returned completely
+			t->wait();
+			t->m_running = true;
+			t->start( QThread::LowPriority );
+		}
+	}
+
+	static void unregisterAnalysis( SpectrumAnalysis * _a )
+	{
+		SpectrumAnalysisThread * t = inst();
+		QMutexLocker ml( &t->m_mutex );
+		t->m_analyses.removeAll( _a );
+	}
+
+
+private:
+	struct Plan
+	{
+		fftwf_plan plan;
+		float * in;
+		fftwf_complex * out;
+	} ;
+
+	SpectrumAnalysisThread() :
+		QThread(),
+		m_mutex(),
+		m_analyses(),
+		m_plans(),
+		m_running( false )
+	{
+	}
+
+	static SpectrumAnalysisThread * inst()
+	{
+		static SpectrumAnalysisThread * s_inst =
+						new SpectrumAnalysisThread;
+		return s_inst;
+	}
+
+	// requires m_mutex to be locked
+	void createPlan( const int _size )
+	{
+		if( !m_plans.contains( _size ) )
+		{
+			Plan p;
+			p.in = (float *) fftwf_malloc( _size * sizeof( float ) );
+			p.out = (fftwf_complex *) fftwf_malloc(
+				( _size / 2 + 1 ) * sizeof( fftwf_complex ) );
+			fftwPlannerLock();
+			p.plan = fftwf_plan_dft_r2c_1d( _size, p.in, p.out,
+								FFTW_ESTIMATE );
+			fftwPlannerUnlock();
+			m_plans[_size] = p;
+		}
+	}
+
+	virtual void run()
+	{
+		while( true )
+		{
+			m_mutex.lock();
+			if( m_analyses.isEmpty() )
+			{
+				m_running = false;
+				m_mutex.unlock();
+				return;
+			}
+			for( QList<SpectrumAnalysis *>::Iterator it =
+							m_analyses.begin();
+						it != m_analyses.end(); ++it )
+			{
+				// created when registering
+				const Plan & p = m_plans[( *it )->fftSize()];
+				( *it )->analyze( p.plan, p.in, p.out );
+			}
+			m_mutex.unlock();
+
+			msleep( 10 );
+		}
+	}
+
+	QMutex m_mutex;
+	QList<SpectrumAnalysis *> m_analyses;
+	// plans are never destroyed as they're likely to be needed again
+	QMap<int, Plan> m_plans;
+	bool m_running;
+
+} ;
+
+
+
+
+SpectrumAnalysis::SpectrumAnalysis( const int _fft_size ) :
+	m_fftSize( qBound<int>( 2, _fft_size, MaxFftSize ) ),
+	m_input(),
+	m_window( m_fftSize ),
+	m_history( m_fftSize ),
+	m_historyFrames( 0 ),
+	m_results()
+{
+	// Hann-window
+	for( int i = 0; i < m_fftSize; ++i )
+	{
+		m_window[i] = 0.5f - 0.5f * cosf( 2.0f * F_PI * i /
+							( m_fftSize - 1 ) );
+	}
+
+	SpectrumAnalysisThread::registerAnalysis( this );
+}
+
+
+
+
+SpectrumAnalysis::~SpectrumAnalysis()
+{
+	SpectrumAnalysisThread::unregisterAnalysis( this );
+}
+
+
+
+
+void SpectrumAnalysis::pushSamples( const sample_t * _samples,
+							const int _count )
+{
+	m_input.write( _samples, _count );
+}
+
+
+
+
+void SpectrumAnalysis::analyze( fftwf_plan _plan, float * _in,
+							fftwf_complex * _out )
+{
+	const int hop = m_fftSize / 2;
+	int n;
+	while( ( n = m_input.read( m_history.data() + m_historyFrames,
+					m_fftSize - m_historyFrames ) ) > 0 )
+	{
+		m_historyFrames += n;
+		if( m_historyFrames < m_fftSize )
+		{
+			continue;
+		}
+
+		Result & r = m_results.back();
+		r.peak = 0.0f;
+		for( int i = 0; i < m_fftSize; ++i )
+		{
+			r.peak = qMax( r.peak, fabsf( m_history[i] ) );
+			_in[i] = m_history[i] * m_window[i];
+		}
+		r.power = signalpower( m_history.data(), m_fftSize );
+
+		fftwf_execute( _plan );
+		r.bins = m_fftSize / 2 + 1;
+		absspec( _out, r.spectrum, r.bins );
+		m_results.publish();
+
+		// next window overlaps by half
+		memmove( m_history.data(), m_history.data() + hop,
+						( m_fftSize - hop ) *
+							sizeof( float ) );
+		m_historyFrames = m_fftSize - hop;
+	}
+}
@@ -29,6 +29,8 @@
 
 #ifdef LMMS_HAVE_ALSA
 
+#include <math.h>
+
 #include "endian_handling.h"
 #include "config_mgr.h"
 #include "engine.h"
@@ -46,35 +48,24 @@ AudioAlsa::AudioAlsa( bool & _success_ful, Mixer*  _mixer ) :
 	m_handle( NULL ),
 	m_hwParams( NULL ),
 	m_swParams( NULL ),
-	m_convertEndian( false )
+	m_format( S16 ),
+	m_convertEndian( false ),
+	m_mmap( false ),
+	// dithering is only applied to integer formats
+	m_dither( configManager::inst()->value( "audioalsa",
+							"dither" ) != "0" ),
+	m_ditherState( 1 ),
+	m_mixBuffer( NULL ),
+	m_mixFrames( 0 ),
+	m_mixPos( 0 )
 {
 	_success_ful = false;
 
-	int err;
-
-	if( ( err = snd_pcm_open( &m_handle,
-					probeDevice().toAscii().constData(),
-						SND_PCM_STREAM_PLAYBACK,
-						0 ) ) < 0 )
-	{
-		printf( "Playback open error: %s\n", snd_strerror( err ) );
-		return;
-	}
-
 	snd_pcm_hw_params_malloc( &m_hwParams );
 	snd_pcm_sw_params_malloc( &m_swParams );
 
-	if( ( err = setHWParams( channels(),
-					SND_PCM_ACCESS_RW_INTERLEAVED ) ) < 0 )
+	if( openDevice() < 0 )
 	{
-		printf( "Setting of hwparams failed: %s\n",
-							snd_strerror( err ) );
-		return;
-	}
-	if( ( err = setSWParams() ) < 0 )
-	{
-		printf( "Setting of swparams failed: %s\n",
-							snd_strerror( err ) );
 		return;
 	}
 
@@ -116,6 +107,49 @@ AudioAlsa::~AudioAlsa()
 	{
 		snd_pcm_sw_params_free( m_swParams );
 	}
+
+	delete[] m_mixBuffer;
+}
+
+
+
+
+int AudioAlsa::openDevice()
+{
+	int err;
+
+	if( ( err = snd_pcm_open( &m_handle,
+					probeDevice().toAscii().constData(),
+						SND_PCM_STREAM_PLAYBACK,
+						0 ) ) < 0 )
+	{
+		printf( "Playback open error: %s\n", snd_strerror( err ) );
+		m_handle = NULL;
+		return err;
+	}
+
+	// writing directly into the device's buffer saves a copy, so
+	// prefer mmap-access
+	m_mmap = true;
+	if( setHWParams( channels(), SND_PCM_ACCESS_MMAP_INTERLEAVED ) < 0 )
+	{
+		m_mmap = false;
+		if( ( err = setHWParams( channels(),
+					SND_PCM_ACCESS_RW_INTERLEAVED ) ) < 0 )
+		{
+			printf( "Setting of hwparams failed: %s\n",
+							snd_strerror( err ) );
+			return err;
+		}
+	}
+	if( ( err = setSWParams() ) < 0 )
+	{
+		printf( "Setting of swparams failed: %s\n",
+							snd_strerror( err ) );
+		return err;
+	}
+
+	return 0;
 }
 
 
@@ -206,28 +240,8 @@ void AudioAlsa::applyQualitySettings()
 			snd_pcm_close( m_handle );
 		}
 
-		int err;
-		if( ( err = snd_pcm_open( &m_handle,
-					probeDevice().toAscii().constData(),
-						SND_PCM_STREAM_PLAYBACK,
-								0 ) ) < 0 )
-		{
-			printf( "Playback open error: %s\n",
-							snd_strerror( err ) );
-			return;
-		}
-
-		if( ( err = setHWParams( channels(),
-					SND_PCM_ACCESS_RW_INTERLEAVED ) ) < 0 )
+		if( openDevice() < 0 )
 		{
-			printf( "Setting of hwparams failed: %s\n",
-							snd_strerror( err ) );
-			return;
-		}
-		if( ( err = setSWParams() ) < 0 )
-		{
-			printf( "Setting of swparams failed: %s\n",
-							snd_strerror( err ) );
 			return;
 		}
 	}
@@ -240,53 +254,114 @@ void AudioAlsa::applyQualitySettings()
 
 void AudioAlsa::run()
 {
-	surroundSampleFrame * temp =
-		new surroundSampleFrame[mixer()->framesPerPeriod()];
-	int_sample_t * outbuf =
-			new int_sample_t[mixer()->framesPerPeriod() *
-								channels()];
-	int_sample_t * pcmbuf = new int_sample_t[m_periodSize * channels()];
+	delete[] m_mixBuffer;
+	m_mixBuffer = new surroundSampleFrame[mixer()->framesPerPeriod()];
+	m_mixFrames = 0;
+	m_mixPos = 0;
+
+	if( m_mmap )
+	{
+		runMmap();
+	}
+	else
+	{
+		runReadWrite();
+	}
+}
+
 
-	int outbuf_size = mixer()->framesPerPeriod() * channels();
-	int outbuf_pos = 0;
-	int pcmbuf_size = m_periodSize * channels();
 
+
+void AudioAlsa::runMmap()
+{
 	bool quit = false;
 	while( quit == false )
 	{
-		int_sample_t * ptr = pcmbuf;
-		int len = pcmbuf_size;
-		while( len )
+		snd_pcm_sframes_t avail = snd_pcm_avail_update( m_handle );
+		if( avail < 0 )
+		{
+			if( handleError( avail ) < 0 )
+			{
+				printf( "Avail update error: %s\n",
+							snd_strerror( avail ) );
+				return;
+			}
+			continue;
+		}
+		if( avail < (snd_pcm_sframes_t) m_periodSize )
+		{
+			const int err = snd_pcm_wait( m_handle, 1000 );
+			if( err < 0 && handleError( err ) < 0 )
+			{
+				printf( "Wait error: %s\n", snd_strerror( err ) );
+				return;
+			}
+			continue;
+		}
+
+		// convert mixer-output directly into device's buffer
+		snd_pcm_uframes_t frames = m_periodSize;
+		while( frames > 0 && quit == false )
 		{
-			if( outbuf_pos == 0 )
+			const snd_pcm_channel_area_t * areas;
+			snd_pcm_uframes_t offset;
+			snd_pcm_uframes_t n = frames;
+			int err = snd_pcm_mmap_begin( m_handle, &areas,
+								&offset, &n );
+			if( err < 0 )
 			{
-				// frames depend on the sample rate
-				const fpp_t frames = getNextBuffer( temp );
-				if( !frames )
+				if( handleError( err ) < 0 )
 				{
-					quit = true;
-					memset( ptr, 0, len
-						* sizeof( int_sample_t ) );
-					break;
+					printf( "Mmap begin error: %s\n",
+							snd_strerror( err ) );
 				}
-				outbuf_size = frames * channels();
+				break;
+			}
+
+			// interleaved access - all channels are in first area
+			char * dst = (char *) areas[0].addr +
+					( areas[0].first + offset *
+							areas[0].step ) / 8;
+			quit = !fillBuffer( dst, n );
 
-				convertToS16( temp, frames,
-						mixer()->masterGain(),
-						outbuf,
-						m_convertEndian );
+			const snd_pcm_sframes_t committed =
+				snd_pcm_mmap_commit( m_handle, offset, n );
+			if( committed < 0 ||
+				(snd_pcm_uframes_t) committed != n )
+			{
+				err = committed < 0 ? committed : -EPIPE;
+				if( handleError( err ) < 0 )
+				{
+					printf( "Mmap commit error: %s\n",
+							snd_strerror( err ) );
+				}
+				break;
 			}
-			int min_len = qMin( len, outbuf_size - outbuf_pos );
-			memcpy( ptr, outbuf + outbuf_pos,
-					min_len * sizeof( int_sample_t ) );
-			ptr += min_len;
-			len -= min_len;
-			outbuf_pos += min_len;
-			outbuf_pos %= outbuf_size;
+			frames -= n;
+		}
+
+		// with mmap-access the stream isn't started automatically
+		if( snd_pcm_state( m_handle ) == SND_PCM_STATE_PREPARED )
+		{
+			snd_pcm_start( m_handle );
 		}
+	}
+}
+
+
+
+
+void AudioAlsa::runReadWrite()
+{
+	char * pcmbuf = new char[m_periodSize * bytesPerFrame()];
+
+	bool quit = false;
+	while( quit == false )
+	{
+		quit = !fillBuffer( pcmbuf, m_periodSize );
 
 		f_cnt_t frames = m_periodSize;
-		ptr = pcmbuf;
+		char * ptr = pcmbuf;
 
 		while( frames )
 		{
@@ -306,19 +381,155 @@ void AudioAlsa::run()
 				}
 				break;	// skip this buffer
 			}
-			ptr += err * channels();
+			ptr += err * bytesPerFrame();
 			frames -= err;
 		}
 	}
 
-	delete[] temp;
-	delete[] outbuf;
 	delete[] pcmbuf;
 }
 
 
 
 
+bool AudioAlsa::fillBuffer( char * _dst, snd_pcm_uframes_t _frames )
+{
+	while( _frames > 0 )
+	{
+		if( m_mixPos >= m_mixFrames )
+		{
+			// frames depend on the sample rate
+			m_mixFrames = getNextBuffer( m_mixBuffer );
+			m_mixPos = 0;
+			if( !m_mixFrames )
+			{
+				memset( _dst, 0, _frames * bytesPerFrame() );
+				return false;
+			}
+		}
+		const fpp_t n = qMin<snd_pcm_uframes_t>( _frames,
+						m_mixFrames - m_mixPos );
+		convert( m_mixBuffer + m_mixPos, n, _dst );
+		m_mixPos += n;
+		_dst += n * bytesPerFrame();
+		_frames -= n;
+	}
+	return true;
+}
+
+
+
+
+void AudioAlsa::convert( const surroundSampleFrame * _src,
+					const fpp_t _frames, char * _dst )
+{
+	const float gain = mixer()->masterGain();
+	const ch_cnt_t chnls = channels();
+
+	switch( m_format )
+	{
+		case Float32:
+		{
+			// keep loop free of branches so that it can be
+			// vectorized
+			float * dst = (float *) _dst;
+			for( fpp_t frame = 0; frame < _frames; ++frame )
+			{
+				for( ch_cnt_t ch = 0; ch < chnls; ++ch )
+				{
+					dst[ch] = qBound( -1.0f,
+						_src[frame][ch] * gain, 1.0f );
+				}
+				dst += chnls;
+			}
+			break;
+		}
+		case S32:
+			// 24 bit is the best resolution we can get from
+			// floats, therefore S32 is made of shifted 24 bit
+			// samples
+			convertToInt<int32_t>( _src, _frames, gain, 8388607.0f,
+							8, (int32_t *) _dst );
+			break;
+		case S24:
+			convertToInt<int32_t>( _src, _frames, gain, 8388607.0f,
+							0, (int32_t *) _dst );
+			break;
+		case S16:
+		default:
+			convertToInt<int16_t>( _src, _frames, gain,
+						OUTPUT_SAMPLE_MULTIPLIER, 0,
+							(int16_t *) _dst );
+			if( m_convertEndian )
+			{
+				uint16_t * dst = (uint16_t *) _dst;
+				for( int i = 0; i < _frames * chnls; ++i )
+				{
+					dst[i] = ( dst[i] & 0x00ff ) << 8 |
+						( dst[i] & 0xff00 ) >> 8;
+				}
+			}
+			break;
+	}
+}
+
+
+
+
+template<typename T>
+void AudioAlsa::convertToInt( const surroundSampleFrame * _src,
+					const fpp_t _frames, const float _gain,
+					const float _max, const int _shift,
+								T * _dst )
+{
+	const ch_cnt_t chnls = channels();
+	const float scale = _gain * _max;
+	const float max = _max;
+	// left-shifting negative values is undefined, so multiply instead
+	const long mul = 1L << _shift;
+
+	if( m_dither )
+	{
+		// TPDF-dither: difference of two uniformly distributed random
+		// values in range [0;1) LSB
+		unsigned int state = m_ditherState;
+		for( fpp_t frame = 0; frame < _frames; ++frame )
+		{
+			for( ch_cnt_t ch = 0; ch < chnls; ++ch )
+			{
+				state = state * 1664525 + 1013904223;
+				const float r1 = ( state >> 8 ) *
+							( 1.0f / 16777216.0f );
+				state = state * 1664525 + 1013904223;
+				const float r2 = ( state >> 8 ) *
+							( 1.0f / 16777216.0f );
+				const float v = qBound( -max,
+					_src[frame][ch] * scale + r1 - r2,
+									max );
+				_dst[ch] = static_cast<T>( lrintf( v ) * mul );
+			}
+			_dst += chnls;
+		}
+		m_ditherState = state;
+	}
+	else
+	{
+		for( fpp_t frame = 0; frame < _frames; ++frame )
+		{
+			for( ch_cnt_t ch = 0; ch < chnls; ++ch )
+			{
+				const float v = qBound( -max,
+					_src[frame][ch] * scale, max );
+				_dst[ch] = static_cast<T>( lrintf( v ) * mul );
+			}
+			_dst += chnls;
+		}
+	}
+}
+
+
+
+
 int AudioAlsa::setHWParams( const ch_cnt_t _channels, snd_pcm_access_t _access )
 {
 	int err, dir;
@@ -340,22 +551,45 @@ int AudioAlsa::setHWParams( const ch_cnt_t _channels, snd_pcm_access_t _access )
 		return err;
 	}
 
-	// set the sample format
-	if( ( snd_pcm_hw_params_set_format( m_handle, m_hwParams,
-						SND_PCM_FORMAT_S16_LE ) ) < 0 )
+	// set the sample format - prefer formats not losing resolution of
+	// mixer-output, all in native byte-order
+	static const struct
+	{
+		snd_pcm_format_t alsaFormat;
+		SampleFormats format;
+	} formats[] =
+	{
+		{ SND_PCM_FORMAT_FLOAT, Float32 },
+		{ SND_PCM_FORMAT_S32, S32 },
+		{ SND_PCM_FORMAT_S24, S24 },
+		{ SND_PCM_FORMAT_S16, S16 }
+	} ;
+	m_convertEndian = false;
+	bool format_set = false;
+	for( unsigned int i = 0; i < sizeof( formats ) / sizeof( formats[0] );
+									++i )
 	{
-		if( ( snd_pcm_hw_params_set_format( m_handle, m_hwParams,
-						SND_PCM_FORMAT_S16_BE ) ) < 0 )
+		if( snd_pcm_hw_params_set_format( m_handle, m_hwParams,
+					formats[i].alsaFormat ) >= 0 )
 		{
-			printf( "Neither little- nor big-endian available for "
-					"playback: %s\n", snd_strerror( err ) );
-			return err;
+			m_format = formats[i].format;
+			format_set = true;
+			break;
 		}
-		m_convertEndian = isLittleEndian();
 	}
-	else
+	if( !format_set )
 	{
-		m_convertEndian = !isLittleEndian();
+		if( ( err = snd_pcm_hw_params_set_format( m_handle, m_hwParams,
+					isLittleEndian() ?
+						SND_PCM_FORMAT_S16_BE :
+					SND_PCM_FORMAT_S16_LE ) ) < 0 )
+		{
+			printf( "No supported sample format available for "
+					"playback: %s\n", snd_strerror( err ) );
+			return err;
+		}
+		m_format = S16;
+		m_convertEndian = true;
 	}
 
 	// set the count of channels
@@ -36,6 +36,7 @@
 #include "InstrumentTrack.h"
 #include "ladspa_2_lmms.h"
 #include "MainWindow.h"
+#include "MicroTimer.h"
 #include "Mixer.h"
 #include "pattern.h"
 #include "piano_roll.h"
@@ -49,6 +50,7 @@
 
 bool engine::s_hasGUI = true;
 bool engine::s_suppressMessages = false;
+bool engine::s_reportStartupTiming = false;
 float engine::s_framesPerTick;
 Mixer* engine::s_mixer = NULL;
 FxMixer * engine::s_fxMixer = NULL;
@@ -70,23 +72,50 @@ QMap<QString, QString> engine::s_pluginFileHandling;
 
 
 
+static void reportStartupTime( const bool _report, const char * _what,
+							MicroTimer & _timer )
+{
+	if( _report )
+	{
+		printf( "startup: %-20s %6.1f ms\n", _what,
+						_timer.elapsed() / 1000.0f );
+	}
+	_timer.reset();
+}
+
+
+
+
 void engine::init( const bool _has_gui )
 {
 	s_hasGUI = _has_gui;
 
+	MicroTimer totalTimer;
+	MicroTimer timer;
+
 	initPluginFileHandling();
+	reportStartupTime( s_reportStartupTiming, "LMMS plugins", timer );
 
 	s_projectJournal = new ProjectJournal;
 	s_mixer = new Mixer;
 	s_song = new song;
 	s_fxMixer = new FxMixer;
 	s_bbTrackContainer = new bbTrackContainer;
+	reportStartupTime( s_reportStartupTiming, "core", timer );
 
 	s_ladspaManager = new ladspa2LMMS;
+	if( s_reportStartupTiming )
+	{
+		printf( "startup: %d LADSPA libraries loaded, %d taken from "
+				"cache\n", s_ladspaManager->librariesScanned(),
+					s_ladspaManager->librariesCached() );
+	}
+	reportStartupTime( s_reportStartupTiming, "LADSPA plugins", timer );
 
 	s_projectJournal->setJournalling( true );
 
 	s_mixer->initDevices();
+	reportStartupTime( s_reportStartupTiming, "audio/MIDI devices", timer );
 
 	if( s_hasGUI )
 	{
@@ -100,12 +129,15 @@ void engine::init( const bool _has_gui )
 		s_automationEditor = new AutomationEditor;
 
 		s_mainWindow->finalize();
+		reportStartupTime( s_reportStartupTiming, "GUI", timer );
 	}
 
 	presetPreviewPlayHandle::init();
 	s_dummyTC = new DummyTrackContainer;
 
 	s_mixer->startProcessing();
+
+	reportStartupTime( s_reportStartupTiming, "total", totalTimer );
 }
 
 
@@ -25,9 +25,14 @@
 
 #include "fft_helpers.h"
 
+#include <QtCore/QMutex>
+
 #include <math.h>
 
 
+static QMutex s_fftwPlannerMutex;
+
+
 /* returns biggest value from abs_spectrum[spec_size] array
 
    returns -1 on error
@@ -241,3 +246,19 @@ float signalpower(float *timesignal, int num_values)
 	return power;	
 }
 
+
+
+
+void fftwPlannerLock()
+{
+	s_fftwPlannerMutex.lock();
+}
+
+
+
+
+void fftwPlannerUnlock()
+{
+	s_fftwPlannerMutex.unlock();
+}
+
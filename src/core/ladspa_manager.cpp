@@ -25,8 +25,10 @@
  */
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QLibrary>
 
@@ -36,8 +38,60 @@
 #include "ladspa_manager.h"
 
 
+static const char * LADSPA_CACHE_FILE = "ladspacache.dat";
+static const quint32 LADSPA_CACHE_MAGIC = 0x4c4c4331;	// "LLC1"
 
-ladspaManager::ladspaManager()
+
+
+QDataStream & operator<<( QDataStream & _s, const ladspaPortDescription & _p )
+{
+	return _s << (qint32) _p.descriptor << (qint32) _p.hints
+			<< _p.lowerBound << _p.upperBound << _p.name;
+}
+
+
+
+
+QDataStream & operator>>( QDataStream & _s, ladspaPortDescription & _p )
+{
+	qint32 descriptor, hints;
+	_s >> descriptor >> hints >> _p.lowerBound >> _p.upperBound >> _p.name;
+	_p.descriptor = descriptor;
+	_p.hints = hints;
+	return _s;
+}
+
+
+
+
+QDataStream & operator<<( QDataStream & _s,
+					const ladspaManagerDescription & _d )
+{
+	return _s << (quint32) _d.index << _d.label << _d.name << _d.maker
+			<< _d.copyright << (qint32) _d.properties << _d.ports;
+}
+
+
+
+
+QDataStream & operator>>( QDataStream & _s, ladspaManagerDescription & _d )
+{
+	quint32 index;
+	qint32 properties;
+	_s >> index >> _d.label >> _d.name >> _d.maker >> _d.copyright
+						>> properties >> _d.ports;
+	_d.descriptorFunction = NULL;
+	_d.index = index;
+	_d.properties = properties;
+	return _s;
+}
+
+
+
+
+ladspaManager::ladspaManager() :
+	m_librariesScanned( 0 ),
+	m_librariesCached( 0 )
 {
 	QStringList ladspaDirectories = QString( getenv( "LADSPA_PATH" ) ).
 								split( LADSPA_PATH_SEPERATOR );
@@ -52,6 +106,12 @@ ladspaManager::ladspaManager()
 	ladspaDirectories.push_back( "/usr/local/lib/ladspa" );
 #endif
 
+	const ladspaCacheMapType cache = readCache();
+	// entries of all libraries found now - written back if anything
+	// changed
+	ladspaCacheMapType newCache;
+	bool cacheChanged = false;
+
 	for( QStringList::iterator it = ladspaDirectories.begin(); 
 			 		   it != ladspaDirectories.end(); ++it )
 	{
@@ -73,25 +133,40 @@ ladspaManager::ladspaManager()
 				continue;
 			}
 
-			QLibrary plugin_lib( f.absoluteFilePath() );
+			const QString path = f.absoluteFilePath();
+			if( newCache.contains( path ) )
+			{
+				// directory listed more than once
+				continue;
+			}
 
-			if( plugin_lib.load() == true )
+			ladspaCacheMapType::ConstIterator cached =
+							cache.find( path );
+			if( cached != cache.end() &&
+				cached->size == f.size() &&
+				cached->modified == f.lastModified().toTime_t() )
 			{
-				LADSPA_Descriptor_Function descriptorFunction =
-			( LADSPA_Descriptor_Function ) plugin_lib.resolve(
-							"ladspa_descriptor" );
-				if( descriptorFunction != NULL )
-				{
-					addPlugins( descriptorFunction,
-							f.fileName() );
-				}
+				newCache[path] = *cached;
+				++m_librariesCached;
 			}
 			else
 			{
-				qWarning() << plugin_lib.errorString();
+				cachedLibrary & lib = newCache[path];
+				lib.size = f.size();
+				lib.modified = f.lastModified().toTime_t();
+				scanLibrary( path, lib.plugins );
+				++m_librariesScanned;
+				cacheChanged = true;
 			}
+
+			addPlugins( newCache[path].plugins, f.fileName() );
 		}
 	}
+
+	if( cacheChanged || newCache.size() != cache.size() )
+	{
+		writeCache( newCache );
+	}
 	
 	l_ladspa_key_t keys = m_ladspaManagerMap.keys();
 	for( l_ladspa_key_t::iterator it = keys.begin();
@@ -133,28 +208,74 @@ ladspaManagerDescription * ladspaManager::getDescription(
 
 
 
-void ladspaManager::addPlugins(
-		LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file )
+void ladspaManager::scanLibrary( const QString & _file,
+				ladspaManagerDescriptionList & _plugins )
 {
+	QLibrary plugin_lib( _file );
+	if( plugin_lib.load() == false )
+	{
+		qWarning() << plugin_lib.errorString();
+		return;
+	}
+
+	LADSPA_Descriptor_Function descriptorFunction =
+			( LADSPA_Descriptor_Function ) plugin_lib.resolve(
+							"ladspa_descriptor" );
+	if( descriptorFunction == NULL )
+	{
+		return;
+	}
+
 	const LADSPA_Descriptor * descriptor;
 
 	for( long pluginIndex = 0;
-		( descriptor = _descriptor_func( pluginIndex ) ) != NULL;
+		( descriptor = descriptorFunction( pluginIndex ) ) != NULL;
 								++pluginIndex )
 	{
-		ladspa_key_t key( _file, QString( descriptor->Label ) );
+		ladspaManagerDescription plugIn;
+		plugIn.descriptorFunction = descriptorFunction;
+		plugIn.file = _file;
+		plugIn.index = pluginIndex;
+		plugIn.label = QString( descriptor->Label );
+		plugIn.name = QString( descriptor->Name );
+		plugIn.maker = QString( descriptor->Maker );
+		plugIn.copyright = QString( descriptor->Copyright );
+		plugIn.properties = descriptor->Properties;
+
+		plugIn.ports.resize( descriptor->PortCount );
+		for( uint32_t port = 0; port < descriptor->PortCount; ++port )
+		{
+			ladspaPortDescription & p = plugIn.ports[port];
+			p.descriptor = descriptor->PortDescriptors[port];
+			p.hints = descriptor->PortRangeHints[port].HintDescriptor;
+			p.lowerBound = descriptor->PortRangeHints[port].LowerBound;
+			p.upperBound = descriptor->PortRangeHints[port].UpperBound;
+			p.name = QString( descriptor->PortNames[port] );
+		}
+
+		_plugins.push_back( plugIn );
+	}
+}
+
+
+
+
+void ladspaManager::addPlugins( const ladspaManagerDescriptionList & _plugins,
+						const QString & _file_name )
+{
+	for( ladspaManagerDescriptionList::ConstIterator it = _plugins.begin();
+						it != _plugins.end(); ++it )
+	{
+		ladspa_key_t key( _file_name, it->label );
 		if( m_ladspaManagerMap.contains( key ) )
 		{
 			continue;
 		}
 
 		ladspaManagerDescription * plugIn = 
-				new ladspaManagerDescription;
-		plugIn->descriptorFunction = _descriptor_func;
-		plugIn->index = pluginIndex;
-		plugIn->inputChannels = getPluginInputs( descriptor );
-		plugIn->outputChannels = getPluginOutputs( descriptor );
+				new ladspaManagerDescription( *it );
+		plugIn->inputChannels = getPluginInputs( plugIn );
+		plugIn->outputChannels = getPluginOutputs( plugIn );
 
 		if( plugIn->inputChannels == 0 && plugIn->outputChannels > 0 )
 		{
@@ -183,23 +304,17 @@ void ladspaManager::addPlugins(
 
 
 uint16_t ladspaManager::getPluginInputs( 
-		const LADSPA_Descriptor * _descriptor )
+		const ladspaManagerDescription * _desc )
 {
 	uint16_t inputs = 0;
 	
-	for( uint16_t port = 0; port < _descriptor->PortCount; port++ )
+	for( int port = 0; port < _desc->ports.size(); port++ )
 	{
-		if( LADSPA_IS_PORT_INPUT( 
-				_descriptor->PortDescriptors[port] ) &&
-			LADSPA_IS_PORT_AUDIO( 
-				_descriptor->PortDescriptors[port] ) )
+		if( LADSPA_IS_PORT_INPUT( _desc->ports[port].descriptor ) &&
+			LADSPA_IS_PORT_AUDIO( _desc->ports[port].descriptor ) &&
+			_desc->ports[port].name.toUpper().contains( "IN" ) )
 		{
-			QString name = QString( 
-					_descriptor->PortNames[port] );
-			if( name.toUpper().contains( "IN" ) )
-			{
-				inputs++;
-			}
+			inputs++;
 		}
 	}
 	return inputs;
@@ -209,23 +324,17 @@ uint16_t ladspaManager::getPluginInputs(
 
 
 uint16_t ladspaManager::getPluginOutputs( 
-		const LADSPA_Descriptor * _descriptor )
+		const ladspaManagerDescription * _desc )
 {
 	uint16_t outputs = 0;
 	
-	for( uint16_t port = 0; port < _descriptor->PortCount; port++ )
+	for( int port = 0; port < _desc->ports.size(); port++ )
 	{
-		if( LADSPA_IS_PORT_OUTPUT( 
-				_descriptor->PortDescriptors[port] ) &&
-			LADSPA_IS_PORT_AUDIO( 
-				_descriptor->PortDescriptors[port] ) )
+		if( LADSPA_IS_PORT_OUTPUT( _desc->ports[port].descriptor ) &&
+			LADSPA_IS_PORT_AUDIO( _desc->ports[port].descriptor ) &&
+			_desc->ports[port].name.toUpper().contains( "OUT" ) )
 		{
-			QString name = QString( 
-					_descriptor->PortNames[port] );
-			if( name.toUpper().contains( "OUT" ) )
-			{
-				outputs++;
-			}
+			outputs++;
 		}
 	}
 	return outputs;
@@ -234,6 +343,154 @@ uint16_t ladspaManager::getPluginOutputs(
 
 
 
+ladspaManager::ladspaCacheMapType ladspaManager::readCache()
+{
+	ladspaCacheMapType cache;
+
+	QFile f( configManager::inst()->workingDir() + LADSPA_CACHE_FILE );
+	if( !f.open( QFile::ReadOnly ) )
+	{
+		return cache;
+	}
+
+	QDataStream s( &f );
+	s.setVersion( QDataStream::Qt_4_0 );
+	quint32 magic = 0;
+	qint32 libraries = 0;
+	s >> magic >> libraries;
+	if( magic != LADSPA_CACHE_MAGIC )
+	{
+		return cache;
+	}
+
+	for( qint32 i = 0; i < libraries && s.status() == QDataStream::Ok;
+									++i )
+	{
+		QString path;
+		cachedLibrary lib;
+		s >> path >> lib.size >> lib.modified >> lib.plugins;
+		for( ladspaManagerDescriptionList::Iterator it =
+							lib.plugins.begin();
+					it != lib.plugins.end(); ++it )
+		{
+			it->file = path;
+		}
+		cache[path] = lib;
+	}
+
+	if( s.status() != QDataStream::Ok )
+	{
+		// corrupt file - scan everything again
+		cache.clear();
+	}
+
+	return cache;
+}
+
+
+
+
+void ladspaManager::writeCache( const ladspaCacheMapType & _cache )
+{
+	// write to temporary file and rename it afterwards so that another
+	// instance starting concurrently never reads a partial file
+	const QString file = configManager::inst()->workingDir() +
+							LADSPA_CACHE_FILE;
+	QFile f( file + ".tmp" );
+	if( !f.open( QFile::WriteOnly | QFile::Truncate ) )
+	{
+		return;
+	}
+
+	QDataStream s( &f );
+	s.setVersion( QDataStream::Qt_4_0 );
+	s << LADSPA_CACHE_MAGIC << (qint32) _cache.size();
+	for( ladspaCacheMapType::ConstIterator it = _cache.begin();
+						it != _cache.end(); ++it )
+	{
+		s << it.key() << it->size << it->modified << it->plugins;
+	}
+	f.close();
+
+	if( s.status() == QDataStream::Ok && f.error() == QFile::NoError )
+	{
+		QFile::remove( file );
+		f.rename( file );
+	}
+	else
+	{
+		f.remove();
+	}
+}
+
+
+
+
+const ladspaPortDescription * ladspaManager::getPort(
+				const ladspa_key_t & _plugin, uint32_t _port )
+{
+	ladspaManagerMapType::ConstIterator it =
+					m_ladspaManagerMap.find( _plugin );
+	if( it != m_ladspaManagerMap.end() &&
+					_port < (uint32_t) ( *it )->ports.size() )
+	{
+		return( &( *it )->ports[_port] );
+	}
+	return( NULL );
+}
+
+
+
+
+const LADSPA_Descriptor * ladspaManager::loadDescriptor(
+						const ladspa_key_t & _plugin )
+{
+	ladspaManagerMapType::ConstIterator it =
+					m_ladspaManagerMap.find( _plugin );
+	if( it == m_ladspaManagerMap.end() )
+	{
+		return( NULL );
+	}
+
+	ladspaManagerDescription * desc = *it;
+	// descriptorFunction is written by whichever thread loads the library
+	// first, so it's only accessed while holding m_loadMutex
+	m_loadMutex.lock();
+	if( desc->descriptorFunction == NULL )
+	{
+		QLibrary plugin_lib( desc->file );
+		if( plugin_lib.load() == false )
+		{
+			m_loadMutex.unlock();
+			qWarning() << plugin_lib.errorString();
+			return( NULL );
+		}
+		desc->descriptorFunction =
+			( LADSPA_Descriptor_Function )
+				plugin_lib.resolve( "ladspa_descriptor" );
+	}
+	const LADSPA_Descriptor_Function descriptor_function =
+						desc->descriptorFunction;
+	m_loadMutex.unlock();
+
+	if( descriptor_function == NULL )
+	{
+		return( NULL );
+	}
+
+	const LADSPA_Descriptor * descriptor =
+				descriptor_function( desc->index );
+	// library replaced while we were running?
+	if( descriptor == NULL || desc->label != descriptor->Label )
+	{
+		return( NULL );
+	}
+	return( descriptor );
+}
+
+
+
+
 l_sortable_plugin_t ladspaManager::getSortedPlugins()
 {
 	return( m_sortedPlugins );
@@ -246,12 +503,7 @@ QString ladspaManager::getLabel( const ladspa_key_t & _plugin )
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor = 
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( QString( descriptor->Label ) );
+		return( m_ladspaManagerMap[_plugin]->label );
 	}
 	else
 	{
@@ -267,12 +519,8 @@ bool ladspaManager::hasRealTimeDependency(
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( LADSPA_IS_REALTIME( descriptor->Properties ) );
+		return( LADSPA_IS_REALTIME(
+				m_ladspaManagerMap[_plugin]->properties ) );
 	}
 	else
 	{
@@ -287,12 +535,8 @@ bool ladspaManager::isInplaceBroken( const ladspa_key_t &  _plugin )
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( LADSPA_IS_INPLACE_BROKEN( descriptor->Properties ) );
+		return( LADSPA_IS_INPLACE_BROKEN(
+				m_ladspaManagerMap[_plugin]->properties ) );
 	}
 	else
 	{
@@ -308,12 +552,8 @@ bool ladspaManager::isRealTimeCapable(
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( LADSPA_IS_HARD_RT_CAPABLE( descriptor->Properties ) );
+		return( LADSPA_IS_HARD_RT_CAPABLE(
+				m_ladspaManagerMap[_plugin]->properties ) );
 	}
 	else
 	{
@@ -328,12 +568,7 @@ QString ladspaManager::getName( const ladspa_key_t & _plugin )
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( QString( descriptor->Name ) );
+		return( m_ladspaManagerMap[_plugin]->name );
 	}
 	else
 	{
@@ -348,12 +583,7 @@ QString ladspaManager::getMaker( const ladspa_key_t & _plugin )
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( QString( descriptor->Maker ) );
+		return( m_ladspaManagerMap[_plugin]->maker );
 	}
 	else
 	{
@@ -368,12 +598,7 @@ QString ladspaManager::getCopyright( const ladspa_key_t & _plugin )
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( QString( descriptor->Copyright ) );
+		return( m_ladspaManagerMap[_plugin]->copyright );
 	}
 	else
 	{
@@ -388,12 +613,7 @@ uint32_t ladspaManager::getPortCount( const ladspa_key_t & _plugin )
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( descriptor->PortCount );
+		return( m_ladspaManagerMap[_plugin]->ports.size() );
 	}
 	else
 	{
@@ -407,22 +627,8 @@ uint32_t ladspaManager::getPortCount( const ladspa_key_t & _plugin )
 bool ladspaManager::isPortInput( const ladspa_key_t & _plugin, 
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		&& _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		
-		return( LADSPA_IS_PORT_INPUT
-				( descriptor->PortDescriptors[_port] ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	return( port != NULL && LADSPA_IS_PORT_INPUT( port->descriptor ) );
 }
 
 
@@ -431,22 +637,8 @@ bool ladspaManager::isPortInput( const ladspa_key_t & _plugin,
 bool ladspaManager::isPortOutput( const ladspa_key_t & _plugin, 
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		
-		return( LADSPA_IS_PORT_OUTPUT
-				( descriptor->PortDescriptors[_port] ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	return( port != NULL && LADSPA_IS_PORT_OUTPUT( port->descriptor ) );
 }
 
 
@@ -455,22 +647,8 @@ bool ladspaManager::isPortOutput( const ladspa_key_t & _plugin,
 bool ladspaManager::isPortAudio( const ladspa_key_t & _plugin,
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		
-		return( LADSPA_IS_PORT_AUDIO
-				( descriptor->PortDescriptors[_port] ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	return( port != NULL && LADSPA_IS_PORT_AUDIO( port->descriptor ) );
 }
 
 
@@ -479,22 +657,8 @@ bool ladspaManager::isPortAudio( const ladspa_key_t & _plugin,
 bool ladspaManager::isPortControl( const ladspa_key_t & _plugin, 
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		
-		return( LADSPA_IS_PORT_CONTROL
-				( descriptor->PortDescriptors[_port] ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	return( port != NULL && LADSPA_IS_PORT_CONTROL( port->descriptor ) );
 }
 
 
@@ -504,22 +668,8 @@ bool ladspaManager::areHintsSampleRateDependent(
 						const ladspa_key_t & _plugin, 
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		LADSPA_PortRangeHintDescriptor hintDescriptor =
-			descriptor->PortRangeHints[_port].HintDescriptor;
-		return( LADSPA_IS_HINT_SAMPLE_RATE ( hintDescriptor ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	return( port != NULL && LADSPA_IS_HINT_SAMPLE_RATE( port->hints ) );
 }
 
 
@@ -528,24 +678,10 @@ bool ladspaManager::areHintsSampleRateDependent(
 float ladspaManager::getLowerBound( const ladspa_key_t & _plugin,
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		LADSPA_PortRangeHintDescriptor hintDescriptor =
-			descriptor->PortRangeHints[_port].HintDescriptor;
-		if( LADSPA_IS_HINT_BOUNDED_BELOW( hintDescriptor ) )
-		{
-			return( descriptor->PortRangeHints[_port].LowerBound );
-		}
-		else
-		{
-			return( NOHINT );
-		}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	if( port != NULL && LADSPA_IS_HINT_BOUNDED_BELOW( port->hints ) )
+	{
+		return( port->lowerBound );
 	}
 	else
 	{
@@ -556,26 +692,13 @@ float ladspaManager::getLowerBound( const ladspa_key_t & _plugin,
 
 
 
-float ladspaManager::getUpperBound( const ladspa_key_t & _plugin,									uint32_t _port )
+float ladspaManager::getUpperBound( const ladspa_key_t & _plugin,
+								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	if( port != NULL && LADSPA_IS_HINT_BOUNDED_ABOVE( port->hints ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		LADSPA_PortRangeHintDescriptor hintDescriptor =
-			descriptor->PortRangeHints[_port].HintDescriptor;
-		if( LADSPA_IS_HINT_BOUNDED_ABOVE( hintDescriptor ) )
-		{
-			return( descriptor->PortRangeHints[_port].UpperBound );
-		}
-		else
-		{
-			return( NOHINT );
-		}
+		return( port->upperBound );
 	}
 	else
 	{
@@ -589,22 +712,8 @@ float ladspaManager::getUpperBound( const ladspa_key_t & _plugin,									uint32
 bool ladspaManager::isPortToggled( const ladspa_key_t & _plugin, 
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		LADSPA_PortRangeHintDescriptor hintDescriptor =
-			descriptor->PortRangeHints[_port].HintDescriptor;
-		return( LADSPA_IS_HINT_TOGGLED( hintDescriptor ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	return( port != NULL && LADSPA_IS_HINT_TOGGLED( port->hints ) );
 }
 
 
@@ -613,85 +722,62 @@ bool ladspaManager::isPortToggled( const ladspa_key_t & _plugin,
 float ladspaManager::getDefaultSetting( const ladspa_key_t & _plugin, 
 							uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		LADSPA_PortRangeHintDescriptor hintDescriptor =
-			descriptor->PortRangeHints[_port].HintDescriptor;
-		switch( hintDescriptor & LADSPA_HINT_DEFAULT_MASK ) 
-		{
-			case LADSPA_HINT_DEFAULT_NONE:
-				return( NOHINT );
-			case LADSPA_HINT_DEFAULT_MINIMUM:
-				return( descriptor->PortRangeHints[_port].
-								LowerBound );
-			case LADSPA_HINT_DEFAULT_LOW:
-				if( LADSPA_IS_HINT_LOGARITHMIC
-							( hintDescriptor ) )
-				{
-					return( exp( log( descriptor->PortRangeHints[_port].LowerBound ) 
-						* 0.75
-						+ log( descriptor->PortRangeHints[_port].UpperBound ) 
-						* 0.25 ) );
-				}
-				else 
-				{
-					return( descriptor->PortRangeHints[_port].LowerBound
-						* 0.75
-						+ descriptor->PortRangeHints[_port].UpperBound
-						* 0.25 );
-				}
-			case LADSPA_HINT_DEFAULT_MIDDLE:
-				if( LADSPA_IS_HINT_LOGARITHMIC
-						( hintDescriptor ) ) 
-				{
-					return( sqrt( descriptor->PortRangeHints[_port].LowerBound
-						* descriptor->PortRangeHints[_port].UpperBound ) );
-				}
-				else 
-				{
-					return( 0.5 * ( descriptor->PortRangeHints[_port].LowerBound
-							+ descriptor->PortRangeHints[_port].UpperBound ) );
-				}
-			case LADSPA_HINT_DEFAULT_HIGH:
-				if( LADSPA_IS_HINT_LOGARITHMIC
-						( hintDescriptor ) ) 
-				{
-					return( exp( log( descriptor->PortRangeHints[_port].LowerBound ) 
-						* 0.25
-						+ log( descriptor->PortRangeHints[_port].UpperBound ) 
-						* 0.75 ) );
-				}
-				else 
-				{
-					return( descriptor->PortRangeHints[_port].LowerBound
-						* 0.25
-						+ descriptor->PortRangeHints[_port].UpperBound
-						* 0.75 );
-				}
-			case LADSPA_HINT_DEFAULT_MAXIMUM:
-				return( descriptor->PortRangeHints[_port].UpperBound );
-			case LADSPA_HINT_DEFAULT_0:
-				return( 0.0 );
-			case LADSPA_HINT_DEFAULT_1:
-				return( 1.0 );
-			case LADSPA_HINT_DEFAULT_100:
-				return( 100.0 );
-			case LADSPA_HINT_DEFAULT_440:
-				return( 440.0 );
-			default:
-				return( NOHINT );
-		}
-	}
-	else
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	if( port == NULL )
 	{
 		return( NOHINT );
 	}
+
+	const float lower = port->lowerBound;
+	const float upper = port->upperBound;
+	switch( port->hints & LADSPA_HINT_DEFAULT_MASK ) 
+	{
+		case LADSPA_HINT_DEFAULT_NONE:
+			return( NOHINT );
+		case LADSPA_HINT_DEFAULT_MINIMUM:
+			return( lower );
+		case LADSPA_HINT_DEFAULT_LOW:
+			if( LADSPA_IS_HINT_LOGARITHMIC( port->hints ) )
+			{
+				return( exp( log( lower ) * 0.75 +
+						log( upper ) * 0.25 ) );
+			}
+			else 
+			{
+				return( lower * 0.75 + upper * 0.25 );
+			}
+		case LADSPA_HINT_DEFAULT_MIDDLE:
+			if( LADSPA_IS_HINT_LOGARITHMIC( port->hints ) )
+			{
+				return( sqrt( lower * upper ) );
+			}
+			else 
+			{
+				return( 0.5 * ( lower + upper ) );
+			}
+		case LADSPA_HINT_DEFAULT_HIGH:
+			if( LADSPA_IS_HINT_LOGARITHMIC( port->hints ) )
+			{
+				return( exp( log( lower ) * 0.25 +
+						log( upper ) * 0.75 ) );
+			}
+			else 
+			{
+				return( lower * 0.25 + upper * 0.75 );
+			}
+		case LADSPA_HINT_DEFAULT_MAXIMUM:
+			return( upper );
+		case LADSPA_HINT_DEFAULT_0:
+			return( 0.0 );
+		case LADSPA_HINT_DEFAULT_1:
+			return( 1.0 );
+		case LADSPA_HINT_DEFAULT_100:
+			return( 100.0 );
+		case LADSPA_HINT_DEFAULT_440:
+			return( 440.0 );
+		default:
+			return( NOHINT );
+	}
 }
 
 
@@ -700,22 +786,8 @@ float ladspaManager::getDefaultSetting( const ladspa_key_t & _plugin,
 bool ladspaManager::isLogarithmic( const ladspa_key_t & _plugin,
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		LADSPA_PortRangeHintDescriptor hintDescriptor =
-			descriptor->PortRangeHints[_port].HintDescriptor;
-		return( LADSPA_IS_HINT_LOGARITHMIC( hintDescriptor ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	return( port != NULL && LADSPA_IS_HINT_LOGARITHMIC( port->hints ) );
 }
 
 
@@ -724,22 +796,8 @@ bool ladspaManager::isLogarithmic( const ladspa_key_t & _plugin,
 bool ladspaManager::isInteger( const ladspa_key_t & _plugin,
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		LADSPA_PortRangeHintDescriptor hintDescriptor =
-			descriptor->PortRangeHints[_port].HintDescriptor;
-		return( LADSPA_IS_HINT_INTEGER( hintDescriptor ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	return( port != NULL && LADSPA_IS_HINT_INTEGER( port->hints ) );
 }
 
 
@@ -748,16 +806,10 @@ bool ladspaManager::isInteger( const ladspa_key_t & _plugin,
 QString ladspaManager::getPortName( const ladspa_key_t & _plugin,
 								uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) &&
-					_port < getPortCount( _plugin ) )
+	const ladspaPortDescription * port = getPort( _plugin, _port );
+	if( port != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-
-		return( QString( descriptor->PortNames[_port] ) );
+		return( port->name );
 	}
 	else
 	{
@@ -771,13 +823,9 @@ QString ladspaManager::getPortName( const ladspa_key_t & _plugin,
 const void * ladspaManager::getImplementationData(
 						const ladspa_key_t & _plugin )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
 		return( descriptor->ImplementationData );
 	}
 	else
@@ -792,19 +840,7 @@ const void * ladspaManager::getImplementationData(
 const LADSPA_Descriptor * ladspaManager::getDescriptor( 
 						const ladspa_key_t & _plugin )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( descriptor );
-	}
-	else
-	{
-		return( NULL );
-	}
+	return( loadDescriptor( _plugin ) );
 }
 
 
@@ -814,13 +850,9 @@ LADSPA_Handle ladspaManager::instantiate(
 					const ladspa_key_t & _plugin, 
 							uint32_t _sample_rate )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
 		return( ( descriptor->instantiate )
 						( descriptor, _sample_rate ) );
 	}
@@ -838,20 +870,13 @@ bool ladspaManager::connectPort( const ladspa_key_t & _plugin,
 						uint32_t _port,
 						LADSPA_Data * _data_location )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) 
-		&& _port < getPortCount( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL && _port < descriptor->PortCount &&
+					descriptor->connect_port != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		if( descriptor->connect_port != NULL )
-		{
-			( descriptor->connect_port )
-					( _instance, _port, _data_location );
-			return( true );
-		}
+		( descriptor->connect_port )
+				( _instance, _port, _data_location );
+		return( true );
 	}
 	return( false );
 }
@@ -862,18 +887,11 @@ bool ladspaManager::connectPort( const ladspa_key_t & _plugin,
 bool ladspaManager::activate( const ladspa_key_t & _plugin, 
 					LADSPA_Handle _instance )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL && descriptor->activate != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		if( descriptor->activate != NULL )
-		{
-			( descriptor->activate ) ( _instance );
-			return( true );
-		}
+		( descriptor->activate ) ( _instance );
+		return( true );
 	}
 	return( false );
 }
@@ -885,18 +903,11 @@ bool ladspaManager::run( const ladspa_key_t & _plugin,
 							LADSPA_Handle _instance,
 							uint32_t _sample_count )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL && descriptor->run != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		if( descriptor->run != NULL )
-		{
-			( descriptor->run ) ( _instance, _sample_count );
-			return( true );
-		}
+		( descriptor->run ) ( _instance, _sample_count );
+		return( true );
 	}
 	return( false );
 }
@@ -908,19 +919,12 @@ bool ladspaManager::runAdding( const ladspa_key_t & _plugin,
 						LADSPA_Handle _instance,
 						uint32_t _sample_count )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL && descriptor->run_adding != NULL &&
+				descriptor->set_run_adding_gain != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		if( descriptor->run_adding != NULL &&
-			  	descriptor->set_run_adding_gain != NULL )
-		{
-			( descriptor->run_adding ) ( _instance, _sample_count );
-			return( true );
-		}
+		( descriptor->run_adding ) ( _instance, _sample_count );
+		return( true );
 	}
 	return( false );
 }
@@ -932,20 +936,12 @@ bool ladspaManager::setRunAddingGain( const ladspa_key_t & _plugin,
 						LADSPA_Handle _instance,
 						LADSPA_Data _gain )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL && descriptor->run_adding != NULL &&
+				descriptor->set_run_adding_gain != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		if( descriptor->run_adding != NULL &&
-				  descriptor->set_run_adding_gain != NULL )
-		{
-			( descriptor->set_run_adding_gain )
-							( _instance, _gain );
-			return( true );
-		}
+		( descriptor->set_run_adding_gain ) ( _instance, _gain );
+		return( true );
 	}
 	return( false );
 }
@@ -956,18 +952,11 @@ bool ladspaManager::setRunAddingGain( const ladspa_key_t & _plugin,
 bool ladspaManager::deactivate( const ladspa_key_t & _plugin, 
 						LADSPA_Handle _instance )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL && descriptor->deactivate != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		if( descriptor->deactivate != NULL )
-		{
-			( descriptor->deactivate ) ( _instance );
-			return( true );
-		}
+		( descriptor->deactivate ) ( _instance );
+		return( true );
 	}
 	return( false );
 }
@@ -978,18 +967,11 @@ bool ladspaManager::deactivate( const ladspa_key_t & _plugin,
 bool ladspaManager::cleanup( const ladspa_key_t & _plugin, 
 						LADSPA_Handle _instance )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	const LADSPA_Descriptor * descriptor = loadDescriptor( _plugin );
+	if( descriptor != NULL && descriptor->cleanup != NULL )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		if( descriptor->cleanup != NULL )
-		{
-			( descriptor->cleanup ) ( _instance );
-			return( true );
-		}
+		( descriptor->cleanup ) ( _instance );
+		return( true );
 	}
 	return( false );
 }
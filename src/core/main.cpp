@@ -62,6 +62,7 @@
 #include "ImportFilter.h"
 #include "MainWindow.h"
 #include "ProjectRenderer.h"
+#include "RenderServer.h"
 #include "mmp.h"
 #include "song.h"
 
@@ -94,11 +95,16 @@ int main( int argc, char * * argv )
 	bool fullscreen = true;
 	bool exit_after_import = false;
 	QString file_to_load, file_to_save, file_to_import, render_out;
+	QString render_server;
+	bool profile = false;
+	bool fixed_seed = false;
+	unsigned int seed = 0;
 
 	for( int i = 1; i < argc; ++i )
 	{
 		if( argc > i && ( ( QString( argv[i] ) == "--render" ||
 					QString( argv[i] ) == "-r" ) ||
+				QString( argv[i] ) == "--render-server" ||
 				( QString( argv[i] ) == "--help" ||
 						QString( argv[i] ) == "-h" ) ) )
 		{
@@ -146,11 +152,15 @@ int main( int argc, char * * argv )
 			printf( "\nLinux MultiMedia Studio %s\n"
 	"Copyright (c) 2004-2013 LMMS developers.\n\n"
 	"usage: lmms [ -r <project file> ] [ options ]\n"
+	"            [ --render-server <socket> ]\n"
 	"            [ -u <in> <out> ]\n"
 	"            [ -d <in> ]\n"
 	"            [ -h ]\n"
 	"            [ <file to load> ]\n\n"
 	"-r, --render <project file>	render given project file\n"
+	"    --render-server <socket>	keep running without GUI and render\n"
+	"				projects as requested by clients of\n"
+	"				local socket <socket>\n"
 	"-o, --output <file>		render into <file>\n"
 	"-f, --output-format <format>	specify format of render-output where\n"
 	"				format is either 'wav' or 'ogg'.\n"
@@ -167,9 +177,15 @@ int main( int argc, char * * argv )
 	"-x, --oversampling <value>	specify oversampling\n"
 	"				possible values: 1, 2, 4, 8\n"
 	"				default: 2\n"
+	"    --profile			print realtime-factor, time spent per\n"
+	"				mixer-stage, allocations and peak\n"
+	"				memory-usage after rendering\n"
+	"    --seed <n>			seed random number generator with <n>\n"
+	"				for reproducible renderings\n"
 	"-u, --upgrade <in> [out]	upgrade file <in> and save as <out>\n"
 	"       standard out is used if no output file is specifed\n"
 	"-d, --dump <in>			dump XML of compressed file <in>\n"
+	"    --startup-timing		print time needed for initialization\n"
 	"-v, --version			show version information and exit.\n"
 	"-h, --help			show this usage information and exit.\n\n",
 							LMMS_VERSION );
@@ -200,6 +216,10 @@ int main( int argc, char * * argv )
 			printf( "%s\n", d.toUtf8().constData() );
 			return( EXIT_SUCCESS );
 		}
+		else if( QString( argv[i] ) == "--startup-timing" )
+		{
+			engine::setReportStartupTiming( true );
+		}
 		else if( argc > i && ( QString( argv[i] ) == "--render" ||
 						QString( argv[i] ) == "-r" ) )
 		{
@@ -207,6 +227,24 @@ int main( int argc, char * * argv )
 			render_out = baseName( file_to_load ) + ".";
 			++i;
 		}
+		else if( argc > i + 1 &&
+				QString( argv[i] ) == "--render-server" )
+		{
+			render_server = QString( argv[i + 1] );
+			++i;
+		}
+		else if( QString( argv[i] ) == "--profile" )
+		{
+			profile = true;
+		}
+		else if( argc > i + 1 && QString( argv[i] ) == "--seed" )
+		{
+			fixed_seed = true;
+			seed = QString( argv[i + 1] ).toUInt();
+			// picked up by plugins running in separate processes
+			qputenv( "LMMS_SEED", argv[i + 1] );
+			++i;
+		}
 		else if( argc > i && ( QString( argv[i] ) == "--output" ||
 						QString( argv[i] ) == "-o" ) )
 		{
@@ -382,7 +420,23 @@ int main( int argc, char * * argv )
 
 	configManager::inst()->loadConfigFile();
 
-	if( render_out.isEmpty() )
+	if( !render_server.isEmpty() )
+	{
+		// initialize everything once and keep it for all jobs
+		engine::init( false );
+		RenderServer * server = new RenderServer( render_server );
+		if( !server->isListening() )
+		{
+			delete server;
+			return( EXIT_FAILURE );
+		}
+		if( fixed_seed )
+		{
+			server->setSeed( seed );
+		}
+		server->setParent( app );
+	}
+	else if( render_out.isEmpty() )
 	{
 		// init style and palette
 		QApplication::setStyle( new LmmsStyle() );
@@ -462,6 +516,13 @@ int main( int argc, char * * argv )
 	{
 		// we're going to render our song
 		engine::init( false );
+		if( fixed_seed )
+		{
+			// after init as shared libraries might have called
+			// srand() and before loading as e.g. organic randomizes
+			// its settings when instantiated
+			srand( seed );
+		}
 		printf( "loading project...\n" );
 		engine::getSong()->loadProject( file_to_load );
 		printf( "done\n" );
@@ -472,6 +533,7 @@ int main( int argc, char * * argv )
 				QString( ( eff ==
 					ProjectRenderer::WaveFile ) ?
 						"wav" : "ogg" ) );
+		r->setProfiling( profile );
 		QCoreApplication::instance()->connect( r,
 				SIGNAL( finished() ), SLOT( quit() ) );
 
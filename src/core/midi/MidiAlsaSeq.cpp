@@ -303,6 +303,8 @@ void MidiAlsaSeq::applyPortMode( MidiPort * _port )
 		}
 	}
 
+	updatePortRoutes();
+
 	m_seqMutex.unlock();
 }
 
@@ -343,9 +345,10 @@ void MidiAlsaSeq::removePort( MidiPort * _port )
 		m_seqMutex.lock();
 		snd_seq_delete_simple_port( m_seqHandle, m_portIDs[_port][0] );
 		snd_seq_delete_simple_port( m_seqHandle, m_portIDs[_port][1] );
-		m_seqMutex.unlock();
 
 		m_portIDs.remove( _port );
+		updatePortRoutes();
+		m_seqMutex.unlock();
 	}
 	MidiClient::removePort( _port );
 }
@@ -461,6 +464,39 @@ void MidiAlsaSeq::subscribeWritablePort( MidiPort * _port,
 
 
 
+void MidiAlsaSeq::updatePortRoutes()
+{
+	int max_id = -1;
+	for( QMap<MidiPort *, Ports>::Iterator it = m_portIDs.begin();
+						it != m_portIDs.end(); ++it )
+	{
+		max_id = qMax( max_id, qMax( ( *it )[0], ( *it )[1] ) );
+	}
+
+	const PortRoute empty = { NULL, false };
+	m_portRoutes.fill( empty, max_id + 1 );
+
+	for( QMap<MidiPort *, Ports>::Iterator it = m_portIDs.begin();
+						it != m_portIDs.end(); ++it )
+	{
+		for( int i = 0; i < 2; ++i )
+		{
+			if( ( *it )[i] >= 0 )
+			{
+				m_portRoutes[( *it )[i]].ours = true;
+			}
+		}
+		// events are received on the first (writable) port only
+		if( ( *it )[0] >= 0 )
+		{
+			m_portRoutes[( *it )[0]].dest = it.key();
+		}
+	}
+}
+
+
+
+
 void MidiAlsaSeq::run()
 {
 	// watch the pipe and sequencer input events
@@ -509,29 +545,29 @@ void MidiAlsaSeq::run()
 			qCritical( "error while fetching MIDI event from sequencer" );
 			break;
 		}
-		m_seqMutex.unlock();
 
 		snd_seq_addr_t * source = NULL;
 		MidiPort * dest = NULL;
-		for( int i = 0; i < m_portIDs.size(); ++i )
+		if( ev->dest.port < m_portRoutes.size() )
 		{
-			if( m_portIDs.values()[i][0] == ev->dest.port )
-			{
-				dest = m_portIDs.keys()[i];
-			}
-			if( ( m_portIDs.values()[i][1] != -1 &&
-					m_portIDs.values()[i][1] == ev->source.port ) ||
-						m_portIDs.values()[i][0] == ev->source.port )
-			{
-				source = &ev->source;
-			}
+			dest = m_portRoutes[ev->dest.port].dest;
 		}
+		if( ev->source.port < m_portRoutes.size() &&
+					m_portRoutes[ev->source.port].ours )
+		{
+			source = &ev->source;
+		}
+
+		m_seqMutex.unlock();
 
 		if( dest == NULL )
 		{
+			m_seqMutex.lock();
 			continue;
 		}
 
+		// events are timestamped by MidiPort when being queued, so
+		// ALSA's (relative) tick-time isn't used
 		switch( ev->type )
 		{
 			case SND_SEQ_EVENT_NOTEON:
@@ -542,7 +578,7 @@ void MidiAlsaSeq::run()
 							ev->data.note.velocity,
 							source
 							),
-						midiTime( ev->time.tick ) );
+						midiTime() );
 				break;
 
 			case SND_SEQ_EVENT_NOTEOFF:
@@ -553,7 +589,7 @@ void MidiAlsaSeq::run()
 							ev->data.note.velocity,
 							source
 							),
-						midiTime( ev->time.tick) );
+						midiTime() );
 				break;
 
 			case SND_SEQ_EVENT_KEYPRESS:
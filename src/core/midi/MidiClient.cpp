@@ -25,6 +25,8 @@
 
 #include "MidiClient.h"
 #include "MidiPort.h"
+#include "engine.h"
+#include "Mixer.h"
 #include "templates.h"
 #include "note.h"
 
@@ -60,7 +62,10 @@ void MidiClient::applyPortName( MidiPort * )
 
 void MidiClient::addPort( MidiPort * _port )
 {
+	// list of ports is iterated by mixer in processQueuedInEvents()
+	engine::mixer()->lock();
 	m_midiPorts.push_back( _port );
+	engine::mixer()->unlock();
 }
 
 
@@ -68,12 +73,27 @@ void MidiClient::addPort( MidiPort * _port )
 
 void MidiClient::removePort( MidiPort * _port )
 {
+	engine::mixer()->lock();
 	QVector<MidiPort *>::Iterator it =
 		qFind( m_midiPorts.begin(), m_midiPorts.end(), _port );
 	if( it != m_midiPorts.end() )
 	{
 		m_midiPorts.erase( it );
 	}
+	engine::mixer()->unlock();
+}
+
+
+
+
+void MidiClient::processQueuedInEvents( const int64_t _period_start )
+{
+	// mixer is locked by caller
+	for( QVector<MidiPort *>::Iterator it = m_midiPorts.begin();
+						it != m_midiPorts.end(); ++it )
+	{
+		( *it )->processQueuedInEvents( _period_start );
+	}
 }
 
 
@@ -25,8 +25,13 @@
 
 #include <QtXml/QDomElement>
 
+#include <cstring>
+
 #include "MidiPort.h"
 #include "MidiClient.h"
+#include "MicroTimer.h"
+#include "engine.h"
+#include "Mixer.h"
 #include "song.h"
 
 
@@ -40,6 +45,7 @@ MidiPort::MidiPort( const QString & _name, MidiClient * _mc,
 	m_midiClient( _mc ),
 	m_midiEventProcessor( _mep ),
 	m_mode( _mode ),
+	m_inEvents(),
 	m_inputChannelModel( 0, 0, MidiChannelCount, this,
 						tr( "Input channel" ) ),
 	m_outputChannelModel( 1, 1, MidiChannelCount, this,
@@ -147,7 +153,117 @@ void MidiPort::processInEvent( const midiEvent & _me, const midiTime & _time )
 		}
 
 		ev.setFromMidiPort( true );
-		m_midiEventProcessor->processInEvent( ev, _time );
+
+		// do not process event right now as this would require locking
+		// the mixer and the event could only be played at the
+		// beginning of next period anyway
+		QueuedInEvent qe = { ev, _time, MicroTimer::now() };
+		if( !m_inEvents.write( qe ) )
+		{
+			qWarning( "MidiPort: input-queue of %s is full, "
+					"dropping event",
+					qPrintable( displayName() ) );
+		}
+	}
+}
+
+
+
+
+// returns whether only the last of several events of this kind within one
+// period matters - not the case for switches, mode-messages and controllers
+// which are part of a sequence like (N)RPN
+static bool isCoalescable( const midiEvent & _me )
+{
+	switch( _me.m_type )
+	{
+		case MidiPitchBend:
+		case MidiChannelPressure:
+			return true;
+
+		case MidiControlChange:
+		{
+			const int c = _me.controllerNumber();
+			return ( c < MidiControllerSustain &&
+					c != MidiControllerBankSelect &&
+					c != MidiControllerBankSelect + 32 &&
+					c != MidiControllerDataEntry &&
+					c != MidiControllerDataEntry + 32 ) ||
+				( c > MidiControllerLegatoFootswitch + 1 &&
+								c < 96 );
+		}
+
+		default:
+			return false;
+	}
+}
+
+
+
+
+void MidiPort::processQueuedInEvents( const int64_t _period_start )
+{
+	// only called by mixer-thread, so one buffer is enough for all ports
+	static QueuedInEvent events[InEventQueueSize];
+	static bool skip[InEventQueueSize];
+
+	int count = 0;
+	while( count < InEventQueueSize && m_inEvents.read( events[count] ) )
+	{
+		++count;
+	}
+	if( count == 0 )
+	{
+		return;
+	}
+
+	// walk backwards and drop controller-changes and pitch-bends if
+	// there's a later one for the same controller and channel - notes
+	// in between act as barrier as they might depend on the values
+	bool seen_cc[MidiChannelCount][MidiControllerCount];
+	bool seen_other[MidiChannelCount][2];
+	memset( seen_cc, 0, sizeof( seen_cc ) );
+	memset( seen_other, 0, sizeof( seen_other ) );
+	for( int i = count - 1; i >= 0; --i )
+	{
+		const midiEvent & ev = events[i].event;
+		skip[i] = false;
+		if( ev.m_type == MidiNoteOn || ev.m_type == MidiNoteOff )
+		{
+			memset( seen_cc, 0, sizeof( seen_cc ) );
+			memset( seen_other, 0, sizeof( seen_other ) );
+			continue;
+		}
+		if( !isCoalescable( ev ) ||
+			ev.channel() < 0 || ev.channel() >= MidiChannelCount )
+		{
+			continue;
+		}
+		bool & seen = ev.m_type == MidiControlChange ?
+			seen_cc[ev.channel()][ev.controllerNumber()] :
+			seen_other[ev.channel()][ev.m_type == MidiPitchBend];
+		skip[i] = seen;
+		seen = true;
+	}
+
+	const fpp_t fpp = engine::mixer()->framesPerPeriod();
+	const int64_t sample_rate = engine::mixer()->processingSampleRate();
+
+	// everything received during last period is played one period later
+	// at the same position, i.e. latency is constant instead of
+	// depending on when event arrived
+	for( int i = 0; i < count; ++i )
+	{
+		if( skip[i] )
+		{
+			continue;
+		}
+		QueuedInEvent & qe = events[i];
+		const int64_t offset = ( qe.timestamp - _period_start ) *
+						sample_rate / ( 1000 * 1000 );
+		qe.event.setOffset( (f_cnt_t) qBound<int64_t>( 0, offset,
+								fpp - 1 ) );
+		m_midiEventProcessor->processInEvent( qe.event, qe.time );
 	}
 }
 
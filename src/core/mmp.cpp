@@ -32,8 +32,12 @@
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QTextStream>
+#include <QtCore/QXmlStreamReader>
 #include <QtGui/QMessageBox>
 
+#include <cstring>
+#include <zlib.h>
+
 
 #include "config_mgr.h"
 #include "project_version.h"
@@ -62,6 +66,108 @@ multimediaProject::typeDescStruct
 
 
 
+// read-only device which inflates data compressed by qCompress() (32 bit
+// big endian length followed by a zlib-stream) while reading from an
+// underlying device
+class InflatingDevice : public QIODevice
+{
+public:
+	InflatingDevice( QIODevice * _src ) :
+		QIODevice(),
+		m_src( _src ),
+		m_finished( false )
+	{
+		memset( &m_stream, 0, sizeof( m_stream ) );
+		m_stream.zalloc = Z_NULL;
+		m_stream.zfree = Z_NULL;
+		m_stream.opaque = Z_NULL;
+		m_ok = inflateInit( &m_stream ) == Z_OK;
+		// skip size-header
+		char header[4];
+		m_ok = m_ok && m_src->read( header, sizeof( header ) ) ==
+							sizeof( header );
+		open( QIODevice::ReadOnly );
+	}
+
+	virtual ~InflatingDevice()
+	{
+		inflateEnd( &m_stream );
+	}
+
+	virtual bool isSequential() const
+	{
+		return true;
+	}
+
+	virtual bool atEnd() const
+	{
+		return m_finished && QIODevice::atEnd();
+	}
+
+
+protected:
+	virtual qint64 readData( char * _data, qint64 _maxlen )
+	{
+		if( !m_ok || m_finished )
+		{
+			return m_ok ? 0 : -1;
+		}
+
+		m_stream.next_out = (Bytef *) _data;
+		m_stream.avail_out = _maxlen;
+		while( m_stream.avail_out > 0 && !m_finished )
+		{
+			if( m_stream.avail_in == 0 )
+			{
+				const qint64 read = m_src->read( m_inBuf,
+							sizeof( m_inBuf ) );
+				if( read <= 0 )
+				{
+					// truncated stream
+					m_ok = false;
+					break;
+				}
+				m_stream.next_in = (Bytef *) m_inBuf;
+				m_stream.avail_in = read;
+			}
+			const int ret = inflate( &m_stream, Z_NO_FLUSH );
+			if( ret == Z_STREAM_END )
+			{
+				m_finished = true;
+			}
+			else if( ret != Z_OK )
+			{
+				m_ok = false;
+				break;
+			}
+		}
+
+		const qint64 produced = _maxlen - m_stream.avail_out;
+		if( produced == 0 && !m_ok )
+		{
+			return -1;
+		}
+		return produced;
+	}
+
+	virtual qint64 writeData( const char *, qint64 )
+	{
+		return -1;
+	}
+
+
+private:
+	QIODevice * m_src;
+	z_stream m_stream;
+	char m_inBuf[64*1024];
+	bool m_ok;
+	bool m_finished;
+
+} ;
+
+
+
+
 multimediaProject::multimediaProject( ProjectTypes _project_type ) :
 	QDomDocument( "multimedia-project" ),
 	m_content(),
@@ -105,7 +211,20 @@ multimediaProject::multimediaProject( const QString & _fileName ) :
 			return;
 	}
 
-	loadData( inFile.readAll(), _fileName );
+	QString errorMsg;
+	int line = -1, col = -1;
+	if( !loadStream( inFile, errorMsg, line, col ) )
+	{
+		qWarning() << "at line" << line << "column" << col << ":" << errorMsg;
+		QMessageBox::critical( NULL,
+			songEditor::tr( "Error in file" ),
+			songEditor::tr( "The file %1 seems to contain "
+					"errors and therefore can't be "
+					"loaded." ).arg( _fileName ) );
+		return;
+	}
+
+	finishLoading();
 }
 
 
@@ -716,7 +835,7 @@ void multimediaProject::loadData( const QByteArray & _data,
 		}
 		if( line >= 0 && col >= 0 )
 		{
-			qWarning() << "at line" << line << "column" << errorMsg;
+			qWarning() << "at line" << line << "column" << col << ":" << errorMsg;
 			QMessageBox::critical( NULL,
 				songEditor::tr( "Error in file" ),
 				songEditor::tr( "The file %1 seems to contain "
@@ -727,6 +846,111 @@ void multimediaProject::loadData( const QByteArray & _data,
 		}
 	}
 
+	finishLoading();
+}
+
+
+
+
+bool multimediaProject::loadStream( QIODevice & _dev, QString & _errorMsg,
+							int & _line, int & _col )
+{
+	// uncompressed projects start with an XML-declaration or at least
+	// with some tag, everything else is considered to be compressed
+	char first = 0;
+	_dev.peek( &first, 1 );
+	const bool compressed = first != '<' && first != '\xef' &&
+				!QChar( first ).isSpace();
+
+	InflatingDevice * inflater = compressed ?
+					new InflatingDevice( &_dev ) : NULL;
+	QXmlStreamReader reader( compressed ? (QIODevice *) inflater : &_dev );
+
+	buildDocument( reader );
+
+	delete inflater;
+
+	if( reader.hasError() )
+	{
+		_errorMsg = reader.errorString();
+		_line = reader.lineNumber();
+		_col = reader.columnNumber();
+		clear();
+		return false;
+	}
+
+	return !documentElement().isNull();
+}
+
+
+
+
+void multimediaProject::buildDocument( QXmlStreamReader & _reader )
+{
+	// DOM-nodes are created while the file is being parsed so that the
+	// file never has to be held in memory as a whole
+	QDomNode parent = *this;
+	while( !_reader.atEnd() )
+	{
+		switch( _reader.readNext() )
+		{
+			case QXmlStreamReader::StartElement:
+			{
+				QDomElement e = createElement(
+					_reader.name().toString() );
+				const QXmlStreamAttributes attrs =
+							_reader.attributes();
+				for( QXmlStreamAttributes::ConstIterator it =
+								attrs.begin();
+						it != attrs.end(); ++it )
+				{
+					e.setAttribute( it->name().toString(),
+						it->value().toString() );
+				}
+				parent.appendChild( e );
+				parent = e;
+				break;
+			}
+			case QXmlStreamReader::EndElement:
+				parent = parent.parentNode();
+				break;
+			case QXmlStreamReader::Characters:
+				// QDomDocument::setContent() also drops
+				// whitespace-only text
+				if( _reader.isCDATA() )
+				{
+					parent.appendChild( createCDATASection(
+						_reader.text().toString() ) );
+				}
+				else if( !_reader.isWhitespace() )
+				{
+					parent.appendChild( createTextNode(
+						_reader.text().toString() ) );
+				}
+				break;
+			case QXmlStreamReader::Comment:
+				parent.appendChild( createComment(
+						_reader.text().toString() ) );
+				break;
+			case QXmlStreamReader::ProcessingInstruction:
+				parent.appendChild(
+					createProcessingInstruction(
+					_reader.processingInstructionTarget().
+								toString(),
+					_reader.processingInstructionData().
+							toString() ) );
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+
+
+
+void multimediaProject::finishLoading()
+{
 	QDomElement root = documentElement();
 	m_type = type( root.attribute( "type" ) );
 	m_head = root.elementsByTagName( "head" ).item( 0 ).toElement();
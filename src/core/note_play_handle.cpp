@@ -30,6 +30,7 @@
 #include "InstrumentSoundShaping.h"
 #include "InstrumentTrack.h"
 #include "MidiPort.h"
+#include "OfflineRenderContext.h"
 #include "song.h"
 
 
@@ -48,7 +49,8 @@ notePlayHandle::notePlayHandle( InstrumentTrack * _it,
 						const f_cnt_t _frames,
 						const note & _n,
 						notePlayHandle *parent,
-						const bool _part_of_arp ) :
+						const bool _part_of_arp,
+						OfflineRenderContext * _render_context ) :
 	playHandle( NotePlayHandle, _offset ),
 	note( _n.length(), _n.pos(), _n.key(),
 			_n.getVolume(), _n.getPanning(), _n.detuning() ),
@@ -64,6 +66,13 @@ notePlayHandle::notePlayHandle( InstrumentTrack * _it,
 	m_topNote( parent == NULL  ),
 	m_partOfArpeggio( _part_of_arp ),
 	m_muted( false ),
+	m_parent( parent ),
+	m_isVoice( false ),
+	m_stolen( false ),
+	m_fadingOut( false ),
+	m_fadedOut( false ),
+	m_silentPeriods( 0 ),
+	m_silent( false ),
 	m_bbTrack( NULL ),
 #ifdef LMMS_SINGERBOT_SUPPORT
 	m_patternIndex( 0 ),
@@ -73,16 +82,22 @@ notePlayHandle::notePlayHandle( InstrumentTrack * _it,
 	m_frequency( 0 ),
 	m_unpitchedFrequency( 0 ),
 	m_baseDetuning( NULL ),
-	m_songGlobalParentOffset( 0 )
+	m_songGlobalParentOffset( 0 ),
+	m_renderContext( _render_context )
 {
 	if( isTopNote() )
 	{
 		m_baseDetuning = new BaseDetuning( detuning() );
-		m_instrumentTrack->m_processHandles.push_back( this );
+		// notes rendered offline must not be visible to the track
+		if( m_renderContext == NULL )
+		{
+			m_instrumentTrack->m_processHandles.push_back( this );
+		}
 	}
 	else
 	{
 		m_baseDetuning = parent->m_baseDetuning;
+		m_renderContext = parent->m_renderContext;
 
 		parent->m_subNotes.push_back( this );
 		// if there was an arp-note added and parent is a base-note
@@ -100,8 +115,16 @@ notePlayHandle::notePlayHandle( InstrumentTrack * _it,
 
 	setFrames( _frames );
 
+	// arpeggio-base-notes don't sound themselves so they're not subject
+	// to voice-limits - this might steal other notes of the track
+	if( m_renderContext == NULL && !isArpeggioBaseNote() )
+	{
+		m_isVoice = true;
+		m_instrumentTrack->addVoice( this );
+	}
 
-	if( !isTopNote() || !instrumentTrack()->isArpeggioEnabled() )
+	if( m_renderContext == NULL &&
+		( !isTopNote() || !instrumentTrack()->isArpeggioEnabled() ) )
 	{
 		// send MIDI-note-on-event
 		m_instrumentTrack->processOutEvent( midiEvent( MidiNoteOn,
@@ -119,10 +142,18 @@ notePlayHandle::~notePlayHandle()
 {
 	noteOff( 0 );
 
+	if( m_isVoice )
+	{
+		m_instrumentTrack->removeVoice( this );
+	}
+
 	if( isTopNote() )
 	{
 		delete m_baseDetuning;
-		m_instrumentTrack->m_processHandles.removeAll( this );
+		if( m_renderContext == NULL )
+		{
+			m_instrumentTrack->m_processHandles.removeAll( this );
+		}
 	}
 
 	if( m_pluginData != NULL )
@@ -151,6 +182,10 @@ notePlayHandle::~notePlayHandle()
 void notePlayHandle::setVolume( const volume_t _volume )
 {
 	note::setVolume( _volume );
+	if( m_renderContext != NULL )
+	{
+		return;
+	}
 	m_instrumentTrack->processOutEvent( midiEvent( MidiKeyPressure,
 			m_instrumentTrack->midiPort()->realOutputChannel(),
 						midiKey(), midiVelocity() ), 0 );
@@ -183,13 +218,25 @@ int notePlayHandle::midiKey() const
 
 void notePlayHandle::play( sampleFrame * _working_buffer )
 {
+	// a stolen note is played for one more period while
+	// InstrumentTrack::processAudioBuffer() fades it out
+	if( m_stolen && !m_fadingOut )
+	{
+		m_fadingOut = true;
+		for( NotePlayHandleList::Iterator it = m_subNotes.begin();
+						it != m_subNotes.end(); ++it )
+		{
+			( *it )->steal();
+		}
+	}
+
 	if( m_muted )
 	{
+		m_fadedOut = m_fadingOut;
 		return;
 	}
 
-	if( m_released == false &&
-		instrumentTrack()->isSustainPedalPressed() == false &&
+	if( m_released == false && isSustained() == false &&
 		m_totalFramesPlayed + engine::mixer()->framesPerPeriod()
 								>= m_frames )
 	{
@@ -199,7 +246,7 @@ void notePlayHandle::play( sampleFrame * _working_buffer )
 	// under some circumstances we're called even if there's nothing to play
 	// therefore do an additional check which fixes crash e.g. when
 	// decreasing release of an instrument-track while the note is active
-	if( framesLeft() > 0 )
+	if( framesLeft() > 0 && !m_silent )
 	{
 		// play note!
 		m_instrumentTrack->playNote( this, _working_buffer );
@@ -286,6 +333,8 @@ void notePlayHandle::play( sampleFrame * _working_buffer )
 
 	// update internal data
 	m_totalFramesPlayed += engine::mixer()->framesPerPeriod();
+
+	m_fadedOut = m_fadingOut;
 }
 
 
@@ -293,7 +342,7 @@ void notePlayHandle::play( sampleFrame * _working_buffer )
 
 f_cnt_t notePlayHandle::framesLeft() const
 {
-	if( instrumentTrack()->isSustainPedalPressed() )
+	if( isSustained() )
 	{
 		return 4*engine::mixer()->framesPerPeriod();
 	}
@@ -339,7 +388,8 @@ void notePlayHandle::noteOff( const f_cnt_t _s )
 	m_releaseFramesToDo = qMax<f_cnt_t>( 0, // 10,
 			m_instrumentTrack->m_soundShaping.releaseFrames() );
 
-	if( !isTopNote() || !instrumentTrack()->isArpeggioEnabled() )
+	if( m_renderContext == NULL &&
+		( !isTopNote() || !instrumentTrack()->isArpeggioEnabled() ) )
 	{
 		// send MIDI-note-off-event
 		m_instrumentTrack->processOutEvent( midiEvent( MidiNoteOff,
@@ -407,10 +457,35 @@ void notePlayHandle::mute()
 
 
 
+void notePlayHandle::reportOutputLevel( const float _peak )
+{
+	if( !m_released || _peak >= engine::mixer()->silenceThreshold() )
+	{
+		m_silentPeriods = 0;
+	}
+	else if( ++m_silentPeriods >= engine::mixer()->silentPeriods() )
+	{
+		m_silent = true;
+	}
+}
+
+
+
+
+void notePlayHandle::steal()
+{
+	if( m_isVoice && !m_stolen )
+	{
+		m_instrumentTrack->stealVoice( this );
+	}
+}
+
+
+
+
 int notePlayHandle::index() const
 {
-	const PlayHandleList & playHandles =
-					engine::mixer()->playHandles();
+	const PlayHandleList & playHandles = siblingPlayHandles();
 	int idx = 0;
 	for( PlayHandleList::ConstIterator it = playHandles.begin();
 						it != playHandles.end(); ++it )
@@ -438,11 +513,22 @@ int notePlayHandle::index() const
 ConstNotePlayHandleList notePlayHandle::nphsOfInstrumentTrack(
 				const InstrumentTrack * _it, bool _all_ph )
 {
-	const PlayHandleList & playHandles = engine::mixer()->playHandles();
+	return nphsOfInstrumentTrack( _it, engine::mixer()->playHandles(),
+								_all_ph );
+}
+
+
+
+
+ConstNotePlayHandleList notePlayHandle::nphsOfInstrumentTrack(
+				const InstrumentTrack * _it,
+				const PlayHandleList & _play_handles,
+				bool _all_ph )
+{
 	ConstNotePlayHandleList cnphv;
 
-	for( PlayHandleList::ConstIterator it = playHandles.begin();
-						it != playHandles.end(); ++it )
+	for( PlayHandleList::ConstIterator it = _play_handles.begin();
+						it != _play_handles.end(); ++it )
 	{
 		const notePlayHandle * nph =
 				dynamic_cast<const notePlayHandle *>( *it );
@@ -458,6 +544,27 @@ ConstNotePlayHandleList notePlayHandle::nphsOfInstrumentTrack(
 
 
 
+const PlayHandleList & notePlayHandle::siblingPlayHandles() const
+{
+	if( m_renderContext != NULL )
+	{
+		return m_renderContext->playHandles();
+	}
+	return engine::mixer()->playHandles();
+}
+
+
+
+
+bool notePlayHandle::isSustained() const
+{
+	return m_renderContext == NULL &&
+			instrumentTrack()->isSustainPedalPressed();
+}
+
+
+
+
 bool notePlayHandle::operator==( const notePlayHandle & _nph ) const
 {
 	return length() == _nph.length() &&
@@ -56,6 +56,7 @@
 #include "project_notes.h"
 #include "ProjectRenderer.h"
 #include "rename_dialog.h"
+#include "SampleCache.h"
 #include "song_editor.h"
 #include "templates.h"
 #include "text_float.h"
@@ -1098,7 +1099,7 @@ void song::createNewProjectFromTemplate( const QString & _template )
 
 
 // load given song
-void song::loadProject( const QString & _file_name )
+bool song::loadProject( const QString & _file_name )
 {
 	m_loadingProject = true;
 
@@ -1115,9 +1116,12 @@ void song::loadProject( const QString & _file_name )
 	if( mmp.head().isNull() )
 	{
 		createNewProject();
-		return;
+		return false;
 	}
 
+	// decode all samples in background while we're loading
+	SampleCache::inst()->prefetchProject( mmp.content() );
+
 	engine::mixer()->lock();
 
 	// get the header information from the DOM
@@ -1210,6 +1214,8 @@ void song::loadProject( const QString & _file_name )
 
 	engine::mixer()->unlock();
 
+	SampleCache::inst()->finishPrefetch();
+
 	configManager::inst()->addRecentlyOpenedProject( _file_name );
 
 	engine::projectJournal()->setJournalling( true );
@@ -1223,6 +1229,8 @@ void song::loadProject( const QString & _file_name )
 	{
 		engine::mainWindow()->resetWindowTitle();
 	}
+
+	return true;
 }
 
 
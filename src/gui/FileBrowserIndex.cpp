@@ -0,0 +1,493 @@
+/*
+ * FileBrowserIndex.cpp - scans directories for file-browsers in background
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+
+#include "FileBrowserIndex.h"
+#include "config_mgr.h"
+
+
+static const char * INDEX_FILE = "browserindex.dat";
+static const quint32 INDEX_MAGIC = 0x4c4c4249;	// "LLBI"
+
+
+
+QDataStream & operator<<( QDataStream & _s,
+				const FileBrowserIndex::Listing & _l )
+{
+	return _s << _l.dirs << _l.lockedDirs << _l.files << _l.modified;
+}
+
+
+
+
+QDataStream & operator>>( QDataStream & _s, FileBrowserIndex::Listing & _l )
+{
+	return _s >> _l.dirs >> _l.lockedDirs >> _l.files >> _l.modified;
+}
+
+
+
+
+FileBrowserIndex::FileBrowserIndex() :
+	QThread(),
+	m_mutex(),
+	m_requestAvailable(),
+	m_listings(),
+	m_dirty( false ),
+	m_urgentRequests(),
+	m_requests(),
+	m_quit( false ),
+	m_crawled(),
+	m_watcher( new QFileSystemWatcher( this ) ),
+	m_watchCount()
+{
+	connect( m_watcher, SIGNAL( directoryChanged( const QString & ) ),
+			this, SLOT( directoryChanged( const QString & ) ) );
+}
+
+
+
+
+FileBrowserIndex::~FileBrowserIndex()
+{
+	stop();
+}
+
+
+
+
+FileBrowserIndex * FileBrowserIndex::inst()
+{
+	static FileBrowserIndex * s_inst = NULL;
+	if( s_inst == NULL )
+	{
+		s_inst = new FileBrowserIndex;
+		connect( QCoreApplication::instance(), SIGNAL( aboutToQuit() ),
+						s_inst, SLOT( stop() ) );
+		s_inst->start( QThread::LowPriority );
+	}
+	return s_inst;
+}
+
+
+
+
+bool FileBrowserIndex::listing( const QString & _path, Listing & _listing )
+{
+	const QString path = QDir::cleanPath( _path );
+
+	m_mutex.lock();
+	const bool found = m_listings.contains( path );
+	if( found )
+	{
+		_listing = m_listings[path];
+	}
+
+	// check for changes in any case and tell caller about contents once
+	// they're known
+	Request r;
+	r.path = path;
+	r.force = false;
+	r.notify = !found;
+	r.crawl = false;
+	addRequest( m_urgentRequests, r );
+	m_mutex.unlock();
+
+	return found;
+}
+
+
+
+
+void FileBrowserIndex::requestScan( const QString & _path, const bool _urgent,
+							const bool _force )
+{
+	Request r;
+	r.path = QDir::cleanPath( _path );
+	r.force = _force;
+	r.notify = false;
+	r.crawl = false;
+
+	QMutexLocker ml( &m_mutex );
+	addRequest( _urgent ? m_urgentRequests : m_requests, r );
+}
+
+
+
+
+void FileBrowserIndex::crawl( const QString & _path )
+{
+	Request r;
+	r.path = QDir::cleanPath( _path );
+	r.force = false;
+	r.notify = false;
+	r.crawl = true;
+
+	QMutexLocker ml( &m_mutex );
+	addRequest( m_requests, r );
+}
+
+
+
+
+void FileBrowserIndex::watch( const QString & _path )
+{
+	const QString path = QDir::cleanPath( _path );
+	if( m_watchCount[path]++ == 0 )
+	{
+		m_watcher->addPath( path );
+	}
+}
+
+
+
+
+void FileBrowserIndex::unwatch( const QString & _path )
+{
+	const QString path = QDir::cleanPath( _path );
+	QHash<QString, int>::Iterator it = m_watchCount.find( path );
+	if( it == m_watchCount.end() )
+	{
+		return;
+	}
+	if( --it.value() <= 0 )
+	{
+		// nobody else is showing this directory
+		m_watchCount.erase( it );
+		m_watcher->removePath( path );
+	}
+}
+
+
+
+
+bool FileBrowserIndex::containsMatch( const QString & _path,
+						const QString & _filter,
+						const QString & _patterns )
+{
+	QMutexLocker ml( &m_mutex );
+	return containsMatchLocked( QDir::cleanPath( _path ), _filter,
+								_patterns );
+}
+
+
+
+
+void FileBrowserIndex::directoryChanged( const QString & _path )
+{
+	requestScan( _path, true, true );
+}
+
+
+
+
+void FileBrowserIndex::stop()
+{
+	m_mutex.lock();
+	m_quit = true;
+	m_requestAvailable.wakeOne();
+	m_mutex.unlock();
+
+	wait();
+}
+
+
+
+
+void FileBrowserIndex::run()
+{
+	readIndex();
+
+	while( true )
+	{
+		m_mutex.lock();
+		if( m_quit )
+		{
+			const bool dirty = m_dirty;
+			m_mutex.unlock();
+			if( dirty )
+			{
+				writeIndex();
+			}
+			return;
+		}
+		while( m_urgentRequests.isEmpty() && m_requests.isEmpty() &&
+								!m_quit )
+		{
+			if( m_dirty )
+			{
+				// idle, so it's a good time for saving
+				m_mutex.unlock();
+				writeIndex();
+				m_mutex.lock();
+				continue;
+			}
+			m_requestAvailable.wait( &m_mutex );
+		}
+		if( m_quit )
+		{
+			// handled at beginning of loop
+			m_mutex.unlock();
+			continue;
+		}
+		const Request r = m_urgentRequests.isEmpty() ?
+					m_requests.takeFirst() :
+					m_urgentRequests.takeFirst();
+		m_mutex.unlock();
+
+		scan( r );
+	}
+}
+
+
+
+
+void FileBrowserIndex::addRequest( QList<Request> & _queue,
+						const Request & _request )
+{
+	for( QList<Request>::Iterator it = _queue.begin();
+						it != _queue.end(); ++it )
+	{
+		if( it->path == _request.path )
+		{
+			it->force |= _request.force;
+			it->notify |= _request.notify;
+			it->crawl |= _request.crawl;
+			return;
+		}
+	}
+	_queue.push_back( _request );
+	m_requestAvailable.wakeOne();
+}
+
+
+
+
+void FileBrowserIndex::scan( const Request & _request )
+{
+	const QFileInfo info( _request.path );
+
+	m_mutex.lock();
+	const bool known = m_listings.contains( _request.path );
+	Listing l = m_listings.value( _request.path );
+	m_mutex.unlock();
+
+	bool changed = false;
+	if( !known || _request.force || info.lastModified() != l.modified )
+	{
+		const Listing old = l;
+		l = Listing();
+		l.modified = info.lastModified();
+
+		QDir dir( _request.path );
+		if( dir.isReadable() )
+		{
+			const QFileInfoList entries = dir.entryInfoList(
+					QDir::Dirs | QDir::Files |
+						QDir::NoDotAndDotDot,
+								QDir::Name );
+			for( QFileInfoList::ConstIterator it = entries.begin();
+						it != entries.end(); ++it )
+			{
+				const QString name = it->fileName();
+				if( name[0] == '.' )
+				{
+					continue;
+				}
+				if( it->isDir() )
+				{
+					l.dirs << name;
+					if( !it->isReadable() )
+					{
+						l.lockedDirs << name;
+					}
+				}
+				else
+				{
+					l.files << name;
+				}
+			}
+		}
+
+		changed = !known || l.dirs != old.dirs ||
+					l.lockedDirs != old.lockedDirs ||
+						l.files != old.files;
+
+		m_mutex.lock();
+		m_listings[_request.path] = l;
+		m_dirty = true;
+		m_mutex.unlock();
+	}
+
+	if( changed || _request.notify )
+	{
+		emit directoryScanned( _request.path );
+	}
+
+	if( _request.crawl )
+	{
+		QMutexLocker ml( &m_mutex );
+		if( m_crawled.contains( info.canonicalFilePath() ) )
+		{
+			return;
+		}
+		m_crawled.insert( info.canonicalFilePath() );
+
+		for( QStringList::ConstIterator it = l.dirs.begin();
+						it != l.dirs.end(); ++it )
+		{
+			if( !l.lockedDirs.contains( *it ) )
+			{
+				Request r;
+				r.path = _request.path + QDir::separator() + *it;
+				r.force = false;
+				r.notify = false;
+				r.crawl = true;
+				m_requests.push_back( r );
+			}
+		}
+	}
+}
+
+
+
+
+bool FileBrowserIndex::containsMatchLocked( const QString & _path,
+						const QString & _filter,
+						const QString & _patterns )
+{
+	QHash<QString, Listing>::ConstIterator l = m_listings.find( _path );
+	if( l == m_listings.end() )
+	{
+		return false;
+	}
+
+	for( QStringList::ConstIterator it = l->files.begin();
+						it != l->files.end(); ++it )
+	{
+		if( it->contains( _filter, Qt::CaseInsensitive ) &&
+				QDir::match( _patterns, it->toLower() ) )
+		{
+			return true;
+		}
+	}
+
+	for( QStringList::ConstIterator it = l->dirs.begin();
+						it != l->dirs.end(); ++it )
+	{
+		if( it->contains( _filter, Qt::CaseInsensitive ) ||
+			containsMatchLocked( _path + QDir::separator() + *it,
+							_filter, _patterns ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+
+
+void FileBrowserIndex::readIndex()
+{
+	QFile f( configManager::inst()->workingDir() + INDEX_FILE );
+	if( !f.open( QFile::ReadOnly ) )
+	{
+		return;
+	}
+
+	QDataStream s( &f );
+	s.setVersion( QDataStream::Qt_4_0 );
+	quint32 magic = 0;
+	QHash<QString, Listing> listings;
+	s >> magic;
+	if( magic != INDEX_MAGIC )
+	{
+		return;
+	}
+	s >> listings;
+	if( s.status() != QDataStream::Ok )
+	{
+		// corrupt file - scan everything again
+		return;
+	}
+
+	// keep directories which were scanned meanwhile
+	QMutexLocker ml( &m_mutex );
+	for( QHash<QString, Listing>::ConstIterator it = listings.begin();
+						it != listings.end(); ++it )
+	{
+		if( !m_listings.contains( it.key() ) )
+		{
+			m_listings[it.key()] = *it;
+		}
+	}
+}
+
+
+
+
+void FileBrowserIndex::writeIndex()
+{
+	m_mutex.lock();
+	const QHash<QString, Listing> listings = m_listings;
+	m_dirty = false;
+	m_mutex.unlock();
+
+	// write to temporary file and rename it afterwards so that another
+	// instance starting concurrently never reads a partial file
+	const QString file = configManager::inst()->workingDir() + INDEX_FILE;
+	QFile f( file + ".tmp" );
+	if( !f.open( QFile::WriteOnly | QFile::Truncate ) )
+	{
+		return;
+	}
+
+	QDataStream s( &f );
+	s.setVersion( QDataStream::Qt_4_0 );
+	s << INDEX_MAGIC << listings;
+	f.close();
+
+	if( s.status() == QDataStream::Ok && f.error() == QFile::NoError )
+	{
+		QFile::remove( file );
+		f.rename( file );
+	}
+	else
+	{
+		f.remove();
+	}
+}
+
+
+
+#include "moc_FileBrowserIndex.cxx"
+
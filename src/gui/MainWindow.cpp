@@ -100,20 +100,20 @@ MainWindow::MainWindow( void ) :
 					"*.mmp *.mmpz *.xml *.mid *.flp",
 							tr( "My projects" ),
 					embed::getIconPixmap( "project_file" ),
-							splitter ) );
+							splitter, false, true ) );
 	sideBar->appendTab( new fileBrowser(
 				configManager::inst()->userSamplesDir() + "*" +
 				configManager::inst()->factorySamplesDir(),
 					"*", tr( "My samples" ),
 					embed::getIconPixmap( "sample_file" ),
-							splitter ) );
+							splitter, false, true ) );
 	sideBar->appendTab( new fileBrowser(
 				configManager::inst()->userPresetsDir() + "*" +
 				configManager::inst()->factoryPresetsDir(),
 					"*.xpf *.cs.xml *.xiz",
 					tr( "My presets" ),
 					embed::getIconPixmap( "preset_file" ),
-							splitter ) );
+							splitter, false, true ) );
 	sideBar->appendTab( new fileBrowser( QDir::homePath(), "*",
 							tr( "My home" ),
 					embed::getIconPixmap( "home" ),
@@ -29,6 +29,7 @@
 #include <QtGui/QLineEdit>
 #include <QtGui/QMenu>
 #include <QtGui/QPushButton>
+#include <QtGui/QTreeWidgetItemIterator>
 #include <QtGui/QMdiArea>
 #include <QtGui/QMdiSubWindow>
 
@@ -38,6 +39,7 @@
 #include "debug.h"
 #include "embed.h"
 #include "engine.h"
+#include "FileBrowserIndex.h"
 #include "gui_templates.h"
 #include "ImportFilter.h"
 #include "Instrument.h"
@@ -62,7 +64,8 @@ enum TreeWidgetItemTypes
 
 fileBrowser::fileBrowser( const QString & _directories, const QString & _filter,
 			const QString & _title, const QPixmap & _pm,
-			QWidget * _parent, bool _dirs_as_items ) :
+			QWidget * _parent, bool _dirs_as_items,
+							bool _index_all ) :
 	SideBarWidget( _title, _pm, _parent ),
 	m_directories( _directories ),
 	m_filter( _filter ),
@@ -94,6 +97,20 @@ fileBrowser::fileBrowser( const QString & _directories, const QString & _filter,
 
 	addContentWidget( ops );
 
+	connect( FileBrowserIndex::inst(),
+			SIGNAL( directoryScanned( const QString & ) ),
+			this, SLOT( directoryScanned( const QString & ) ) );
+	if( _index_all )
+	{
+		// allows searching everything without expanding directories
+		QStringList paths = m_directories.split( '*' );
+		for( QStringList::iterator it = paths.begin();
+						it != paths.end(); ++it )
+		{
+			FileBrowserIndex::inst()->crawl( *it );
+		}
+	}
+
 	reloadTree();
 	show();
 }
@@ -103,6 +120,11 @@ fileBrowser::fileBrowser( const QString & _directories, const QString & _filter,
 
 fileBrowser::~fileBrowser()
 {
+	for( QStringList::const_iterator it = m_watched.begin();
+						it != m_watched.end(); ++it )
+	{
+		FileBrowserIndex::inst()->unwatch( *it );
+	}
 }
 
 
@@ -149,9 +171,10 @@ void fileBrowser::filterItems( const QString & _filter )
 		}
 		else
 		{
-			// file matches filter?
+			// file or collapsed directory matches filter?
 			it->setHidden( !it->text( 0 ).
-				contains( _filter, Qt::CaseInsensitive ) );
+				contains( _filter, Qt::CaseInsensitive ) &&
+				!directoryContainsMatch( it, _filter ) );
 		}
 	
 	}
@@ -205,9 +228,10 @@ bool fileBrowser::filterItems( QTreeWidgetItem * _item, const QString & _filter
 		}
 		else
 		{
-			// file matches filter?
+			// file or collapsed directory matches filter?
 			cm = it->text( 0 ).
-				contains( _filter, Qt::CaseInsensitive );
+				contains( _filter, Qt::CaseInsensitive ) ||
+				directoryContainsMatch( it, _filter );
 			it->setHidden( !cm );
 		}
 	
@@ -223,15 +247,137 @@ bool fileBrowser::filterItems( QTreeWidgetItem * _item, const QString & _filter
 
 
 
+bool fileBrowser::directoryContainsMatch( QTreeWidgetItem * _item,
+						const QString & _filter )
+{
+	directory * d = dynamic_cast<directory *>( _item );
+	if( d == NULL )
+	{
+		return false;
+	}
+
+	// look into index as contents of directory aren't loaded yet
+	for( QStringList::const_iterator it = d->directories().begin();
+					it != d->directories().end(); ++it )
+	{
+		if( FileBrowserIndex::inst()->containsMatch(
+					d->fullName( *it ), _filter, m_filter ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
 void fileBrowser::reloadTree( void )
 {
 	m_filterEdit->clear();
+	m_l->clear();
+	for( QStringList::const_iterator it = m_watched.begin();
+						it != m_watched.end(); ++it )
+	{
+		FileBrowserIndex::inst()->unwatch( *it );
+	}
+	m_watched = m_directories.split( '*' );
+	for( QStringList::const_iterator it = m_watched.begin();
+						it != m_watched.end(); ++it )
+	{
+		// contents are shown as soon as they're scanned
+		FileBrowserIndex::inst()->requestScan( *it, true, true );
+		FileBrowserIndex::inst()->watch( *it );
+		addItems( *it );
+	}
+}
+
+
+
+
+void fileBrowser::rebuildTopLevelItems( void )
+{
+	QStringList expanded;
+	for( int i = 0; i < m_l->topLevelItemCount(); ++i )
+	{
+		if( m_l->topLevelItem( i )->isExpanded() )
+		{
+			expanded << m_l->topLevelItem( i )->text( 0 );
+		}
+	}
+
 	m_l->clear();
 	QStringList paths = m_directories.split( '*' );
 	for( QStringList::iterator it = paths.begin(); it != paths.end(); ++it )
 	{
 		addItems( *it );
 	}
+
+	for( int i = 0; i < m_l->topLevelItemCount(); ++i )
+	{
+		QTreeWidgetItem * it = m_l->topLevelItem( i );
+		if( expanded.contains( it->text( 0 ) ) )
+		{
+			it->setExpanded( true );
+		}
+	}
+
+	if( !m_filterEdit->text().isEmpty() )
+	{
+		filterItems( m_filterEdit->text() );
+	}
+}
+
+
+
+
+void fileBrowser::directoryScanned( const QString & _path )
+{
+	if( !m_dirsAsItems )
+	{
+		QStringList paths = m_directories.split( '*' );
+		for( QStringList::iterator it = paths.begin();
+						it != paths.end(); ++it )
+		{
+			if( QDir::cleanPath( *it ) == _path )
+			{
+				rebuildTopLevelItems();
+				return;
+			}
+		}
+	}
+
+	QList<directory *> dirs;
+	for( QTreeWidgetItemIterator it( m_l ); *it; ++it )
+	{
+		directory * d = dynamic_cast<directory *>( *it );
+		if( d == NULL || ( !d->isExpanded() && !d->childCount() ) )
+		{
+			continue;
+		}
+		for( QStringList::const_iterator p = d->directories().begin();
+					p != d->directories().end(); ++p )
+		{
+			if( QDir::cleanPath( d->fullName( *p ) ) == _path )
+			{
+				dirs << d;
+				break;
+			}
+		}
+	}
+
+	// a directory and one of its sub-directories never have the same path,
+	// so refreshing (and thereby deleting children) is safe here
+	for( QList<directory *>::iterator it = dirs.begin();
+						it != dirs.end(); ++it )
+	{
+		( *it )->refresh();
+	}
+
+	if( !dirs.isEmpty() && !m_filterEdit->text().isEmpty() )
+	{
+		filterItems( m_filterEdit->text() );
+	}
 }
 
 
@@ -246,12 +392,18 @@ void fileBrowser::addItems( const QString & _path )
 		return;
 	}
 
-	QDir cdir( _path );
-	QStringList files = cdir.entryList( QDir::Dirs, QDir::Name );
-	for( QStringList::const_iterator it = files.constBegin();
-						it != files.constEnd(); ++it )
+	FileBrowserIndex::Listing l;
+	if( !FileBrowserIndex::inst()->listing( _path, l ) )
+	{
+		// we'll be notified once contents are known
+		return;
+	}
+
+	for( QStringList::const_iterator it = l.dirs.constBegin();
+						it != l.dirs.constEnd(); ++it )
 	{
 		QString cur_file = *it;
+		const bool locked = l.lockedDirs.contains( cur_file );
 		if( cur_file[0] != '.' )
 		{
 			bool orphan = true;
@@ -263,7 +415,7 @@ void fileBrowser::addItems( const QString & _path )
 				{
 					m_l->insertTopLevelItem( i,
 						new directory( cur_file, _path,
-								m_filter ) );
+							m_filter, locked ) );
 					orphan = false;
 					break;
 				}
@@ -277,14 +429,13 @@ void fileBrowser::addItems( const QString & _path )
 			if( orphan )
 			{
 				m_l->addTopLevelItem( new directory( cur_file,
-							_path, m_filter ) );
+						_path, m_filter, locked ) );
 			}
 		}
 	}
 
-	files = cdir.entryList( QDir::Files, QDir::Name );
-	for( QStringList::const_iterator it = files.constBegin();
-						it != files.constEnd(); ++it )
+	for( QStringList::const_iterator it = l.files.constBegin();
+						it != l.files.constEnd(); ++it )
 	{
 		QString cur_file = *it;
 		if( cur_file[0] != '.' )
@@ -704,16 +855,19 @@ QPixmap * directory::s_folderLockedPixmap = NULL;
 
 
 directory::directory( const QString & _name, const QString & _path,
-						const QString & _filter ) :
+				const QString & _filter, bool _locked ) :
 	QTreeWidgetItem( QStringList( _name ), TypeDirectoryItem ),
 	m_directories( _path ),
-	m_filter( _filter )
+	m_filter( _filter ),
+	m_watched()
 {
 	initPixmaps();
 
 	setChildIndicatorPolicy( QTreeWidgetItem::ShowIndicator );
 
-	if( !QDir( fullName() ).isReadable() )
+	// readability is determined by FileBrowserIndex so we don't have to
+	// access the file-system here
+	if( _locked )
 	{
 		setIcon( 0, *s_folderLockedPixmap );
 	}
@@ -726,6 +880,18 @@ directory::directory( const QString & _name, const QString & _path,
 
 
 
+directory::~directory()
+{
+	for( QStringList::const_iterator it = m_watched.begin();
+						it != m_watched.end(); ++it )
+	{
+		FileBrowserIndex::inst()->unwatch( *it );
+	}
+}
+
+
+
+
 void directory::initPixmaps( void )
 {
 	if( s_folderPixmap == NULL )
@@ -755,28 +921,81 @@ void directory::update( void )
 	if( !isExpanded() )
 	{
 		setIcon( 0, *s_folderPixmap );
+		for( QStringList::const_iterator it = m_watched.begin();
+						it != m_watched.end(); ++it )
+		{
+			FileBrowserIndex::inst()->unwatch( *it );
+		}
+		m_watched.clear();
 		return;
 	}
 
 	setIcon( 0, *s_folderOpenedPixmap );
+	// update() is called on every expand, so only register paths we
+	// don't watch yet - directories might have been added meanwhile
+	for( QStringList::iterator it = m_directories.begin();
+					it != m_directories.end(); ++it )
+	{
+		const QString path = fullName( *it );
+		if( !m_watched.contains( path ) )
+		{
+			FileBrowserIndex::inst()->watch( path );
+			m_watched << path;
+		}
+	}
 	if( !childCount() )
 	{
-		for( QStringList::iterator it = m_directories.begin();
-					it != m_directories.end(); ++it )
+		populate();
+	}
+}
+
+
+
+
+void directory::refresh( void )
+{
+	QStringList expanded;
+	for( int i = 0; i < childCount(); ++i )
+	{
+		if( child( i )->isExpanded() )
 		{
-			int top_index = childCount();
-			if( addItems( fullName( *it ) ) &&
-				( *it ).contains(
-					configManager::inst()->dataDir() ) )
-			{
-				QTreeWidgetItem * sep = new QTreeWidgetItem;
-				sep->setText( 0,
-					fileBrowserTreeWidget::tr(
-						"--- Factory files ---" ) );
-				sep->setIcon( 0, embed::getIconPixmap(
-							"factory_files" ) );
-				insertChild( top_index, sep );
-			}
+			expanded << child( i )->text( 0 );
+		}
+	}
+
+	treeWidget()->setUpdatesEnabled( false );
+	qDeleteAll( takeChildren() );
+	populate();
+	for( int i = 0; i < childCount(); ++i )
+	{
+		if( expanded.contains( child( i )->text( 0 ) ) )
+		{
+			child( i )->setExpanded( true );
+		}
+	}
+	treeWidget()->setUpdatesEnabled( true );
+}
+
+
+
+
+void directory::populate( void )
+{
+	for( QStringList::iterator it = m_directories.begin();
+				it != m_directories.end(); ++it )
+	{
+		int top_index = childCount();
+		if( addItems( fullName( *it ) ) &&
+			( *it ).contains(
+				configManager::inst()->dataDir() ) )
+		{
+			QTreeWidgetItem * sep = new QTreeWidgetItem;
+			sep->setText( 0,
+				fileBrowserTreeWidget::tr(
+					"--- Factory files ---" ) );
+			sep->setIcon( 0, embed::getIconPixmap(
+						"factory_files" ) );
+			insertChild( top_index, sep );
 		}
 	}
 }
@@ -786,9 +1005,10 @@ void directory::update( void )
 
 bool directory::addItems( const QString & _path )
 {
-	QDir thisDir( _path );
-	if( !thisDir.isReadable() )
+	FileBrowserIndex::Listing l;
+	if( !FileBrowserIndex::inst()->listing( _path, l ) )
 	{
+		// contents are added by refresh() once they're known
 		return false;
 	}
 
@@ -796,11 +1016,11 @@ bool directory::addItems( const QString & _path )
 
 	bool added_something = false;
 
-	QStringList files = thisDir.entryList( QDir::Dirs, QDir::Name );
-	for( QStringList::const_iterator it = files.constBegin();
-						it != files.constEnd(); ++it )
+	for( QStringList::const_iterator it = l.dirs.constBegin();
+						it != l.dirs.constEnd(); ++it )
 	{
 		QString cur_file = *it;
+		const bool locked = l.lockedDirs.contains( cur_file );
 		if( cur_file[0] != '.' )
 		{
 			bool orphan = true;
@@ -811,7 +1031,7 @@ bool directory::addItems( const QString & _path )
 				if( d == NULL || cur_file < d->text( 0 ) )
 				{
 					insertChild( i, new directory( cur_file,
-							_path, m_filter ) );
+						_path, m_filter, locked ) );
 					orphan = false;
 					break;
 				}
@@ -825,7 +1045,7 @@ bool directory::addItems( const QString & _path )
 			if( orphan )
 			{
 				addChild( new directory( cur_file, _path,
-								m_filter ) );
+							m_filter, locked ) );
 			}
 
 			added_something = true;
@@ -833,13 +1053,12 @@ bool directory::addItems( const QString & _path )
 	}
 
 	QList<QTreeWidgetItem*> items;
-	files = thisDir.entryList( QDir::Files, QDir::Name );
-	for( QStringList::const_iterator it = files.constBegin();
-						it != files.constEnd(); ++it )
+	for( QStringList::const_iterator it = l.files.constBegin();
+						it != l.files.constEnd(); ++it )
 	{
 		QString cur_file = *it;
 		if( cur_file[0] != '.' &&
-				thisDir.match( m_filter, cur_file.toLower() ) )
+				QDir::match( m_filter, cur_file.toLower() ) )
 		{
 			items << new fileItem( cur_file, _path );
 			added_something = true;
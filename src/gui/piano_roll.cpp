@@ -170,7 +170,14 @@ pianoRoll::pianoRoll() :
 	m_editMode( ModeDraw ),
 	m_mouseDownLeft( false ),
 	m_mouseDownRight( false ),
-	m_scrollBack( false )
+	m_scrollBack( false ),
+	m_backgroundCache(),
+	m_notesCache(),
+	m_backgroundState( 0 ),
+	m_notesViewState( 0 ),
+	m_notesDirty( true ),
+	m_notesSorted( false ),
+	m_maxNoteLength( 0 )
 {
 	// gui names of edit modes
 	m_nemStr.push_back( tr( "Note Volume" ) );
@@ -718,9 +725,11 @@ void pianoRoll::setCurrentPattern( pattern * _new_pattern )
 	if( validPattern() )
 	{
 		m_pattern->instrumentTrack()->disconnect( this );
+		m_pattern->disconnect( this );
 	}
 
 	m_pattern = _new_pattern;
+	m_notesDirty = true;
 	m_currentPosition = 0;
 	m_currentNote = NULL;
 	m_startKey = INITIAL_START_KEY;
@@ -774,6 +783,8 @@ void pianoRoll::setCurrentPattern( pattern * _new_pattern )
 	connect( m_pattern->instrumentTrack()->pianoModel(),
 			SIGNAL( dataChanged() ),
 			this, SLOT( update() ) );
+	connect( m_pattern, SIGNAL( dataChanged() ),
+			this, SLOT( notesChanged() ) );
 
 	setWindowTitle( tr( "Piano-Roll - %1" ).arg( m_pattern->name() ) );
 
@@ -1105,6 +1116,7 @@ int pianoRoll::selectionCount() const // how many notes are selected?
 
 void pianoRoll::keyPressEvent( QKeyEvent* event )
 {
+	m_notesDirty = true;
 	if( validPattern() && event->modifiers() == Qt::NoModifier )
 	{
 		const int key_num = PianoView::getKeyFromKeyEvent( event ) + ( DefaultOctave - 1 ) * KeysPerOctave;
@@ -1476,9 +1488,18 @@ void pianoRoll::mousePressEvent( QMouseEvent * _me )
 		return;
 	}
 
+	m_notesDirty = true;
+
 	if( m_editMode == ModeEditDetuning && noteUnderMouse() )
 	{
-		noteUnderMouse()->editDetuningPattern();
+		note * n = noteUnderMouse();
+		n->editDetuningPattern();
+		// detuning is edited in automation-editor
+		QObject * detuning = n->detuning()->automationPattern();
+		disconnect( detuning, SIGNAL( dataChanged() ),
+					this, SLOT( notesChanged() ) );
+		connect( detuning, SIGNAL( dataChanged() ),
+					this, SLOT( notesChanged() ) );
 		return;
 	}
 	
@@ -1849,6 +1870,7 @@ void pianoRoll::mouseDoubleClickEvent( QMouseEvent * _me )
 	{
 		return;
 	}	
+	m_notesDirty = true;
 	
 	// if they clicked in the note edit area, clear selection
 	if( _me->x() > noteEditLeft() && _me->x() < noteEditRight()
@@ -2012,6 +2034,7 @@ void pianoRoll::computeSelectedNotes(bool shift)
 void pianoRoll::mouseReleaseEvent( QMouseEvent * _me )
 {
 	bool mustRepaint = false;
+	m_notesDirty = true;
 	
 	if( _me->button() & Qt::LeftButton )
 	{
@@ -2102,6 +2125,12 @@ void pianoRoll::mouseMoveEvent( QMouseEvent * _me )
 		update();
 		return;
 	}
+
+	// notes are only changed while dragging
+	if( _me->buttons() != Qt::NoButton )
+	{
+		m_notesDirty = true;
+	}
 	
 	if( m_action == ActionNone && _me->buttons() == 0 )
 	{
@@ -2709,16 +2738,262 @@ static void printNoteHeights(QPainter& p, int bottom, int width, int startKey)
 	}
 }
 
+// comparators for searching position-sorted notes
+static bool notePosLessThan( const note * _n, const int _pos )
+{
+	return _n->pos() < _pos;
+}
+
+
+
+
+static bool posNoteLessThan( const int _pos, const note * _n )
+{
+	return _pos < _n->pos();
+}
+
+
+
+
 void pianoRoll::paintEvent( QPaintEvent * _pe )
 {
-	QStyleOption opt;
-	opt.initFrom( this );
+	// keyboard, grid and notes only change on scrolling, zooming and
+	// editing, so they're cached in pixmaps - everything else is drawn
+	// on top of them
+	const uint background_state = backgroundState();
+	if( m_backgroundCache.size() != size() ||
+				background_state != m_backgroundState )
+	{
+		m_backgroundCache = QPixmap( size() );
+		QPainter bp( &m_backgroundCache );
+		QStyleOption opt;
+		opt.initFrom( this );
+		style()->drawPrimitive( QStyle::PE_Widget, &opt, &bp, this );
+		// set font-size to 8
+		bp.setFont( pointSize<8>( font() ) );
+		drawBackground( bp );
+		m_backgroundState = background_state;
+	}
+
 	QPainter p( this );
-	style()->drawPrimitive( QStyle::PE_Widget, &opt, &p, this );
+	p.drawPixmap( 0, 0, m_backgroundCache );
 
 	// set font-size to 8
 	p.setFont( pointSize<8>( p.font() ) );
 
+	// following code draws all notes in visible area 
+	// and the note editing stuff (volume, panning, etc)
+
+	// setup selection-vars
+	int sel_pos_start = m_selectStartTick;
+	int sel_pos_end = m_selectStartTick+m_selectedTick;
+	if( sel_pos_start > sel_pos_end )
+	{
+		qSwap<int>( sel_pos_start, sel_pos_end );
+	}
+
+	int sel_key_start = m_selectStartKey - m_startKey + 1;
+	int sel_key_end = sel_key_start + m_selectedKeys;
+	if( sel_key_start > sel_key_end )
+	{
+		qSwap<int>( sel_key_start, sel_key_end );
+	}
+
+	int y_base = keyAreaBottom() - 1;
+	if( validPattern() == true )
+	{
+		const uint notes_view_state = notesViewState();
+		if( m_notesCache.size() != size() || m_notesDirty ||
+				notes_view_state != m_notesViewState )
+		{
+			if( m_notesDirty )
+			{
+				updateCullingInfo();
+				m_notesDirty = false;
+			}
+			m_notesCache = QPixmap( size() );
+			m_notesCache.fill( Qt::transparent );
+			QPainter np( &m_notesCache );
+			np.setFont( pointSize<8>( font() ) );
+			drawNotes( np );
+			m_notesViewState = notes_view_state;
+		}
+		p.drawPixmap( 0, 0, m_notesCache );
+	}
+	else
+	{
+		QFont f = p.font();
+		f.setBold( true );
+		p.setFont( pointSize<14>( f ) );
+		p.setPen( QColor( 0x4A, 0xFD, 0x85 ) );
+		p.drawText( WHITE_KEY_WIDTH + 20, PR_TOP_MARGIN + 40,
+				tr( "Please open a pattern by double-clicking "
+								"on it!" ) );
+	}
+
+	p.setClipRect( WHITE_KEY_WIDTH, PR_TOP_MARGIN, width() -
+				WHITE_KEY_WIDTH, height() - PR_TOP_MARGIN -
+					m_notesEditHeight - PR_BOTTOM_MARGIN );
+
+	// now draw selection-frame
+	int x = ( ( sel_pos_start - m_currentPosition ) * m_ppt ) /
+						midiTime::ticksPerTact();
+	int w = ( ( ( sel_pos_end - m_currentPosition ) * m_ppt ) /
+						midiTime::ticksPerTact() ) - x;
+	int y = (int) y_base - sel_key_start * KEY_LINE_HEIGHT;
+	int h = (int) y_base - sel_key_end * KEY_LINE_HEIGHT - y;
+	p.setPen( QColor( 0, 64, 192 ) );
+	p.drawRect( x + WHITE_KEY_WIDTH, y, w, h );
+
+	// TODO: Get this out of paint event
+	int l = ( validPattern() == true )? (int) m_pattern->length() : 0;
+
+	// reset scroll-range
+	if( m_leftRightScroll->maximum() != l )
+	{
+		m_leftRightScroll->setRange( 0, l );
+		m_leftRightScroll->setPageStep( l );
+	}
+
+	// horizontal line for the key under the cursor
+	if( validPattern() == true )
+	{
+		int key_num = getKey( mapFromGlobal( QCursor::pos() ).y() );
+		p.fillRect( 10, keyAreaBottom() + 3 - KEY_LINE_HEIGHT *
+					( key_num - m_startKey + 1 ),
+				width() - 10, KEY_LINE_HEIGHT - 7,
+							QColor( 64, 64, 64 ) );
+	}
+	
+	// bar to resize note edit area
+	p.setClipRect( 0, 0, width(), height() );
+	p.fillRect( QRect( 0, keyAreaBottom(), 
+					width()-PR_RIGHT_MARGIN, NOTE_EDIT_RESIZE_BAR ),
+			   QColor( 64, 64, 64 ) );
+
+	const QPixmap * cursor = NULL;
+	// draw current edit-mode-icon below the cursor
+	switch( m_editMode )
+	{
+		case ModeDraw:
+			if( m_mouseDownRight )
+			{
+				cursor = s_toolErase;
+			}
+			else if( m_action == ActionMoveNote )
+			{
+				cursor = s_toolMove;
+			}
+			else
+			{
+				cursor = s_toolDraw;
+			}
+			break;
+		case ModeErase: cursor = s_toolErase; break;
+		case ModeSelect: cursor = s_toolSelect; break;
+		case ModeEditDetuning: cursor = s_toolOpen; break;
+	}
+	if( cursor != NULL )
+	{
+		p.drawPixmap( mapFromGlobal( QCursor::pos() ) + QPoint( 8, 8 ),
+								*cursor );
+	}
+
+	if( configManager::inst()->value( "ui", "printnotelabels").toInt() )
+	{
+		printNoteHeights(p, keyAreaBottom(), width(), m_startKey);
+	}
+}
+
+
+
+
+
+
+
+
+uint pianoRoll::backgroundState() const
+{
+	uint h = width();
+	h = h * 31 + height();
+	h = h * 31 + m_startKey;
+	h = h * 31 + (int) m_currentPosition;
+	h = h * 31 + m_ppt;
+	h = h * 31 + m_notesEditHeight;
+	h = h * 31 + quantization();
+	h = h * 31 + m_zoomingModel.value();
+	h = h * 31 + m_noteEditMode;
+	h = h * 31 + midiTime::stepsPerTact();
+	for( QList<int>::ConstIterator it = m_markedSemiTones.begin();
+					it != m_markedSemiTones.end(); ++it )
+	{
+		h = h * 31 + *it;
+	}
+	h = h * 31 + validPattern();
+	if( validPattern() )
+	{
+		const Piano * piano = m_pattern->instrumentTrack()->pianoModel();
+		const int last_key = qMin<int>( NumKeys, m_startKey +
+				( keyAreaBottom() - keyAreaTop() ) /
+							KEY_LINE_HEIGHT + 2 );
+		for( int key = qMax( 0, m_startKey - 1 ); key < last_key; ++key )
+		{
+			h = h * 31 + piano->isKeyPressed( key );
+		}
+	}
+	return h;
+}
+
+
+
+
+uint pianoRoll::notesViewState() const
+{
+	uint h = width();
+	h = h * 31 + height();
+	h = h * 31 + m_startKey;
+	h = h * 31 + (int) m_currentPosition;
+	h = h * 31 + m_ppt;
+	h = h * 31 + m_notesEditHeight;
+	h = h * 31 + m_noteEditMode;
+	return h;
+}
+
+
+
+
+void pianoRoll::updateCullingInfo()
+{
+	m_notesSorted = true;
+	m_maxNoteLength = 4;
+
+	const NoteVector & notes = m_pattern->notes();
+	for( NoteVector::ConstIterator it = notes.begin(); it != notes.end();
+									++it )
+	{
+		m_maxNoteLength = qMax<int>( m_maxNoteLength, ( *it )->length() );
+		if( it != notes.begin() &&
+				( *it )->pos() < ( *( it - 1 ) )->pos() )
+		{
+			m_notesSorted = false;
+		}
+	}
+}
+
+
+
+
+void pianoRoll::notesChanged()
+{
+	m_notesDirty = true;
+	update();
+}
+
+
+
+
+void pianoRoll::drawBackground( QPainter & _p )
+{
 	// y_offset is used to align the piano-keys on the key-lines
 	int y_offset = 0;
 
@@ -2757,7 +3032,7 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 			break;
 		}
 
-		p.fillRect( WHITE_KEY_WIDTH+1, y-KEY_LINE_HEIGHT/2,
+		_p.fillRect( WHITE_KEY_WIDTH+1, y-KEY_LINE_HEIGHT/2,
 			    width() - 10, KEY_LINE_HEIGHT,
 							QColor( 0, 80 - ( key_num % KeysPerOctave ) * 3, 64 + key_num / 2) );
 	}
@@ -2774,7 +3049,7 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 								PR_BLACK_KEY )
 		{
 			// draw it!
-			p.drawPixmap( PIANO_X, y - WHITE_KEY_SMALL_HEIGHT,
+			_p.drawPixmap( PIANO_X, y - WHITE_KEY_SMALL_HEIGHT,
 							*s_whiteKeySmallPm );
 			// update y-pos
 			y -= WHITE_KEY_SMALL_HEIGHT / 2;
@@ -2791,11 +3066,11 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 			// draw a small one while checking if it is pressed or not
 			if( validPattern() && m_pattern->instrumentTrack()->pianoModel()->isKeyPressed( key ) )
 			{
-				p.drawPixmap( PIANO_X, y - WHITE_KEY_SMALL_HEIGHT, *s_whiteKeySmallPressedPm );
+				_p.drawPixmap( PIANO_X, y - WHITE_KEY_SMALL_HEIGHT, *s_whiteKeySmallPressedPm );
 			}
 			else
 			{
-				p.drawPixmap( PIANO_X, y - WHITE_KEY_SMALL_HEIGHT, *s_whiteKeySmallPm );
+				_p.drawPixmap( PIANO_X, y - WHITE_KEY_SMALL_HEIGHT, *s_whiteKeySmallPm );
 			}
 			// update y-pos
 			y -= WHITE_KEY_SMALL_HEIGHT;
@@ -2807,11 +3082,11 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 			// draw a big one while checking if it is pressed or not
 			if( validPattern() && m_pattern->instrumentTrack()->pianoModel()->isKeyPressed( key ) )
 			{
-				p.drawPixmap( PIANO_X, y - WHITE_KEY_BIG_HEIGHT, *s_whiteKeyBigPressedPm );
+				_p.drawPixmap( PIANO_X, y - WHITE_KEY_BIG_HEIGHT, *s_whiteKeyBigPressedPm );
 			}
 			else
 			{
-				p.drawPixmap( PIANO_X, y-WHITE_KEY_BIG_HEIGHT, *s_whiteKeyBigPm );
+				_p.drawPixmap( PIANO_X, y-WHITE_KEY_BIG_HEIGHT, *s_whiteKeyBigPm );
 			}
 			// if a big white key has been the first key,
 			// black keys needs to be lifted up
@@ -2825,22 +3100,22 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 		// label C-keys...
 		if( static_cast<Keys>( key % KeysPerOctave ) == Key_C )
 		{
-			p.setPen( QColor( 240, 240, 240 ) );
-			p.drawText( C_KEY_LABEL_X + 1, y+14, "C" +
+			_p.setPen( QColor( 240, 240, 240 ) );
+			_p.drawText( C_KEY_LABEL_X + 1, y+14, "C" +
 					QString::number( static_cast<int>( key /
 							KeysPerOctave ) ) );
-			p.setPen( QColor( 0, 0, 0 ) );
-			p.drawText( C_KEY_LABEL_X, y + 13, "C" +
+			_p.setPen( QColor( 0, 0, 0 ) );
+			_p.drawText( C_KEY_LABEL_X, y + 13, "C" +
 					QString::number( static_cast<int>( key /
 							KeysPerOctave ) ) );
-			p.setPen( QColor( 0x4F, 0x4F, 0x4F ) );
+			_p.setPen( QColor( 0x4F, 0x4F, 0x4F ) );
 		}
 		else
 		{
-			p.setPen( QColor( 0x3F, 0x3F, 0x3F ) );
+			_p.setPen( QColor( 0x3F, 0x3F, 0x3F ) );
 		}
 		// draw key-line
-		p.drawLine( WHITE_KEY_WIDTH, key_line_y, width(), key_line_y );
+		_p.drawLine( WHITE_KEY_WIDTH, key_line_y, width(), key_line_y );
 		++key;
 	}
 
@@ -2864,7 +3139,7 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 								PR_BLACK_KEY )
 		{
 			// draw the black key!
-			p.drawPixmap( PIANO_X, y - BLACK_KEY_HEIGHT / 2,
+			_p.drawPixmap( PIANO_X, y - BLACK_KEY_HEIGHT / 2,
 								*s_blackKeyPm );
 			// is the one after the start-note a black key??
 			if( prKeyOrder[( key + 1 ) % KeysPerOctave] !=
@@ -2882,14 +3157,14 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 			// check if the key is pressed or not
 			if( validPattern() && m_pattern->instrumentTrack()->pianoModel()->isKeyPressed( key ) )
 			{
-				p.drawPixmap( PIANO_X, y - ( first_white_key_height -
+				_p.drawPixmap( PIANO_X, y - ( first_white_key_height -
 						WHITE_KEY_SMALL_HEIGHT ) -
 						WHITE_KEY_SMALL_HEIGHT/2 - 1 -
 						BLACK_KEY_HEIGHT, *s_blackKeyPressedPm );
 			}
 		    else
 			{
-				p.drawPixmap( PIANO_X, y - ( first_white_key_height -
+				_p.drawPixmap( PIANO_X, y - ( first_white_key_height -
 						WHITE_KEY_SMALL_HEIGHT ) -
 						WHITE_KEY_SMALL_HEIGHT/2 - 1 -
 						BLACK_KEY_HEIGHT, *s_blackKeyPm );
@@ -2916,23 +3191,23 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 
 	// erase the area below the piano, because there might be keys that 
 	// should be only half-visible
-	p.fillRect( QRect( 0, keyAreaBottom(),
+	_p.fillRect( QRect( 0, keyAreaBottom(),
 			WHITE_KEY_WIDTH, noteEditBottom()-keyAreaBottom() ),
 			QColor( 0, 0, 0 ) );
 	
 	// display note editing info
-	QFont f = p.font();
+	QFont f = _p.font();
 	f.setBold( false );
-	p.setFont( pointSize<10>( f ) );
-	p.setPen( QColor( 255, 255, 255) );
-	p.drawText( QRect( 0, keyAreaBottom(), 
+	_p.setFont( pointSize<10>( f ) );
+	_p.setPen( QColor( 255, 255, 255) );
+	_p.drawText( QRect( 0, keyAreaBottom(), 
 					  WHITE_KEY_WIDTH, noteEditBottom() - keyAreaBottom() ),
 			   Qt::AlignCenter | Qt::TextWordWrap,
 			   m_nemStr.at( m_noteEditMode ) + ":" );
 
 	// set clipping area, because we are not allowed to paint over
 	// keyboard...
-	p.setClipRect( WHITE_KEY_WIDTH, PR_TOP_MARGIN,
+	_p.setClipRect( WHITE_KEY_WIDTH, PR_TOP_MARGIN,
 				width() - WHITE_KEY_WIDTH,
 				height() - PR_TOP_MARGIN - PR_BOTTOM_MARGIN );
 
@@ -2967,246 +3242,162 @@ void pianoRoll::paintEvent( QPaintEvent * _pe )
 			// every tact-start needs to be a bright line
 			if( tact_16th % spt == 0 )
 			{
-	 			p.setPen( QColor( 0x7F, 0x7F, 0x7F ) );
+	 			_p.setPen( QColor( 0x7F, 0x7F, 0x7F ) );
 			}
 			// normal line
 			else if( tact_16th % 4 == 0 )
 			{
-				p.setPen( QColor( 0x5F, 0x5F, 0x5F ) );
+				_p.setPen( QColor( 0x5F, 0x5F, 0x5F ) );
 			}
 			// weak line
 			else
 			{
-				p.setPen( QColor( 0x3F, 0x3F, 0x3F ) );
+				_p.setPen( QColor( 0x3F, 0x3F, 0x3F ) );
 			}
 
-			p.drawLine( (int)x, PR_TOP_MARGIN, (int)x, height() -
+			_p.drawLine( (int)x, PR_TOP_MARGIN, (int)x, height() -
 							PR_BOTTOM_MARGIN );
 
 			// extra 32nd's line
 			if( show32nds )
 			{
-				p.setPen( QColor( 0x22, 0x22, 0x22 ) );
-				p.drawLine( (int)(x + pp16th/2) , PR_TOP_MARGIN, 
+				_p.setPen( QColor( 0x22, 0x22, 0x22 ) );
+				_p.drawLine( (int)(x + pp16th/2) , PR_TOP_MARGIN, 
 						(int)(x + pp16th/2), height() -
 						PR_BOTTOM_MARGIN );
 			}
 		}
 	}
+}
 
 
 
-	// following code draws all notes in visible area 
-	// and the note editing stuff (volume, panning, etc)
-
-	// setup selection-vars
-	int sel_pos_start = m_selectStartTick;
-	int sel_pos_end = m_selectStartTick+m_selectedTick;
-	if( sel_pos_start > sel_pos_end )
-	{
-		qSwap<int>( sel_pos_start, sel_pos_end );
-	}
 
-	int sel_key_start = m_selectStartKey - m_startKey + 1;
-	int sel_key_end = sel_key_start + m_selectedKeys;
-	if( sel_key_start > sel_key_end )
-	{
-		qSwap<int>( sel_key_start, sel_key_end );
-	}
+void pianoRoll::drawNotes( QPainter & _p )
+{
+	const int y_base = keyAreaBottom() - 1;
 
-	int y_base = keyAreaBottom() - 1;
-	if( validPattern() == true )
-	{
-		p.setClipRect( WHITE_KEY_WIDTH, PR_TOP_MARGIN,
+	_p.setClipRect( WHITE_KEY_WIDTH, PR_TOP_MARGIN,
 				width() - WHITE_KEY_WIDTH,
 				height() - PR_TOP_MARGIN );
 
-		const NoteVector & notes = m_pattern->notes();
+	const NoteVector & notes = m_pattern->notes();
 
-		const int visible_keys = ( keyAreaBottom()-keyAreaTop() ) /
-							KEY_LINE_HEIGHT + 2;
-	
-		QPolygon editHandles;
+	const int visible_keys = ( keyAreaBottom()-keyAreaTop() ) /
+						KEY_LINE_HEIGHT + 2;
 
-		for( NoteVector::ConstIterator it = notes.begin();
-						it != notes.end(); ++it )
-		{
-			int len_ticks = ( *it )->length();
+	// notes are sorted by position, so only look at the ones which can
+	// reach into visible area - a note starting before it can't be
+	// longer than m_maxNoteLength
+	NoteVector::ConstIterator first = notes.begin();
+	NoteVector::ConstIterator last = notes.end();
+	if( m_notesSorted )
+	{
+		const int end_ticks = m_currentPosition + ( width() -
+					WHITE_KEY_WIDTH ) *
+				midiTime::ticksPerTact() / m_ppt + 1;
+		first = qLowerBound( notes.begin(), notes.end(),
+				(int) m_currentPosition - m_maxNoteLength,
+							notePosLessThan );
+		last = qUpperBound( first, notes.end(), end_ticks,
+							posNoteLessThan );
+	}
 
-			if( len_ticks == 0 )
-			{
-				continue;
-			}
-			else if( len_ticks < 0 )
-			{
-				len_ticks = 4;
-			}
+	QPolygon editHandles;
 
-			const int key = ( *it )->key() - m_startKey + 1;
+	for( NoteVector::ConstIterator it = first; it != last; ++it )
+	{
+		int len_ticks = ( *it )->length();
 
-			int pos_ticks = ( *it )->pos();
+		if( len_ticks == 0 )
+		{
+			continue;
+		}
+		else if( len_ticks < 0 )
+		{
+			len_ticks = 4;
+		}
 
-			int note_width = len_ticks * m_ppt /
-						midiTime::ticksPerTact();
-			const int x = ( pos_ticks - m_currentPosition ) *
-					m_ppt / midiTime::ticksPerTact();
-			// skip this note if not in visible area at all
-			if( !( x + note_width >= 0 &&
-					x <= width() - WHITE_KEY_WIDTH ) )
-			{
-				continue;
-			}
+		const int key = ( *it )->key() - m_startKey + 1;
 
-			// is the note in visible area?
-			if( key > 0 && key <= visible_keys )
-			{
+		int pos_ticks = ( *it )->pos();
 
-				// we've done and checked all, let's draw the
-				// note
-				drawNoteRect( p, x + WHITE_KEY_WIDTH,
-						y_base - key * KEY_LINE_HEIGHT,
-								note_width, *it );
-			}
-			
-			// draw note editing stuff
-			int editHandleTop = 0;
-			if( m_noteEditMode == NoteEditVolume )
-			{
-				QColor color = QColor::fromHsv( 140, 221, 
-						qMin(255, 60 + ( *it )->getVolume() ) );
-				if( ( *it )->selected() )
-				{
-					color.setRgb( 0x00, 0x40, 0xC0 );
-				}
-				p.setPen( QPen( color, NE_LINE_WIDTH ) );
+		int note_width = len_ticks * m_ppt /
+					midiTime::ticksPerTact();
+		const int x = ( pos_ticks - m_currentPosition ) *
+				m_ppt / midiTime::ticksPerTact();
+		// skip this note if not in visible area at all
+		if( !( x + note_width >= 0 &&
+				x <= width() - WHITE_KEY_WIDTH ) )
+		{
+			continue;
+		}
 
-				editHandleTop = noteEditBottom() - 
-					( (float)( ( *it )->getVolume() - MinVolume ) ) / 
-					( (float)( MaxVolume - MinVolume ) ) * 
-					( (float)( noteEditBottom() - noteEditTop() ) );
-				
-				p.drawLine( noteEditLeft() + x, editHandleTop, 
-							noteEditLeft() + x, noteEditBottom() );
+		// is the note in visible area?
+		if( key > 0 && key <= visible_keys )
+		{
 
-			}
-			else if( m_noteEditMode == NoteEditPanning )
+			// we've done and checked all, let's draw the
+			// note
+			drawNoteRect( _p, x + WHITE_KEY_WIDTH,
+					y_base - key * KEY_LINE_HEIGHT,
+							note_width, *it );
+		}
+		
+		// draw note editing stuff
+		int editHandleTop = 0;
+		if( m_noteEditMode == NoteEditVolume )
+		{
+			QColor color = QColor::fromHsv( 140, 221, 
+					qMin(255, 60 + ( *it )->getVolume() ) );
+			if( ( *it )->selected() )
 			{
-				QColor color( 0x99, 0xAF, 0xFF );
-				if( ( *it )->selected() )
-				{
-					color.setRgb( 0x00, 0x40, 0xC0 );
-				}
-				
-				p.setPen( QPen( color, NE_LINE_WIDTH ) );
-				
-				editHandleTop = noteEditBottom() -
-					( (float)( ( *it )->getPanning() - PanningLeft ) ) / 
-					( (float)( (PanningRight - PanningLeft ) ) ) *
-					( (float)( noteEditBottom() - noteEditTop() ) );
-				
-				p.drawLine( noteEditLeft() + x, noteEditTop() +
-						( (float)( noteEditBottom() - noteEditTop() ) ) / 2.0f,
-						    noteEditLeft() + x, editHandleTop );
+				color.setRgb( 0x00, 0x40, 0xC0 );
 			}
-			editHandles << QPoint( x + noteEditLeft(),
-						editHandleTop+1 );
+			_p.setPen( QPen( color, NE_LINE_WIDTH ) );
 
-			if( ( *it )->hasDetuningInfo() )
+			editHandleTop = noteEditBottom() - 
+				( (float)( ( *it )->getVolume() - MinVolume ) ) / 
+				( (float)( MaxVolume - MinVolume ) ) * 
+				( (float)( noteEditBottom() - noteEditTop() ) );
+			
+			_p.drawLine( noteEditLeft() + x, editHandleTop, 
+						noteEditLeft() + x, noteEditBottom() );
+
+		}
+		else if( m_noteEditMode == NoteEditPanning )
+		{
+			QColor color( 0x99, 0xAF, 0xFF );
+			if( ( *it )->selected() )
 			{
-				drawDetuningInfo( p, *it,
-					x + WHITE_KEY_WIDTH,
-					y_base - key * KEY_LINE_HEIGHT );
+				color.setRgb( 0x00, 0x40, 0xC0 );
 			}
+			
+			_p.setPen( QPen( color, NE_LINE_WIDTH ) );
+			
+			editHandleTop = noteEditBottom() -
+				( (float)( ( *it )->getPanning() - PanningLeft ) ) / 
+				( (float)( (PanningRight - PanningLeft ) ) ) *
+				( (float)( noteEditBottom() - noteEditTop() ) );
+			
+			_p.drawLine( noteEditLeft() + x, noteEditTop() +
+					( (float)( noteEditBottom() - noteEditTop() ) ) / 2.0f,
+					    noteEditLeft() + x, editHandleTop );
 		}
-		
-		p.setPen( QPen( QColor( 0x99, 0xAF, 0xFF ),
-				NE_LINE_WIDTH+2 ) );
-		p.drawPoints( editHandles );
-		
-	}
-	else
-	{
-		QFont f = p.font();
-		f.setBold( true );
-		p.setFont( pointSize<14>( f ) );
-		p.setPen( QColor( 0x4A, 0xFD, 0x85 ) );
-		p.drawText( WHITE_KEY_WIDTH + 20, PR_TOP_MARGIN + 40,
-				tr( "Please open a pattern by double-clicking "
-								"on it!" ) );
-	}
-
-	p.setClipRect( WHITE_KEY_WIDTH, PR_TOP_MARGIN, width() -
-				WHITE_KEY_WIDTH, height() - PR_TOP_MARGIN -
-					m_notesEditHeight - PR_BOTTOM_MARGIN );
+		editHandles << QPoint( x + noteEditLeft(),
+					editHandleTop+1 );
 
-	// now draw selection-frame
-	int x = ( ( sel_pos_start - m_currentPosition ) * m_ppt ) /
-						midiTime::ticksPerTact();
-	int w = ( ( ( sel_pos_end - m_currentPosition ) * m_ppt ) /
-						midiTime::ticksPerTact() ) - x;
-	int y = (int) y_base - sel_key_start * KEY_LINE_HEIGHT;
-	int h = (int) y_base - sel_key_end * KEY_LINE_HEIGHT - y;
-	p.setPen( QColor( 0, 64, 192 ) );
-	p.drawRect( x + WHITE_KEY_WIDTH, y, w, h );
-
-	// TODO: Get this out of paint event
-	int l = ( validPattern() == true )? (int) m_pattern->length() : 0;
-
-	// reset scroll-range
-	if( m_leftRightScroll->maximum() != l )
-	{
-		m_leftRightScroll->setRange( 0, l );
-		m_leftRightScroll->setPageStep( l );
-	}
-
-	// horizontal line for the key under the cursor
-	if( validPattern() == true )
-	{
-		int key_num = getKey( mapFromGlobal( QCursor::pos() ).y() );
-		p.fillRect( 10, keyAreaBottom() + 3 - KEY_LINE_HEIGHT *
-					( key_num - m_startKey + 1 ),
-				width() - 10, KEY_LINE_HEIGHT - 7,
-							QColor( 64, 64, 64 ) );
+		if( ( *it )->hasDetuningInfo() )
+		{
+			drawDetuningInfo( _p, *it,
+				x + WHITE_KEY_WIDTH,
+				y_base - key * KEY_LINE_HEIGHT );
+		}
 	}
 	
-	// bar to resize note edit area
-	p.setClipRect( 0, 0, width(), height() );
-	p.fillRect( QRect( 0, keyAreaBottom(), 
-					width()-PR_RIGHT_MARGIN, NOTE_EDIT_RESIZE_BAR ),
-			   QColor( 64, 64, 64 ) );
-
-	const QPixmap * cursor = NULL;
-	// draw current edit-mode-icon below the cursor
-	switch( m_editMode )
-	{
-		case ModeDraw:
-			if( m_mouseDownRight )
-			{
-				cursor = s_toolErase;
-			}
-			else if( m_action == ActionMoveNote )
-			{
-				cursor = s_toolMove;
-			}
-			else
-			{
-				cursor = s_toolDraw;
-			}
-			break;
-		case ModeErase: cursor = s_toolErase; break;
-		case ModeSelect: cursor = s_toolSelect; break;
-		case ModeEditDetuning: cursor = s_toolOpen; break;
-	}
-	if( cursor != NULL )
-	{
-		p.drawPixmap( mapFromGlobal( QCursor::pos() ) + QPoint( 8, 8 ),
-								*cursor );
-	}
-
-	if( configManager::inst()->value( "ui", "printnotelabels").toInt() )
-	{
-		printNoteHeights(p, keyAreaBottom(), width(), m_startKey);
-	}
+	_p.setPen( QPen( QColor( 0x99, 0xAF, 0xFF ),
+			NE_LINE_WIDTH+2 ) );
+	_p.drawPoints( editHandles );
 }
 
 
@@ -3517,6 +3708,8 @@ void pianoRoll::selectAll()
 		return;
 	}
 
+	m_notesDirty = true;
+
 	const NoteVector & notes = m_pattern->notes();
 
 	// if first_time = true, we HAVE to set the vars for select
@@ -3635,6 +3828,8 @@ void pianoRoll::cutSelectedNotes()
 		return;
 	}
 
+	m_notesDirty = true;
+
 	NoteVector selected_notes;
 	getSelectedNotes( selected_notes );
 
@@ -3667,6 +3862,8 @@ void pianoRoll::pasteNotes()
 		return;
 	}
 
+	m_notesDirty = true;
+
 	QString value = QApplication::clipboard()
 				->mimeData( QClipboard::Clipboard )
 						->data( Clipboard::mimeType() );
@@ -3714,6 +3911,8 @@ void pianoRoll::deleteSelectedNotes()
 	{
 		return;
 	}
+
+	m_notesDirty = true;
 	
 	bool update_after_delete = false;
 	
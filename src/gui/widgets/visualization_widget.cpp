@@ -42,18 +42,23 @@ visualizationWidget::visualizationWidget( const QPixmap & _bg, QWidget * _p,
 						visualizationTypes _vtype ) :
 	QWidget( _p ),
 	s_background( _bg ),
-	m_points( new QPointF[engine::mixer()->framesPerPeriod()] ),
+	m_inactiveBackground( _bg ),
+	m_lines(),
 	m_active( false )
 {
 	setFixedSize( s_background.width(), s_background.height() );
 	setAttribute( Qt::WA_OpaquePaintEvent, true );
-	setActive( configManager::inst()->value( "ui", "displaywaveform").toInt() );
 
-	const fpp_t frames = engine::mixer()->framesPerPeriod();
-	m_buffer = new sampleFrame[frames];
+	// text shown while inactive doesn't change, so render it only once
+	QPainter p( &m_inactiveBackground );
+	p.setPen( QColor( 192, 192, 192 ) );
+	p.setFont( pointSize<7>( p.font() ) );
+	p.drawText( 6, height()-5, tr( "Click to enable" ) );
+	p.end();
 
-	engine::mixer()->clearAudioBuffer( m_buffer, frames );
+	m_lines.reserve( width() );
 
+	setActive( configManager::inst()->value( "ui", "displaywaveform").toInt() );
 
 	toolTip::add( this, tr( "click to enable/disable visualization of "
 							"master-output" ) );
@@ -64,22 +69,9 @@ visualizationWidget::visualizationWidget( const QPixmap & _bg, QWidget * _p,
 
 visualizationWidget::~visualizationWidget()
 {
-	delete[] m_buffer;
-}
-
-
-
-
-void visualizationWidget::updateAudioBuffer()
-{
-	if( !engine::getSong()->isExporting() )
+	if( m_active )
 	{
-		engine::mixer()->lock();
-		const surroundSampleFrame * c = engine::mixer()->
-							currentReadBuffer();
-		const fpp_t fpp = engine::mixer()->framesPerPeriod();
-		memcpy( m_buffer, c, sizeof( surroundSampleFrame ) * fpp );
-		engine::mixer()->unlock();
+		engine::mixer()->removeScopeUser();
 	}
 }
 
@@ -88,24 +80,27 @@ void visualizationWidget::updateAudioBuffer()
 
 void visualizationWidget::setActive( bool _active )
 {
+	if( _active == m_active )
+	{
+		return;
+	}
+
 	m_active = _active;
 	if( m_active )
 	{
+		// let mixer compute scope-data after each period - we only
+		// pick up the latest one whenever we're repainted
+		engine::mixer()->addScopeUser();
 		connect( engine::mainWindow(),
 					SIGNAL( periodicUpdate() ),
 					this, SLOT( update() ) );
-		connect( engine::mixer(),
-					SIGNAL( nextAudioBuffer() ),
-				this, SLOT( updateAudioBuffer() ) );
 	}
 	else
 	{
+		engine::mixer()->removeScopeUser();
 		disconnect( engine::mainWindow(),
 					SIGNAL( periodicUpdate() ),
 					this, SLOT( update() ) );
-		disconnect( engine::mixer(),
-					SIGNAL( nextAudioBuffer() ),
-				this, SLOT( updateAudioBuffer() ) );
 		// we have to update (remove last waves),
 		// because timer doesn't do that anymore
 		update();
@@ -119,63 +114,67 @@ void visualizationWidget::paintEvent( QPaintEvent * )
 {
 	QPainter p( this );
 
-	p.drawPixmap( 0, 0, s_background );
-
-	if( m_active && !engine::getSong()->isExporting() )
+	if( !m_active || engine::getSong()->isExporting() )
 	{
-		float master_output = engine::mixer()->masterGain();
-		int w = width()-4;
-		const float half_h = -( height() - 6 ) / 3.0 * master_output - 1;
-		int x_base = 2;
-		const float y_base = height()/2 - 0.5f;
-
-//		p.setClipRect( 2, 2, w, height()-4 );
-
+		p.drawPixmap( 0, 0, m_inactiveBackground );
+		return;
+	}
 
-		const fpp_t frames =
-				engine::mixer()->framesPerPeriod();
-		const float max_level = qMax<float>(
-				Mixer::peakValueLeft( m_buffer, frames ),
-				Mixer::peakValueRight( m_buffer, frames ) );
+	p.drawPixmap( 0, 0, s_background );
 
-		// and set color according to that...
-		if( max_level * master_output < 0.9 )
-		{
-			p.setPen( QColor( 128, 224, 128 ) );
-		}
-		else if( max_level * master_output < 1.0 )
-		{
-			p.setPen( QColor( 255, 192, 64 ) );
-		}
-		else
-		{
-			p.setPen( QColor( 255, 64, 64 ) );
-		}
+	const Mixer::ScopeData & d = engine::mixer()->scopeData();
+	if( d.numColumns == 0 )
+	{
+		return;
+	}
 
-		p.setPen( QPen( p.pen().color(), 0.7 ) );
+	const float master_output = engine::mixer()->masterGain();
+	const int w = width()-4;
+	const float half_h = -( height() - 6 ) / 3.0 * master_output - 1;
+	const int x_base = 2;
+	const float y_base = height()/2 - 0.5f;
 
-		const float xd = (float) w / frames;
-		p.setRenderHint( QPainter::Antialiasing );
+	// set color according to peak-level
+	const float max_level = d.peak * master_output;
+	if( max_level < 0.9 )
+	{
+		p.setPen( QColor( 128, 224, 128 ) );
+	}
+	else if( max_level < 1.0 )
+	{
+		p.setPen( QColor( 255, 192, 64 ) );
+	}
+	else
+	{
+		p.setPen( QColor( 255, 64, 64 ) );
+	}
 
-		// now draw all that stuff
-		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	// draw one vertical line per pixel-column from minimum to maximum,
+	// extended so that it touches the line of previous column
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		m_lines.clear();
+		int prev_top = 0;
+		int prev_bottom = 0;
+		for( int x = 0; x < w; ++x )
 		{
-			for( int frame = 0; frame < frames; ++frame )
+			const Mixer::ScopeColumn & c =
+					d.columns[x * d.numColumns / w];
+			int top = (int)( y_base +
+					Mixer::clip( c.max[ch] ) * half_h );
+			int bottom = (int)( y_base +
+					Mixer::clip( c.min[ch] ) * half_h );
+			if( x > 0 )
 			{
-				m_points[frame] = QPointF(
-					x_base + (float) frame * xd,
-					y_base + ( Mixer::clip(
-						m_buffer[frame][ch] ) *
-								half_h ) );
+				top = qMin( top, prev_bottom );
+				bottom = qMax( bottom, prev_top );
 			}
-			p.drawPolyline( m_points, frames );
+			m_lines.push_back( QLine( x_base + x, top,
+							x_base + x, bottom ) );
+			prev_top = top;
+			prev_bottom = bottom;
 		}
-	}
-	else
-	{
-		p.setPen( QColor( 192, 192, 192 ) );
-		p.setFont( pointSize<7>( p.font() ) );
-		p.drawText( 6, height()-5, tr( "Click to enable" ) );
+		p.drawLines( m_lines );
 	}
 }
 
@@ -37,11 +37,14 @@
 #include <QtGui/QMdiSubWindow>
 #include <QtGui/QPainter>
 
+#include <math.h>
+
 #include "FileDialog.h"
 #include "InstrumentTrack.h"
 #include "AudioPort.h"
 #include "AutomationPattern.h"
 #include "bb_track.h"
+#include "combobox.h"
 #include "config_mgr.h"
 #include "ControllerConnection.h"
 #include "debug.h"
@@ -67,6 +70,7 @@
 #include "MidiPortMenu.h"
 #include "mmp.h"
 #include "note_play_handle.h"
+#include "OfflineRenderContext.h"
 #include "pattern.h"
 #include "PluginView.h"
 #include "SamplePlayHandle.h"
@@ -106,11 +110,22 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	m_pitchModel( 0, -100, 100, 1, this, tr( "Pitch" ) ),
 	m_pitchRangeModel( 1, 1, 24, this, tr( "Pitch range" ) ),
 	m_effectChannelModel( 0, 0, NumFxChannels, this, tr( "FX channel" ) ),
+	m_maxVoicesModel( qMin( 64, engine::mixer()->configuredMaxVoices() ), 1,
+				engine::mixer()->configuredMaxVoices(),
+					this, tr( "Maximum voices" ) ),
+	m_voiceStealingModel( this, tr( "Voice stealing" ) ),
+	m_voicesMutex(),
+	m_voices(),
+	m_activeVoices( 0 ),
 	m_instrument( NULL ),
 	m_soundShaping( this ),
 	m_arpeggio( this ),
 	m_noteStacking( this ),
-	m_piano( this )
+	m_piano( this ),
+	m_offlineRenderMutex(),
+	m_offlineRenderDone(),
+	m_offlineRenderContexts(),
+	m_offlineRenderDisabled( 0 )
 {
 	m_pitchModel.setCenterValue( 0 );
 	m_panningModel.setCenterValue( DefaultPanning );
@@ -124,6 +139,10 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	connect( &m_pitchRangeModel, SIGNAL( dataChanged() ),
 				this, SLOT( updatePitchRange() ) );
 
+	m_voiceStealingModel.addItem( tr( "Oldest" ) );
+	m_voiceStealingModel.addItem( tr( "Quietest" ) );
+	m_voiceStealingModel.addItem( tr( "Same key" ) );
+
 	for( int i = 0; i < NumKeys; ++i )
 	{
 		m_notes[i] = NULL;
@@ -142,6 +161,7 @@ InstrumentTrack::~InstrumentTrack()
 {
 	// kill all running notes
 	silenceAllNotes();
+	disableOfflineRendering();
 
 	// now we're save deleting the instrument
 	delete m_instrument;
@@ -154,15 +174,23 @@ void InstrumentTrack::processAudioBuffer( sampleFrame * _buf,
 							const fpp_t _frames,
 							notePlayHandle * _n )
 {
+	// notes rendered by an OfflineRenderContext are rendered regardless
+	// of mute-state as the result is played back through this track
+	// later on
+	OfflineRenderContext * context = _n ? _n->renderContext() : NULL;
+
 	// we must not play the sound if this InstrumentTrack is muted...
-	if( isMuted() || ( _n && _n->bbTrackMuted() ) )
+	if( context == NULL && ( isMuted() || ( _n && _n->bbTrackMuted() ) ) )
 	{
 		return;
 	}
 
 	// if effects "went to sleep" because there was no input, wake them up
 	// now
-	m_audioPort.effects()->startRunning();
+	if( context == NULL )
+	{
+		m_audioPort.effects()->startRunning();
+	}
 
 	float v_scale = (float) getVolume() / DefaultVolume;
 
@@ -173,6 +201,29 @@ void InstrumentTrack::processAudioBuffer( sampleFrame * _buf,
 	{
 		m_soundShaping.processAudioBuffer( _buf, _frames, _n );
 		v_scale *= ( (float) _n->getVolume() / DefaultVolume );
+
+		// a stolen voice has to be silent at the end of this period
+		if( _n->isFadingOut() )
+		{
+			for( fpp_t f = 0; f < _frames; ++f )
+			{
+				const float fade = 1.0f - (float) f / _frames;
+				_buf[f][0] *= fade;
+				_buf[f][1] *= fade;
+			}
+		}
+
+		// let released notes end early once they became inaudible
+		if( _n->released() )
+		{
+			float peak = 0.0f;
+			for( fpp_t f = 0; f < _frames; ++f )
+			{
+				peak = qMax( peak, qMax( fabsf( _buf[f][0] ),
+							fabsf( _buf[f][1] ) ) );
+			}
+			_n->reportOutputLevel( peak * v_scale );
+		}
 	}
 	else
 	{
@@ -183,14 +234,24 @@ void InstrumentTrack::processAudioBuffer( sampleFrame * _buf,
 		}
 	}
 
-	m_audioPort.setNextFxChannel( m_effectChannelModel.value() );
-	
 	int panning = m_panningModel.value();
 	if( _n != NULL )
 	{
 		panning += _n->getPanning();
 		panning = tLimit<int>( panning, PanningLeft, PanningRight );
 	}
+
+	if( context != NULL )
+	{
+		context->bufferToContext( _buf,
+			qMin<f_cnt_t>( _n->framesLeftForCurrentPeriod(), _frames ),
+					_n->offset(),
+					panningToVolumeVector( panning, v_scale ) );
+		return;
+	}
+
+	m_audioPort.setNextFxChannel( m_effectChannelModel.value() );
+
 	engine::mixer()->bufferToPort( _buf, ( _n != NULL ) ?
 		qMin<f_cnt_t>(_n->framesLeftForCurrentPeriod(), _frames ) :
 								_frames,
@@ -259,11 +320,14 @@ void InstrumentTrack::processInEvent( const midiEvent & _me,
 					n.setKey( _me.key() );
 					n.setVolume( _me.getVolume() );
 
-					// create (timed) note-play-handle
+					// create (timed) note-play-handle - events
+					// from MIDI-ports carry their position
+					// within current period
 					notePlayHandle * nph = new
 						notePlayHandle( this,
 							_time.frames(
-						engine::framesPerTick() ),
+						engine::framesPerTick() ) +
+								_me.offset(),
 						typeInfo<f_cnt_t>::max() / 2,
 									n );
 					if( engine::mixer()->addPlayHandle(
@@ -296,7 +360,14 @@ void InstrumentTrack::processInEvent( const midiEvent & _me,
 							n->getVolume(),
 							n->getPanning() );
 
-				n->noteOff();
+				// release at position of event - if note
+				// was started later within the period, this
+				// is only possible in next period
+				const fpp_t fpp =
+					engine::mixer()->framesPerPeriod();
+				n->noteOff( _me.offset() > 0 ?
+					( _me.offset() - n->offset() % fpp +
+							fpp ) % fpp : 0 );
 				m_notes[_me.key()] = NULL;
 
 				emit noteOff( done_note );
@@ -469,6 +540,190 @@ void InstrumentTrack::silenceAllNotes()
 
 
 
+void InstrumentTrack::addVoice( notePlayHandle * _n )
+{
+	QMutexLocker ml( &m_voicesMutex );
+
+	m_voices.push_back( _n );
+	++m_activeVoices;
+
+	const int limit = qMax( 1, (int)( m_maxVoicesModel.value() *
+				engine::mixer()->voiceBudgetScale() ) );
+	int excess = m_activeVoices - limit;
+	// voices of other tracks are left alone, so if the global limit is
+	// exceeded the new note replaces one of this track
+	if( engine::mixer()->addVoice() > engine::mixer()->maxVoices() )
+	{
+		excess = qMax( excess, 1 );
+	}
+
+	while( excess-- > 0 )
+	{
+		notePlayHandle * victim = voiceToSteal( _n );
+		if( victim == NULL )
+		{
+			break;
+		}
+		markVoiceStolen( victim );
+	}
+}
+
+
+
+
+void InstrumentTrack::removeVoice( notePlayHandle * _n )
+{
+	QMutexLocker ml( &m_voicesMutex );
+
+	m_voices.removeOne( _n );
+	if( !_n->m_stolen )
+	{
+		--m_activeVoices;
+		engine::mixer()->removeVoice();
+	}
+}
+
+
+
+
+void InstrumentTrack::stealVoice( notePlayHandle * _n )
+{
+	QMutexLocker ml( &m_voicesMutex );
+
+	if( !_n->m_stolen )
+	{
+		markVoiceStolen( _n );
+	}
+}
+
+
+
+
+notePlayHandle * InstrumentTrack::voiceToSteal( const notePlayHandle * _n )
+{
+	const int policy = m_voiceStealingModel.value();
+
+	notePlayHandle * oldest = NULL;
+	notePlayHandle * oldestReleased = NULL;
+	notePlayHandle * quietest = NULL;
+	float quietestLevel = 0;
+
+	// m_voices is sorted by age
+	for( NotePlayHandleList::ConstIterator it = m_voices.begin();
+						it != m_voices.end(); ++it )
+	{
+		notePlayHandle * v = *it;
+		// stealing the parent would steal the new note as well
+		if( v == _n || v == _n->m_parent || v->m_stolen )
+		{
+			continue;
+		}
+
+		if( policy == StealSameKey && v->key() == _n->key() )
+		{
+			return v;
+		}
+
+		if( oldest == NULL )
+		{
+			oldest = v;
+		}
+		if( oldestReleased == NULL && v->released() )
+		{
+			oldestReleased = v;
+		}
+
+		if( policy == StealQuietest )
+		{
+			const float level = v->getVolume() *
+				v->volumeLevel( v->totalFramesPlayed() );
+			if( quietest == NULL || level < quietestLevel )
+			{
+				quietest = v;
+				quietestLevel = level;
+			}
+		}
+	}
+
+	if( quietest != NULL )
+	{
+		return quietest;
+	}
+	// voices in release-phase are least audible without looking at
+	// envelopes
+	return oldestReleased != NULL ? oldestReleased : oldest;
+}
+
+
+
+
+void InstrumentTrack::markVoiceStolen( notePlayHandle * _n )
+{
+	_n->m_stolen = true;
+	--m_activeVoices;
+	engine::mixer()->removeVoice();
+}
+
+
+
+
+bool InstrumentTrack::addOfflineRenderContext(
+					OfflineRenderContext * _context )
+{
+	QMutexLocker ml( &m_offlineRenderMutex );
+	if( m_offlineRenderDisabled > 0 || m_instrument == NULL ||
+				!m_instrument->supportsOfflineRendering() )
+	{
+		return false;
+	}
+	m_offlineRenderContexts.push_back( _context );
+	return true;
+}
+
+
+
+
+void InstrumentTrack::removeOfflineRenderContext(
+					OfflineRenderContext * _context )
+{
+	QMutexLocker ml( &m_offlineRenderMutex );
+	m_offlineRenderContexts.removeAll( _context );
+	m_offlineRenderDone.wakeAll();
+}
+
+
+
+
+void InstrumentTrack::disableOfflineRendering()
+{
+	QMutexLocker ml( &m_offlineRenderMutex );
+	++m_offlineRenderDisabled;
+	for( QList<OfflineRenderContext *>::Iterator it =
+					m_offlineRenderContexts.begin();
+				it != m_offlineRenderContexts.end(); ++it )
+	{
+		( *it )->abort();
+	}
+	// contexts check for abortion once per period so we won't have to
+	// wait for long
+	while( !m_offlineRenderContexts.isEmpty() )
+	{
+		m_offlineRenderDone.wait( &m_offlineRenderMutex );
+	}
+}
+
+
+
+
+void InstrumentTrack::enableOfflineRendering()
+{
+	QMutexLocker ml( &m_offlineRenderMutex );
+	--m_offlineRenderDisabled;
+}
+
+
+
+
 f_cnt_t InstrumentTrack::beatLen( notePlayHandle * _n ) const
 {
 	if( m_instrument != NULL )
@@ -489,9 +744,13 @@ void InstrumentTrack::playNote( notePlayHandle * _n,
 						sampleFrame * _working_buffer )
 {
 	// arpeggio- and chord-widget has to do its work -> adding sub-notes
-	// for chords/arpeggios
-	m_noteStacking.processNote( _n );
-	m_arpeggio.processNote( _n );
+	// for chords/arpeggios - not for a stolen note as sub-notes would
+	// outlive it
+	if( !_n->isFadingOut() )
+	{
+		m_noteStacking.processNote( _n );
+		m_arpeggio.processNote( _n );
+	}
 
 	if( !_n->isArpeggioBaseNote() && m_instrument != NULL )
 	{
@@ -773,6 +1032,8 @@ void InstrumentTrack::saveTrackSpecificSettings( QDomDocument & _doc,
 
 	m_effectChannelModel.saveSettings( _doc, _this, "fxch" );
 	m_baseNoteModel.saveSettings( _doc, _this, "basenote" );
+	m_maxVoicesModel.saveSettings( _doc, _this, "maxvoices" );
+	m_voiceStealingModel.saveSettings( _doc, _this, "voicestealing" );
 
 	if( m_instrument != NULL )
 	{
@@ -794,6 +1055,7 @@ void InstrumentTrack::saveTrackSpecificSettings( QDomDocument & _doc,
 void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & _this )
 {
 	silenceAllNotes();
+	disableOfflineRendering();
 
 	engine::mixer()->lock();
 
@@ -816,6 +1078,8 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & _this )
 	m_pitchModel.loadSettings( _this, "pitch" );
 	m_pitchRangeModel.loadSettings( _this, "pitchrange" );
 	m_effectChannelModel.loadSettings( _this, "fxch" );
+	m_maxVoicesModel.loadSettings( _this, "maxvoices" );
+	m_voiceStealingModel.loadSettings( _this, "voicestealing" );
 
 	if( _this.hasAttribute( "baseoct" ) )
 	{
@@ -892,6 +1156,8 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & _this )
 		node = node.nextSibling();
         }
 	engine::mixer()->unlock();
+
+	enableOfflineRendering();
 }
 
 
@@ -900,12 +1166,15 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & _this )
 Instrument * InstrumentTrack::loadInstrument( const QString & _plugin_name )
 {
 	silenceAllNotes();
+	disableOfflineRendering();
 
 	engine::mixer()->lock();
 	delete m_instrument;
 	m_instrument = Instrument::instantiate( _plugin_name, this );
 	engine::mixer()->unlock();
 
+	enableOfflineRendering();
+
 	setName( m_instrument->displayName() );
 	emit instrumentChanged();
 
@@ -1361,6 +1630,30 @@ InstrumentTrackWindow::InstrumentTrackWindow( InstrumentTrackView * _itv ) :
 
 	instrumentFunctionsLayout->addWidget( m_noteStackingView );
 	instrumentFunctionsLayout->addWidget( m_arpeggioView );
+
+	// voice-limit and -stealing
+	QHBoxLayout* voicesLayout = new QHBoxLayout;
+	voicesLayout->setSpacing( 6 );
+	m_maxVoicesSpinBox = new lcdSpinBox( 3, NULL, tr( "Maximum voices" ) );
+	m_maxVoicesSpinBox->setLabel( tr( "VOICES" ) );
+	m_maxVoicesSpinBox->setWhatsThis(
+		tr( "Maximum number of notes (including chord- and "
+			"arpeggio-notes) this channel plays at the same time. "
+			"If more notes are played, one of the playing notes "
+			"is stopped. The limit is lowered automatically if "
+			"your computer runs out of CPU." ) );
+
+	QLabel* voiceStealingLabel = new QLabel( tr( "Stop:" ) );
+	voiceStealingLabel->setFont( pointSize<8>( voiceStealingLabel->font() ) );
+	m_voiceStealingComboBox = new comboBox( NULL, tr( "Voice stealing" ) );
+	m_voiceStealingComboBox->setWhatsThis(
+		tr( "Select which note to stop if the maximum number of "
+			"voices is reached." ) );
+
+	voicesLayout->addWidget( m_maxVoicesSpinBox );
+	voicesLayout->addWidget( voiceStealingLabel );
+	voicesLayout->addWidget( m_voiceStealingComboBox, 1 );
+	instrumentFunctionsLayout->addLayout( voicesLayout );
 	instrumentFunctionsLayout->addStretch();
 
 	// MIDI tab
@@ -1465,6 +1758,8 @@ void InstrumentTrackWindow::modelChanged()
 	m_ssView->setModel( &m_track->m_soundShaping );
 	m_noteStackingView->setModel( &m_track->m_noteStacking );
 	m_arpeggioView->setModel( &m_track->m_arpeggio );
+	m_maxVoicesSpinBox->setModel( &m_track->m_maxVoicesModel );
+	m_voiceStealingComboBox->setModel( &m_track->m_voiceStealingModel );
 	m_midiView->setModel( &m_track->m_midiPort );
 	m_effectView->setModel( m_track->m_audioPort.effects() );
 	updateName();
@@ -39,6 +39,7 @@
 #include "gui_templates.h"
 #include "embed.h"
 #include "engine.h"
+#include "OfflineRenderContext.h"
 #include "piano_roll.h"
 #include "TrackContainer.h"
 #include "rename_dialog.h"
@@ -66,7 +67,8 @@ pattern::pattern( InstrumentTrack * _instrument_track ) :
 	m_steps( midiTime::stepsPerTact() ),
 	m_frozenPattern( NULL ),
 	m_freezing( false ),
-	m_freezeAborted( false )
+	m_freezeAborted( false ),
+	m_freezeThread( NULL )
 {
 	setName( _instrument_track->name() );
 	init();
@@ -81,7 +83,9 @@ pattern::pattern( const pattern & _pat_to_copy ) :
 	m_patternType( _pat_to_copy.m_patternType ),
 	m_steps( _pat_to_copy.m_steps ),
 	m_frozenPattern( NULL ),
-	m_freezeAborted( false )
+	m_freezing( false ),
+	m_freezeAborted( false ),
+	m_freezeThread( NULL )
 {
 	for( NoteVector::ConstIterator it = _pat_to_copy.m_notes.begin();
 					it != _pat_to_copy.m_notes.end(); ++it )
@@ -95,6 +99,13 @@ pattern::pattern( const pattern & _pat_to_copy ) :
 
 pattern::~pattern()
 {
+	if( m_freezeThread != NULL )
+	{
+		m_freezeThread->abort();
+		m_freezeThread->wait();
+		m_freezeThread->detachPattern();
+	}
+
 	for( NoteVector::Iterator it = m_notes.begin();
 						it != m_notes.end(); ++it )
 	{
@@ -438,7 +449,16 @@ void pattern::clear()
 
 void pattern::freeze()
 {
-	if( engine::getSong()->isPlaying() )
+	// still freezing in background?
+	if( m_freezeThread != NULL )
+	{
+		return;
+	}
+
+	// background-freezing doesn't touch the mixer so there's no need
+	// to stop playback
+	if( !OfflineRenderContext::isSupported( m_instrumentTrack ) &&
+					engine::getSong()->isPlaying() )
 	{
 		QMessageBox::information( 0, tr( "Cannot freeze pattern" ),
 						tr( "The pattern currently "
@@ -466,6 +486,12 @@ void pattern::freeze()
 
 void pattern::unfreeze()
 {
+	// result of a running freeze would be outdated
+	if( m_freezeThread != NULL )
+	{
+		m_freezeThread->abort();
+	}
+
 	if( m_frozenPattern != NULL )
 	{
 		sharedObject::unref( m_frozenPattern );
@@ -479,6 +505,10 @@ void pattern::unfreeze()
 
 void pattern::abortFreeze()
 {
+	if( m_freezeThread != NULL )
+	{
+		m_freezeThread->abort();
+	}
 	m_freezeAborted = true;
 }
 
@@ -624,13 +654,14 @@ void pattern::changeTimeSignature()
 
 
 
-patternFreezeStatusDialog::patternFreezeStatusDialog( QThread * _thread ) :
+patternFreezeStatusDialog::patternFreezeStatusDialog( QThread * _thread,
+							bool _modal ) :
 	QDialog(),
 	m_freezeThread( _thread ),
 	m_progress( 0 )
 {
 	setWindowTitle( tr( "Freezing pattern..." ) );
-	setModal( true );
+	setModal( _modal );
 
 	m_progressBar = new QProgressBar( this );
 	m_progressBar->setGeometry( 10, 10, 200, 24 );
@@ -714,10 +745,25 @@ void patternFreezeStatusDialog::updateProgress()
 
 
 patternFreezeThread::patternFreezeThread( pattern * _pattern ) :
-	m_pattern( _pattern )
+	m_pattern( _pattern ),
+	m_renderContext( NULL ),
+	m_result( NULL )
 {
-	// create status-dialog
-	m_statusDlg = new patternFreezeStatusDialog( this );
+	if( OfflineRenderContext::isSupported( m_pattern->instrumentTrack() ) )
+	{
+		// notes have to be copied here as the pattern might be edited
+		// while we're rendering
+		m_renderContext = new OfflineRenderContext(
+						m_pattern->instrumentTrack() );
+		m_renderContext->addPattern( m_pattern );
+	}
+
+	m_pattern->m_freezeThread = this;
+
+	// create status-dialog - no need to block the user when freezing
+	// in background
+	m_statusDlg = new patternFreezeStatusDialog( this,
+						m_renderContext == NULL );
 	QObject::connect( m_statusDlg, SIGNAL( aborted() ),
 					m_pattern, SLOT( abortFreeze() ) );
 
@@ -729,13 +775,79 @@ patternFreezeThread::patternFreezeThread( pattern * _pattern ) :
 
 patternFreezeThread::~patternFreezeThread()
 {
+	delete m_renderContext;
+
+	if( m_pattern == NULL )
+	{
+		// pattern went away while freezing
+		if( m_result )
+		{
+			sharedObject::unref( m_result );
+		}
+		return;
+	}
+
+	m_pattern->m_freezeThread = NULL;
+
+	if( m_result != NULL )
+	{
+		// we're in GUI-thread again so we can safely exchange the
+		// sample-buffer, only mixer might be using it right now
+		engine::mixer()->lock();
+		if( m_pattern->m_frozenPattern != NULL )
+		{
+			sharedObject::unref( m_pattern->m_frozenPattern );
+		}
+		m_pattern->m_frozenPattern = m_result;
+		engine::mixer()->unlock();
+	}
+
 	m_pattern->dataChanged();
 }
 
 
 
 
+void patternFreezeThread::abort()
+{
+	if( m_renderContext != NULL )
+	{
+		m_renderContext->abort();
+	}
+	else if( m_pattern != NULL )
+	{
+		m_pattern->m_freezeAborted = true;
+	}
+}
+
+
+
+
+void patternFreezeThread::detachPattern()
+{
+	m_pattern->m_freezeThread = NULL;
+	m_pattern = NULL;
+}
+
+
+
+
 void patternFreezeThread::run()
+{
+	if( m_renderContext != NULL )
+	{
+		m_result = m_renderContext->render( m_statusDlg->progress() );
+		m_statusDlg->setProgress( -1 );	// we're finished
+		return;
+	}
+
+	renderLegacy();
+}
+
+
+
+
+void patternFreezeThread::renderLegacy()
 {
 	// create and install audio-sample-recorder
 	bool b;
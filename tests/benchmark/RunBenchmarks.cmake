@@ -0,0 +1,146 @@
+#
+# RunBenchmarks.cmake - renders reference projects, prints profiling results
+# and compares renderings with golden files
+#
+# invoked by "make benchmark" and "make benchmark-update-golden" - expects
+# LMMS (installed binary), WAVCOMPARE, SOURCE_DIR and OUTPUT_DIR to be set;
+# GOLDEN_DIR, TOLERANCE (peak difference of samples) and MAX_SLOWDOWN (in
+# percent of reference realtime-factor) can be overridden
+#
+# GOLDEN_DIR holds a rendering (<name>.wav) and a profile (<name>.profile) of
+# each benchmark - both are only written with UPDATE_GOLDEN set, so slowdowns
+# are always measured against the same reference and not against whatever
+# ran last; a missing golden file makes the benchmark fail
+#
+
+IF(NOT TOLERANCE)
+	SET(TOLERANCE 0.001)
+ENDIF(NOT TOLERANCE)
+IF(NOT MAX_SLOWDOWN)
+	SET(MAX_SLOWDOWN 10)
+ENDIF(NOT MAX_SLOWDOWN)
+
+SET(PROJECTS_DIR ${SOURCE_DIR}/data/projects)
+IF(NOT GOLDEN_DIR)
+	SET(GOLDEN_DIR ${SOURCE_DIR}/tests/benchmark/golden)
+ENDIF(NOT GOLDEN_DIR)
+
+# many voices of TripleOscillator
+SET(tripleoscillator_PROJECT ${PROJECTS_DIR}/OldStuff/Silva-ElvesCall.mmp)
+# sample-based drum-kit (AudioFileProcessor)
+SET(drumkit_PROJECT ${PROJECTS_DIR}/Demos/CapDan-ReggaeTry.mmpz)
+# long LADSPA effect-chains
+SET(ladspa_PROJECT ${PROJECTS_DIR}/Shorties/Root84-TrancyLoop.mmpz)
+# layered ZynAddSubFX pads
+SET(zynaddsubfx_PROJECT ${PROJECTS_DIR}/CoolSongs/Oglsdl-Dr8v2.mmpz)
+# lots of automation-patterns
+SET(automation_PROJECT ${PROJECTS_DIR}/Demos/AngryLlama-NewFangled.mmpz)
+
+SET(BENCHMARKS tripleoscillator drumkit ladspa zynaddsubfx automation)
+
+FILE(MAKE_DIRECTORY ${OUTPUT_DIR})
+
+SET(FAILURES "")
+SET(SUMMARY "")
+
+FOREACH(NAME ${BENCHMARKS})
+	SET(PROJECT ${${NAME}_PROJECT})
+	SET(OUTPUT ${OUTPUT_DIR}/${NAME}.wav)
+	SET(PROFILE ${OUTPUT_DIR}/${NAME}.profile)
+	SET(GOLDEN ${GOLDEN_DIR}/${NAME}.wav)
+	SET(GOLDEN_PROFILE ${GOLDEN_DIR}/${NAME}.profile)
+
+	MESSAGE(STATUS "Rendering ${NAME} (${PROJECT})")
+
+	# stored reference is the baseline for detecting slowdowns
+	SET(OLD_FACTOR "")
+	IF(EXISTS ${GOLDEN_PROFILE})
+		FILE(READ ${GOLDEN_PROFILE} OLD_PROFILE)
+		STRING(REGEX MATCH "realtime-factor [0-9]+\\.[0-9][0-9]"
+						OLD_FACTOR "${OLD_PROFILE}")
+	ENDIF(EXISTS ${GOLDEN_PROFILE})
+
+	EXECUTE_PROCESS(COMMAND ${LMMS} --render ${PROJECT} --output ${OUTPUT}
+						--profile --seed 1
+			RESULT_VARIABLE RESULT
+			OUTPUT_VARIABLE LOG
+			ERROR_VARIABLE ERRORS)
+
+	STRING(REGEX MATCHALL "profile: [^\n]*" PROFILE_LINES "${LOG}")
+	IF(NOT RESULT EQUAL 0 OR NOT PROFILE_LINES)
+		MESSAGE("${ERRORS}")
+		SET(FAILURES "${FAILURES} ${NAME}(render)")
+		SET(SUMMARY "${SUMMARY}\n  ${NAME}: rendering failed")
+	ELSE(NOT RESULT EQUAL 0 OR NOT PROFILE_LINES)
+		SET(PROFILE_TEXT "")
+		FOREACH(LINE ${PROFILE_LINES})
+			MESSAGE("  ${LINE}")
+			SET(PROFILE_TEXT "${PROFILE_TEXT}${LINE}\n")
+		ENDFOREACH(LINE)
+		FILE(WRITE ${PROFILE} "${PROFILE_TEXT}")
+
+		STRING(REGEX MATCH "realtime-factor [0-9]+\\.[0-9][0-9]"
+						FACTOR "${PROFILE_TEXT}")
+		STRING(REGEX REPLACE "realtime-factor " "" FACTOR "${FACTOR}")
+		SET(STATE "realtime-factor ${FACTOR}")
+
+		# factors are printed with two decimals, so compare them as
+		# integers in hundredths
+		IF(OLD_FACTOR AND FACTOR AND NOT UPDATE_GOLDEN)
+			STRING(REGEX REPLACE "realtime-factor " "" OLD_FACTOR
+							"${OLD_FACTOR}")
+			STRING(REPLACE "." "" NEW_HUNDREDTHS "${FACTOR}")
+			STRING(REPLACE "." "" OLD_HUNDREDTHS "${OLD_FACTOR}")
+			MATH(EXPR NEW_SCALED "${NEW_HUNDREDTHS} * 100")
+			MATH(EXPR MIN_SCALED
+				"${OLD_HUNDREDTHS} * (100 - ${MAX_SLOWDOWN})")
+			SET(STATE "${STATE} (reference: ${OLD_FACTOR})")
+			IF(NEW_SCALED LESS MIN_SCALED)
+				SET(FAILURES "${FAILURES} ${NAME}(speed)")
+				SET(STATE "${STATE}, SLOWER")
+			ENDIF(NEW_SCALED LESS MIN_SCALED)
+		ENDIF(OLD_FACTOR AND FACTOR AND NOT UPDATE_GOLDEN)
+
+		IF(UPDATE_GOLDEN)
+			FILE(MAKE_DIRECTORY ${GOLDEN_DIR})
+			EXECUTE_PROCESS(COMMAND ${CMAKE_COMMAND} -E copy
+							${OUTPUT} ${GOLDEN})
+			FILE(WRITE ${GOLDEN_PROFILE} "${PROFILE_TEXT}")
+			SET(STATE "${STATE}, golden file updated")
+		ELSEIF(EXISTS ${GOLDEN})
+			EXECUTE_PROCESS(COMMAND ${WAVCOMPARE} ${OUTPUT}
+							${GOLDEN} ${TOLERANCE}
+					RESULT_VARIABLE RESULT
+					OUTPUT_VARIABLE DIFF)
+			STRING(STRIP "${DIFF}" DIFF)
+			MESSAGE("  ${DIFF}")
+			IF(RESULT EQUAL 0)
+				SET(STATE "${STATE}, matches golden file")
+			ELSE(RESULT EQUAL 0)
+				SET(FAILURES "${FAILURES} ${NAME}(audio)")
+				SET(STATE "${STATE}, DIFFERS from golden file")
+			ENDIF(RESULT EQUAL 0)
+		ELSE(UPDATE_GOLDEN)
+			SET(FAILURES "${FAILURES} ${NAME}(golden)")
+			SET(STATE "${STATE}, MISSING golden file ${GOLDEN}")
+		ENDIF(UPDATE_GOLDEN)
+
+		IF(NOT UPDATE_GOLDEN AND NOT OLD_FACTOR AND EXISTS ${GOLDEN})
+			SET(FAILURES "${FAILURES} ${NAME}(reference)")
+			SET(STATE "${STATE}, MISSING reference ${GOLDEN_PROFILE}")
+		ENDIF(NOT UPDATE_GOLDEN AND NOT OLD_FACTOR AND EXISTS ${GOLDEN})
+
+		SET(SUMMARY "${SUMMARY}\n  ${NAME}: ${STATE}")
+	ENDIF(NOT RESULT EQUAL 0 OR NOT PROFILE_LINES)
+ENDFOREACH(NAME)
+
+MESSAGE("\nBenchmark results:${SUMMARY}\n")
+
+IF(FAILURES)
+	IF(FAILURES MATCHES "\\((golden|reference)\\)")
+		MESSAGE("Run \"make benchmark-update-golden\" on this machine "
+			"or point BENCHMARK_GOLDEN_DIR to existing golden "
+								"files.")
+	ENDIF(FAILURES MATCHES "\\((golden|reference)\\)")
+	MESSAGE(FATAL_ERROR "Benchmarks failed:${FAILURES}")
+ENDIF(FAILURES)
@@ -0,0 +1,136 @@
+/*
+ * wavcompare.cpp - compares rendered audio-files with golden files
+ *
+ * Copyright (c) 2014 LMMS Developers
+ *
+ * This file is part of Linux MultiMedia Studio - http://lmms.sourceforge.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sndfile.h>
+
+
+// Renderings aren't bit-exact across compilers and CPUs (and summing of
+// play-handles rendered by different worker-threads isn't ordered either), so
+// files are considered equal if peak difference of all samples doesn't exceed
+// given tolerance. Exit code is 0 if files match, 1 if they differ and 2 on
+// errors.
+
+static const int BUFFER_FRAMES = 4096;
+
+
+static SNDFILE * openFile( const char * _name, SF_INFO * _info )
+{
+	memset( _info, 0, sizeof( *_info ) );
+	SNDFILE * f = sf_open( _name, SFM_READ, _info );
+	if( f == NULL )
+	{
+		fprintf( stderr, "could not open %s: %s\n", _name,
+							sf_strerror( NULL ) );
+	}
+	return f;
+}
+
+
+
+
+int main( int argc, char * * argv )
+{
+	if( argc < 3 || argc > 4 )
+	{
+		fprintf( stderr, "usage: %s <file> <golden file> "
+						"[<tolerance>]\n", argv[0] );
+		return 2;
+	}
+
+	const double tolerance = argc > 3 ? atof( argv[3] ) : 1.0e-4;
+
+	SF_INFO info, golden_info;
+	SNDFILE * f = openFile( argv[1], &info );
+	SNDFILE * golden = openFile( argv[2], &golden_info );
+	if( f == NULL || golden == NULL )
+	{
+		return 2;
+	}
+
+	if( info.channels != golden_info.channels ||
+				info.samplerate != golden_info.samplerate )
+	{
+		printf( "format differs: %d channels at %d Hz vs. "
+					"%d channels at %d Hz\n",
+				info.channels, info.samplerate,
+				golden_info.channels, golden_info.samplerate );
+		return 1;
+	}
+
+	const int ch = info.channels;
+	float * buf = new float[BUFFER_FRAMES * ch];
+	float * golden_buf = new float[BUFFER_FRAMES * ch];
+
+	double max_diff = 0;
+	double sum_sq = 0;
+	sf_count_t frames = 0;
+	sf_count_t max_diff_frame = 0;
+
+	while( true )
+	{
+		const sf_count_t n = sf_readf_float( f, buf, BUFFER_FRAMES );
+		const sf_count_t gn = sf_readf_float( golden, golden_buf,
+								BUFFER_FRAMES );
+		// compare common part, length is checked below
+		const sf_count_t common = n < gn ? n : gn;
+		for( sf_count_t i = 0; i < common * ch; ++i )
+		{
+			const double d = fabs( buf[i] - golden_buf[i] );
+			if( d > max_diff )
+			{
+				max_diff = d;
+				max_diff_frame = frames + i / ch;
+			}
+			sum_sq += d * d;
+		}
+		frames += common;
+		if( n < BUFFER_FRAMES || gn < BUFFER_FRAMES )
+		{
+			break;
+		}
+	}
+
+	delete[] buf;
+	delete[] golden_buf;
+	sf_close( f );
+	sf_close( golden );
+
+	const double rms = frames > 0 ? sqrt( sum_sq / ( frames * ch ) ) : 0;
+	printf( "max-diff %g at frame %ld, rms-diff %g\n", max_diff,
+					(long) max_diff_frame, rms );
+
+	if( info.frames != golden_info.frames )
+	{
+		printf( "length differs: %ld vs. %ld frames\n",
+				(long) info.frames, (long) golden_info.frames );
+		return 1;
+	}
+
+	return max_diff > tolerance ? 1 : 0;
+}
+